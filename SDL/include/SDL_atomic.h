@@ -0,0 +1,153 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifndef _SDL_atomic_h
+#define _SDL_atomic_h
+
+/** @file SDL_atomic.h
+ *  Atomic operations, memory barriers and spinlocks
+ *
+ *  @note These are independent of the other SDL routines.
+ *
+ *  Unless you know what you're doing, use a mutex instead.  These are
+ *  for short pieces of shared state that are touched very often, like
+ *  counters and flags, where a mutex would cost more than the work.
+ *  The operations that change a value are full memory barriers, and
+ *  getting a value is an acquire barrier.
+ */
+
+#include "SDL_stdinc.h"
+
+#include "begin_code.h"
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/** @name Spinlock functions                                     */ /*@{*/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** A spinlock, unlocked when it's 0.  Spinlocks aren't recursive and
+ *  should only be held for a few instructions.
+ */
+typedef int SDL_SpinLock;
+
+/** Try to lock a spinlock without waiting
+ *  @return SDL_TRUE if the lock was taken, SDL_FALSE if it's held
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicTryLock(SDL_SpinLock *lock);
+
+/** Lock a spinlock, waiting until it's free */
+extern DECLSPEC void SDLCALL SDL_AtomicLock(SDL_SpinLock *lock);
+
+/** Unlock a spinlock taken by this thread */
+extern DECLSPEC void SDLCALL SDL_AtomicUnlock(SDL_SpinLock *lock);
+
+/*@}*/
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/** @name Memory barriers                                        */ /*@{*/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** Keep the compiler from moving memory accesses across this point.
+ *  The processor may still reorder them.
+ */
+#if defined(_MSC_VER) && (_MSC_VER > 1200)
+void _ReadWriteBarrier(void);
+#pragma intrinsic(_ReadWriteBarrier)
+#define SDL_CompilerBarrier()	_ReadWriteBarrier()
+#elif defined(__GNUC__)
+#define SDL_CompilerBarrier()	__asm__ __volatile__ ("" : : : "memory")
+#else
+#define SDL_CompilerBarrier()	SDL_MemoryBarrierAcquire()
+#endif
+
+/** Make the writes before this point visible to other processors before
+ *  the writes after it, when publishing data for another thread.
+ */
+extern DECLSPEC void SDLCALL SDL_MemoryBarrierRelease(void);
+
+/** Make the reads after this point see data at least as new as the reads
+ *  before it, when picking up data published by another thread.
+ */
+extern DECLSPEC void SDLCALL SDL_MemoryBarrierAcquire(void);
+
+/*@}*/
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/** @name Atomic integers and pointers                           */ /*@{*/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** An integer that's only changed atomically.  Use the functions below
+ *  to get at the value, so the compiler doesn't cache it.
+ */
+typedef struct { int value; } SDL_atomic_t;
+
+/** Set the value to 'newval' if it's 'oldval'
+ *  @return SDL_TRUE if the value was set
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicCAS(SDL_atomic_t *a, int oldval, int newval);
+
+/** Set the value
+ *  @return The previous value
+ */
+extern DECLSPEC int SDLCALL SDL_AtomicSet(SDL_atomic_t *a, int v);
+
+/** Get the value */
+extern DECLSPEC int SDLCALL SDL_AtomicGet(SDL_atomic_t *a);
+
+/** Add to the value, which can be negative
+ *  @return The previous value
+ */
+extern DECLSPEC int SDLCALL SDL_AtomicAdd(SDL_atomic_t *a, int v);
+
+/** Increment a reference count */
+#define SDL_AtomicIncRef(a)	SDL_AtomicAdd(a, 1)
+
+/** Decrement a reference count
+ *  @return SDL_TRUE if the count went down to 0
+ */
+#define SDL_AtomicDecRef(a)	(SDL_AtomicAdd(a, -1) == 1)
+
+/** Set a pointer to 'newval' if it's 'oldval'
+ *  @return SDL_TRUE if the pointer was set
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicCASPtr(void **a, void *oldval, void *newval);
+
+/** Set a pointer
+ *  @return The previous pointer
+ */
+extern DECLSPEC void * SDLCALL SDL_AtomicSetPtr(void **a, void *v);
+
+/** Get a pointer */
+extern DECLSPEC void * SDLCALL SDL_AtomicGetPtr(void **a);
+
+/*@}*/
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+#include "close_code.h"
+
+#endif /* _SDL_atomic_h */
@@ -60,6 +60,54 @@ extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE2(void);
 /** This function returns true if the CPU has AltiVec features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasAltiVec(void);
 
+/** This function returns true if the CPU has SSE3 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE3(void);
+
+/** This function returns true if the CPU has SSSE3 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSSE3(void);
+
+/** This function returns true if the CPU has SSE4.1 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE41(void);
+
+/** This function returns true if the CPU has SSE4.2 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE42(void);
+
+/** This function returns true if the CPU has AVX features and the
+ *  OS saves the AVX registers
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX(void);
+
+/** This function returns true if the CPU has AVX2 features and the
+ *  OS saves the AVX registers
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX2(void);
+
+/** This function returns true if the CPU has AVX-512 Foundation features
+ *  and the OS saves the AVX-512 registers
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX512F(void);
+
+/** This function returns the number of logical processors online,
+ *  counting each hyperthread, or 1 if it can't be found out
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCount(void);
+
+/** This function returns the number of physical processor cores,
+ *  or the number of logical processors if it can't be found out
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCoreCount(void);
+
+/** This function returns the size of a line of the L1 data cache in
+ *  bytes, or a safe guess if it can't be found out
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCacheLineSize(void);
+
+/** This function returns the size in bytes of the L1 data cache, L2 cache
+ *  or L3 cache for level 1, 2 or 3, or 0 if there is none or it can't be
+ *  found out
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCacheSize(int level);
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
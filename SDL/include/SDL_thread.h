@@ -105,6 +105,75 @@ extern DECLSPEC void SDLCALL SDL_WaitThread(SDL_Thread *thread, int *status);
 /** Forcefully kill a thread without worrying about its state */
 extern DECLSPEC void SDLCALL SDL_KillThread(SDL_Thread *thread);
 
+/** Thread local storage ID, 0 is never a valid ID */
+typedef unsigned int SDL_TLSID;
+
+/** Create an identifier that every thread can store a value under.
+ *  The value is NULL in every thread until the thread sets it.
+ *  @return The new ID
+ */
+extern DECLSPEC SDL_TLSID SDLCALL SDL_TLSCreate(void);
+
+/** Get the calling thread's value for a thread local storage ID.
+ *  @return The value, or NULL if the thread hasn't set one
+ */
+extern DECLSPEC void * SDLCALL SDL_TLSGet(SDL_TLSID id);
+
+/** Set the calling thread's value for a thread local storage ID.
+ *  If 'destructor' isn't NULL it's called with the value when the thread
+ *  ends, if the thread was created by SDL_CreateThread() or the platform
+ *  uses pthreads.
+ *  @return 0 on success or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_TLSSet(SDL_TLSID id, const void *value, void (SDLCALL *destructor)(void*));
+
+/** @name Job threads
+ *  A pool of threads, one for each processor, that run short pieces of
+ *  work.  It's started the first time it's used and stopped by SDL_Quit().
+ *  The SDL_JOB_THREADS environment variable sets the number of threads.
+ */
+/*@{*/
+typedef struct SDL_JobGroup SDL_JobGroup;
+
+/** A job, run once on one of the job threads */
+typedef void (SDLCALL *SDL_JobFunc)(void *data);
+
+/** A piece of a parallel loop, from 'start' up to but not including 'end' */
+typedef void (SDLCALL *SDL_RangeFunc)(void *data, int start, int end);
+
+/** Get the number of threads running jobs, counting the thread that
+ *  waits for them, which helps.
+ */
+extern DECLSPEC int SDLCALL SDL_GetJobThreads(void);
+
+/** Create a group that jobs can be added to and waited for together
+ *  @return The group, or NULL on error
+ */
+extern DECLSPEC SDL_JobGroup * SDLCALL SDL_CreateJobGroup(void);
+
+/** Add a job to a group.  Jobs run in no particular order and can add
+ *  more jobs and wait for them.  If it can't be queued the job is run
+ *  right away.
+ *  @return 0 on success or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_AddJob(SDL_JobGroup *group, SDL_JobFunc func, void *data);
+
+/** Wait for all the jobs in a group to finish, running queued jobs
+ *  in the meantime.
+ */
+extern DECLSPEC void SDLCALL SDL_WaitJobGroup(SDL_JobGroup *group);
+
+/** Wait for the jobs in a group to finish and free it */
+extern DECLSPEC void SDLCALL SDL_DestroyJobGroup(SDL_JobGroup *group);
+
+/** Call 'func' on pieces of the range from 'start' to 'end' on the job
+ *  threads and the calling thread, returning when they're all done.
+ *  The pieces have 'grain' values each, or a size chosen from the number
+ *  of threads if 'grain' is 0 or less.
+ */
+extern DECLSPEC void SDLCALL SDL_ParallelFor(int start, int end, int grain, SDL_RangeFunc func, void *data);
+/*@}*/
+
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
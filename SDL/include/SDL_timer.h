@@ -48,9 +48,36 @@ extern "C" {
  */ 
 extern DECLSPEC Uint32 SDLCALL SDL_GetTicks(void);
 
+/**
+ * Get the current value of the high resolution counter, which starts
+ * at 0 when SDL_GetTicks() does and counts SDL_GetPerformanceFrequency()
+ * times a second.  The counter is monotonic where the system allows it.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceCounter(void);
+
+/** Get the number of counts per second of the high resolution counter */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceFrequency(void);
+
+/**
+ * Get the number of nanoseconds since the SDL library initialization,
+ * from the high resolution counter.  This value doesn't wrap.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetTicksNS(void);
+
 /** Wait a specified number of milliseconds before returning */
 extern DECLSPEC void SDLCALL SDL_Delay(Uint32 ms);
 
+/**
+ * Wait until SDL_GetTicksNS() reaches the given value before returning.
+ * Most of the wait is spent sleeping and the last part spinning, so the
+ * wait ends within microseconds of the deadline, unlike SDL_Delay().
+ * This is meant for frame pacing, where sleeping too long drops frames.
+ */
+extern DECLSPEC void SDLCALL SDL_DelayUntilNS(Uint64 ns);
+
+/** Wait a specified number of nanoseconds as precisely as possible */
+extern DECLSPEC void SDLCALL SDL_DelayNS(Uint64 ns);
+
 /** Function prototype for the timer callback function */
 typedef Uint32 (SDLCALL *SDL_TimerCallback)(Uint32 interval);
 
@@ -67,7 +94,9 @@ typedef Uint32 (SDLCALL *SDL_TimerCallback)(Uint32 interval);
  * The timer callback function may run in a different thread than your
  * main code, and so shouldn't call any functions from within itself.
  *
- * The maximum resolution of this timer is 10 ms, which means that if
+ * On platforms that run timers in a thread, the callback runs when its
+ * interval is up and the timer stays in step with the requested period.
+ * Elsewhere the resolution of this timer is 10 ms, which means that if
  * you request a 16 ms timer, your callback will run approximately 20 ms
  * later on an unloaded system.  If you wanted to set a flag signaling
  * a frame update at 30 frames per second (every 33 ms), you might set a 
@@ -114,6 +143,30 @@ extern DECLSPEC SDL_TimerID SDLCALL SDL_AddTimer(Uint32 interval, SDL_NewTimerCa
  */
 extern DECLSPEC SDL_bool SDLCALL SDL_RemoveTimer(SDL_TimerID t);
 
+/**
+ * Add a timer like SDL_AddTimer(), with the interval in microseconds.
+ * The callback is also passed and returns microseconds.  Timers are
+ * kept in order of when they are due, and the timer thread sleeps until
+ * the next one, so short intervals don't cost anything between callbacks.
+ */
+extern DECLSPEC SDL_TimerID SDLCALL SDL_AddTimerUS(Uint32 interval, SDL_NewTimerCallback callback, void *param);
+
+/** Counters kept while running timers, see SDL_GetTimerStats() */
+typedef struct SDL_TimerStats {
+	Uint32 callbacks;	/**< Timer callbacks run */
+	Uint32 late;		/**< Callbacks run more than a millisecond after they were due */
+	Uint32 lateness_total;	/**< Total microseconds callbacks ran after they were due */
+	Uint32 lateness_max;	/**< Most microseconds a callback ran after it was due */
+	Uint32 wakeups;		/**< Times the timer thread woke up */
+} SDL_TimerStats;
+
+/**
+ * Get the counters kept while running timers, and reset them if 'reset'
+ * is non-zero.  With no timers the timer thread sleeps, so 'wakeups'
+ * doesn't grow.
+ */
+extern DECLSPEC void SDLCALL SDL_GetTimerStats(SDL_TimerStats *stats, int reset);
+
 /*@}*/
 
 /* Ends C function definitions when using C++ */
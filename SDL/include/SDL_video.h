@@ -399,6 +399,49 @@ extern DECLSPEC void SDLCALL SDL_UpdateRects
  */
 extern DECLSPEC void SDLCALL SDL_UpdateRect
 		(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h);
+
+/** Counters kept by SDL_UpdateRects(), see SDL_GetUpdateStats() */
+typedef struct SDL_UpdateStats {
+	Uint32 rects_in;	/**< Rectangles passed to SDL_UpdateRects() */
+	Uint32 rects_out;	/**< Rectangles passed on to the video driver */
+	Uint32 full_updates;	/**< Times the rectangles were replaced by a full screen update */
+	Uint32 tiles_compared;	/**< Tiles compared with the last frame */
+	Uint32 tiles_sent;	/**< Tiles that changed and were sent */
+	Uint32 frames_presented;	/**< Frames finished by an asynchronous presenter */
+	Uint32 present_waits;	/**< Times the caller waited for a free present buffer */
+	Uint32 present_latency;	/**< Total milliseconds from queueing frames to their completion */
+	Uint32 present_latency_max;	/**< Longest time from queueing a frame to its completion */
+} SDL_UpdateStats;
+
+/**
+ * Get the counters SDL_UpdateRects() keeps while it merges rectangles
+ * or compares frames, and reset them if 'reset' is non-zero.
+ *
+ * Merging is enabled by setting the SDL_VIDEO_MERGE_RECTS environment
+ * variable to 1 before initializing the video subsystem.  Overlapping and
+ * touching rectangles are then joined before they are sent to the video
+ * driver, and if the result covers more than SDL_VIDEO_MERGE_COVERAGE
+ * percent of the screen (75 by default) a single full screen update is
+ * done instead.
+ *
+ * Setting SDL_VIDEO_FRAME_DIFF to 1 makes SDL keep a copy of the last
+ * frame sent to the display and compare the updated area with it in
+ * tiles of SDL_VIDEO_FRAME_DIFF_TILE pixels (32 by default), so only the
+ * tiles that changed are updated.  This helps programs that call
+ * SDL_Flip() or update the whole screen every frame.
+ *
+ * The X11 driver can hand finished frames to a separate thread instead
+ * of waiting for the X server, when SDL_VIDEO_X11_ASYNC_PRESENT is set
+ * to 1 and the MIT-SHM extension is available.  The present counters
+ * show how long frames took to reach the display and how often the
+ * program had to wait because both present buffers were still in use.
+ * The dummy driver presents the same way when SDL_VIDEO_DUMMY_ASYNC_PRESENT
+ * is set to 1, taking SDL_VIDEO_DUMMY_PRESENT_DELAY milliseconds per frame.
+ *
+ * The counters are kept by the thread that updates the screen, and this
+ * function should be called from that thread.
+ */
+extern DECLSPEC void SDLCALL SDL_GetUpdateStats(SDL_UpdateStats *stats, int reset);
 /*@}*/
 
 /**
@@ -462,6 +505,10 @@ extern DECLSPEC int SDLCALL SDL_GetGammaRamp(Uint16 *red, Uint16 *green, Uint16
  * will always return 1, and the palette is guaranteed to be set the way
  * you desire, even if the window colormap has to be warped or run under
  * emulation.
+ *
+ * If you write to surface->format->palette->colors directly, pass those
+ * entries to SDL_SetColors() afterwards, so SDL_MapRGB() and blits to the
+ * surface use the new colors.
  */
 extern DECLSPEC int SDLCALL SDL_SetColors(SDL_Surface *surface, 
 			SDL_Color *colors, int firstcolor, int ncolors);
@@ -580,6 +627,15 @@ extern DECLSPEC void SDLCALL SDL_FreeSurface(SDL_Surface *surface);
 extern DECLSPEC int SDLCALL SDL_LockSurface(SDL_Surface *surface);
 extern DECLSPEC void SDLCALL SDL_UnlockSurface(SDL_Surface *surface);
 
+/**
+ * Tells SDL that rows 'y' to 'y'+'h'-1 of a locked surface have been
+ * written to.  When an RLE accelerated surface is unlocked, only the
+ * marked rows are encoded again, instead of the whole surface.  If no
+ * rows are marked during a lock, the whole surface is assumed modified.
+ * Fills and blits into the surface mark the rows they change themselves.
+ */
+extern DECLSPEC void SDLCALL SDL_DirtySurfaceRows(SDL_Surface *surface, int y, int h);
+
 /**
  * Load a surface from a seekable SDL data source (memory or file.)
  * If 'freesrc' is non-zero, the source will be closed after being read.
@@ -668,6 +724,20 @@ extern DECLSPEC void SDLCALL SDL_GetClipRect(SDL_Surface *surface, SDL_Rect *rec
 extern DECLSPEC SDL_Surface * SDLCALL SDL_ConvertSurface
 			(SDL_Surface *src, SDL_PixelFormat *fmt, Uint32 flags);
 
+/**
+ * Converts 'count' surfaces to the same pixel format, as if by calling
+ * SDL_ConvertSurface() on each, and stores the new surfaces in 'dst'.
+ * Surfaces that can't be converted have a NULL entry in 'dst'.
+ *
+ * Conversions between RGB formats write straight into the new surfaces,
+ * and when there are enough pixels they are spread over several threads
+ * (see SDL_VIDEO_THREADS), which makes this the fastest way to prepare
+ * many sprites at once.  Returns the number of surfaces converted.
+ */
+extern DECLSPEC int SDLCALL SDL_ConvertSurfaces
+			(SDL_Surface **src, int count, SDL_PixelFormat *fmt,
+			 Uint32 flags, SDL_Surface **dst);
+
 /**
  * This performs a fast blit from the source surface to the destination
  * surface.  It assumes that the source and destination rectangles are
@@ -941,6 +1011,47 @@ extern DECLSPEC SDL_GrabMode SDLCALL SDL_WM_GrabInput(SDL_GrabMode mode);
 /** @internal Not in public API at the moment - do not use! */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                                     SDL_Surface *dst, SDL_Rect *dstrect);
+
+/** Filters understood by SDL_SoftStretchFiltered() */
+typedef enum {
+	SDL_STRETCH_NEAREST,	/**< Pixel replication, same as SDL_SoftStretch() */
+	SDL_STRETCH_BILINEAR,	/**< Interpolate between the four closest pixels */
+	SDL_STRETCH_BOX		/**< Average every covered pixel when shrinking */
+} SDL_StretchFilter;
+
+/**
+ * Perform a filtered stretch blit between two surfaces of the same depth.
+ * The bilinear and box filters work on 16 and 32 bits per pixel surfaces,
+ * other depths always use the nearest filter.  When enlarging, the box
+ * filter behaves like the nearest filter.
+ *
+ * @return 0 on success, or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFiltered(SDL_Surface *src, SDL_Rect *srcrect,
+                                    SDL_Surface *dst, SDL_Rect *dstrect,
+                                    SDL_StretchFilter filter);
+
+/** Filters understood by SDL_SoftUpscale() */
+typedef enum {
+	SDL_UPSCALE_NEAREST,	/**< Replicate each pixel factor x factor times */
+	SDL_UPSCALE_SCALEX	/**< Edge smoothing Scale2x/Scale3x (Scale4x is two Scale2x passes) */
+} SDL_UpscaleFilter;
+
+/**
+ * Enlarge a rectangle of one surface into another surface of the same
+ * depth by an integer factor.  This works on 8, 16 and 32 bits per pixel
+ * surfaces; the Scale2x/Scale3x filter supports factors 2, 3 and 4 and
+ * only compares pixels for equality, so it is safe to use on palettized
+ * surfaces.
+ *
+ * Only the position of 'dstrect' is used, on return its width and height
+ * are set to the size of the enlarged area.
+ *
+ * @return 0 on success, or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_SoftUpscale(SDL_Surface *src, SDL_Rect *srcrect,
+                                    SDL_Surface *dst, SDL_Rect *dstrect,
+                                    int factor, SDL_UpscaleFilter filter);
                     
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
@@ -35,8 +35,6 @@ static SDL_error SDL_global_error;
 extern SDL_error *SDL_GetErrBuf(void);
 #endif /* SDL_THREADS_DISABLED */
 
-#define SDL_ERRBUFIZE	1024
-
 /* Private functions */
 
 static const char *SDL_LookupString(const char *key)
@@ -186,9 +184,10 @@ char *SDL_GetErrorMsg(char *errstr, unsigned int maxlen)
 /* Available for backwards compatibility */
 char *SDL_GetError (void)
 {
-	static char errmsg[SDL_ERRBUFIZE];
+	SDL_error *error;
 
-	return((char *)SDL_GetErrorMsg(errmsg, SDL_ERRBUFIZE));
+	error = SDL_GetErrBuf();
+	return((char *)SDL_GetErrorMsg(error->msg, sizeof(error->msg)));
 }
 
 void SDL_ClearError(void)
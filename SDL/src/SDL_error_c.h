@@ -30,6 +30,7 @@
 
 #define ERR_MAX_STRLEN	128
 #define ERR_MAX_ARGS	5
+#define ERR_MAX_MSGLEN	1024
 
 typedef struct SDL_error {
 	/* This is a numeric value corresponding to the current error */
@@ -53,6 +54,9 @@ typedef struct SDL_error {
 		double value_f;
 		char buf[ERR_MAX_STRLEN];
 	} args[ERR_MAX_ARGS];
+
+	/* The message SDL_GetError() returns, so each thread has its own */
+	char msg[ERR_MAX_MSGLEN];
 } SDL_error;
 
 #endif /* _SDL_error_c_h */
@@ -193,7 +193,7 @@ int SDLCALL SDL_RunAudio(void *audiop)
 
 		SDL_memset(stream, silence, stream_len);
 
-		if ( ! audio->paused ) {
+		if ( ! SDL_AtomicGet(&audio->paused) ) {
 			SDL_mutexP(audio->mixer_lock);
 			(*fill)(udata, stream, stream_len);
 			SDL_mutexV(audio->mixer_lock);
@@ -493,7 +493,7 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 	SDL_memcpy(&audio->spec, desired, sizeof(audio->spec));
 	audio->convert.needed = 0;
 	audio->enabled = 1;
-	audio->paused  = 1;
+	SDL_AtomicSet(&audio->paused, 1);
 
 	audio->opened = audio->OpenAudio(audio, &audio->spec)+1;
 
@@ -576,7 +576,7 @@ SDL_audiostatus SDL_GetAudioStatus(void)
 
 	status = SDL_AUDIO_STOPPED;
 	if ( audio && audio->enabled ) {
-		if ( audio->paused ) {
+		if ( SDL_AtomicGet(&audio->paused) ) {
 			status = SDL_AUDIO_PAUSED;
 		} else {
 			status = SDL_AUDIO_PLAYING;
@@ -590,7 +590,7 @@ void SDL_PauseAudio (int pause_on)
 	SDL_AudioDevice *audio = current_audio;
 
 	if ( audio ) {
-		audio->paused = pause_on;
+		SDL_AtomicSet(&audio->paused, pause_on);
 	}
 }
 
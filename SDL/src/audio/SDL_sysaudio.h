@@ -24,6 +24,7 @@
 #ifndef _SDL_sysaudio_h
 #define _SDL_sysaudio_h
 
+#include "SDL_atomic.h"
 #include "SDL_mutex.h"
 #include "SDL_thread.h"
 
@@ -72,7 +73,7 @@ struct SDL_AudioDevice {
 
 	/* Current state flags */
 	int enabled;
-	int paused;
+	SDL_atomic_t paused;	/* Changed by SDL_PauseAudio() while playing */
 	int opened;
 
 	/* Fake audio buffer for when the audio hardware is busy */
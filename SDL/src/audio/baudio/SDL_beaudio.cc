@@ -106,7 +106,7 @@ static void FillSound(void *device, void *stream, size_t len,
 	if ( ! audio->enabled )
 		return;
 
-	if ( ! audio->paused ) {
+	if ( ! SDL_AtomicGet(&audio->paused) ) {
 		if ( audio->convert.needed ) {
 			SDL_mutexP(audio->mixer_lock);
 			(*audio->spec.callback)(audio->spec.userdata,
@@ -107,7 +107,7 @@ static OSStatus     audioCallback (void                            *inRefCon,
     UInt32 i;
 
     /* Only do anything if audio is enabled and not paused */
-    if ( ! this->enabled || this->paused ) {
+    if ( ! this->enabled || SDL_AtomicGet(&this->paused) ) {
         for (i = 0; i < ioData->mNumberBuffers; i++) {
             abuf = &ioData->mBuffers[i];
             SDL_memset(abuf->mData, this->spec.silence, abuf->mDataByteSize);
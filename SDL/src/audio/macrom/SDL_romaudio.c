@@ -120,7 +120,7 @@ static volatile Uint32 fill_me = 0;
 
 static void mix_buffer(SDL_AudioDevice *audio, UInt8 *buffer)
 {
-   if ( ! audio->paused ) {
+   if ( ! SDL_AtomicGet(&audio->paused) ) {
 #ifdef __MACOSX__
         SDL_mutexP(audio->mixer_lock);
 #endif
@@ -341,7 +341,7 @@ void sndDoubleBackProc (SndChannelPtr chan, SndDoubleBufferPtr newbuf)
     }
     memset (newbuf->dbSoundData, 0, audio->spec.size);
     newbuf->dbNumFrames = audio->spec.samples;
-    if ( ! audio->paused ) {
+    if ( ! SDL_AtomicGet(&audio->paused) ) {
         if ( audio->convert.needed ) {
             audio->spec.callback(audio->spec.userdata,
                 (Uint8 *)audio->convert.buf,audio->convert.len);
@@ -26,12 +26,27 @@
 #include "SDL.h"
 #include "SDL_cpuinfo.h"
 
-#if defined(__MACOSX__) && (defined(__ppc__) || defined(__ppc64__))
-#include <sys/sysctl.h> /* For AltiVec check */
+#if defined(__MACOSX__)
+#include <sys/types.h>
+#include <sys/sysctl.h> /* For AltiVec check and the processor counts */
 #elif SDL_ALTIVEC_BLITTERS && HAVE_SETJMP
 #include <signal.h>
 #include <setjmp.h>
 #endif
+#if defined(__WIN32__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__LINUX__)
+#include <stdio.h>	/* For reading /sys/devices/system/cpu */
+#include <unistd.h>
+#elif defined(__unix__) || defined(__IRIX__)
+#include <unistd.h>
+#endif
+#if defined(_MSC_VER) && (_MSC_VER >= 1600) && \
+    (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>	/* For __cpuidex() and _xgetbv() */
+#define HAVE_MSC_CPUID	1
+#endif
 
 #define CPU_HAS_RDTSC	0x00000001
 #define CPU_HAS_MMX	0x00000002
@@ -41,6 +56,16 @@
 #define CPU_HAS_SSE	0x00000040
 #define CPU_HAS_SSE2	0x00000080
 #define CPU_HAS_ALTIVEC	0x00000100
+#define CPU_HAS_SSE3	0x00000200
+#define CPU_HAS_SSSE3	0x00000400
+#define CPU_HAS_SSE41	0x00000800
+#define CPU_HAS_SSE42	0x00001000
+#define CPU_HAS_AVX	0x00002000
+#define CPU_HAS_AVX2	0x00004000
+#define CPU_HAS_AVX512F	0x00008000
+
+/* A guess at the cache line size, if the system won't tell */
+#define SDL_CACHELINE_SIZE	128
 
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__
 /* This is the brute force way of detecting instruction sets...
@@ -381,6 +406,144 @@ static __inline__ int CPU_haveAltiVec(void)
 	return altivec; 
 }
 
+/* Run CPUID with any function and subfunction, setting regs to EAX, EBX,
+   ECX and EDX.  The caller checks that there is a CPUID instruction and
+   that it knows the function.
+*/
+static __inline__ void CPU_getCPUID(Uint32 func, Uint32 subfunc, Uint32 regs[4])
+{
+	regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#if defined(__GNUC__) && defined(__x86_64__)
+	__asm__ __volatile__ (
+"        cpuid                                                         \n"
+	: "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+	: "0" (func), "2" (subfunc)
+	);
+#elif defined(__GNUC__) && defined(i386)
+	/* EBX may hold the PIC register, so it's swapped out of the way */
+	__asm__ __volatile__ (
+"        xchgl   %%ebx,%1                                              \n"
+"        cpuid                                                         \n"
+"        xchgl   %%ebx,%1                                              \n"
+	: "=a" (regs[0]), "=&r" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+	: "0" (func), "2" (subfunc)
+	);
+#elif HAVE_MSC_CPUID
+	__cpuidex((int *)regs, (int)func, (int)subfunc);
+#endif
+}
+
+/* The highest CPUID function, or 0 if there's no CPUID instruction */
+static __inline__ Uint32 CPU_getCPUIDMax(Uint32 base)
+{
+	Uint32 regs[4];
+
+	if ( ! CPU_haveCPUID() ) {
+		return 0;
+	}
+	CPU_getCPUID(base, 0, regs);
+	if ( regs[0] < base ) {
+		return 0;
+	}
+	return regs[0];
+}
+
+/* The feature bits CPUID function 1 returns in ECX */
+static __inline__ Uint32 CPU_getCPUIDFeaturesECX(void)
+{
+	Uint32 regs[4];
+
+	if ( CPU_getCPUIDMax(0) < 1 ) {
+		return 0;
+	}
+	CPU_getCPUID(1, 0, regs);
+	return regs[2];
+}
+
+/* The feature bits CPUID function 7 returns in EBX */
+static __inline__ Uint32 CPU_getCPUIDFeatures7(void)
+{
+	Uint32 regs[4];
+
+	if ( CPU_getCPUIDMax(0) < 7 ) {
+		return 0;
+	}
+	CPU_getCPUID(7, 0, regs);
+	return regs[1];
+}
+
+/* The register state the OS saves on a task switch, from XGETBV.  The
+   AVX registers can't be used unless it saves them, whatever CPUID says.
+*/
+static __inline__ Uint32 CPU_getOSRegisterState(void)
+{
+	Uint32 xcr0 = 0;
+
+	/* OSXSAVE says the OS turned on XGETBV */
+	if ( !(CPU_getCPUIDFeaturesECX() & 0x08000000) ) {
+		return 0;
+	}
+#if defined(__GNUC__) && (defined(i386) || defined(__x86_64__))
+	{
+		Uint32 edx;
+		__asm__ __volatile__ (
+"        .byte   0x0f,0x01,0xd0      # xgetbv, for old assemblers      \n"
+		: "=a" (xcr0), "=d" (edx)
+		: "c" (0)
+		);
+	}
+#elif HAVE_MSC_CPUID
+	xcr0 = (Uint32)_xgetbv(0);
+#endif
+	return xcr0;
+}
+
+static __inline__ int CPU_haveSSE3(void)
+{
+	return (CPU_getCPUIDFeaturesECX() & 0x00000001);
+}
+
+static __inline__ int CPU_haveSSSE3(void)
+{
+	return (CPU_getCPUIDFeaturesECX() & 0x00000200);
+}
+
+static __inline__ int CPU_haveSSE41(void)
+{
+	return (CPU_getCPUIDFeaturesECX() & 0x00080000);
+}
+
+static __inline__ int CPU_haveSSE42(void)
+{
+	return (CPU_getCPUIDFeaturesECX() & 0x00100000);
+}
+
+static __inline__ int CPU_haveAVX(void)
+{
+	/* The OS has to save the XMM and YMM registers */
+	if ( (CPU_getOSRegisterState() & 0x06) != 0x06 ) {
+		return 0;
+	}
+	return (CPU_getCPUIDFeaturesECX() & 0x10000000);
+}
+
+static __inline__ int CPU_haveAVX2(void)
+{
+	if ( ! CPU_haveAVX() ) {
+		return 0;
+	}
+	return (CPU_getCPUIDFeatures7() & 0x00000020);
+}
+
+static __inline__ int CPU_haveAVX512F(void)
+{
+	/* ... and the opmask and ZMM registers too */
+	if ( (CPU_getOSRegisterState() & 0xE6) != 0xE6 ) {
+		return 0;
+	}
+	return (CPU_getCPUIDFeatures7() & 0x00010000);
+}
+
 static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
 
 static Uint32 SDL_GetCPUFeatures(void)
@@ -411,6 +574,27 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveAltiVec() ) {
 			SDL_CPUFeatures |= CPU_HAS_ALTIVEC;
 		}
+		if ( CPU_haveSSE3() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSE3;
+		}
+		if ( CPU_haveSSSE3() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSSE3;
+		}
+		if ( CPU_haveSSE41() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSE41;
+		}
+		if ( CPU_haveSSE42() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSE42;
+		}
+		if ( CPU_haveAVX() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX;
+		}
+		if ( CPU_haveAVX2() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX2;
+		}
+		if ( CPU_haveAVX512F() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX512F;
+		}
 	}
 	return SDL_CPUFeatures;
 }
@@ -479,6 +663,358 @@ SDL_bool SDL_HasAltiVec(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSSE3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSE41(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE41 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSE42(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE42 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX2(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX2 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX512F(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX512F ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+/* The processor counts and caches, filled in the first time they're asked
+   for.  Cache sizes are indexed by level, and 0 when not known.
+*/
+static int SDL_CPUCount = 0;
+static int SDL_CPUCoreCount = 0;
+static int SDL_CPUCacheLineSize = 0;
+static int SDL_CPUCacheSizes[4];
+
+#if defined(__LINUX__)
+/* Read the first line of a file under /sys/devices/system/cpu */
+static int CPU_readSysFile(const char *fmt, int cpu, int index,
+                           char *line, int maxlen)
+{
+	char path[128];
+	FILE *fp;
+	int found = 0;
+
+	SDL_snprintf(path, sizeof(path), fmt, cpu, index);
+	fp = fopen(path, "r");
+	if ( fp ) {
+		found = (fgets(line, maxlen, fp) != NULL);
+		fclose(fp);
+	}
+	return found;
+}
+
+/* ... and the number at the start of it, which may be in K or M */
+static int CPU_readSysNumber(const char *fmt, int cpu, int index)
+{
+	char line[64];
+	char *end;
+	int value;
+
+	if ( !CPU_readSysFile(fmt, cpu, index, line, sizeof(line)) ||
+	     line[0] < '0' || line[0] > '9' ) {
+		return -1;
+	}
+	value = (int)SDL_strtol(line, &end, 10);
+	if ( *end == 'K' ) {
+		value *= 1024;
+	} else if ( *end == 'M' ) {
+		value *= 1024*1024;
+	}
+	return value;
+}
+#endif
+
+static void CPU_calcCPUCount(void)
+{
+#if defined(__WIN32__)
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	SDL_CPUCount = (int)info.dwNumberOfProcessors;
+#elif defined(__MACOSX__)
+	size_t size = sizeof(SDL_CPUCount);
+	if ( sysctlbyname("hw.logicalcpu", &SDL_CPUCount, &size, NULL, 0) < 0 ) {
+		SDL_CPUCount = 0;
+	}
+#elif defined(__IRIX__)
+	SDL_CPUCount = (int)sysconf(_SC_NPROC_ONLN);
+#elif defined(_SC_NPROCESSORS_ONLN)
+	/* number of processors online (SVR4.0MP compliant machines) */
+	SDL_CPUCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(_SC_NPROCESSORS_CONF)
+	/* number of processors configured (SVR4.0MP compliant machines) */
+	SDL_CPUCount = (int)sysconf(_SC_NPROCESSORS_CONF);
+#endif
+	if ( SDL_CPUCount <= 0 ) {
+		SDL_CPUCount = 1;
+	}
+}
+
+static void CPU_calcCPUCoreCount(void)
+{
+	int cores = 0;
+#if defined(__LINUX__)
+	int cpu;
+
+	/* Count each core once, as the first processor that shares it */
+	for ( cpu = 0; cpu < SDL_GetCPUCount(); ++cpu ) {
+		int first = CPU_readSysNumber(
+			"/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+			cpu, 0);
+		if ( first < 0 ) {
+			cores = 0;
+			break;
+		}
+		if ( first == cpu ) {
+			++cores;
+		}
+	}
+#elif defined(__MACOSX__)
+	size_t size = sizeof(cores);
+	if ( sysctlbyname("hw.physicalcpu", &cores, &size, NULL, 0) < 0 ) {
+		cores = 0;
+	}
+#elif defined(__WIN32__) && defined(_MSC_VER) && (_MSC_VER >= 1500)
+	/* Not there before XP SP3 */
+	typedef BOOL (WINAPI *GetLPIFunc)(PSYSTEM_LOGICAL_PROCESSOR_INFORMATION, PDWORD);
+	GetLPIFunc getLPI;
+	PSYSTEM_LOGICAL_PROCESSOR_INFORMATION info;
+	DWORD size = 0, i;
+
+	getLPI = (GetLPIFunc)GetProcAddress(GetModuleHandle(TEXT("kernel32")),
+	                                    "GetLogicalProcessorInformation");
+	if ( getLPI && !getLPI(NULL, &size) &&
+	     GetLastError() == ERROR_INSUFFICIENT_BUFFER ) {
+		info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION)SDL_malloc(size);
+		if ( info && getLPI(info, &size) ) {
+			for ( i = 0; i < size / sizeof(*info); ++i ) {
+				if ( info[i].Relationship == RelationProcessorCore ) {
+					++cores;
+				}
+			}
+		}
+		SDL_free(info);
+	}
+#endif
+	if ( cores <= 0 || cores > SDL_GetCPUCount() ) {
+		cores = SDL_GetCPUCount();
+	}
+	SDL_CPUCoreCount = cores;
+}
+
+/* Read the caches from the CPUID functions that describe them, which
+   Intel has as function 4 and AMD as 0x8000001D, or the older AMD ones
+*/
+static void CPU_calcCPUIDCaches(void)
+{
+	Uint32 regs[4];
+	Uint32 func = 0, extmax, i;
+	int type, level, line, size;
+
+	CPU_getCPUID(0, 0, regs);
+	extmax = CPU_getCPUIDMax(0x80000000);
+	if ( regs[1] == 0x756e6547 /* "Genu" */ &&
+	     CPU_getCPUIDMax(0) >= 4 ) {
+		func = 4;
+	} else if ( extmax >= 0x8000001D ) {
+		CPU_getCPUID(0x80000001, 0, regs);
+		if ( regs[2] & 0x00400000 ) {	/* Topology extensions */
+			func = 0x8000001D;
+		}
+	}
+
+	if ( func ) {
+		for ( i = 0; i < 16; ++i ) {
+			CPU_getCPUID(func, i, regs);
+			type = (regs[0] & 0x1F);
+			if ( type == 0 ) {
+				break;
+			}
+			if ( type == 2 ) {
+				continue;	/* Instruction cache */
+			}
+			level = ((regs[0] >> 5) & 0x7);
+			line = (regs[1] & 0xFFF) + 1;
+			size = (int)(((regs[1] >> 22) + 1) *
+			             (((regs[1] >> 12) & 0x3FF) + 1) *
+			             line * (regs[2] + 1));
+			if ( level >= 1 && level <= 3 ) {
+				SDL_CPUCacheSizes[level] = size;
+			}
+			if ( level == 1 ) {
+				SDL_CPUCacheLineSize = line;
+			}
+		}
+	} else if ( extmax >= 0x80000006 ) {
+		CPU_getCPUID(0x80000005, 0, regs);
+		SDL_CPUCacheSizes[1] = (int)(regs[2] >> 24) * 1024;
+		SDL_CPUCacheLineSize = (int)(regs[2] & 0xFF);
+		CPU_getCPUID(0x80000006, 0, regs);
+		SDL_CPUCacheSizes[2] = (int)(regs[2] >> 16) * 1024;
+		SDL_CPUCacheSizes[3] = (int)(regs[3] >> 18) * 512 * 1024;
+	}
+
+	/* The CLFLUSH line size is there on nearly everything */
+	if ( !SDL_CPUCacheLineSize && CPU_getCPUIDMax(0) >= 1 ) {
+		CPU_getCPUID(1, 0, regs);
+		if ( regs[3] & 0x00080000 ) {
+			SDL_CPUCacheLineSize = (int)((regs[1] >> 8) & 0xFF) * 8;
+		}
+	}
+}
+
+static void CPU_calcCaches(void)
+{
+	int level;
+
+	if ( CPU_getCPUIDMax(0) ) {
+		CPU_calcCPUIDCaches();
+	}
+#if defined(__LINUX__)
+	/* Other processors, or x86 ones that don't describe their caches */
+	if ( !SDL_CPUCacheSizes[1] ) {
+		char type[32];
+		int index;
+
+		for ( index = 0; index < 16; ++index ) {
+			level = CPU_readSysNumber(
+			    "/sys/devices/system/cpu/cpu%d/cache/index%d/level",
+			    0, index);
+			if ( level < 0 ) {
+				break;
+			}
+			if ( !CPU_readSysFile(
+			    "/sys/devices/system/cpu/cpu%d/cache/index%d/type",
+			    0, index, type, sizeof(type)) ||
+			     SDL_strncmp(type, "Instruction", 11) == 0 ) {
+				continue;
+			}
+			if ( level >= 1 && level <= 3 ) {
+				SDL_CPUCacheSizes[level] = CPU_readSysNumber(
+				    "/sys/devices/system/cpu/cpu%d/cache/index%d/size",
+				    0, index);
+			}
+			if ( level == 1 && !SDL_CPUCacheLineSize ) {
+				SDL_CPUCacheLineSize = CPU_readSysNumber(
+				    "/sys/devices/system/cpu/cpu%d/cache/index%d/coherency_line_size",
+				    0, index);
+			}
+		}
+	}
+#elif defined(__MACOSX__)
+	{
+		static const char *names[4] = {
+			"hw.cachelinesize", "hw.l1dcachesize",
+			"hw.l2cachesize", "hw.l3cachesize"
+		};
+		Sint64 value;
+		size_t size;
+		int i;
+
+		for ( i = 0; i < 4; ++i ) {
+			value = 0;
+			size = sizeof(value);
+			if ( sysctlbyname(names[i], &value, &size, NULL, 0) < 0 ) {
+				continue;
+			}
+			if ( size == sizeof(int) ) {	/* Older systems */
+				value = *(int *)&value;
+			}
+			if ( i == 0 ) {
+				SDL_CPUCacheLineSize = (int)value;
+			} else {
+				SDL_CPUCacheSizes[i] = (int)value;
+			}
+		}
+	}
+#endif
+	for ( level = 1; level <= 3; ++level ) {
+		if ( SDL_CPUCacheSizes[level] < 0 ) {
+			SDL_CPUCacheSizes[level] = 0;
+		}
+	}
+	if ( SDL_CPUCacheLineSize <= 0 ) {
+		SDL_CPUCacheLineSize = SDL_CACHELINE_SIZE;
+	}
+}
+
+int SDL_GetCPUCount(void)
+{
+	if ( !SDL_CPUCount ) {
+		CPU_calcCPUCount();
+	}
+	return SDL_CPUCount;
+}
+
+int SDL_GetCPUCoreCount(void)
+{
+	if ( !SDL_CPUCoreCount ) {
+		CPU_calcCPUCoreCount();
+	}
+	return SDL_CPUCoreCount;
+}
+
+int SDL_GetCPUCacheLineSize(void)
+{
+	if ( !SDL_CPUCacheLineSize ) {
+		CPU_calcCaches();
+	}
+	return SDL_CPUCacheLineSize;
+}
+
+int SDL_GetCPUCacheSize(int level)
+{
+	if ( level < 1 || level > 3 ) {
+		return 0;
+	}
+	if ( !SDL_CPUCacheLineSize ) {
+		CPU_calcCaches();
+	}
+	return SDL_CPUCacheSizes[level];
+}
+
 #ifdef TEST_MAIN
 
 #include <stdio.h>
@@ -493,6 +1029,18 @@ int main()
 	printf("SSE: %d\n", SDL_HasSSE());
 	printf("SSE2: %d\n", SDL_HasSSE2());
 	printf("AltiVec: %d\n", SDL_HasAltiVec());
+	printf("SSE3: %d\n", SDL_HasSSE3());
+	printf("SSSE3: %d\n", SDL_HasSSSE3());
+	printf("SSE4.1: %d\n", SDL_HasSSE41());
+	printf("SSE4.2: %d\n", SDL_HasSSE42());
+	printf("AVX: %d\n", SDL_HasAVX());
+	printf("AVX2: %d\n", SDL_HasAVX2());
+	printf("AVX-512F: %d\n", SDL_HasAVX512F());
+	printf("Processors: %d\n", SDL_GetCPUCount());
+	printf("Cores: %d\n", SDL_GetCPUCoreCount());
+	printf("Cache line: %d\n", SDL_GetCPUCacheLineSize());
+	printf("L1/L2/L3 caches: %d/%d/%d\n", SDL_GetCPUCacheSize(1),
+	       SDL_GetCPUCacheSize(2), SDL_GetCPUCacheSize(3));
 	return 0;
 }
 
@@ -28,10 +28,24 @@
 #include "SDL_sysevents.h"
 #include "SDL_events_c.h"
 #include "../timer/SDL_timer_c.h"
+#include "../video/SDL_cursor_c.h"
 #if !SDL_JOYSTICK_DISABLED
 #include "../joystick/SDL_joystick_c.h"
 #endif
 
+#if SDL_EVENT_FDS
+#include <sys/types.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__LINUX__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 8))
+#include <sys/eventfd.h>
+#define HAVE_EVENTFD	1
+#endif
+#endif
+
 /* Public data -- the event filter */
 SDL_EventFilter SDL_EventOK = NULL;
 Uint8 SDL_ProcessEvents[SDL_NUMEVENTS];
@@ -41,41 +55,233 @@ static Uint32 SDL_eventstate = 0;
 #define MAXEVENTS	128
 static struct {
 	SDL_mutex *lock;
-	int active;
+	SDL_cond *added;	/* Signaled when events are added */
+	int waiting;		/* Threads waiting for the signal */
+	SDL_atomic_t driver_waiting;	/* In the driver's WaitEvents() */
+	SDL_atomic_t active;
 	int head;
 	int tail;
+	SDL_atomic_t count;	/* Events queued, can be read without the lock */
 	SDL_Event event[MAXEVENTS];
 	int wmmsg_next;
 	struct SDL_SysWMmsg wmmsg[MAXEVENTS];
 } SDL_EventQ;
 
-/* Private data -- event locking structure */
+/* Private data -- event locking structure
+   The event thread clears 'safe' before it touches the display and sets
+   it again when it's done, and other threads count themselves in
+   'requests' while they want it.  Each side looks at the other's flag
+   after setting its own, so they never both go ahead, and the mutex and
+   condition are only used when one of them has to wait for the other.
+ */
 static struct {
-	SDL_mutex *lock;
-	int safe;
+	SDL_mutex *lock;	/* Held by the thread that has the display */
+	SDL_mutex *wait_lock;
+	SDL_cond *wait_cond;	/* Signaled when 'safe' or 'requests' drop */
+	SDL_atomic_t safe;
+	SDL_atomic_t requests;
 } SDL_EventLock;
 
 /* Thread functions */
 static SDL_Thread *SDL_EventThread = NULL;	/* Thread handle */
 static Uint32 event_thread;			/* The event thread id */
 
+/* How long SDL_WaitEvent() sleeps between pumps when the driver can't
+   wait for its events */
+#define PUMP_INTERVAL	10
+
+#if SDL_EVENT_FDS
+/* An eventfd, or a pipe, written to wake up the thread waiting for the
+   driver's events */
+static int SDL_wakeup_fds[2] = { -1, -1 };
+
+static void SDL_OpenEventWakeup(void)
+{
+	int i;
+
+#if HAVE_EVENTFD
+	/* One descriptor and no buffer to fill up, if the kernel has them */
+	SDL_wakeup_fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if ( SDL_wakeup_fds[0] >= 0 ) {
+		SDL_wakeup_fds[1] = SDL_wakeup_fds[0];
+		return;
+	}
+#endif
+	if ( pipe(SDL_wakeup_fds) < 0 ) {
+		SDL_wakeup_fds[0] = SDL_wakeup_fds[1] = -1;
+		return;
+	}
+	for ( i = 0; i < 2; ++i ) {
+		fcntl(SDL_wakeup_fds[i], F_SETFL,
+		      fcntl(SDL_wakeup_fds[i], F_GETFL) | O_NONBLOCK);
+		fcntl(SDL_wakeup_fds[i], F_SETFD, FD_CLOEXEC);
+	}
+}
+
+static void SDL_CloseEventWakeup(void)
+{
+	if ( SDL_wakeup_fds[0] >= 0 ) {
+		close(SDL_wakeup_fds[0]);
+		if ( SDL_wakeup_fds[1] != SDL_wakeup_fds[0] ) {
+			close(SDL_wakeup_fds[1]);
+		}
+		SDL_wakeup_fds[0] = SDL_wakeup_fds[1] = -1;
+	}
+}
+
+void SDL_SendEventWakeup(void)
+{
+	Uint64 one = 1;
+	size_t size;
+
+	if ( SDL_wakeup_fds[1] >= 0 ) {
+		/* An eventfd takes an 8 byte count, a pipe takes anything */
+		if ( SDL_wakeup_fds[1] == SDL_wakeup_fds[0] ) {
+			size = sizeof(one);
+		} else {
+			size = 1;
+		}
+		/* If the pipe is full a wakeup is pending anyway */
+		if ( write(SDL_wakeup_fds[1], &one, size) < 0 ) {
+			return;
+		}
+	}
+}
+
+void SDL_WaitEventFDs(const int *fds, int numfds, int timeout)
+{
+	fd_set fdset;
+	struct timeval tv;
+	int i, max_fd;
+	char buf[64];
+
+	FD_ZERO(&fdset);
+	max_fd = -1;
+	for ( i = 0; i < numfds; ++i ) {
+		if ( fds[i] >= 0 ) {
+			FD_SET(fds[i], &fdset);
+			if ( max_fd < fds[i] ) {
+				max_fd = fds[i];
+			}
+		}
+	}
+	if ( SDL_wakeup_fds[0] >= 0 ) {
+		FD_SET(SDL_wakeup_fds[0], &fdset);
+		if ( max_fd < SDL_wakeup_fds[0] ) {
+			max_fd = SDL_wakeup_fds[0];
+		}
+	}
+	if ( max_fd < 0 ) {
+		/* Nothing to wait for, so don't wait forever */
+		if ( timeout < 0 || timeout > PUMP_INTERVAL ) {
+			timeout = PUMP_INTERVAL;
+		}
+	}
+	tv.tv_sec = timeout / 1000;
+	tv.tv_usec = (timeout % 1000) * 1000;
+	if ( select(max_fd+1, &fdset, NULL, NULL,
+	            timeout < 0 ? NULL : &tv) > 0 &&
+	     SDL_wakeup_fds[0] >= 0 && FD_ISSET(SDL_wakeup_fds[0], &fdset) ) {
+		while ( read(SDL_wakeup_fds[0], buf, sizeof(buf)) > 0 ) {
+			/* Drain all the wakeups */ ;
+		}
+	}
+}
+#else
+void SDL_SendEventWakeup(void)
+{
+}
+#endif /* SDL_EVENT_FDS */
+
+/* The shorter of two timeouts, where a negative one is forever */
+static int SDL_MinTimeout(int a, int b)
+{
+	if ( a < 0 ) {
+		return(b);
+	}
+	if ( b < 0 || a < b ) {
+		return(a);
+	}
+	return(b);
+}
+
+/* How long until the event loop needs pumping for anything but events:
+   key repeat, or joysticks that can only be polled */
+static int SDL_PumpTimeout(void)
+{
+	int timeout = SDL_KeyRepeatTimeout();
+
+#if !SDL_JOYSTICK_DISABLED
+	if ( SDL_numjoysticks && (SDL_eventstate & SDL_JOYEVENTMASK) ) {
+		timeout = SDL_MinTimeout(timeout, PUMP_INTERVAL);
+	}
+#endif
+	return(timeout);
+}
+
 void SDL_Lock_EventThread(void)
 {
 	if ( SDL_EventThread && (SDL_ThreadID() != event_thread) ) {
-		/* Grab lock and spin until we're sure event thread stopped */
+		/* Only one other thread at a time asks for the display */
 		SDL_mutexP(SDL_EventLock.lock);
-		while ( ! SDL_EventLock.safe ) {
-			SDL_Delay(1);
+		SDL_AtomicIncRef(&SDL_EventLock.requests);
+		if ( ! SDL_AtomicGet(&SDL_EventLock.safe) ) {
+			/* Get it out of waiting for events, and wait for it
+			   to finish with the display */
+			SDL_SendEventWakeup();
+			SDL_mutexP(SDL_EventLock.wait_lock);
+			while ( ! SDL_AtomicGet(&SDL_EventLock.safe) ) {
+				SDL_CondWait(SDL_EventLock.wait_cond,
+				             SDL_EventLock.wait_lock);
+			}
+			SDL_mutexV(SDL_EventLock.wait_lock);
 		}
 	}
 }
 void SDL_Unlock_EventThread(void)
 {
 	if ( SDL_EventThread && (SDL_ThreadID() != event_thread) ) {
+		if ( SDL_AtomicDecRef(&SDL_EventLock.requests) ) {
+			/* The event thread may be waiting for us */
+			SDL_mutexP(SDL_EventLock.wait_lock);
+			SDL_CondBroadcast(SDL_EventLock.wait_cond);
+			SDL_mutexV(SDL_EventLock.wait_lock);
+		}
 		SDL_mutexV(SDL_EventLock.lock);
 	}
 }
 
+/* The event thread is done with the display for now */
+static void SDL_LeaveEventThreadUnsafe(void)
+{
+	SDL_AtomicSet(&SDL_EventLock.safe, 1);
+	if ( SDL_AtomicGet(&SDL_EventLock.requests) ) {
+		SDL_mutexP(SDL_EventLock.wait_lock);
+		SDL_CondBroadcast(SDL_EventLock.wait_cond);
+		SDL_mutexV(SDL_EventLock.wait_lock);
+	}
+}
+
+/* The event thread wants the display, once no other thread has it */
+static void SDL_EnterEventThreadUnsafe(void)
+{
+	while ( 1 ) {
+		SDL_AtomicSet(&SDL_EventLock.safe, 0);
+		if ( ! SDL_AtomicGet(&SDL_EventLock.requests) ) {
+			return;
+		}
+
+		/* Back off and wait for the other threads to finish */
+		SDL_LeaveEventThreadUnsafe();
+		SDL_mutexP(SDL_EventLock.wait_lock);
+		while ( SDL_AtomicGet(&SDL_EventLock.requests) ) {
+			SDL_CondWait(SDL_EventLock.wait_cond,
+			             SDL_EventLock.wait_lock);
+		}
+		SDL_mutexV(SDL_EventLock.wait_lock);
+	}
+}
+
 #ifdef __OS2__
 /*
  * We'll increase the priority of GobbleEvents thread, so it will process
@@ -98,9 +304,15 @@ static int SDLCALL SDL_GobbleEvents(void *unused)
 #endif
 #endif
 
-	while ( SDL_EventQ.active ) {
+	SDL_EnterEventThreadUnsafe();
+	while ( SDL_AtomicGet(&SDL_EventQ.active) ) {
 		SDL_VideoDevice *video = current_video;
 		SDL_VideoDevice *this  = current_video;
+		int timeout;
+
+		/* Move the software cursor if the screen hasn't been updated
+		   since the mouse moved */
+		SDL_FlushCursorMotion();
 
 		/* Get events from the video subsystem */
 		if ( video ) {
@@ -117,25 +329,30 @@ static int SDLCALL SDL_GobbleEvents(void *unused)
 		}
 #endif
 
-		/* Give up the CPU for the rest of our timeslice */
-		SDL_EventLock.safe = 1;
+		/* Let the other threads at the display while the timers run */
+		SDL_LeaveEventThreadUnsafe();
+		timeout = SDL_PumpTimeout();
 		if ( SDL_timer_running ) {
 			SDL_ThreadedTimerCheck();
+			timeout = SDL_MinTimeout(timeout,
+			                         SDL_ThreadedTimerTimeout());
 		}
-		SDL_Delay(1);
 
-		/* Check for event locking.
-		   On the P of the lock mutex, if the lock is held, this thread
-		   will wait until the lock is released before continuing.  The
-		   safe flag will be set, meaning that the other thread can go
-		   about it's business.  The safe flag is reset before the V,
-		   so as soon as the mutex is free, other threads can see that
-		   it's not safe to interfere with the event thread.
-		 */
-		SDL_mutexP(SDL_EventLock.lock);
-		SDL_EventLock.safe = 0;
-		SDL_mutexV(SDL_EventLock.lock);
+		if ( video && video->WaitEvents ) {
+			/* Sleep until there are events, the next timer is due
+			   or another thread wants the display, which wakes us
+			   up with SDL_SendEventWakeup() */
+			SDL_EnterEventThreadUnsafe();
+			if ( SDL_AtomicGet(&SDL_EventQ.active) ) {
+				video->WaitEvents(this, timeout);
+			}
+		} else {
+			/* The driver has to be polled */
+			SDL_Delay(1);
+			SDL_EnterEventThreadUnsafe();
+		}
 	}
+	SDL_LeaveEventThreadUnsafe();
 	SDL_SetTimerThreaded(0);
 	event_thread = 0;
 	return(0);
@@ -157,15 +374,24 @@ static int SDL_StartEventThread(Uint32 flags)
 		return(-1);
 #endif
 	}
+	/* Without it SDL_WaitEvent() has to poll for added events */
+	SDL_EventQ.added = SDL_CreateCond();
+	SDL_EventQ.waiting = 0;
 #endif /* !SDL_THREADS_DISABLED */
-	SDL_EventQ.active = 1;
+	SDL_AtomicSet(&SDL_EventQ.driver_waiting, 0);
+	SDL_AtomicSet(&SDL_EventQ.active, 1);
 
 	if ( (flags&SDL_INIT_EVENTTHREAD) == SDL_INIT_EVENTTHREAD ) {
 		SDL_EventLock.lock = SDL_CreateMutex();
-		if ( SDL_EventLock.lock == NULL ) {
+		SDL_EventLock.wait_lock = SDL_CreateMutex();
+		SDL_EventLock.wait_cond = SDL_CreateCond();
+		if ( SDL_EventLock.lock == NULL ||
+		     SDL_EventLock.wait_lock == NULL ||
+		     SDL_EventLock.wait_cond == NULL ) {
 			return(-1);
 		}
-		SDL_EventLock.safe = 0;
+		SDL_AtomicSet(&SDL_EventLock.safe, 0);
+		SDL_AtomicSet(&SDL_EventLock.requests, 0);
 
 		/* The event thread will handle timers too */
 		SDL_SetTimerThreaded(2);
@@ -186,17 +412,32 @@ static int SDL_StartEventThread(Uint32 flags)
 
 static void SDL_StopEventThread(void)
 {
-	SDL_EventQ.active = 0;
+	SDL_AtomicSet(&SDL_EventQ.active, 0);
 	if ( SDL_EventThread ) {
+		SDL_SendEventWakeup();
 		SDL_WaitThread(SDL_EventThread, NULL);
 		SDL_EventThread = NULL;
+	}
+	if ( SDL_EventLock.lock ) {
 		SDL_DestroyMutex(SDL_EventLock.lock);
 		SDL_EventLock.lock = NULL;
 	}
+	if ( SDL_EventLock.wait_lock ) {
+		SDL_DestroyMutex(SDL_EventLock.wait_lock);
+		SDL_EventLock.wait_lock = NULL;
+	}
+	if ( SDL_EventLock.wait_cond ) {
+		SDL_DestroyCond(SDL_EventLock.wait_cond);
+		SDL_EventLock.wait_cond = NULL;
+	}
 #ifndef IPOD
 	SDL_DestroyMutex(SDL_EventQ.lock);
 	SDL_EventQ.lock = NULL;
 #endif
+	if ( SDL_EventQ.added ) {
+		SDL_DestroyCond(SDL_EventQ.added);
+		SDL_EventQ.added = NULL;
+	}
 }
 
 Uint32 SDL_EventThreadID(void)
@@ -217,9 +458,14 @@ void SDL_StopEventLoop(void)
 	SDL_MouseQuit();
 	SDL_QuitQuit();
 
+#if SDL_EVENT_FDS
+	SDL_CloseEventWakeup();
+#endif
+
 	/* Clean out EventQ */
 	SDL_EventQ.head = 0;
 	SDL_EventQ.tail = 0;
+	SDL_AtomicSet(&SDL_EventQ.count, 0);
 	SDL_EventQ.wmmsg_next = 0;
 }
 
@@ -252,6 +498,10 @@ int SDL_StartEventLoop(Uint32 flags)
 		return(-1);
 	}
 
+#if SDL_EVENT_FDS
+	SDL_OpenEventWakeup();
+#endif
+
 	/* Create the lock and event thread */
 	if ( SDL_StartEventThread(flags) < 0 ) {
 		SDL_StopEventLoop();
@@ -281,6 +531,10 @@ static int SDL_AddEvent(SDL_Event *event)
 			SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
 		}
 		SDL_EventQ.tail = tail;
+		SDL_AtomicAdd(&SDL_EventQ.count, 1);
+		if ( SDL_EventQ.waiting ) {
+			SDL_CondBroadcast(SDL_EventQ.added);
+		}
 		added = 1;
 	}
 	return(added);
@@ -290,6 +544,7 @@ static int SDL_AddEvent(SDL_Event *event)
 /*                           -- called with the queue locked */
 static int SDL_CutEvent(int spot)
 {
+	SDL_AtomicAdd(&SDL_EventQ.count, -1);
 	if ( spot == SDL_EventQ.head ) {
 		SDL_EventQ.head = (SDL_EventQ.head+1)%MAXEVENTS;
 		return(SDL_EventQ.head);
@@ -322,9 +577,14 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	int i, used;
 
 	/* Don't look after we've quit */
-	if ( ! SDL_EventQ.active ) {
+	if ( ! SDL_AtomicGet(&SDL_EventQ.active) ) {
 		return(-1);
 	}
+	/* Polling an empty queue doesn't need the lock */
+	if ( action != SDL_ADDEVENT &&
+	     SDL_AtomicGet(&SDL_EventQ.count) == 0 ) {
+		return(0);
+	}
 	/* Lock the event queue */
 	used = 0;
 	if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
@@ -357,6 +617,14 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 			}
 		}
 		SDL_mutexV(SDL_EventQ.lock);
+
+		/* The events are counted before this looks for a waiting
+		   thread, and the thread says it's waiting before it looks
+		   at the count, so either it sees them or it's woken up */
+		if ( action == SDL_ADDEVENT && used > 0 &&
+		     SDL_AtomicGet(&SDL_EventQ.driver_waiting) ) {
+			SDL_SendEventWakeup();
+		}
 	} else {
 		SDL_SetError("Couldn't lock event queue");
 		used = -1;
@@ -371,6 +639,10 @@ void SDL_PumpEvents(void)
 		SDL_VideoDevice *video = current_video;
 		SDL_VideoDevice *this  = current_video;
 
+		/* Move the software cursor if the mouse moved since the last
+		   pump and the screen hasn't been updated in between */
+		SDL_FlushCursorMotion();
+
 		/* Get events from the video subsystem */
 		if ( video ) {
 			video->PumpEvents(this);
@@ -400,18 +672,80 @@ int SDL_PollEvent (SDL_Event *event)
 	return 1;
 }
 
-int SDL_WaitEvent (SDL_Event *event)
+/* Sleep until there may be events, for at most 'timeout' milliseconds
+   or forever if it's negative */
+static void SDL_SleepForEvents(int timeout)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+	int pump_timeout = -1;
+
+	/* Wake up for the things SDL_PumpEvents() does on a timer */
+	if ( !SDL_EventThread ) {
+		pump_timeout = SDL_PumpTimeout();
+		if ( !video || !video->WaitEvents ) {
+			pump_timeout = PUMP_INTERVAL;
+		}
+	}
+	timeout = SDL_MinTimeout(timeout, pump_timeout);
+
+	if ( !SDL_EventThread && video && video->WaitEvents ) {
+		/* This thread pumps, so it waits for the driver's events */
+		SDL_AtomicSet(&SDL_EventQ.driver_waiting, 1);
+		if ( SDL_AtomicGet(&SDL_EventQ.count) == 0 ) {
+			video->WaitEvents(this, timeout);
+		}
+		SDL_AtomicSet(&SDL_EventQ.driver_waiting, 0);
+	} else if ( SDL_EventQ.added ) {
+		/* The event thread or other threads add the events */
+		if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
+			if ( SDL_AtomicGet(&SDL_EventQ.count) == 0 ) {
+				++SDL_EventQ.waiting;
+				if ( timeout < 0 ) {
+					SDL_CondWait(SDL_EventQ.added,
+					             SDL_EventQ.lock);
+				} else {
+					SDL_CondWaitTimeout(SDL_EventQ.added,
+					             SDL_EventQ.lock, timeout);
+				}
+				--SDL_EventQ.waiting;
+			}
+			SDL_mutexV(SDL_EventQ.lock);
+		}
+	} else {
+		SDL_Delay(timeout < 0 ? PUMP_INTERVAL : timeout);
+	}
+}
+
+int SDL_WaitEventTimeout (SDL_Event *event, int timeout)
 {
+	Uint32 start = SDL_GetTicks();
+	Uint32 elapsed;
+	int wait = -1;
+
 	while ( 1 ) {
 		SDL_PumpEvents();
 		switch(SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS)) {
 		    case -1: return 0;
 		    case 1: return 1;
-		    case 0: SDL_Delay(10);
+		    case 0: break;
+		}
+		if ( timeout >= 0 ) {
+			elapsed = SDL_GetTicks() - start;
+			if ( elapsed >= (Uint32)timeout ) {
+				return 0;
+			}
+			wait = timeout - (int)elapsed;
 		}
+		SDL_SleepForEvents(wait);
 	}
 }
 
+int SDL_WaitEvent (SDL_Event *event)
+{
+	return SDL_WaitEventTimeout(event, -1);
+}
+
 int SDL_PushEvent(SDL_Event *event)
 {
 	if ( SDL_PeepEvents(event, 1, SDL_ADDEVENT, 0) <= 0 )
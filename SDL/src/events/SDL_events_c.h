@@ -76,6 +76,10 @@ extern void SDL_ResetKeyboard(void);
 /* Used by the event loop to queue pending keyboard repeat events */
 extern void SDL_CheckKeyRepeat(void);
 
+/* Milliseconds until SDL_CheckKeyRepeat() has something to do, or -1 if
+   no key is repeating */
+extern int SDL_KeyRepeatTimeout(void);
+
 /* Used by the OS keyboard code to detect whether or not to do UNICODE */
 #ifndef DEFAULT_UNICODE_TRANSLATION
 #define DEFAULT_UNICODE_TRANSLATION 0	/* Default off because of overhead */
@@ -593,6 +593,27 @@ void SDL_CheckKeyRepeat(void)
 	}
 }
 
+int SDL_KeyRepeatTimeout(void)
+{
+	Uint32 due, now;
+
+	if ( ! SDL_KeyRepeat.timestamp ) {
+		return(-1);
+	}
+	/* SDL_CheckKeyRepeat() waits for more than the delay or interval */
+	due = SDL_KeyRepeat.timestamp + 1;
+	if ( SDL_KeyRepeat.firsttime ) {
+		due += SDL_KeyRepeat.delay;
+	} else {
+		due += SDL_KeyRepeat.interval;
+	}
+	now = SDL_GetTicks();
+	if ( (Sint32)(due - now) <= 0 ) {
+		return(0);
+	}
+	return((int)(due - now));
+}
+
 int SDL_EnableKeyRepeat(int delay, int interval)
 {
 	if ( (delay < 0) || (interval < 0) ) {
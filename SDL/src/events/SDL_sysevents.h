@@ -44,3 +44,13 @@
 #ifdef __OS2__		/* The OS/2 event loop runs in a separate thread */
 #define MUST_THREAD_EVENTS
 #endif
+
+#if SDL_VIDEO_DRIVER_X11 || SDL_VIDEO_DRIVER_FBCON
+/* Drivers that get their events from file descriptors wait with this,
+   which also returns when SDL_SendEventWakeup() is called */
+#define SDL_EVENT_FDS	1
+extern void SDL_WaitEventFDs(const int *fds, int numfds, int timeout);
+#endif
+
+/* Wake up a thread waiting in the WaitEvents() function of the driver */
+extern void SDL_SendEventWakeup(void);
@@ -0,0 +1,256 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Atomic operations, memory barriers and spinlocks */
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_timer.h"
+
+/* GCC 4.1 and later have builtins for the sizes the processor can do
+   atomically, and Win32 has the Interlocked functions.  Anything else
+   goes through a mutex.
+*/
+#if defined(__GNUC__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4) && \
+    (!defined(__SIZEOF_POINTER__) || __SIZEOF_POINTER__ == 4 || \
+     defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8))
+#define HAVE_GCC_ATOMICS	1
+#elif defined(__WIN32__) && !defined(_WIN32_WCE)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define HAVE_WIN32_ATOMICS	1
+#endif
+
+/* Let the other hyperthread of the core run while spinning */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SDL_CPUPause()	__asm__ __volatile__ ("pause")
+#elif HAVE_WIN32_ATOMICS && defined(YieldProcessor)
+#define SDL_CPUPause()	YieldProcessor()
+#else
+#define SDL_CPUPause()
+#endif
+
+/* Spin this many times on a held lock before giving up the processor */
+#define SPIN_COUNT	64
+
+#if !HAVE_GCC_ATOMICS && !HAVE_WIN32_ATOMICS
+/* The WARNING in SDL_AddThread() applies, the first atomic operation
+   shouldn't happen in two threads at once */
+static SDL_mutex *SDL_atomic_lock = NULL;
+
+static void SDL_LockAtomics(void)
+{
+	if ( ! SDL_atomic_lock ) {
+		SDL_atomic_lock = SDL_CreateMutex();
+	}
+	SDL_mutexP(SDL_atomic_lock);
+}
+
+static void SDL_UnlockAtomics(void)
+{
+	SDL_mutexV(SDL_atomic_lock);
+}
+#endif
+
+SDL_bool SDL_AtomicTryLock(SDL_SpinLock *lock)
+{
+#if HAVE_GCC_ATOMICS
+	return (__sync_lock_test_and_set(lock, 1) == 0);
+#elif HAVE_WIN32_ATOMICS
+	return (InterlockedExchange((LONG *)lock, 1) == 0);
+#else
+	SDL_bool taken = SDL_FALSE;
+
+	SDL_LockAtomics();
+	if ( *lock == 0 ) {
+		*lock = 1;
+		taken = SDL_TRUE;
+	}
+	SDL_UnlockAtomics();
+	return taken;
+#endif
+}
+
+void SDL_AtomicLock(SDL_SpinLock *lock)
+{
+	int spins = 0;
+
+	while ( ! SDL_AtomicTryLock(lock) ) {
+		/* Wait for it to look free before trying again, so waiting
+		   threads don't keep taking the cache line from the owner */
+		while ( *(volatile SDL_SpinLock *)lock ) {
+			if ( ++spins < SPIN_COUNT ) {
+				SDL_CPUPause();
+			} else {
+				/* The owner may be waiting for this processor */
+				SDL_Delay(0);
+			}
+		}
+	}
+}
+
+void SDL_AtomicUnlock(SDL_SpinLock *lock)
+{
+#if HAVE_GCC_ATOMICS
+	__sync_lock_release(lock);
+#elif HAVE_WIN32_ATOMICS
+	InterlockedExchange((LONG *)lock, 0);
+#else
+	SDL_LockAtomics();
+	*lock = 0;
+	SDL_UnlockAtomics();
+#endif
+}
+
+void SDL_MemoryBarrierRelease(void)
+{
+#if HAVE_GCC_ATOMICS
+#if defined(__i386__) || defined(__x86_64__)
+	/* x86 doesn't reorder writes with other writes */
+	SDL_CompilerBarrier();
+#else
+	__sync_synchronize();
+#endif
+#elif HAVE_WIN32_ATOMICS
+	LONG barrier = 0;
+	InterlockedExchange(&barrier, 0);
+#elif !SDL_THREADS_DISABLED
+	SDL_LockAtomics();
+	SDL_UnlockAtomics();
+#endif
+}
+
+void SDL_MemoryBarrierAcquire(void)
+{
+#if HAVE_GCC_ATOMICS
+#if defined(__i386__) || defined(__x86_64__)
+	/* x86 doesn't reorder reads with other reads */
+	SDL_CompilerBarrier();
+#else
+	__sync_synchronize();
+#endif
+#elif HAVE_WIN32_ATOMICS
+	LONG barrier = 0;
+	InterlockedExchange(&barrier, 0);
+#elif !SDL_THREADS_DISABLED
+	SDL_LockAtomics();
+	SDL_UnlockAtomics();
+#endif
+}
+
+SDL_bool SDL_AtomicCAS(SDL_atomic_t *a, int oldval, int newval)
+{
+#if HAVE_GCC_ATOMICS
+	return (SDL_bool)__sync_bool_compare_and_swap(&a->value, oldval, newval);
+#elif HAVE_WIN32_ATOMICS
+	return (InterlockedCompareExchange((LONG *)&a->value,
+	                                   newval, oldval) == oldval);
+#else
+	SDL_bool swapped = SDL_FALSE;
+
+	SDL_LockAtomics();
+	if ( a->value == oldval ) {
+		a->value = newval;
+		swapped = SDL_TRUE;
+	}
+	SDL_UnlockAtomics();
+	return swapped;
+#endif
+}
+
+int SDL_AtomicSet(SDL_atomic_t *a, int v)
+{
+#if HAVE_WIN32_ATOMICS
+	return (int)InterlockedExchange((LONG *)&a->value, v);
+#else
+	/* __sync_lock_test_and_set() is only an acquire barrier */
+	int value;
+
+	do {
+		value = *(volatile int *)&a->value;
+	} while ( ! SDL_AtomicCAS(a, value, v) );
+	return value;
+#endif
+}
+
+int SDL_AtomicGet(SDL_atomic_t *a)
+{
+	int value = *(volatile int *)&a->value;
+
+	SDL_MemoryBarrierAcquire();
+	return value;
+}
+
+int SDL_AtomicAdd(SDL_atomic_t *a, int v)
+{
+#if HAVE_GCC_ATOMICS
+	return __sync_fetch_and_add(&a->value, v);
+#elif HAVE_WIN32_ATOMICS
+	return (int)InterlockedExchangeAdd((LONG *)&a->value, v);
+#else
+	int value;
+
+	SDL_LockAtomics();
+	value = a->value;
+	a->value += v;
+	SDL_UnlockAtomics();
+	return value;
+#endif
+}
+
+SDL_bool SDL_AtomicCASPtr(void **a, void *oldval, void *newval)
+{
+#if HAVE_GCC_ATOMICS
+	return (SDL_bool)__sync_bool_compare_and_swap(a, oldval, newval);
+#elif HAVE_WIN32_ATOMICS
+	return (InterlockedCompareExchangePointer(a, newval, oldval) == oldval);
+#else
+	SDL_bool swapped = SDL_FALSE;
+
+	SDL_LockAtomics();
+	if ( *a == oldval ) {
+		*a = newval;
+		swapped = SDL_TRUE;
+	}
+	SDL_UnlockAtomics();
+	return swapped;
+#endif
+}
+
+void *SDL_AtomicSetPtr(void **a, void *v)
+{
+	void *value;
+
+	do {
+		value = *(void * volatile *)a;
+	} while ( ! SDL_AtomicCASPtr(a, value, v) );
+	return value;
+}
+
+void *SDL_AtomicGetPtr(void **a)
+{
+	void *value = *(void * volatile *)a;
+
+	SDL_MemoryBarrierAcquire();
+	return value;
+}
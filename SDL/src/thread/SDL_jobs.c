@@ -0,0 +1,489 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* A pool of worker threads that run jobs for the library and the
+   application
+
+   Every worker has a queue of its own, and there's one more for the
+   threads that aren't workers.  A worker takes the newest job from its
+   own queue, so jobs that add more jobs keep their data in the cache,
+   and when that's empty it steals the oldest job from the other queues.
+   A thread waiting for a group of jobs runs jobs too instead of blocking,
+   which also lets jobs wait for jobs of their own.  Workers sleep on a
+   condition variable when there's nothing at all to do.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+#include "SDL_thread_c.h"
+
+#define MAX_JOB_THREADS	64
+#define JOB_QUEUE_SIZE	256
+
+typedef struct SDL_Job {
+	SDL_JobFunc func;
+	void *data;
+	SDL_JobGroup *group;
+	int allocated;		/* Freed once it has run */
+} SDL_Job;
+
+struct SDL_JobGroup {
+	SDL_atomic_t pending;	/* Jobs added and not finished yet */
+};
+
+#if SDL_THREADS_DISABLED
+
+int SDL_GetJobThreads(void)
+{
+	return(1);
+}
+
+int SDL_AddJob(SDL_JobGroup *group, SDL_JobFunc func, void *data)
+{
+	func(data);
+	return(0);
+}
+
+void SDL_WaitJobGroup(SDL_JobGroup *group)
+{
+}
+
+void SDL_ParallelForThreads(int start, int end, int grain, int threads,
+                            SDL_RangeFunc func, void *data)
+{
+	if ( start < end ) {
+		func(data, start, end);
+	}
+}
+
+void SDL_JobsQuit(void)
+{
+}
+
+#else
+
+/* A queue that its owner uses as a stack, with the others taking jobs
+   from the other end */
+typedef struct SDL_JobQueue {
+	SDL_SpinLock lock;
+	unsigned int top;	/* Where jobs are stolen */
+	unsigned int bottom;	/* Where the owner adds and takes jobs */
+	SDL_Job *jobs[JOB_QUEUE_SIZE];
+} SDL_JobQueue;
+
+static SDL_SpinLock SDL_jobs_lock = 0;
+static SDL_atomic_t SDL_jobs_started;
+static int SDL_num_workers = 0;
+static SDL_Thread *SDL_workers[MAX_JOB_THREADS];
+static SDL_JobQueue *SDL_job_queues = NULL;	/* SDL_num_workers + 1 */
+static SDL_TLSID SDL_worker_id = 0;		/* Queue index + 1 */
+
+static SDL_atomic_t SDL_jobs_queued;		/* Jobs in all the queues */
+static SDL_atomic_t SDL_workers_sleeping;
+static SDL_atomic_t SDL_jobs_quit;
+static SDL_mutex *SDL_jobs_mutex = NULL;
+static SDL_cond *SDL_jobs_added = NULL;		/* Wakes sleeping workers */
+static SDL_cond *SDL_jobs_done = NULL;		/* Wakes waiting threads */
+
+/* The queue of the calling thread */
+static int SDL_MyJobQueue(void)
+{
+	int id = (int)(size_t)SDL_TLSGet(SDL_worker_id);
+
+	return(id ? id - 1 : SDL_num_workers);
+}
+
+static int SDL_PushJob(SDL_Job *job)
+{
+	SDL_JobQueue *queue = &SDL_job_queues[SDL_MyJobQueue()];
+	int pushed = 0;
+
+	SDL_AtomicLock(&queue->lock);
+	if ( queue->bottom - queue->top < JOB_QUEUE_SIZE ) {
+		queue->jobs[queue->bottom % JOB_QUEUE_SIZE] = job;
+		++queue->bottom;
+		pushed = 1;
+	}
+	SDL_AtomicUnlock(&queue->lock);
+	if ( ! pushed ) {
+		return(-1);
+	}
+
+	/* A worker going to sleep counts itself and then looks at the
+	   queued jobs, in the opposite order, so one of us sees the other */
+	SDL_AtomicAdd(&SDL_jobs_queued, 1);
+	if ( SDL_AtomicGet(&SDL_workers_sleeping) ) {
+		SDL_mutexP(SDL_jobs_mutex);
+		SDL_CondSignal(SDL_jobs_added);
+		SDL_mutexV(SDL_jobs_mutex);
+	}
+	return(0);
+}
+
+static SDL_Job *SDL_TakeJob(int self)
+{
+	int num_queues = SDL_num_workers + 1;
+	SDL_JobQueue *queue;
+	SDL_Job *job = NULL;
+	int i;
+
+	if ( ! SDL_AtomicGet(&SDL_jobs_queued) ) {
+		return(NULL);
+	}
+
+	/* The newest job of our own first */
+	queue = &SDL_job_queues[self];
+	SDL_AtomicLock(&queue->lock);
+	if ( queue->bottom != queue->top ) {
+		--queue->bottom;
+		job = queue->jobs[queue->bottom % JOB_QUEUE_SIZE];
+	}
+	SDL_AtomicUnlock(&queue->lock);
+
+	/* Then the oldest job of the others, starting with our neighbour */
+	for ( i = 1; !job && i < num_queues; ++i ) {
+		queue = &SDL_job_queues[(self + i) % num_queues];
+		if ( queue->bottom == queue->top ) {
+			continue;	/* Don't lock it just to see that */
+		}
+		SDL_AtomicLock(&queue->lock);
+		if ( queue->bottom != queue->top ) {
+			job = queue->jobs[queue->top % JOB_QUEUE_SIZE];
+			++queue->top;
+		}
+		SDL_AtomicUnlock(&queue->lock);
+	}
+
+	if ( job ) {
+		SDL_AtomicAdd(&SDL_jobs_queued, -1);
+	}
+	return(job);
+}
+
+static void SDL_RunJob(SDL_Job *job)
+{
+	SDL_JobGroup *group = job->group;
+
+	job->func(job->data);
+	if ( job->allocated ) {
+		SDL_free(job);
+	}
+	if ( SDL_AtomicDecRef(&group->pending) ) {
+		SDL_mutexP(SDL_jobs_mutex);
+		SDL_CondBroadcast(SDL_jobs_done);
+		SDL_mutexV(SDL_jobs_mutex);
+	}
+}
+
+static int SDLCALL SDL_JobWorker(void *data)
+{
+	int self = (int)(size_t)data;
+	SDL_Job *job;
+
+	SDL_TLSSet(SDL_worker_id, (void *)(size_t)(self + 1), NULL);
+	while ( ! SDL_AtomicGet(&SDL_jobs_quit) ) {
+		job = SDL_TakeJob(self);
+		if ( job ) {
+			SDL_RunJob(job);
+			continue;
+		}
+
+		SDL_mutexP(SDL_jobs_mutex);
+		SDL_AtomicAdd(&SDL_workers_sleeping, 1);
+		while ( ! SDL_AtomicGet(&SDL_jobs_queued) &&
+		        ! SDL_AtomicGet(&SDL_jobs_quit) ) {
+			SDL_CondWait(SDL_jobs_added, SDL_jobs_mutex);
+		}
+		SDL_AtomicAdd(&SDL_workers_sleeping, -1);
+		SDL_mutexV(SDL_jobs_mutex);
+	}
+	return(0);
+}
+
+/* The number of workers: SDL_JOB_THREADS overrides the number of
+   processors, the thread that waits for the jobs being one of them */
+static int SDL_CountJobThreads(void)
+{
+	const char *env = SDL_getenv("SDL_JOB_THREADS");
+	int num_threads = 0;
+
+	if ( env ) {
+		num_threads = SDL_atoi(env);
+	} else {
+		num_threads = SDL_GetCPUCount();
+	}
+	if ( num_threads < 1 ) {
+		num_threads = 1;
+	} else if ( num_threads > MAX_JOB_THREADS ) {
+		num_threads = MAX_JOB_THREADS;
+	}
+	return(num_threads);
+}
+
+/* Start the workers the first time there are jobs */
+static void SDL_StartJobs(void)
+{
+	int i, num_workers;
+
+	if ( SDL_AtomicGet(&SDL_jobs_started) ) {
+		return;
+	}
+	SDL_AtomicLock(&SDL_jobs_lock);
+	if ( ! SDL_AtomicGet(&SDL_jobs_started) ) {
+		num_workers = SDL_CountJobThreads() - 1;
+		SDL_AtomicSet(&SDL_jobs_queued, 0);
+		SDL_AtomicSet(&SDL_workers_sleeping, 0);
+		SDL_AtomicSet(&SDL_jobs_quit, 0);
+		if ( ! SDL_worker_id ) {
+			SDL_worker_id = SDL_TLSCreate();
+		}
+		SDL_jobs_mutex = SDL_CreateMutex();
+		SDL_jobs_added = SDL_CreateCond();
+		SDL_jobs_done = SDL_CreateCond();
+		SDL_job_queues = (SDL_JobQueue *)SDL_malloc(
+			(num_workers + 1) * sizeof(*SDL_job_queues));
+		if ( !SDL_jobs_mutex || !SDL_jobs_added || !SDL_jobs_done ||
+		     !SDL_job_queues ) {
+			/* Run the jobs without a thread of their own */
+			num_workers = 0;
+		}
+		if ( SDL_job_queues ) {
+			SDL_memset(SDL_job_queues, 0,
+			           (num_workers + 1) * sizeof(*SDL_job_queues));
+		}
+
+		/* If a worker can't be started, make do with the others */
+		SDL_num_workers = 0;
+		for ( i = 0; i < num_workers; ++i ) {
+			SDL_workers[i] = SDL_CreateThread(SDL_JobWorker,
+			                                  (void *)(size_t)i);
+			if ( SDL_workers[i] == NULL ) {
+				break;
+			}
+			++SDL_num_workers;
+		}
+		SDL_AtomicSet(&SDL_jobs_started, 1);
+	}
+	SDL_AtomicUnlock(&SDL_jobs_lock);
+}
+
+int SDL_GetJobThreads(void)
+{
+	SDL_StartJobs();
+	return(SDL_num_workers + 1);
+}
+
+/* Queue a job, or run it right away if it can't be queued */
+static void SDL_QueueJob(SDL_Job *job)
+{
+	SDL_AtomicIncRef(&job->group->pending);
+	if ( !SDL_num_workers || !SDL_job_queues || SDL_PushJob(job) < 0 ) {
+		SDL_RunJob(job);
+	}
+}
+
+int SDL_AddJob(SDL_JobGroup *group, SDL_JobFunc func, void *data)
+{
+	SDL_Job *job;
+
+	if ( ! group ) {
+		SDL_SetError("Passed a NULL job group");
+		return(-1);
+	}
+	SDL_StartJobs();
+	job = (SDL_Job *)SDL_malloc(sizeof(*job));
+	if ( job == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	job->func = func;
+	job->data = data;
+	job->group = group;
+	job->allocated = 1;
+	SDL_QueueJob(job);
+	return(0);
+}
+
+void SDL_WaitJobGroup(SDL_JobGroup *group)
+{
+	SDL_Job *job;
+	int self;
+
+	if ( ! group || ! SDL_AtomicGet(&group->pending) ) {
+		return;
+	}
+	self = SDL_MyJobQueue();
+	while ( SDL_AtomicGet(&group->pending) ) {
+		job = SDL_TakeJob(self);
+		if ( job ) {
+			SDL_RunJob(job);
+			continue;
+		}
+
+		/* The rest of the group is running on other threads */
+		SDL_mutexP(SDL_jobs_mutex);
+		if ( SDL_AtomicGet(&group->pending) &&
+		     ! SDL_AtomicGet(&SDL_jobs_queued) ) {
+			SDL_CondWait(SDL_jobs_done, SDL_jobs_mutex);
+		}
+		SDL_mutexV(SDL_jobs_mutex);
+	}
+}
+
+/* A parallel loop: every thread taking part runs chunks of the range,
+   handed out in order, until there are none left */
+typedef struct {
+	SDL_RangeFunc func;
+	void *data;
+	int start;
+	int end;
+	int grain;
+	int chunks;
+	SDL_atomic_t next;
+} SDL_ForLoop;
+
+static void SDLCALL SDL_RunForLoop(void *arg)
+{
+	SDL_ForLoop *loop = (SDL_ForLoop *)arg;
+	int chunk, first, last;
+
+	for ( ;; ) {
+		chunk = SDL_AtomicAdd(&loop->next, 1);
+		if ( chunk >= loop->chunks ) {
+			break;
+		}
+		first = loop->start + chunk * loop->grain;
+		last = (chunk == loop->chunks - 1) ? loop->end :
+		                                     first + loop->grain;
+		loop->func(loop->data, first, last);
+	}
+}
+
+void SDL_ParallelForThreads(int start, int end, int grain, int threads,
+                            SDL_RangeFunc func, void *data)
+{
+	SDL_ForLoop loop;
+	SDL_JobGroup group;
+	SDL_Job jobs[MAX_JOB_THREADS];
+	int i;
+
+	if ( start >= end ) {
+		return;
+	}
+	SDL_StartJobs();
+	if ( threads <= 0 || threads > SDL_num_workers + 1 ) {
+		threads = SDL_num_workers + 1;
+	}
+	if ( grain <= 0 ) {
+		/* A few chunks per thread, for the threads that finish early */
+		grain = (int)(((Sint64)end - start) / (threads * 4));
+		if ( grain < 1 ) {
+			grain = 1;
+		}
+	}
+	loop.chunks = (int)((((Sint64)end - start) + grain - 1) / grain);
+	if ( threads > loop.chunks ) {
+		threads = loop.chunks;
+	}
+	if ( threads <= 1 ) {
+		func(data, start, end);
+		return;
+	}
+	loop.func = func;
+	loop.data = data;
+	loop.start = start;
+	loop.end = end;
+	loop.grain = grain;
+	SDL_AtomicSet(&loop.next, 0);
+
+	/* This thread takes part too */
+	SDL_AtomicSet(&group.pending, 0);
+	for ( i = 0; i < threads - 1; ++i ) {
+		jobs[i].func = SDL_RunForLoop;
+		jobs[i].data = &loop;
+		jobs[i].group = &group;
+		jobs[i].allocated = 0;
+		SDL_QueueJob(&jobs[i]);
+	}
+	SDL_RunForLoop(&loop);
+	SDL_WaitJobGroup(&group);
+}
+
+void SDL_JobsQuit(void)
+{
+	int i;
+
+	if ( ! SDL_AtomicGet(&SDL_jobs_started) ) {
+		return;
+	}
+	SDL_AtomicLock(&SDL_jobs_lock);
+	SDL_mutexP(SDL_jobs_mutex);
+	SDL_AtomicSet(&SDL_jobs_quit, 1);
+	SDL_CondBroadcast(SDL_jobs_added);
+	SDL_mutexV(SDL_jobs_mutex);
+	for ( i = 0; i < SDL_num_workers; ++i ) {
+		SDL_WaitThread(SDL_workers[i], NULL);
+	}
+	SDL_num_workers = 0;
+	SDL_DestroyCond(SDL_jobs_done);
+	SDL_jobs_done = NULL;
+	SDL_DestroyCond(SDL_jobs_added);
+	SDL_jobs_added = NULL;
+	SDL_DestroyMutex(SDL_jobs_mutex);
+	SDL_jobs_mutex = NULL;
+	SDL_free(SDL_job_queues);
+	SDL_job_queues = NULL;
+	SDL_AtomicSet(&SDL_jobs_started, 0);
+	SDL_AtomicUnlock(&SDL_jobs_lock);
+}
+
+#endif /* SDL_THREADS_DISABLED */
+
+SDL_JobGroup *SDL_CreateJobGroup(void)
+{
+	SDL_JobGroup *group;
+
+	group = (SDL_JobGroup *)SDL_malloc(sizeof(*group));
+	if ( group == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_AtomicSet(&group->pending, 0);
+	return(group);
+}
+
+void SDL_DestroyJobGroup(SDL_JobGroup *group)
+{
+	if ( group ) {
+		SDL_WaitJobGroup(group);
+		SDL_free(group);
+	}
+}
+
+void SDL_ParallelFor(int start, int end, int grain,
+                     SDL_RangeFunc func, void *data)
+{
+	SDL_ParallelForThreads(start, end, grain, 0, func, data);
+}
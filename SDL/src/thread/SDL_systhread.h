@@ -27,6 +27,7 @@
 #define _SDL_systhread_h
 
 #include "SDL_thread.h"
+#include "SDL_thread_c.h"
 
 /* This function creates a thread, passing args to SDL_RunThread(),
    saves a system-dependent thread id in thread->id, and returns 0
@@ -49,4 +50,11 @@ extern void SDL_SYS_WaitThread(SDL_Thread *thread);
 /* This function kills the thread and returns */
 extern void SDL_SYS_KillThread(SDL_Thread *thread);
 
+/* These get and set the thread local values of the calling thread, which
+   are NULL until they're set.  Thread libraries without thread local
+   storage use a list kept in SDL_thread.c.
+ */
+extern SDL_TLSData *SDL_SYS_GetTLSData(void);
+extern int SDL_SYS_SetTLSData(SDL_TLSData *data);
+
 #endif /* _SDL_systhread_h */
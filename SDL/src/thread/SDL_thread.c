@@ -141,6 +141,185 @@ static void SDL_DelThread(SDL_Thread *thread)
 #endif
 }
 
+/* Thread local values are kept in an array for each thread, found through
+   the thread library's own thread local storage where it has some.
+   The first ID is kept for the error messages.
+*/
+#define TLS_ERRBUF	1
+#define TLS_CHUNKSIZE	4
+static SDL_TLSID SDL_next_TLSID = TLS_ERRBUF+1;
+
+SDL_TLSID SDL_TLSCreate(void)
+{
+	SDL_TLSID id;
+
+	/* Until a thread has been created there's only this one */
+	if ( thread_lock ) {
+		SDL_mutexP(thread_lock);
+	}
+	id = SDL_next_TLSID++;
+	if ( thread_lock ) {
+		SDL_mutexV(thread_lock);
+	}
+	return(id);
+}
+
+void *SDL_TLSGet(SDL_TLSID id)
+{
+	SDL_TLSData *storage;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( !storage || id == 0 || id > storage->limit ) {
+		return(NULL);
+	}
+	return(storage->array[id-1].data);
+}
+
+/* This doesn't set the error message, which may be what it's storing */
+static int SDL_SetTLS(SDL_TLSID id, const void *value,
+                      void (SDLCALL *destructor)(void *))
+{
+	SDL_TLSData *storage;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( !storage || id > storage->limit ) {
+		unsigned int i, oldlimit, newlimit;
+
+		oldlimit = storage ? storage->limit : 0;
+		newlimit = id + TLS_CHUNKSIZE;
+		storage = (SDL_TLSData *)SDL_realloc(storage,
+			sizeof(*storage)+(newlimit-1)*sizeof(storage->array[0]));
+		if ( storage == NULL ) {
+			return(-1);
+		}
+		storage->limit = newlimit;
+		for ( i=oldlimit; i<newlimit; ++i ) {
+			storage->array[i].data = NULL;
+			storage->array[i].destructor = NULL;
+		}
+		/* This can only fail when the first values are stored */
+		if ( SDL_SYS_SetTLSData(storage) < 0 ) {
+			SDL_free(storage);
+			return(-1);
+		}
+	}
+	storage->array[id-1].data = (void *)value;
+	storage->array[id-1].destructor = destructor;
+	return(0);
+}
+
+int SDL_TLSSet(SDL_TLSID id, const void *value,
+               void (SDLCALL *destructor)(void *))
+{
+	if ( id == 0 ) {
+		SDL_SetError("Invalid thread local storage ID");
+		return(-1);
+	}
+	if ( SDL_SetTLS(id, value, destructor) < 0 ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	return(0);
+}
+
+void SDL_TLSCleanup(void)
+{
+	SDL_TLSData *storage;
+	unsigned int i;
+
+	/* Destructors that set an error get a new buffer for it */
+	storage = SDL_SYS_GetTLSData();
+	if ( storage ) {
+		SDL_SYS_SetTLSData(NULL);
+		for ( i=0; i<storage->limit; ++i ) {
+			if ( storage->array[i].destructor ) {
+				storage->array[i].destructor(storage->array[i].data);
+			}
+		}
+		SDL_free(storage);
+	}
+}
+
+#if !SDL_THREAD_PTHREAD
+/* The thread local values of each thread, for the thread libraries
+   without thread local storage */
+typedef struct SDL_TLSEntry {
+	Uint32 thread;
+	SDL_TLSData *storage;
+	struct SDL_TLSEntry *next;
+} SDL_TLSEntry;
+
+static SDL_TLSEntry *SDL_TLSEntries = NULL;
+
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	SDL_mutex *lock;
+	SDL_TLSEntry *entry;
+	SDL_TLSData *storage;
+	Uint32 this_thread;
+
+	storage = NULL;
+	this_thread = SDL_ThreadID();
+	lock = thread_lock;
+	if ( lock ) {
+		SDL_mutexP(lock);
+	}
+	for ( entry=SDL_TLSEntries; entry; entry=entry->next ) {
+		if ( entry->thread == this_thread ) {
+			storage = entry->storage;
+			break;
+		}
+	}
+	if ( lock ) {
+		SDL_mutexV(lock);
+	}
+	return(storage);
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *data)
+{
+	SDL_mutex *lock;
+	SDL_TLSEntry *entry, **prev;
+	Uint32 this_thread;
+	int retval;
+
+	retval = 0;
+	this_thread = SDL_ThreadID();
+	lock = thread_lock;
+	if ( lock ) {
+		SDL_mutexP(lock);
+	}
+	for ( prev=&SDL_TLSEntries; *prev; prev=&(*prev)->next ) {
+		if ( (*prev)->thread == this_thread ) {
+			break;
+		}
+	}
+	entry = *prev;
+	if ( data == NULL ) {
+		if ( entry ) {
+			*prev = entry->next;
+			SDL_free(entry);
+		}
+	} else if ( entry ) {
+		entry->storage = data;
+	} else {
+		entry = (SDL_TLSEntry *)SDL_malloc(sizeof(*entry));
+		if ( entry ) {
+			entry->thread = this_thread;
+			entry->storage = data;
+			entry->next = SDL_TLSEntries;
+			SDL_TLSEntries = entry;
+		} else {
+			retval = -1;
+		}
+	}
+	if ( lock ) {
+		SDL_mutexV(lock);
+	}
+	return(retval);
+}
+#endif /* !SDL_THREAD_PTHREAD */
+
 /* The default (non-thread-safe) global error variable */
 static SDL_error SDL_global_error;
 
@@ -149,20 +328,19 @@ SDL_error *SDL_GetErrBuf(void)
 {
 	SDL_error *errbuf;
 
-	errbuf = &SDL_global_error;
-	if ( SDL_Threads ) {
-		int i;
-		Uint32 this_thread;
-
-		this_thread = SDL_ThreadID();
-		SDL_mutexP(thread_lock);
-		for ( i=0; i<SDL_numthreads; ++i ) {
-			if ( this_thread == SDL_Threads[i]->threadid ) {
-				errbuf = &SDL_Threads[i]->errbuf;
-				break;
-			}
+	errbuf = (SDL_error *)SDL_TLSGet(TLS_ERRBUF);
+	if ( errbuf == NULL ) {
+		/* Errors while the buffer is set up go to the global one,
+		   which is where this thread's errors stay if that fails */
+		if ( SDL_SetTLS(TLS_ERRBUF, &SDL_global_error, NULL) < 0 ) {
+			return(&SDL_global_error);
 		}
-		SDL_mutexV(thread_lock);
+		errbuf = (SDL_error *)SDL_malloc(sizeof(*errbuf));
+		if ( errbuf == NULL ) {
+			return(&SDL_global_error);
+		}
+		SDL_memset(errbuf, 0, sizeof(*errbuf));
+		SDL_SetTLS(TLS_ERRBUF, errbuf, SDL_free);
 	}
 	return(errbuf);
 }
@@ -202,6 +380,9 @@ void SDL_RunThread(void *data)
 
 	/* Run the function */
 	*statusloc = userfunc(userdata);
+
+	/* Free the thread local values, including the error message */
+	SDL_TLSCleanup();
 }
 
 #ifdef SDL_PASSED_BEGINTHREAD_ENDTHREAD
@@ -298,3 +479,9 @@ void SDL_KillThread(SDL_Thread *thread)
 	}
 }
 
+#if !SDL_THREAD_PTHREAD
+int SDL_CondWaitTimeoutUS(SDL_cond *cond, SDL_mutex *mutex, Uint32 us)
+{
+	return SDL_CondWaitTimeout(cond, mutex, us/1000 + (us%1000 != 0));
+}
+#endif
@@ -48,17 +48,43 @@
 #include "generic/SDL_systhread_c.h"
 #endif
 #include "../SDL_error_c.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
 
 /* This is the system-independent thread info structure */
 struct SDL_Thread {
 	Uint32 threadid;
 	SYS_ThreadHandle handle;
 	int status;
-	SDL_error errbuf;
 	void *data;
 };
 
+/* The thread local values of a thread, array[id-1] for each SDL_TLSID */
+typedef struct SDL_TLSData {
+	unsigned int limit;
+	struct {
+		void *data;
+		void (SDLCALL *destructor)(void *);
+	} array[1];
+} SDL_TLSData;
+
 /* This is the function called to run a thread */
 extern void SDL_RunThread(void *data);
 
+/* Call the destructors of the thread local values of the calling thread
+   and free them, when the thread ends */
+extern void SDL_TLSCleanup(void);
+
+/* Like SDL_CondWaitTimeout(), with the timeout in microseconds.  Thread
+   libraries that can't wait that precisely round up to milliseconds. */
+extern int SDL_CondWaitTimeoutUS(SDL_cond *cond, SDL_mutex *mutex, Uint32 us);
+
+/* SDL_ParallelFor() with at most 'threads' threads, or all of them if
+   it's 0 */
+extern void SDL_ParallelForThreads(int start, int end, int grain, int threads,
+                                   SDL_RangeFunc func, void *data);
+
+/* Stop the job threads */
+extern void SDL_JobsQuit(void);
+
 #endif /* _SDL_thread_c_h */
@@ -0,0 +1,144 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Condition variables on Linux futexes: waiters sleep on a sequence
+   number that signaling changes, so a signal between unlocking the mutex
+   and going to sleep isn't lost */
+
+#include <limits.h>
+
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+#include "../SDL_thread_c.h"
+#include "SDL_sysmutex_c.h"
+
+struct SDL_cond
+{
+	SDL_atomic_t seq;
+	SDL_atomic_t waiters;
+};
+
+/* Create a condition variable */
+SDL_cond * SDL_CreateCond(void)
+{
+	SDL_cond *cond;
+
+	cond = (SDL_cond *) SDL_calloc(1, sizeof(SDL_cond));
+	if ( ! cond ) {
+		SDL_OutOfMemory();
+	}
+	return(cond);
+}
+
+/* Destroy a condition variable */
+void SDL_DestroyCond(SDL_cond *cond)
+{
+	if ( cond ) {
+		SDL_free(cond);
+	}
+}
+
+static int SDL_CondWake(SDL_cond *cond, int count)
+{
+	if ( ! cond ) {
+		SDL_SetError("Passed a NULL condition variable");
+		return -1;
+	}
+
+	if ( SDL_AtomicGet(&cond->waiters) ) {
+		SDL_AtomicIncRef(&cond->seq);
+		SDL_FutexWake(&cond->seq, count);
+	}
+	return 0;
+}
+
+/* Restart one of the threads that are waiting on the condition variable */
+int SDL_CondSignal(SDL_cond *cond)
+{
+	return SDL_CondWake(cond, 1);
+}
+
+/* Restart all threads that are waiting on the condition variable */
+int SDL_CondBroadcast(SDL_cond *cond)
+{
+	return SDL_CondWake(cond, INT_MAX);
+}
+
+/* Wait for at most 'ns' nanoseconds, or forever if it's negative */
+static int SDL_CondWaitNS(SDL_cond *cond, SDL_mutex *mutex, Sint64 ns)
+{
+	Uint64 deadline = 0, now;
+	int seq, retval;
+
+	if ( ! cond ) {
+		SDL_SetError("Passed a NULL condition variable");
+		return -1;
+	}
+
+	/* Anything signaled after this, while we hold the mutex, changes
+	   the sequence number and the futex won't sleep */
+	seq = SDL_AtomicGet(&cond->seq);
+	SDL_AtomicIncRef(&cond->waiters);
+	if ( SDL_mutexV(mutex) < 0 ) {
+		SDL_AtomicAdd(&cond->waiters, -1);
+		return -1;
+	}
+
+	if ( ns >= 0 ) {
+		deadline = SDL_GetTicksNS() + ns;
+	}
+	retval = 0;
+	while ( SDL_AtomicGet(&cond->seq) == seq ) {
+		if ( ns >= 0 ) {
+			now = SDL_GetTicksNS();
+			if ( now >= deadline ) {
+				retval = SDL_MUTEX_TIMEDOUT;
+				break;
+			}
+			ns = (Sint64)(deadline - now);
+		}
+		SDL_FutexWait(&cond->seq, seq, ns);
+	}
+	SDL_AtomicAdd(&cond->waiters, -1);
+
+	SDL_mutexP(mutex);
+	return retval;
+}
+
+int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
+{
+	return SDL_CondWaitNS(cond, mutex, (Sint64)ms * 1000000);
+}
+
+int SDL_CondWaitTimeoutUS(SDL_cond *cond, SDL_mutex *mutex, Uint32 us)
+{
+	return SDL_CondWaitNS(cond, mutex, (Sint64)us * 1000);
+}
+
+/* Wait on the condition variable, unlocking the provided mutex.
+   The mutex must be locked before entering this function!
+ */
+int SDL_CondWait(SDL_cond *cond, SDL_mutex *mutex)
+{
+	return SDL_CondWaitNS(cond, mutex, -1);
+}
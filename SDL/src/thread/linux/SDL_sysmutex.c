@@ -0,0 +1,172 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Mutexes on Linux futexes: the uncontended cases are a single atomic
+   operation, and a thread only goes into the kernel after spinning a
+   while on a mutex that stays locked.
+   See "Futexes Are Tricky" by Ulrich Drepper for the algorithm.
+*/
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "SDL_thread.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_sysmutex_c.h"
+
+#ifndef FUTEX_PRIVATE_FLAG
+#define FUTEX_PRIVATE_FLAG	0
+#endif
+
+SDL_bool SDL_FutexSpinning(void)
+{
+	static int spinning = -1;
+
+	if ( spinning < 0 ) {
+		spinning = (SDL_GetCPUCount() > 1);
+	}
+	return spinning ? SDL_TRUE : SDL_FALSE;
+}
+
+int SDL_FutexWait(SDL_atomic_t *word, int value, Sint64 ns)
+{
+	struct timespec timeout;
+
+	if ( ns >= 0 ) {
+		timeout.tv_sec = (time_t)(ns / 1000000000);
+		timeout.tv_nsec = (long)(ns % 1000000000);
+	}
+	if ( syscall(SYS_futex, &word->value, FUTEX_WAIT | FUTEX_PRIVATE_FLAG,
+	             value, ns < 0 ? NULL : &timeout, NULL, 0) < 0 &&
+	     errno == ETIMEDOUT ) {
+		return SDL_MUTEX_TIMEDOUT;
+	}
+	return 0;
+}
+
+void SDL_FutexWake(SDL_atomic_t *word, int count)
+{
+	syscall(SYS_futex, &word->value, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+	        count, NULL, NULL, 0);
+}
+
+SDL_mutex *SDL_CreateMutex (void)
+{
+	SDL_mutex *mutex;
+
+	/* Allocate the structure */
+	mutex = (SDL_mutex *)SDL_calloc(1, sizeof(*mutex));
+	if ( ! mutex ) {
+		SDL_OutOfMemory();
+	}
+	return(mutex);
+}
+
+void SDL_DestroyMutex(SDL_mutex *mutex)
+{
+	if ( mutex ) {
+		SDL_free(mutex);
+	}
+}
+
+/* Take a mutex that another thread has */
+static void SDL_LockContended(SDL_mutex *mutex)
+{
+	int spins, max_spins;
+
+	/* Spin about as long as it took the last few times, in case the
+	   owner is about to let go of it */
+	if ( SDL_FutexSpinning() ) {
+		max_spins = mutex->spins * 2 + 10;
+		if ( max_spins > MAX_SPINS ) {
+			max_spins = MAX_SPINS;
+		}
+		for ( spins = 0; spins < max_spins; ++spins ) {
+			if ( SDL_AtomicGet(&mutex->state) == 0 &&
+			     SDL_AtomicCAS(&mutex->state, 0, 1) ) {
+				break;
+			}
+			SDL_CPUPause();
+		}
+		mutex->spins += (spins - mutex->spins) / 8;
+		if ( spins < max_spins ) {
+			return;
+		}
+	}
+
+	/* Say there are waiters, and sleep until it's unlocked */
+	while ( SDL_AtomicSet(&mutex->state, 2) != 0 ) {
+		SDL_FutexWait(&mutex->state, 2, -1);
+	}
+}
+
+/* Lock the mutex */
+int SDL_mutexP(SDL_mutex *mutex)
+{
+	Uint32 this_thread;
+
+	if ( mutex == NULL ) {
+		SDL_SetError("Passed a NULL mutex");
+		return -1;
+	}
+
+	this_thread = SDL_ThreadID();
+	if ( mutex->owner == this_thread ) {
+		++mutex->recursive;
+	} else {
+		if ( ! SDL_AtomicCAS(&mutex->state, 0, 1) ) {
+			SDL_LockContended(mutex);
+		}
+		mutex->owner = this_thread;
+		mutex->recursive = 0;
+	}
+	return 0;
+}
+
+int SDL_mutexV(SDL_mutex *mutex)
+{
+	if ( mutex == NULL ) {
+		SDL_SetError("Passed a NULL mutex");
+		return -1;
+	}
+
+	/* We can only unlock the mutex if we own it */
+	if ( mutex->owner != SDL_ThreadID() ) {
+		SDL_SetError("mutex not owned by this thread");
+		return -1;
+	}
+	if ( mutex->recursive ) {
+		--mutex->recursive;
+	} else {
+		/* Reset the owner before another thread can lock it, and only
+		   make the system call if somebody is waiting */
+		mutex->owner = 0;
+		if ( SDL_AtomicSet(&mutex->state, 0) == 2 ) {
+			SDL_FutexWake(&mutex->state, 1);
+		}
+	}
+	return 0;
+}
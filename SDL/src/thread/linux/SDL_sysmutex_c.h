@@ -0,0 +1,58 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+#ifndef _SDL_mutex_c_h
+#define _SDL_mutex_c_h
+
+#include "SDL_atomic.h"
+
+struct SDL_mutex {
+	SDL_atomic_t state;	/* 0 unlocked, 1 locked, 2 locked with waiters */
+	Uint32 owner;		/* The SDL_ThreadID() of the locking thread */
+	int recursive;
+	int spins;		/* How long spinning has been taking */
+};
+
+/* Let the other hyperthread of the core run while spinning */
+#if defined(__i386__) || defined(__x86_64__)
+#define SDL_CPUPause()	__asm__ __volatile__ ("pause")
+#else
+#define SDL_CPUPause()
+#endif
+
+/* Spin at most this many times before sleeping on a futex */
+#define MAX_SPINS	100
+
+/* Whether spinning can get anywhere, which it can't on one processor */
+extern SDL_bool SDL_FutexSpinning(void);
+
+/* Sleep while 'word' is 'value', for at most 'ns' nanoseconds or forever
+   if it's negative.  It can return early, so the caller checks again.
+   Returns SDL_MUTEX_TIMEDOUT if the time ran out, otherwise 0.
+ */
+extern int SDL_FutexWait(SDL_atomic_t *word, int value, Sint64 ns);
+
+/* Wake up to 'count' threads sleeping on 'word' */
+extern void SDL_FutexWake(SDL_atomic_t *word, int count);
+
+#endif /* _SDL_mutex_c_h */
@@ -0,0 +1,169 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Semaphores on Linux futexes, which can wait for exactly as long as
+   they're asked to */
+
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+#include "SDL_sysmutex_c.h"
+
+struct SDL_semaphore {
+	SDL_atomic_t count;
+	SDL_atomic_t waiters;	/* Threads that may be sleeping on 'count' */
+	int spins;
+};
+
+/* Create a semaphore, initialized with value */
+SDL_sem *SDL_CreateSemaphore(Uint32 initial_value)
+{
+	SDL_sem *sem = (SDL_sem *) SDL_calloc(1, sizeof(SDL_sem));
+	if ( sem ) {
+		SDL_AtomicSet(&sem->count, (int)initial_value);
+	} else {
+		SDL_OutOfMemory();
+	}
+	return sem;
+}
+
+void SDL_DestroySemaphore(SDL_sem *sem)
+{
+	if ( sem ) {
+		SDL_free(sem);
+	}
+}
+
+/* Take one off the count if it's positive */
+static SDL_bool SDL_SemDown(SDL_sem *sem)
+{
+	int count;
+
+	while ( (count = SDL_AtomicGet(&sem->count)) > 0 ) {
+		if ( SDL_AtomicCAS(&sem->count, count, count - 1) ) {
+			return SDL_TRUE;
+		}
+	}
+	return SDL_FALSE;
+}
+
+/* Wait for at most 'ns' nanoseconds, or forever if it's negative */
+static int SDL_SemWaitNS(SDL_sem *sem, Sint64 ns)
+{
+	Uint64 deadline = 0, now;
+	int spins, max_spins;
+	int retval;
+
+	if ( ! sem ) {
+		SDL_SetError("Passed a NULL semaphore");
+		return -1;
+	}
+	if ( SDL_SemDown(sem) ) {
+		return 0;
+	}
+	if ( ns == 0 ) {
+		return SDL_MUTEX_TIMEDOUT;
+	}
+
+	/* Spin about as long as it took the last few times */
+	if ( SDL_FutexSpinning() ) {
+		max_spins = sem->spins * 2 + 10;
+		if ( max_spins > MAX_SPINS ) {
+			max_spins = MAX_SPINS;
+		}
+		for ( spins = 0; spins < max_spins; ++spins ) {
+			SDL_CPUPause();
+			if ( SDL_AtomicGet(&sem->count) > 0 && SDL_SemDown(sem) ) {
+				break;
+			}
+		}
+		sem->spins += (spins - sem->spins) / 8;
+		if ( spins < max_spins ) {
+			return 0;
+		}
+	}
+
+	/* Say we're waiting before looking at the count again, so either we
+	   see the post or the post sees us and wakes us up */
+	if ( ns > 0 ) {
+		deadline = SDL_GetTicksNS() + ns;
+	}
+	retval = 0;
+	SDL_AtomicIncRef(&sem->waiters);
+	while ( ! SDL_SemDown(sem) ) {
+		if ( ns > 0 ) {
+			now = SDL_GetTicksNS();
+			if ( now >= deadline ) {
+				retval = SDL_MUTEX_TIMEDOUT;
+				break;
+			}
+			ns = (Sint64)(deadline - now);
+		}
+		SDL_FutexWait(&sem->count, 0, ns);
+	}
+	SDL_AtomicAdd(&sem->waiters, -1);
+	return retval;
+}
+
+int SDL_SemTryWait(SDL_sem *sem)
+{
+	return SDL_SemWaitNS(sem, 0);
+}
+
+int SDL_SemWait(SDL_sem *sem)
+{
+	return SDL_SemWaitNS(sem, -1);
+}
+
+int SDL_SemWaitTimeout(SDL_sem *sem, Uint32 timeout)
+{
+	if ( timeout == SDL_MUTEX_MAXWAIT ) {
+		return SDL_SemWaitNS(sem, -1);
+	}
+	return SDL_SemWaitNS(sem, (Sint64)timeout * 1000000);
+}
+
+Uint32 SDL_SemValue(SDL_sem *sem)
+{
+	int ret = 0;
+	if ( sem ) {
+		ret = SDL_AtomicGet(&sem->count);
+		if ( ret < 0 ) {
+			ret = 0;
+		}
+	}
+	return (Uint32)ret;
+}
+
+int SDL_SemPost(SDL_sem *sem)
+{
+	if ( ! sem ) {
+		SDL_SetError("Passed a NULL semaphore");
+		return -1;
+	}
+
+	SDL_AtomicAdd(&sem->count, 1);
+	if ( SDL_AtomicGet(&sem->waiters) ) {
+		SDL_FutexWake(&sem->count, 1);
+	}
+	return 0;
+}
@@ -27,6 +27,7 @@
 #include <pthread.h>
 
 #include "SDL_thread.h"
+#include "../SDL_thread_c.h"
 #include "SDL_sysmutex_c.h"
 
 struct SDL_cond
@@ -95,9 +96,32 @@ int SDL_CondBroadcast(SDL_cond *cond)
 	return retval;
 }
 
-int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
+static int SDL_CondWaitUntil(SDL_cond *cond, SDL_mutex *mutex,
+                             struct timespec *abstime)
 {
 	int retval;
+
+  tryagain:
+	retval = pthread_cond_timedwait(&cond->cond, &mutex->id, abstime);
+	switch (retval) {
+	    case EINTR:
+		goto tryagain;
+		break;
+	    case ETIMEDOUT:
+		retval = SDL_MUTEX_TIMEDOUT;
+		break;
+	    case 0:
+		break;
+	    default:
+		SDL_SetError("pthread_cond_timedwait() failed");
+		retval = -1;
+		break;
+	}
+	return retval;
+}
+
+int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
+{
 	struct timeval delta;
 	struct timespec abstime;
 
@@ -115,23 +139,29 @@ int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
           abstime.tv_nsec -= 1000000000;
         }
 
-  tryagain:
-	retval = pthread_cond_timedwait(&cond->cond, &mutex->id, &abstime);
-	switch (retval) {
-	    case EINTR:
-		goto tryagain;
-		break;
-	    case ETIMEDOUT:
-		retval = SDL_MUTEX_TIMEDOUT;
-		break;
-	    case 0:
-		break;
-	    default:
-		SDL_SetError("pthread_cond_timedwait() failed");
-		retval = -1;
-		break;
+	return SDL_CondWaitUntil(cond, mutex, &abstime);
+}
+
+int SDL_CondWaitTimeoutUS(SDL_cond *cond, SDL_mutex *mutex, Uint32 us)
+{
+	struct timeval delta;
+	struct timespec abstime;
+
+	if ( ! cond ) {
+		SDL_SetError("Passed a NULL condition variable");
+		return -1;
 	}
-	return retval;
+
+	gettimeofday(&delta, NULL);
+
+	abstime.tv_sec = delta.tv_sec + (us/1000000);
+	abstime.tv_nsec = (delta.tv_usec + (us%1000000)) * 1000;
+	if ( abstime.tv_nsec >= 1000000000 ) {
+		abstime.tv_sec += 1;
+		abstime.tv_nsec -= 1000000000;
+	}
+
+	return SDL_CondWaitUntil(cond, mutex, &abstime);
 }
 
 /* Wait on the condition variable, unlocking the provided mutex.
@@ -144,15 +144,20 @@ int SDL_SemWaitTimeout(SDL_sem *sem, Uint32 timeout)
 		retval = sem_timedwait(&sem->sem, &ts_timeout);
 	while (retval == -1 && errno == EINTR);
 
-	if (retval == -1)
-		SDL_SetError(strerror(errno));
+	if (retval == -1) {
+		if (errno == ETIMEDOUT) {
+			retval = SDL_MUTEX_TIMEDOUT;
+		} else {
+			SDL_SetError(strerror(errno));
+		}
+	}
 #else
 	end = SDL_GetTicks() + timeout;
 	while ((retval = SDL_SemTryWait(sem)) == SDL_MUTEX_TIMEDOUT) {
-		if ((SDL_GetTicks() - end) >= 0) {
+		if ((Sint32)(SDL_GetTicks() - end) >= 0) {
 			break;
 		}
-		SDL_Delay(0);
+		SDL_Delay(1);
 	}
 #endif /* HAVE_SEM_TIMEDWAIT */
 
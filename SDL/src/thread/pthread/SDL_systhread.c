@@ -107,6 +107,43 @@ void SDL_SYS_WaitThread(SDL_Thread *thread)
 	pthread_join(thread->handle, 0);
 }
 
+/* The thread local values, set up the first time a thread uses them */
+static pthread_once_t tls_once = PTHREAD_ONCE_INIT;
+static pthread_key_t tls_key;
+static int tls_ready = 0;
+
+/* Threads SDL didn't create free their values here when they end */
+static void TLSDestructor(void *data)
+{
+	pthread_setspecific(tls_key, data);
+	SDL_TLSCleanup();
+}
+
+static void TLSCreateKey(void)
+{
+	if ( pthread_key_create(&tls_key, TLSDestructor) == 0 ) {
+		tls_ready = 1;
+	}
+}
+
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	pthread_once(&tls_once, TLSCreateKey);
+	if ( ! tls_ready ) {
+		return(NULL);
+	}
+	return((SDL_TLSData *)pthread_getspecific(tls_key));
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *data)
+{
+	pthread_once(&tls_once, TLSCreateKey);
+	if ( ! tls_ready || pthread_setspecific(tls_key, data) != 0 ) {
+		return(-1);
+	}
+	return(0);
+}
+
 void SDL_SYS_KillThread(SDL_Thread *thread)
 {
 #ifdef PTHREAD_CANCEL_ASYNCHRONOUS
@@ -25,6 +25,7 @@
 #include "SDL_timer_c.h"
 #include "SDL_mutex.h"
 #include "SDL_systimer.h"
+#include "../thread/SDL_thread_c.h"
 
 /* #define DEBUG_TIMERS */
 
@@ -37,18 +38,218 @@ SDL_TimerCallback SDL_alarm_callback;
 
 /* Data used for a thread-based timer */
 static int SDL_timer_threaded = 0;
+#if !SDL_EVENTS_DISABLED
+extern void SDL_SendEventWakeup(void);
+#endif
 
 struct _SDL_TimerID {
-	Uint32 interval;
+	Uint32 interval;	/* Milliseconds, or microseconds if 'us' is set */
+	int us;
 	SDL_NewTimerCallback cb;
 	void *param;
-	Uint32 last_alarm;
-	struct _SDL_TimerID *next;
+	Uint64 deadline;	/* When it's next due on SDL_TimerClock() */
 };
 
-static SDL_TimerID SDL_timers = NULL;
+/* The timers waiting to run, kept as a binary heap on their deadlines so
+   the next one due is always SDL_timers[0] */
+static SDL_TimerID *SDL_timers = NULL;
+static int SDL_num_timers = 0;
+static int SDL_max_timers = 0;
+
+/* The timer whose callback is running, which is out of the heap */
+static SDL_TimerID SDL_current_timer = NULL;
+static SDL_bool current_removed = SDL_FALSE;
+
 static SDL_mutex *SDL_timer_mutex;
-static volatile SDL_bool list_changed = SDL_FALSE;
+static SDL_cond *SDL_timer_cond;
+static SDL_bool SDL_timer_wake = SDL_FALSE;
+static SDL_TimerStats SDL_timer_stats;
+
+#if !SDL_TIMER_UNIX && !SDL_TIMER_WIN32
+/* The other platforms only have SDL_GetTicks(), carried into the high
+   bits when it wraps */
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	static Uint32 last = 0;
+	static Uint64 high = 0;
+	Uint32 ticks = SDL_GetTicks();
+
+	if ( ticks < last ) {
+		high += (Uint64)1 << 32;
+	}
+	last = ticks;
+	return high + ticks;
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return 1000;
+}
+#endif
+
+Uint64 SDL_GetTicksNS(void)
+{
+	Uint64 counter = SDL_GetPerformanceCounter();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+
+	if ( frequency == 1000000000 ) {
+		return counter;
+	}
+	return (counter / frequency) * 1000000000 +
+	       ((counter % frequency) * 1000000000) / frequency;
+}
+
+/* How much of a delay is spent spinning instead of sleeping, following
+   how late the sleeps have been waking up */
+#define MIN_DELAY_MARGIN	10000
+#define MAX_DELAY_MARGIN	2000000
+static Uint32 SDL_delay_margin = 200000;
+static Uint32 SDL_oversleep_mean = 50000;
+static Uint32 SDL_oversleep_dev = 50000;
+
+static void SDL_UpdateDelayMargin(Uint64 oversleep)
+{
+	Sint32 mean = (Sint32)SDL_oversleep_mean;
+	Sint32 dev = (Sint32)SDL_oversleep_dev;
+	Sint32 diff;
+	Uint32 margin;
+
+	if ( oversleep > MAX_DELAY_MARGIN ) {
+		oversleep = MAX_DELAY_MARGIN;
+	}
+	diff = (Sint32)oversleep - mean;
+	mean += diff / 8;
+	dev += ((diff < 0 ? -diff : diff) - dev) / 8;
+
+	/* Leave room for nearly every wakeup */
+	margin = (Uint32)mean + 3 * (Uint32)dev;
+	if ( margin < MIN_DELAY_MARGIN ) {
+		margin = MIN_DELAY_MARGIN;
+	} else if ( margin > MAX_DELAY_MARGIN ) {
+		margin = MAX_DELAY_MARGIN;
+	}
+	SDL_oversleep_mean = (Uint32)mean;
+	SDL_oversleep_dev = (Uint32)dev;
+	SDL_delay_margin = margin;
+}
+
+void SDL_DelayUntilNS(Uint64 ns)
+{
+	Uint32 margin = SDL_delay_margin;
+	Uint64 now, until;
+
+	now = SDL_GetTicksNS();
+	if ( now + margin < ns ) {
+		until = ns - margin;
+#if SDL_HAVE_SYS_SLEEPUNTIL
+		SDL_SYS_SleepUntilNS(until);
+#else
+		if ( (until - now) / 1000000 > 0xFFFFFFFF ) {
+			SDL_Delay(0xFFFFFFFF);
+		} else {
+			SDL_Delay((Uint32)((until - now) / 1000000));
+		}
+#endif
+		now = SDL_GetTicksNS();
+		SDL_UpdateDelayMargin(now > until ? now - until : 0);
+	}
+
+	/* Spin for the rest, sleeps aren't that precise */
+	while ( now < ns ) {
+		now = SDL_GetTicksNS();
+	}
+}
+
+void SDL_DelayNS(Uint64 ns)
+{
+	SDL_DelayUntilNS(SDL_GetTicksNS() + ns);
+}
+
+/* Microseconds since SDL_StartTicks(), for the timer deadlines */
+static Uint64 SDL_TimerClock(void)
+{
+	return SDL_GetTicksNS() / 1000;
+}
+
+/* The timer's interval in microseconds, never 0 */
+static Uint64 SDL_TimerPeriod(SDL_TimerID t)
+{
+	Uint64 period = t->interval;
+
+	if ( ! t->us ) {
+		period *= 1000;
+	}
+	return period ? period : 1;
+}
+
+static void SDL_SiftTimerUp(int i)
+{
+	SDL_TimerID t = SDL_timers[i];
+
+	while ( i > 0 ) {
+		int parent = (i - 1) / 2;
+		if ( SDL_timers[parent]->deadline <= t->deadline ) {
+			break;
+		}
+		SDL_timers[i] = SDL_timers[parent];
+		i = parent;
+	}
+	SDL_timers[i] = t;
+}
+
+static void SDL_SiftTimerDown(int i)
+{
+	SDL_TimerID t = SDL_timers[i];
+
+	for ( ;; ) {
+		int child = 2 * i + 1;
+		if ( child >= SDL_num_timers ) {
+			break;
+		}
+		if ( child + 1 < SDL_num_timers &&
+		     SDL_timers[child + 1]->deadline < SDL_timers[child]->deadline ) {
+			++child;
+		}
+		if ( t->deadline <= SDL_timers[child]->deadline ) {
+			break;
+		}
+		SDL_timers[i] = SDL_timers[child];
+		i = child;
+	}
+	SDL_timers[i] = t;
+}
+
+/* There's always room, SDL_AddTimerInternal() makes it */
+static void SDL_PushTimer(SDL_TimerID t)
+{
+	SDL_timers[SDL_num_timers] = t;
+	SDL_SiftTimerUp(SDL_num_timers++);
+}
+
+static void SDL_DeleteTimer(int i)
+{
+	--SDL_num_timers;
+	if ( i < SDL_num_timers ) {
+		SDL_timers[i] = SDL_timers[SDL_num_timers];
+		SDL_SiftTimerUp(i);
+		SDL_SiftTimerDown(i);
+	}
+}
+
+/* Let a thread waiting for the next deadline know the timers changed */
+static void SDL_WakeTimerThread(void)
+{
+	SDL_timer_wake = SDL_TRUE;
+	if ( SDL_timer_cond ) {
+		SDL_CondSignal(SDL_timer_cond);
+	}
+#if !SDL_EVENTS_DISABLED
+	if ( SDL_timer_threaded == 2 ) {
+		/* The event thread may be waiting for events */
+		SDL_SendEventWakeup();
+	}
+#endif
+}
 
 /* Set whether or not the timer should use a thread.
    This should not be called while the timer subsystem is running.
@@ -75,11 +276,17 @@ int SDL_TimerInit(void)
 	if ( SDL_timer_started ) {
 		SDL_TimerQuit();
 	}
+	/* A timer thread started by SDL_SYS_TimerInit() waits on these */
+	SDL_timer_mutex = SDL_CreateMutex();
+	SDL_timer_cond = SDL_CreateCond();
 	if ( ! SDL_timer_threaded ) {
 		retval = SDL_SYS_TimerInit();
 	}
-	if ( SDL_timer_threaded ) {
-		SDL_timer_mutex = SDL_CreateMutex();
+	if ( ! SDL_timer_threaded ) {
+		SDL_DestroyCond(SDL_timer_cond);
+		SDL_timer_cond = NULL;
+		SDL_DestroyMutex(SDL_timer_mutex);
+		SDL_timer_mutex = NULL;
 	}
 	if ( retval == 0 ) {
 		SDL_timer_started = 1;
@@ -94,87 +301,169 @@ void SDL_TimerQuit(void)
 		SDL_SYS_TimerQuit();
 	}
 	if ( SDL_timer_threaded ) {
+		SDL_DestroyCond(SDL_timer_cond);
+		SDL_timer_cond = NULL;
 		SDL_DestroyMutex(SDL_timer_mutex);
 		SDL_timer_mutex = NULL;
 	}
+	if ( SDL_timers ) {
+		SDL_free(SDL_timers);
+		SDL_timers = NULL;
+		SDL_max_timers = 0;
+	}
 	SDL_timer_started = 0;
 	SDL_timer_threaded = 0;
 }
 
-void SDL_ThreadedTimerCheck(void)
+/* Run the timers that are due, with the timer mutex held */
+static void SDL_RunTimers(void)
 {
-	Uint32 now, ms;
-	SDL_TimerID t, prev, next;
-	SDL_bool removed;
+	Uint64 now, period, late;
+	Uint32 interval;
+	SDL_TimerID t;
 
-	SDL_mutexP(SDL_timer_mutex);
-	list_changed = SDL_FALSE;
-	now = SDL_GetTicks();
-	for ( prev = NULL, t = SDL_timers; t; t = next ) {
-		removed = SDL_FALSE;
-		ms = t->interval - SDL_TIMESLICE;
-		next = t->next;
-		if ( (int)(now - t->last_alarm) > (int)ms ) {
-			struct _SDL_TimerID timer;
-
-			if ( (now - t->last_alarm) < t->interval ) {
-				t->last_alarm += t->interval;
-			} else {
-				t->last_alarm = now;
-			}
+	/* Each timer runs at most once, the rest waits for the next check */
+	now = SDL_TimerClock();
+	while ( SDL_num_timers && SDL_timers[0]->deadline <= now ) {
+		t = SDL_timers[0];
+		SDL_DeleteTimer(0);
+
+		late = SDL_TimerClock() - t->deadline;
+		++SDL_timer_stats.callbacks;
+		if ( late > 1000 ) {
+			++SDL_timer_stats.late;
+		}
+		if ( late > 0xFFFFFFFF ) {
+			late = 0xFFFFFFFF;
+		}
+		SDL_timer_stats.lateness_total += (Uint32)late;
+		if ( (Uint32)late > SDL_timer_stats.lateness_max ) {
+			SDL_timer_stats.lateness_max = (Uint32)late;
+		}
 #ifdef DEBUG_TIMERS
-			printf("Executing timer %p (thread = %d)\n",
-				t, SDL_ThreadID());
+		printf("Executing timer %p (thread = %d)\n",
+			t, SDL_ThreadID());
 #endif
-			timer = *t;
-			SDL_mutexV(SDL_timer_mutex);
-			ms = timer.cb(timer.interval, timer.param);
-			SDL_mutexP(SDL_timer_mutex);
-			if ( list_changed ) {
-				/* Abort, list of timers modified */
-				/* FIXME: what if ms was changed? */
-				break;
-			}
-			if ( ms != t->interval ) {
-				if ( ms ) {
-					t->interval = ROUND_RESOLUTION(ms);
-				} else {
-					/* Remove timer from the list */
+		SDL_current_timer = t;
+		current_removed = SDL_FALSE;
+		SDL_mutexV(SDL_timer_mutex);
+		interval = t->cb(t->interval, t->param);
+		SDL_mutexP(SDL_timer_mutex);
+		SDL_current_timer = NULL;
+
+		if ( current_removed ) {
+			SDL_free(t);
+		} else if ( ! interval ) {
+			/* Remove timer from the list */
 #ifdef DEBUG_TIMERS
-					printf("SDL: Removing timer %p\n", t);
+			printf("SDL: Removing timer %p\n", t);
 #endif
-					if ( prev ) {
-						prev->next = next;
-					} else {
-						SDL_timers = next;
-					}
-					SDL_free(t);
-					--SDL_timer_running;
-					removed = SDL_TRUE;
-				}
+			SDL_free(t);
+			--SDL_timer_running;
+		} else {
+			/* Keep in step unless a whole period was missed */
+			period = SDL_TimerPeriod(t);
+			if ( now - t->deadline >= period ) {
+				t->deadline = now;
+			}
+			t->interval = interval;
+			t->deadline += SDL_TimerPeriod(t);
+			SDL_PushTimer(t);
+		}
+	}
+}
+
+void SDL_ThreadedTimerCheck(void)
+{
+	SDL_mutexP(SDL_timer_mutex);
+	SDL_RunTimers();
+	SDL_mutexV(SDL_timer_mutex);
+}
+
+int SDL_ThreadedTimerTimeout(void)
+{
+	Uint64 now, wait;
+	int timeout = -1;
+
+	SDL_mutexP(SDL_timer_mutex);
+	if ( SDL_num_timers ) {
+		now = SDL_TimerClock();
+		if ( SDL_timers[0]->deadline > now ) {
+			/* Round up, so the timer is due on waking up */
+			wait = (SDL_timers[0]->deadline - now + 999) / 1000;
+			if ( wait > 0x7FFFFFFF ) {
+				wait = 0x7FFFFFFF;
 			}
+			timeout = (int)wait;
+		} else {
+			timeout = 0;
 		}
-		/* Don't update prev if the timer has disappeared */
-		if ( ! removed ) {
-			prev = t;
+	}
+	SDL_mutexV(SDL_timer_mutex);
+	return(timeout);
+}
+
+void SDL_ThreadedTimerWait(void)
+{
+	Uint64 now, wait;
+
+	SDL_mutexP(SDL_timer_mutex);
+	SDL_RunTimers();
+	if ( ! SDL_timer_wake ) {
+		if ( ! SDL_num_timers ) {
+			SDL_CondWait(SDL_timer_cond, SDL_timer_mutex);
+		} else {
+			now = SDL_TimerClock();
+			if ( SDL_timers[0]->deadline > now ) {
+				wait = SDL_timers[0]->deadline - now;
+				if ( wait > 0xFFFFFFFF ) {
+					wait = 0xFFFFFFFF;
+				}
+				SDL_CondWaitTimeoutUS(SDL_timer_cond,
+				                      SDL_timer_mutex, (Uint32)wait);
+			}
 		}
+		++SDL_timer_stats.wakeups;
 	}
+	SDL_timer_wake = SDL_FALSE;
+	SDL_mutexV(SDL_timer_mutex);
+}
+
+void SDL_ThreadedTimerWake(void)
+{
+	SDL_mutexP(SDL_timer_mutex);
+	SDL_WakeTimerThread();
 	SDL_mutexV(SDL_timer_mutex);
 }
 
-static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, int us, SDL_NewTimerCallback callback, void *param)
 {
 	SDL_TimerID t;
+
+	/* Make room for every timer, including one whose callback is running */
+	if ( SDL_timer_running >= SDL_max_timers ) {
+		int max_timers = SDL_max_timers ? 2 * SDL_max_timers : 8;
+		SDL_TimerID *timers = (SDL_TimerID *) SDL_realloc(SDL_timers,
+		                                  max_timers * sizeof(*timers));
+		if ( ! timers ) {
+			SDL_OutOfMemory();
+			return NULL;
+		}
+		SDL_timers = timers;
+		SDL_max_timers = max_timers;
+	}
 	t = (SDL_TimerID) SDL_malloc(sizeof(struct _SDL_TimerID));
 	if ( t ) {
-		t->interval = ROUND_RESOLUTION(interval);
+		t->interval = interval;
+		t->us = us;
 		t->cb = callback;
 		t->param = param;
-		t->last_alarm = SDL_GetTicks();
-		t->next = SDL_timers;
-		SDL_timers = t;
+		t->deadline = SDL_TimerClock() + SDL_TimerPeriod(t);
+		SDL_PushTimer(t);
 		++SDL_timer_running;
-		list_changed = SDL_TRUE;
+		if ( SDL_timers[0] == t ) {
+			SDL_WakeTimerThread();
+		}
 	}
 #ifdef DEBUG_TIMERS
 	printf("SDL_AddTimer(%d) = %08x num_timers = %d\n", interval, (Uint32)t, SDL_timer_running);
@@ -182,7 +471,7 @@ static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback ca
 	return t;
 }
 
-SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+static SDL_TimerID SDL_AddTimerChecked(Uint32 interval, int us, SDL_NewTimerCallback callback, void *param)
 {
 	SDL_TimerID t;
 	if ( ! SDL_timer_mutex ) {
@@ -198,31 +487,47 @@ SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *p
 		return NULL;
 	}
 	SDL_mutexP(SDL_timer_mutex);
-	t = SDL_AddTimerInternal(interval, callback, param);
+	t = SDL_AddTimerInternal(interval, us, callback, param);
 	SDL_mutexV(SDL_timer_mutex);
 	return t;
 }
 
+SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+{
+	return SDL_AddTimerChecked(interval, 0, callback, param);
+}
+
+SDL_TimerID SDL_AddTimerUS(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+{
+	return SDL_AddTimerChecked(interval, 1, callback, param);
+}
+
 SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 {
-	SDL_TimerID t, prev = NULL;
+	int i;
 	SDL_bool removed;
 
 	removed = SDL_FALSE;
 	SDL_mutexP(SDL_timer_mutex);
-	/* Look for id in the linked list of timers */
-	for (t = SDL_timers; t; prev=t, t = t->next ) {
-		if ( t == id ) {
-			if(prev) {
-				prev->next = t->next;
-			} else {
-				SDL_timers = t->next;
+	if ( id && id == SDL_current_timer && ! current_removed ) {
+		/* Freed when its callback returns */
+		current_removed = SDL_TRUE;
+		--SDL_timer_running;
+		removed = SDL_TRUE;
+	} else {
+		/* Look for id in the heap of timers */
+		for ( i = 0; i < SDL_num_timers; ++i ) {
+			if ( SDL_timers[i] == id ) {
+				SDL_DeleteTimer(i);
+				SDL_free(id);
+				--SDL_timer_running;
+				removed = SDL_TRUE;
+				/* The thread may be waiting for it */
+				if ( i == 0 ) {
+					SDL_WakeTimerThread();
+				}
+				break;
 			}
-			SDL_free(t);
-			--SDL_timer_running;
-			removed = SDL_TRUE;
-			list_changed = SDL_TRUE;
-			break;
 		}
 	}
 #ifdef DEBUG_TIMERS
@@ -232,6 +537,22 @@ SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 	return removed;
 }
 
+void SDL_GetTimerStats(SDL_TimerStats *stats, int reset)
+{
+	if ( SDL_timer_mutex ) {
+		SDL_mutexP(SDL_timer_mutex);
+	}
+	if ( stats ) {
+		*stats = SDL_timer_stats;
+	}
+	if ( reset ) {
+		SDL_memset(&SDL_timer_stats, 0, sizeof(SDL_timer_stats));
+	}
+	if ( SDL_timer_mutex ) {
+		SDL_mutexV(SDL_timer_mutex);
+	}
+}
+
 /* Old style callback functions are wrapped through this */
 static Uint32 SDLCALL callback_wrapper(Uint32 ms, void *param)
 {
@@ -253,13 +574,14 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 	}
 	if ( SDL_timer_running ) {	/* Stop any currently running timer */
 		if ( SDL_timer_threaded ) {
-			while ( SDL_timers ) {
-				SDL_TimerID freeme = SDL_timers;
-				SDL_timers = SDL_timers->next;
-				SDL_free(freeme);
+			while ( SDL_num_timers ) {
+				SDL_free(SDL_timers[--SDL_num_timers]);
+			}
+			if ( SDL_current_timer ) {
+				current_removed = SDL_TRUE;
 			}
 			SDL_timer_running = 0;
-			list_changed = SDL_TRUE;
+			SDL_WakeTimerThread();
 		} else {
 			SDL_SYS_StopTimer();
 			SDL_timer_running = 0;
@@ -267,7 +589,7 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 	}
 	if ( ms ) {
 		if ( SDL_timer_threaded ) {
-			if ( SDL_AddTimerInternal(ms, callback_wrapper, (void *)callback) == NULL ) {
+			if ( SDL_AddTimerInternal(ms, 0, callback_wrapper, (void *)callback) == NULL ) {
 				retval = -1;
 			}
 		} else {
@@ -44,3 +44,23 @@ extern void SDL_TimerQuit(void);
 
 /* This function is called from the SDL event thread if it is available */
 extern void SDL_ThreadedTimerCheck(void);
+
+/* Milliseconds until the next timer is due, or -1 if there are none, for
+   the event thread to wait for events in between */
+extern int SDL_ThreadedTimerTimeout(void);
+
+/* Run the timers that are due, then sleep until the next one is due or
+   the timers change.  This is the loop of a thread that only runs timers.
+ */
+extern void SDL_ThreadedTimerWait(void);
+
+/* Wake up a thread sleeping in SDL_ThreadedTimerWait() */
+extern void SDL_ThreadedTimerWake(void);
+
+/* Sleep until SDL_GetTicksNS() reaches 'ns' as precisely as the system
+   allows, for the platforms that can do better than SDL_Delay().
+ */
+#if SDL_TIMER_UNIX && !SDL_THREAD_PTH
+#define SDL_HAVE_SYS_SLEEPUNTIL	1
+extern void SDL_SYS_SleepUntilNS(Uint64 ns);
+#endif
@@ -38,8 +38,15 @@
    for __USE_POSIX199309
    Tommi Kyntola (tommi.kyntola@ray.fi) 27/09/2005
 */
-#if HAVE_NANOSLEEP || HAVE_CLOCK_GETTIME
 #include <time.h>
+
+/* glibc 2.17 and later have clock_gettime() in libc itself, so there's
+   no need to link with librt for it, and it's read without a system call
+*/
+#if !HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC) && defined(__GLIBC__)
+#if (__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 17)
+#define HAVE_CLOCK_GETTIME 1
+#endif
 #endif
 
 #if SDL_THREAD_PTH
@@ -85,6 +92,30 @@ Uint32 SDL_GetTicks (void)
 #endif
 }
 
+Uint64 SDL_GetPerformanceCounter(void)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return (Uint64)(now.tv_sec-start.tv_sec)*1000000000 +
+	       (now.tv_nsec-start.tv_nsec);
+#else
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return (Uint64)(now.tv_sec-start.tv_sec)*1000000 +
+	       (now.tv_usec-start.tv_usec);
+#endif
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+#if HAVE_CLOCK_GETTIME
+	return 1000000000;
+#else
+	return 1000000;
+#endif
+}
+
 void SDL_Delay (Uint32 ms)
 {
 #if SDL_THREAD_PTH
@@ -134,6 +165,47 @@ void SDL_Delay (Uint32 ms)
 #endif /* SDL_THREAD_PTH */
 }
 
+#if !SDL_THREAD_PTH
+void SDL_SYS_SleepUntilNS(Uint64 ns)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec until;
+
+	until.tv_sec = start.tv_sec + (time_t)(ns/1000000000);
+	until.tv_nsec = start.tv_nsec + (long)(ns%1000000000);
+	if ( until.tv_nsec >= 1000000000 ) {
+		until.tv_sec += 1;
+		until.tv_nsec -= 1000000000;
+	}
+	/* An absolute wait doesn't get longer when a signal interrupts it */
+	while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+	                        &until, NULL) == EINTR ) {
+		continue;
+	}
+#else
+	Uint64 now, left;
+#if HAVE_NANOSLEEP
+	struct timespec tv;
+#else
+	struct timeval tv;
+#endif
+
+	while ( (now = SDL_GetTicksNS()) < ns ) {
+		left = ns - now;
+#if HAVE_NANOSLEEP
+		tv.tv_sec = (time_t)(left/1000000000);
+		tv.tv_nsec = (long)(left%1000000000);
+		nanosleep(&tv, NULL);
+#else
+		tv.tv_sec = (time_t)(left/1000000000);
+		tv.tv_usec = (long)((left%1000000000)/1000);
+		select(0, NULL, NULL, NULL, &tv);
+#endif
+	}
+#endif /* HAVE_CLOCK_GETTIME */
+}
+#endif /* !SDL_THREAD_PTH */
+
 #ifdef USE_ITIMER
 
 static void HandleAlarm(int sig)
@@ -197,10 +269,7 @@ static SDL_Thread *timer = NULL;
 static int RunTimer(void *unused)
 {
 	while ( timer_alive ) {
-		if ( SDL_timer_running ) {
-			SDL_ThreadedTimerCheck();
-		}
-		SDL_Delay(1);
+		SDL_ThreadedTimerWait();
 	}
 	return(0);
 }
@@ -219,6 +288,7 @@ void SDL_SYS_TimerQuit(void)
 {
 	timer_alive = 0;
 	if ( timer ) {
+		SDL_ThreadedTimerWake();
 		SDL_WaitThread(timer, NULL);
 		timer = NULL;
 	}
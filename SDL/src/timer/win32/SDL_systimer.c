@@ -48,9 +48,17 @@ static LARGE_INTEGER hires_start_ticks;
 static LARGE_INTEGER hires_ticks_per_second;
 #endif
 
+/* The performance counter at startup and its frequency, 0 if there's none */
+static LARGE_INTEGER counter_start;
+static LARGE_INTEGER counter_frequency;
+
 void SDL_StartTicks(void)
 {
 	/* Set first ticks value */
+	if ( ! QueryPerformanceFrequency(&counter_frequency) ||
+	     ! QueryPerformanceCounter(&counter_start) ) {
+		counter_frequency.QuadPart = 0;
+	}
 #ifdef USE_GETTICKCOUNT
 	start = GetTickCount();
 #else
@@ -104,6 +112,34 @@ Uint32 SDL_GetTicks(void)
 	return(ticks);
 }
 
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	/* Count the ticks in high bits that don't wrap if there's no counter */
+	static Uint32 last = 0;
+	static Uint64 high = 0;
+	LARGE_INTEGER now;
+	Uint32 ticks;
+
+	if ( counter_frequency.QuadPart ) {
+		QueryPerformanceCounter(&now);
+		return (Uint64)(now.QuadPart - counter_start.QuadPart);
+	}
+	ticks = SDL_GetTicks();
+	if ( ticks < last ) {
+		high += (Uint64)1 << 32;
+	}
+	last = ticks;
+	return high + ticks;
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	if ( counter_frequency.QuadPart ) {
+		return (Uint64)counter_frequency.QuadPart;
+	}
+	return 1000;
+}
+
 void SDL_Delay(Uint32 ms)
 {
 	Sleep(ms);
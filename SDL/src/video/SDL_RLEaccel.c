@@ -90,6 +90,7 @@
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
+#include "SDL_parallel_c.h"
 
 /* Force MMX to 0; this blows up on almost every major compiler now. --ryan. */
 #if 0 && defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && SDL_ASSEMBLY_ROUTINES
@@ -108,6 +109,64 @@
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+/*
+ * The encoding is made in bands of RLE_BAND_ROWS rows, which are encoded
+ * independently (and in parallel for large surfaces) and then concatenated.
+ * The index remembers where each band is, so that when the surface is
+ * locked and unlocked again only the bands that were modified in between
+ * have to be encoded again; the others are copied from the old encoding.
+ *
+ * It also has the offset of every line (of both the opaque and translucent
+ * halves of a line for pixel alpha encodings), so blits of a part of the
+ * surface can start at the first line they need, and every RLE_CHECKPOINT
+ * pixels a checkpoint of the run covering that pixel, so that lines which
+ * are clipped on the left don't have to be walked from the start.
+ */
+#define RLE_BAND_ROWS	16
+
+/* Minimum number of pixels worth handing to another thread */
+#define RLE_THREAD_PIXELS	(64 * 1024)
+
+/* Distance in pixels between checkpoints on a line */
+#define RLE_CHECKPOINT	256
+
+typedef struct {
+    Uint32 offset;		/* where the run starts, from the line start */
+    Uint32 x;			/* x position before its skip count */
+} RLECheckpoint;
+
+struct private_rleindex {
+    int bands;			/* number of bands in the surface */
+    int last;			/* last band with visible pixels, or -1 */
+    int *offset;		/* where each band starts in aux_data */
+    int *length;		/* encoded size of each band */
+    int *used;			/* size up to the end of its last visible row */
+    int *todo;			/* bands being encoded */
+    int sections;		/* encoded lines per row */
+    int *line;			/* where each line starts in aux_data */
+    int checkpoints;		/* checkpoints per line */
+    RLECheckpoint *checkpoint;	/* checkpoints of each line */
+    Uint8 *dirty;		/* bands modified while locked */
+    int tracking;		/* only the dirty bands have been modified */
+    int suspended;		/* surface is decoded for locking */
+};
+
+/* Find where the encoded line 'n' starts when clipped at 'left' */
+static Uint8 *RLESeek(Uint8 *aux, struct private_rleindex *index,
+		      int n, int left, int *ofs)
+{
+    Uint8 *srcbuf = aux + index->line[n];
+
+    *ofs = 0;
+    if(left >= RLE_CHECKPOINT && index->checkpoints) {
+	RLECheckpoint *cp = index->checkpoint + n * index->checkpoints
+			    + left / RLE_CHECKPOINT - 1;
+	srcbuf += cp->offset;
+	*ofs = cp->x;
+    }
+    return srcbuf;
+}
+
 #define PIXEL_COPY(to, from, len, bpp)			\
 do {							\
     if(bpp == 4) {					\
@@ -778,55 +837,56 @@ do {							\
 
 /*
  * This takes care of the case when the surface is clipped on the left and/or
- * right. Top clipping has already been taken care of.
+ * right.  Each line is entered at the checkpoint before the left edge and
+ * left as soon as the right edge is reached.
  */
-static void RLEClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
-			Uint8 *dstbuf, SDL_Rect *srcrect, unsigned alpha)
+static void RLEClipBlit(Uint8 *aux, struct private_rleindex *index,
+			SDL_Surface *dst, Uint8 *dstbuf, SDL_Rect *srcrect,
+			unsigned alpha)
 {
     SDL_PixelFormat *fmt = dst->format;
 
 #define RLECLIPBLIT(bpp, Type, do_blit)					   \
     do {								   \
+	int line = srcrect->y;						   \
 	int linecount = srcrect->h;					   \
-	int ofs = 0;							   \
 	int left = srcrect->x;						   \
 	int right = left + srcrect->w;					   \
 	dstbuf -= left * bpp;						   \
-	for(;;) {							   \
-	    int run;							   \
-	    ofs += *(Type *)srcbuf;					   \
-	    run = ((Type *)srcbuf)[1];					   \
-	    srcbuf += 2 * sizeof(Type);					   \
-	    if(run) {							   \
-		/* clip to left and right borders */			   \
-		if(ofs < right) {					   \
-		    int start = 0;					   \
-		    int len = run;					   \
-		    int startcol;					   \
-		    if(left - ofs > 0) {				   \
-			start = left - ofs;				   \
-			len -= start;					   \
-			if(len <= 0)					   \
-			    goto nocopy ## bpp ## do_blit;		   \
+	do {								   \
+	    int ofs;							   \
+	    Uint8 *srcbuf = RLESeek(aux, index, line++, left, &ofs);	   \
+	    do {							   \
+		int run;						   \
+		ofs += *(Type *)srcbuf;					   \
+		run = ((Type *)srcbuf)[1];				   \
+		srcbuf += 2 * sizeof(Type);				   \
+		if(run) {						   \
+		    /* clip to left and right borders */		   \
+		    if(ofs < right) {					   \
+			int start = 0;					   \
+			int len = run;					   \
+			int startcol;					   \
+			if(left - ofs > 0) {				   \
+			    start = left - ofs;				   \
+			    len -= start;				   \
+			    if(len <= 0)				   \
+				goto nocopy ## bpp ## do_blit;		   \
+			}						   \
+			startcol = ofs + start;				   \
+			if(len > right - startcol)			   \
+			    len = right - startcol;			   \
+			do_blit(dstbuf + startcol * bpp, srcbuf + start * bpp, \
+				len, bpp, alpha);			   \
 		    }							   \
-		    startcol = ofs + start;				   \
-		    if(len > right - startcol)				   \
-			len = right - startcol;				   \
-		    do_blit(dstbuf + startcol * bpp, srcbuf + start * bpp, \
-			    len, bpp, alpha);				   \
-		}							   \
-	    nocopy ## bpp ## do_blit:					   \
-		srcbuf += run * bpp;					   \
-		ofs += run;						   \
-	    } else if(!ofs)						   \
-		break;							   \
-	    if(ofs == w) {						   \
-		ofs = 0;						   \
-		dstbuf += dst->pitch;					   \
-		if(!--linecount)					   \
-		    break;						   \
-	    }								   \
-	}								   \
+		nocopy ## bpp ## do_blit:				   \
+		    srcbuf += run * bpp;				   \
+		    ofs += run;						   \
+		} else if(!ofs)						   \
+		    return;						   \
+	    } while(ofs < right);					   \
+	    dstbuf += dst->pitch;					   \
+	} while(--linecount);						   \
     } while(0)
 
     CHOOSE_BLIT(RLECLIPBLIT, alpha, fmt);
@@ -842,6 +902,8 @@ int SDL_RLEBlit(SDL_Surface *src, SDL_Rect *srcrect,
 {
 	Uint8 *dstbuf;
 	Uint8 *srcbuf;
+	Uint8 *aux;
+	struct private_rleindex *index;
 	int x, y;
 	int w = src->w;
 	unsigned alpha;
@@ -851,6 +913,9 @@ int SDL_RLEBlit(SDL_Surface *src, SDL_Rect *srcrect,
 		if ( SDL_LockSurface(dst) < 0 ) {
 			return(-1);
 		}
+		if ( dst->flags & SDL_RLEACCEL ) {
+			SDL_DirtyRLESurface(dst, dstrect->y, dstrect->h, 0);
+		}
 	}
 
 	/* Set up the source and destination pointers */
@@ -858,49 +923,18 @@ int SDL_RLEBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	y = dstrect->y;
 	dstbuf = (Uint8 *)dst->pixels
 	         + y * dst->pitch + x * src->format->BytesPerPixel;
-	srcbuf = (Uint8 *)src->map->sw_data->aux_data;
-
-	{
-	    /* skip lines at the top if neccessary */
-	    int vskip = srcrect->y;
-	    int ofs = 0;
-	    if(vskip) {
-
-#define RLESKIP(bpp, Type)			\
-		for(;;) {			\
-		    int run;			\
-		    ofs += *(Type *)srcbuf;	\
-		    run = ((Type *)srcbuf)[1];	\
-		    srcbuf += sizeof(Type) * 2;	\
-		    if(run) {			\
-			srcbuf += run * bpp;	\
-			ofs += run;		\
-		    } else if(!ofs)		\
-			goto done;		\
-		    if(ofs == w) {		\
-			ofs = 0;		\
-			if(!--vskip)		\
-			    break;		\
-		    }				\
-		}
+	aux = (Uint8 *)src->map->sw_data->aux_data;
+	index = src->map->sw_data->rle_index;
+	srcbuf = aux;
 
-		switch(src->format->BytesPerPixel) {
-		case 1: RLESKIP(1, Uint8); break;
-		case 2: RLESKIP(2, Uint8); break;
-		case 3: RLESKIP(3, Uint8); break;
-		case 4: RLESKIP(4, Uint16); break;
-		}
-
-#undef RLESKIP
-
-	    }
-	}
+	/* skip lines at the top if neccessary */
+	srcbuf += index->line[srcrect->y];
 
 	alpha = (src->flags & SDL_SRCALPHA) == SDL_SRCALPHA
 	        ? src->format->alpha : 255;
 	/* if left or right edge clipping needed, call clip blit */
 	if ( srcrect->x || srcrect->w != src->w ) {
-	    RLEClipBlit(w, srcbuf, dst, dstbuf, srcrect, alpha);
+	    RLEClipBlit(aux, index, dst, dstbuf, srcrect, alpha);
 	} else {
 	    SDL_PixelFormat *fmt = src->format;
 
@@ -933,7 +967,6 @@ int SDL_RLEBlit(SDL_Surface *src, SDL_Rect *srcrect,
 #undef RLEBLIT
 	}
 
-done:
 	/* Unlock the destination if necessary */
 	if ( SDL_MUSTLOCK(dst) ) {
 		SDL_UnlockSurface(dst);
@@ -1012,8 +1045,9 @@ typedef struct {
 } RLEDestFormat;
 
 /* blit a pixel-alpha RLE surface clipped at the right and/or left edges */
-static void RLEAlphaClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
-			     Uint8 *dstbuf, SDL_Rect *srcrect)
+static void RLEAlphaClipBlit(Uint8 *aux, struct private_rleindex *index,
+			     SDL_Surface *dst, Uint8 *dstbuf,
+			     SDL_Rect *srcrect)
 {
     SDL_PixelFormat *df = dst->format;
     /*
@@ -1023,13 +1057,15 @@ static void RLEAlphaClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
      */
 #define RLEALPHACLIPBLIT(Ptype, Ctype, do_blend)			  \
     do {								  \
+	int line = srcrect->y * 2;					  \
 	int linecount = srcrect->h;					  \
 	int left = srcrect->x;						  \
 	int right = left + srcrect->w;					  \
 	dstbuf -= left * sizeof(Ptype);					  \
 	do {								  \
-	    int ofs = 0;						  \
+	    int ofs;							  \
 	    /* blit opaque pixels on one line */			  \
+	    Uint8 *srcbuf = RLESeek(aux, index, line++, left, &ofs);	  \
 	    do {							  \
 		unsigned run;						  \
 		ofs += ((Ctype *)srcbuf)[0];				  \
@@ -1053,12 +1089,9 @@ static void RLEAlphaClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
 		    ofs += run;						  \
 		} else if(!ofs)						  \
 		    return;						  \
-	    } while(ofs < w);						  \
-	    /* skip padding if necessary */				  \
-	    if(sizeof(Ptype) == 2)					  \
-		srcbuf += (uintptr_t)srcbuf & 2;			  \
+	    } while(ofs < right);					  \
 	    /* blit translucent pixels on the same line */		  \
-	    ofs = 0;							  \
+	    srcbuf = RLESeek(aux, index, line++, left, &ofs);		  \
 	    do {							  \
 		unsigned run;						  \
 		ofs += ((Uint16 *)srcbuf)[0];				  \
@@ -1084,7 +1117,7 @@ static void RLEAlphaClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
 		    srcbuf += run * 4;					  \
 		    ofs += run;						  \
 		}							  \
-	    } while(ofs < w);						  \
+	    } while(ofs < right);					  \
 	    dstbuf += dst->pitch;					  \
 	} while(--linecount);						  \
     } while(0)
@@ -1109,7 +1142,8 @@ int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
 {
     int x, y;
     int w = src->w;
-    Uint8 *srcbuf, *dstbuf;
+    Uint8 *srcbuf, *dstbuf, *aux;
+    struct private_rleindex *index;
     SDL_PixelFormat *df = dst->format;
 
     /* Lock the destination if necessary */
@@ -1117,73 +1151,24 @@ int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	if ( SDL_LockSurface(dst) < 0 ) {
 	    return -1;
 	}
+	if ( dst->flags & SDL_RLEACCEL ) {
+	    SDL_DirtyRLESurface(dst, dstrect->y, dstrect->h, 0);
+	}
     }
 
     x = dstrect->x;
     y = dstrect->y;
     dstbuf = (Uint8 *)dst->pixels
 	     + y * dst->pitch + x * df->BytesPerPixel;
-    srcbuf = (Uint8 *)src->map->sw_data->aux_data + sizeof(RLEDestFormat);
-
-    {
-	/* skip lines at the top if necessary */
-	int vskip = srcrect->y;
-	if(vskip) {
-	    int ofs;
-	    if(df->BytesPerPixel == 2) {
-		/* the 16/32 interleaved format */
-		do {
-		    /* skip opaque line */
-		    ofs = 0;
-		    do {
-			int run;
-			ofs += srcbuf[0];
-			run = srcbuf[1];
-			srcbuf += 2;
-			if(run) {
-			    srcbuf += 2 * run;
-			    ofs += run;
-			} else if(!ofs)
-			    goto done;
-		    } while(ofs < w);
-
-		    /* skip padding */
-		    srcbuf += (uintptr_t)srcbuf & 2;
-
-		    /* skip translucent line */
-		    ofs = 0;
-		    do {
-			int run;
-			ofs += ((Uint16 *)srcbuf)[0];
-			run = ((Uint16 *)srcbuf)[1];
-			srcbuf += 4 * (run + 1);
-			ofs += run;
-		    } while(ofs < w);
-		} while(--vskip);
-	    } else {
-		/* the 32/32 interleaved format */
-		vskip <<= 1;	/* opaque and translucent have same format */
-		do {
-		    ofs = 0;
-		    do {
-			int run;
-			ofs += ((Uint16 *)srcbuf)[0];
-			run = ((Uint16 *)srcbuf)[1];
-			srcbuf += 4;
-			if(run) {
-			    srcbuf += 4 * run;
-			    ofs += run;
-			} else if(!ofs)
-			    goto done;
-		    } while(ofs < w);
-		} while(--vskip);
-	    }
-	}
-    }
+    aux = (Uint8 *)src->map->sw_data->aux_data;
+    index = src->map->sw_data->rle_index;
+
+    /* skip lines at the top if necessary */
+    srcbuf = aux + index->line[srcrect->y * 2];
 
     /* if left or right edge clipping needed, call clip blit */
     if(srcrect->x || srcrect->w != src->w) {
-	RLEAlphaClipBlit(w, srcbuf, dst, dstbuf, srcrect);
+	RLEAlphaClipBlit(aux, index, dst, dstbuf, srcrect);
     } else {
 
 	/*
@@ -1396,21 +1381,182 @@ static int uncopy_32(Uint32 *dst, void *src, int n,
 #define ISTRANSL(pixel, fmt)	\
     ((unsigned)((((pixel) & fmt->Amask) >> fmt->Ashift) - 1U) < 254U)
 
-/* convert surface to be quickly alpha-blittable onto dest, if possible */
-static int RLEAlphaSurface(SDL_Surface *surface)
-{
-    SDL_Surface *dest;
+typedef struct RLEEncoder RLEEncoder;
+
+struct RLEEncoder {
+    SDL_Surface *surface;
+    int (*encode)(RLEEncoder *enc, int y, int h, Uint8 *dst, int *used);
+    int maxline;		/* worst case encoded size of one line */
+    int header;			/* bytes before the first line */
+    int endsize;		/* size of the end of data marker */
+    int sections;		/* encoded lines per row */
+    RLEDestFormat format;	/* header of alpha encodings */
+
+    /* alpha encoding parameters */
     SDL_PixelFormat *df;
-    int maxsize = 0;
     int max_opaque_run;
-    int max_transl_run = 65535;
-    unsigned masksum;
-    Uint8 *rlebuf, *dst;
     int (*copy_opaque)(void *, Uint32 *, int,
 		       SDL_PixelFormat *, SDL_PixelFormat *);
     int (*copy_transl)(void *, Uint32 *, int,
 		       SDL_PixelFormat *, SDL_PixelFormat *);
 
+    /* where the bands are being encoded */
+    struct private_rleindex *index;
+    Uint8 *scratch;
+    int slot;
+};
+
+/*
+ * Index keeping for the band encoders: START_LINE records where a line
+ * starts, relative to the start of the band, and ADD_CHECKPOINTS(n, m)
+ * records the checkpoints covered by the next count pair.
+ */
+#define START_LINE()				\
+	*line++ = dst - start;			\
+	linestart = dst;			\
+	cpend = cp + ncp;			\
+	cpx = RLE_CHECKPOINT;			\
+	pos = 0
+
+#define ADD_CHECKPOINTS(n, m)			\
+	pos += (n) + (m);			\
+	while(cp < cpend && cpx < pos) {	\
+	    cp->offset = dst - linestart;	\
+	    cp->x = pos - (n) - (m);		\
+	    cp++;				\
+	    cpx += RLE_CHECKPOINT;		\
+	}
+
+/* encode rows y to y+h-1 of a surface with per-pixel alpha */
+static int RLEAlphaBand(RLEEncoder *enc, int y, int h, Uint8 *dst, int *used)
+{
+    SDL_Surface *surface = enc->surface;
+    SDL_PixelFormat *sf = surface->format;
+    SDL_PixelFormat *df = enc->df;
+    int max_opaque_run = enc->max_opaque_run;
+    int max_transl_run = 65535;
+    int x, w = surface->w;
+    Uint32 *src = (Uint32 *)((Uint8 *)surface->pixels + y * surface->pitch);
+    Uint8 *start = dst;
+    Uint8 *lastline = dst;	/* end of last non-blank line */
+    int *line = enc->index->line + y * 2;
+    int ncp = enc->index->checkpoints;
+    RLECheckpoint *cp = enc->index->checkpoint + y * 2 * ncp;
+    RLECheckpoint *cpend;
+    Uint8 *linestart;
+    int pos, cpx;
+
+    /* opaque counts are 8 or 16 bits, depending on target depth */
+#define ADD_OPAQUE_COUNTS(n, m)			\
+	ADD_CHECKPOINTS(n, m);			\
+	if(df->BytesPerPixel == 4) {		\
+	    ((Uint16 *)dst)[0] = n;		\
+	    ((Uint16 *)dst)[1] = m;		\
+	    dst += 4;				\
+	} else {				\
+	    dst[0] = n;				\
+	    dst[1] = m;				\
+	    dst += 2;				\
+	}
+
+    /* translucent counts are always 16 bit */
+#define ADD_TRANSL_COUNTS(n, m)		\
+	ADD_CHECKPOINTS(n, m);		\
+	(((Uint16 *)dst)[0] = n, ((Uint16 *)dst)[1] = m, dst += 4)
+
+    for(; h; h--) {
+	int runstart, skipstart;
+	int blankline = 0;
+	/* First encode all opaque pixels of a scan line */
+	START_LINE();
+	x = 0;
+	do {
+	    int run, skip, len;
+	    skipstart = x;
+	    while(x < w && !ISOPAQUE(src[x], sf))
+		x++;
+	    runstart = x;
+	    while(x < w && ISOPAQUE(src[x], sf))
+		x++;
+	    skip = runstart - skipstart;
+	    if(skip == w)
+		blankline = 1;
+	    run = x - runstart;
+	    while(skip > max_opaque_run) {
+		ADD_OPAQUE_COUNTS(max_opaque_run, 0);
+		skip -= max_opaque_run;
+	    }
+	    len = MIN(run, max_opaque_run);
+	    ADD_OPAQUE_COUNTS(skip, len);
+	    dst += enc->copy_opaque(dst, src + runstart, len, sf, df);
+	    runstart += len;
+	    run -= len;
+	    while(run) {
+		len = MIN(run, max_opaque_run);
+		ADD_OPAQUE_COUNTS(0, len);
+		dst += enc->copy_opaque(dst, src + runstart, len, sf, df);
+		runstart += len;
+		run -= len;
+	    }
+	} while(x < w);
+
+	/* Make sure the next output address is 32-bit aligned */
+	dst += (uintptr_t)dst & 2;
+
+	/* Next, encode all translucent pixels of the same scan line */
+	START_LINE();
+	x = 0;
+	do {
+	    int run, skip, len;
+	    skipstart = x;
+	    while(x < w && !ISTRANSL(src[x], sf))
+		x++;
+	    runstart = x;
+	    while(x < w && ISTRANSL(src[x], sf))
+		x++;
+	    skip = runstart - skipstart;
+	    blankline &= (skip == w);
+	    run = x - runstart;
+	    while(skip > max_transl_run) {
+		ADD_TRANSL_COUNTS(max_transl_run, 0);
+		skip -= max_transl_run;
+	    }
+	    len = MIN(run, max_transl_run);
+	    ADD_TRANSL_COUNTS(skip, len);
+	    dst += enc->copy_transl(dst, src + runstart, len, sf, df);
+	    runstart += len;
+	    run -= len;
+	    while(run) {
+		len = MIN(run, max_transl_run);
+		ADD_TRANSL_COUNTS(0, len);
+		dst += enc->copy_transl(dst, src + runstart, len, sf, df);
+		runstart += len;
+		run -= len;
+	    }
+	    if(!blankline)
+		lastline = dst;
+	} while(x < w);
+
+	src += surface->pitch >> 2;
+    }
+
+#undef ADD_OPAQUE_COUNTS
+#undef ADD_TRANSL_COUNTS
+
+    *used = lastline - start;
+    return dst - start;
+}
+
+/* set up encoding a surface to be quickly alpha-blittable onto dest,
+   if possible */
+static int RLEAlphaSetup(RLEEncoder *enc)
+{
+    SDL_Surface *surface = enc->surface;
+    SDL_Surface *dest;
+    SDL_PixelFormat *df;
+    unsigned masksum;
+    int w = surface->w;
+
     dest = surface->map->dst;
     if(!dest)
 	return -1;
@@ -1419,7 +1565,7 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 	return -1;		/* only 32bpp source supported */
 
     /* find out whether the destination is one we support,
-       and determine the max size of the encoded result */
+       and determine the max size of an encoded line */
     masksum = df->Rmask | df->Gmask | df->Bmask;
     switch(df->BytesPerPixel) {
     case 2:
@@ -1428,184 +1574,61 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 	case 0xffff:
 	    if(df->Gmask == 0x07e0
 	       || df->Rmask == 0x07e0 || df->Bmask == 0x07e0) {
-		copy_opaque = copy_opaque_16;
-		copy_transl = copy_transl_565;
+		enc->copy_opaque = copy_opaque_16;
+		enc->copy_transl = copy_transl_565;
 	    } else
 		return -1;
 	    break;
 	case 0x7fff:
 	    if(df->Gmask == 0x03e0
 	       || df->Rmask == 0x03e0 || df->Bmask == 0x03e0) {
-		copy_opaque = copy_opaque_16;
-		copy_transl = copy_transl_555;
+		enc->copy_opaque = copy_opaque_16;
+		enc->copy_transl = copy_transl_555;
 	    } else
 		return -1;
 	    break;
 	default:
 	    return -1;
 	}
-	max_opaque_run = 255;	/* runs stored as bytes */
+	enc->max_opaque_run = 255;	/* runs stored as bytes */
 
 	/* worst case is alternating opaque and translucent pixels,
 	   with room for alignment padding between lines */
-	maxsize = surface->h * (2 + (4 + 2) * (surface->w + 1)) + 2;
+	enc->maxline = 2 + (4 + 2) * (w + 1);
+	enc->endsize = 2;
 	break;
     case 4:
 	if(masksum != 0x00ffffff)
 	    return -1;		/* requires unused high byte */
-	copy_opaque = copy_32;
-	copy_transl = copy_32;
-	max_opaque_run = 255;	/* runs stored as short ints */
+	enc->copy_opaque = copy_32;
+	enc->copy_transl = copy_32;
+	enc->max_opaque_run = 255;	/* runs stored as short ints */
 
 	/* worst case is alternating opaque and translucent pixels */
-	maxsize = surface->h * 2 * 4 * (surface->w + 1) + 4;
+	enc->maxline = 2 * 4 * (w + 1);
+	enc->endsize = 4;
 	break;
     default:
 	return -1;		/* anything else unsupported right now */
     }
-
-    maxsize += sizeof(RLEDestFormat);
-    rlebuf = (Uint8 *)SDL_malloc(maxsize);
-    if(!rlebuf) {
-	SDL_OutOfMemory();
-	return -1;
-    }
-    {
-	/* save the destination format so we can undo the encoding later */
-	RLEDestFormat *r = (RLEDestFormat *)rlebuf;
-	r->BytesPerPixel = df->BytesPerPixel;
-	r->Rloss = df->Rloss;
-	r->Gloss = df->Gloss;
-	r->Bloss = df->Bloss;
-	r->Rshift = df->Rshift;
-	r->Gshift = df->Gshift;
-	r->Bshift = df->Bshift;
-	r->Ashift = df->Ashift;
-	r->Rmask = df->Rmask;
-	r->Gmask = df->Gmask;
-	r->Bmask = df->Bmask;
-	r->Amask = df->Amask;
-    }
-    dst = rlebuf + sizeof(RLEDestFormat);
-
-    /* Do the actual encoding */
-    {
-	int x, y;
-	int h = surface->h, w = surface->w;
-	SDL_PixelFormat *sf = surface->format;
-	Uint32 *src = (Uint32 *)surface->pixels;
-	Uint8 *lastline = dst;	/* end of last non-blank line */
-
-	/* opaque counts are 8 or 16 bits, depending on target depth */
-#define ADD_OPAQUE_COUNTS(n, m)			\
-	if(df->BytesPerPixel == 4) {		\
-	    ((Uint16 *)dst)[0] = n;		\
-	    ((Uint16 *)dst)[1] = m;		\
-	    dst += 4;				\
-	} else {				\
-	    dst[0] = n;				\
-	    dst[1] = m;				\
-	    dst += 2;				\
-	}
-
-	/* translucent counts are always 16 bit */
-#define ADD_TRANSL_COUNTS(n, m)		\
-	(((Uint16 *)dst)[0] = n, ((Uint16 *)dst)[1] = m, dst += 4)
-
-	for(y = 0; y < h; y++) {
-	    int runstart, skipstart;
-	    int blankline = 0;
-	    /* First encode all opaque pixels of a scan line */
-	    x = 0;
-	    do {
-		int run, skip, len;
-		skipstart = x;
-		while(x < w && !ISOPAQUE(src[x], sf))
-		    x++;
-		runstart = x;
-		while(x < w && ISOPAQUE(src[x], sf))
-		    x++;
-		skip = runstart - skipstart;
-		if(skip == w)
-		    blankline = 1;
-		run = x - runstart;
-		while(skip > max_opaque_run) {
-		    ADD_OPAQUE_COUNTS(max_opaque_run, 0);
-		    skip -= max_opaque_run;
-		}
-		len = MIN(run, max_opaque_run);
-		ADD_OPAQUE_COUNTS(skip, len);
-		dst += copy_opaque(dst, src + runstart, len, sf, df);
-		runstart += len;
-		run -= len;
-		while(run) {
-		    len = MIN(run, max_opaque_run);
-		    ADD_OPAQUE_COUNTS(0, len);
-		    dst += copy_opaque(dst, src + runstart, len, sf, df);
-		    runstart += len;
-		    run -= len;
-		}
-	    } while(x < w);
-
-	    /* Make sure the next output address is 32-bit aligned */
-	    dst += (uintptr_t)dst & 2;
-
-	    /* Next, encode all translucent pixels of the same scan line */
-	    x = 0;
-	    do {
-		int run, skip, len;
-		skipstart = x;
-		while(x < w && !ISTRANSL(src[x], sf))
-		    x++;
-		runstart = x;
-		while(x < w && ISTRANSL(src[x], sf))
-		    x++;
-		skip = runstart - skipstart;
-		blankline &= (skip == w);
-		run = x - runstart;
-		while(skip > max_transl_run) {
-		    ADD_TRANSL_COUNTS(max_transl_run, 0);
-		    skip -= max_transl_run;
-		}
-		len = MIN(run, max_transl_run);
-		ADD_TRANSL_COUNTS(skip, len);
-		dst += copy_transl(dst, src + runstart, len, sf, df);
-		runstart += len;
-		run -= len;
-		while(run) {
-		    len = MIN(run, max_transl_run);
-		    ADD_TRANSL_COUNTS(0, len);
-		    dst += copy_transl(dst, src + runstart, len, sf, df);
-		    runstart += len;
-		    run -= len;
-		}
-		if(!blankline)
-		    lastline = dst;
-	    } while(x < w);
-
-	    src += surface->pitch >> 2;
-	}
-	dst = lastline;		/* back up past trailing blank lines */
-	ADD_OPAQUE_COUNTS(0, 0);
-    }
-
-#undef ADD_OPAQUE_COUNTS
-#undef ADD_TRANSL_COUNTS
-
-    /* Now that we have it encoded, release the original pixels */
-    if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-       && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	SDL_free( surface->pixels );
-	surface->pixels = NULL;
-    }
-
-    /* realloc the buffer to release unused memory */
-    {
-	Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
-	if(!p)
-	    p = rlebuf;
-	surface->map->sw_data->aux_data = p;
-    }
+    enc->df = df;
+    enc->sections = 2;
+    enc->encode = RLEAlphaBand;
+
+    /* save the destination format so we can undo the encoding later */
+    enc->header = sizeof(RLEDestFormat);
+    enc->format.BytesPerPixel = df->BytesPerPixel;
+    enc->format.Rloss = df->Rloss;
+    enc->format.Gloss = df->Gloss;
+    enc->format.Bloss = df->Bloss;
+    enc->format.Rshift = df->Rshift;
+    enc->format.Gshift = df->Gshift;
+    enc->format.Bshift = df->Bshift;
+    enc->format.Ashift = df->Ashift;
+    enc->format.Rmask = df->Rmask;
+    enc->format.Gmask = df->Gmask;
+    enc->format.Bmask = df->Bmask;
+    enc->format.Amask = df->Amask;
 
     return 0;
 }
@@ -1640,56 +1663,34 @@ static getpix_func getpixes[4] = {
     getpix_8, getpix_16, getpix_24, getpix_32
 };
 
-static int RLEColorkeySurface(SDL_Surface *surface)
+/* encode rows y to y+h-1 of a surface with a colour key */
+static int RLEColorkeyBand(RLEEncoder *enc, int y, int h, Uint8 *dst, int *used)
 {
-        Uint8 *rlebuf, *dst;
+	SDL_Surface *surface = enc->surface;
 	int maxn;
-	int y;
-	Uint8 *srcbuf, *lastline;
-	int maxsize = 0;
+	Uint8 *srcbuf, *lastline, *start;
+	int *line = enc->index->line + y;
+	int ncp = enc->index->checkpoints;
+	RLECheckpoint *cp = enc->index->checkpoint + y * ncp;
+	RLECheckpoint *cpend;
+	Uint8 *linestart;
+	int pos, cpx;
 	int bpp = surface->format->BytesPerPixel;
 	getpix_func getpix;
 	Uint32 ckey, rgbmask;
-	int w, h;
-
-	/* calculate the worst case size for the compressed surface */
-	switch(bpp) {
-	case 1:
-	    /* worst case is alternating opaque and transparent pixels,
-	       starting with an opaque pixel */
-	    maxsize = surface->h * 3 * (surface->w / 2 + 1) + 2;
-	    break;
-	case 2:
-	case 3:
-	    /* worst case is solid runs, at most 255 pixels wide */
-	    maxsize = surface->h * (2 * (surface->w / 255 + 1)
-				    + surface->w * bpp) + 2;
-	    break;
-	case 4:
-	    /* worst case is solid runs, at most 65535 pixels wide */
-	    maxsize = surface->h * (4 * (surface->w / 65535 + 1)
-				    + surface->w * 4) + 4;
-	    break;
-	}
-
-	rlebuf = (Uint8 *)SDL_malloc(maxsize);
-	if ( rlebuf == NULL ) {
-		SDL_OutOfMemory();
-		return(-1);
-	}
+	int w;
 
 	/* Set up the conversion */
-	srcbuf = (Uint8 *)surface->pixels;
+	srcbuf = (Uint8 *)surface->pixels + y * surface->pitch;
 	maxn = bpp == 4 ? 65535 : 255;
-	dst = rlebuf;
 	rgbmask = ~surface->format->Amask;
 	ckey = surface->format->colorkey & rgbmask;
-	lastline = dst;
+	start = lastline = dst;
 	getpix = getpixes[bpp - 1];
 	w = surface->w;
-	h = surface->h;
 
 #define ADD_COUNTS(n, m)			\
+	ADD_CHECKPOINTS(n, m);			\
 	if(bpp == 4) {				\
 	    ((Uint16 *)dst)[0] = n;		\
 	    ((Uint16 *)dst)[1] = m;		\
@@ -1700,9 +1701,10 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 	    dst += 2;				\
 	}
 
-	for(y = 0; y < h; y++) {
+	for(; h; h--) {
 	    int x = 0;
 	    int blankline = 0;
+	    START_LINE();
 	    do {
 		int run, skip, len;
 		int runstart;
@@ -1744,10 +1746,268 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 
 	    srcbuf += surface->pitch;
 	}
-	dst = lastline;		/* back up bast trailing blank lines */
-	ADD_COUNTS(0, 0);
 
 #undef ADD_COUNTS
+#undef ADD_CHECKPOINTS
+#undef START_LINE
+
+	*used = lastline - start;
+	return dst - start;
+}
+
+static int RLEColorkeySetup(RLEEncoder *enc)
+{
+	SDL_Surface *surface = enc->surface;
+	int bpp = surface->format->BytesPerPixel;
+	int w = surface->w;
+
+	/* calculate the worst case size for a compressed line */
+	switch(bpp) {
+	case 1:
+	    /* worst case is alternating opaque and transparent pixels,
+	       starting with an opaque pixel */
+	    enc->maxline = 3 * (w / 2 + 1);
+	    break;
+	case 2:
+	case 3:
+	    /* worst case is solid runs, at most 255 pixels wide */
+	    enc->maxline = 2 * (w / 255 + 1) + w * bpp;
+	    break;
+	case 4:
+	    /* worst case is solid runs, at most 65535 pixels wide */
+	    enc->maxline = 4 * (w / 65535 + 1) + w * 4;
+	    break;
+	}
+	enc->header = 0;
+	enc->endsize = (bpp == 4) ? 4 : 2;
+	enc->sections = 1;
+	enc->encode = RLEColorkeyBand;
+	return(0);
+}
+
+static int RLESetup(RLEEncoder *enc, SDL_Surface *surface)
+{
+	SDL_memset(enc, 0, sizeof(*enc));
+	enc->surface = surface;
+	if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
+	    return RLEColorkeySetup(enc);
+	}
+	if((surface->flags & SDL_SRCALPHA) == SDL_SRCALPHA
+	   && surface->format->Amask != 0) {
+	    return RLEAlphaSetup(enc);
+	}
+	return -1;	/* no RLE for per-surface alpha sans ckey */
+}
+
+static struct private_rleindex *RLECreateIndex(RLEEncoder *enc)
+{
+	struct private_rleindex *index;
+	int w = enc->surface->w;
+	int h = enc->surface->h;
+	int bands = (h + RLE_BAND_ROWS - 1) / RLE_BAND_ROWS;
+	int lines = h * enc->sections;
+	int checkpoints = (w - 1) / RLE_CHECKPOINT;
+
+	/* all the tables go in the same block as the index */
+	index = (struct private_rleindex *)SDL_malloc(sizeof(*index) +
+			lines * checkpoints * sizeof(RLECheckpoint) +
+			(bands * 4 + lines) * sizeof(int) + bands);
+	if ( index == NULL ) {
+		return(NULL);
+	}
+	index->bands = bands;
+	index->last = -1;
+	index->sections = enc->sections;
+	index->checkpoints = checkpoints;
+	index->checkpoint = (RLECheckpoint *)(index + 1);
+	index->offset = (int *)(index->checkpoint + lines * checkpoints);
+	index->length = index->offset + bands;
+	index->used = index->length + bands;
+	index->todo = index->used + bands;
+	index->line = index->todo + bands;
+	index->dirty = (Uint8 *)(index->line + lines);
+	SDL_memset(index->dirty, 1, bands);
+	index->tracking = 0;
+	index->suspended = 0;
+	return(index);
+}
+
+static void RLEFree(SDL_Surface *surface)
+{
+	if ( surface->map && surface->map->sw_data ) {
+		struct private_swaccel *sw_data = surface->map->sw_data;
+		if ( sw_data->aux_data ) {
+			SDL_free(sw_data->aux_data);
+			sw_data->aux_data = NULL;
+		}
+		if ( sw_data->rle_index ) {
+			SDL_free(sw_data->rle_index);
+			sw_data->rle_index = NULL;
+		}
+	}
+}
+
+static void RLEEncodeBand(void *data, int i)
+{
+	RLEEncoder *enc = (RLEEncoder *)data;
+	struct private_rleindex *index = enc->index;
+	int band = index->todo[i];
+	int y = band * RLE_BAND_ROWS;
+	int h = MIN(RLE_BAND_ROWS, enc->surface->h - y);
+	Uint8 *dst = enc->scratch + enc->header + i * enc->slot;
+
+	index->length[band] = enc->encode(enc, y, h, dst, &index->used[band]);
+}
+
+/*
+ * Point the lines of a band, found at 'from', at its new place 'to' in the
+ * encoding.  Lines that were left out point at the end of data marker,
+ * with checkpoints that lead there too.
+ */
+static void RLEMoveLines(RLEEncoder *enc, int band, int from, int to,
+                         int len, int end)
+{
+	struct private_rleindex *index = enc->index;
+	int first = band * RLE_BAND_ROWS * index->sections;
+	int last = MIN((band + 1) * RLE_BAND_ROWS, enc->surface->h)
+	           * index->sections;
+	int n;
+
+	for ( n = first; n < last; ++n ) {
+		int ofs = index->line[n] - from;
+		if ( ofs < len ) {
+			index->line[n] = to + ofs;
+		} else {
+			index->line[n] = end;
+			SDL_memset(index->checkpoint + n * index->checkpoints, 0,
+			           index->checkpoints * sizeof(RLECheckpoint));
+		}
+	}
+}
+
+/*
+ * Encode the dirty bands of a surface (all of them the first time), and
+ * put them together with the unmodified bands of the old encoding.
+ */
+static int RLEEncode(RLEEncoder *enc)
+{
+	SDL_Surface *surface = enc->surface;
+	struct private_swaccel *sw_data = surface->map->sw_data;
+	struct private_rleindex *index = sw_data->rle_index;
+	Uint8 *old = NULL;
+	Uint8 *rlebuf, *dst;
+	int band, i, ntodo, last, size, pixels, threads;
+
+	if ( index ) {
+		old = (Uint8 *)sw_data->aux_data;
+	} else {
+		index = RLECreateIndex(enc);
+		if ( index == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+	}
+
+	/* The last visible band was stored without its trailing blank
+	   lines, and the bands after it not at all, so they are redone */
+	ntodo = 0;
+	for ( band = 0; band < index->bands; ++band ) {
+		if ( index->dirty[band] || band >= index->last ) {
+			index->todo[ntodo++] = band;
+		}
+	}
+
+	/* Encode the bands into worst case sized slots */
+	enc->index = index;
+	enc->slot = (RLE_BAND_ROWS * enc->maxline + 3) & ~3;
+	enc->scratch = (Uint8 *)SDL_malloc(enc->header + ntodo * enc->slot
+	                                   + enc->endsize);
+	if ( enc->scratch == NULL ) {
+		if ( index != sw_data->rle_index ) {
+			SDL_free(index);
+		}
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	pixels = ntodo * RLE_BAND_ROWS * surface->w;
+	threads = 1;
+	if ( pixels >= 2 * RLE_THREAD_PIXELS ) {
+		threads = MIN(SDL_ParallelThreads(), pixels / RLE_THREAD_PIXELS);
+	}
+	SDL_ParallelBands(ntodo, threads, RLEEncodeBand, enc);
+
+	/* Trailing blank lines are left out */
+	last = -1;
+	size = enc->header + enc->endsize;
+	for ( band = 0; band < index->bands; ++band ) {
+		if ( index->used[band] ) {
+			last = band;
+		}
+	}
+	for ( band = 0; band < last; ++band ) {
+		size += index->length[band];
+	}
+	if ( last >= 0 ) {
+		size += index->used[last];
+	}
+
+	/* A full encoding is packed in place, otherwise the bands are
+	   gathered in a new buffer */
+	if ( ntodo == index->bands ) {
+		rlebuf = enc->scratch;
+	} else {
+		rlebuf = (Uint8 *)SDL_malloc(size);
+		if ( rlebuf == NULL ) {
+			SDL_free(enc->scratch);
+			SDL_OutOfMemory();
+			return(-1);
+		}
+	}
+	SDL_memcpy(rlebuf, &enc->format, enc->header);
+	dst = rlebuf + enc->header;
+	for ( band = 0, i = 0; band < index->bands; ++band ) {
+		Uint8 *src;
+		int base;
+		int len = 0;
+
+		if ( i < ntodo && index->todo[i] == band ) {
+			src = enc->scratch + enc->header + i++ * enc->slot;
+			base = 0;
+		} else {
+			src = old + index->offset[band];
+			base = index->offset[band];
+		}
+		if ( band < last ) {
+			len = index->length[band];
+		} else if ( band == last ) {
+			len = index->used[band];
+		}
+		SDL_memmove(dst, src, len);
+		index->offset[band] = dst - rlebuf;
+		RLEMoveLines(enc, band, base, index->offset[band], len,
+		             size - enc->endsize);
+		dst += len;
+	}
+	SDL_memset(dst, 0, enc->endsize);	/* end of data marker */
+
+	if ( rlebuf == enc->scratch ) {
+		/* If realloc returns NULL, the original block is left intact */
+		Uint8 *p = SDL_realloc(rlebuf, size);
+		if ( p ) {
+			rlebuf = p;
+		}
+	} else {
+		SDL_free(enc->scratch);
+	}
+	if ( old ) {
+		SDL_free(old);
+	}
+	sw_data->aux_data = rlebuf;
+	sw_data->rle_index = index;
+	index->last = last;
+	SDL_memset(index->dirty, 0, index->bands);
+	index->tracking = 0;
+	index->suspended = 0;
 
 	/* Now that we have it encoded, release the original pixels */
 	if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
@@ -1756,20 +2016,12 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 	    surface->pixels = NULL;
 	}
 
-	/* realloc the buffer to release unused memory */
-	{
-	    /* If realloc returns NULL, the original block is left intact */
-	    Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
-	    if(!p)
-		p = rlebuf;
-	    surface->map->sw_data->aux_data = p;
-	}
-
 	return(0);
 }
 
 int SDL_RLESurface(SDL_Surface *surface)
 {
+	RLEEncoder enc;
 	int retcode;
 
 	/* Clear any previous RLE conversion */
@@ -1790,14 +2042,9 @@ int SDL_RLESurface(SDL_Surface *surface)
 	}
 
 	/* Encode */
-	if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
-	    retcode = RLEColorkeySurface(surface);
-	} else {
-	    if((surface->flags & SDL_SRCALPHA) == SDL_SRCALPHA
-	       && surface->format->Amask != 0)
-		retcode = RLEAlphaSurface(surface);
-	    else
-		retcode = -1;	/* no RLE for per-surface alpha sans ckey */
+	retcode = RLESetup(&enc, surface);
+	if ( retcode == 0 ) {
+		retcode = RLEEncode(&enc);
 	}
 
 	/* Unlock the surface if it's in hardware */
@@ -1892,50 +2139,150 @@ static SDL_bool UnRLEAlpha(SDL_Surface *surface)
     return(SDL_TRUE);
 }
 
+/* re-create the pixels of an encoded surface */
+static SDL_bool RLEDecode(SDL_Surface *surface)
+{
+    if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
+	SDL_Rect full;
+	unsigned alpha_flag;
+
+	/* re-create the original surface */
+	surface->pixels = SDL_malloc(surface->h * surface->pitch);
+	if ( !surface->pixels ) {
+	    return(SDL_FALSE);
+	}
+
+	/* fill it with the background colour */
+	SDL_FillRect(surface, NULL, surface->format->colorkey);
+
+	/* now render the encoded surface */
+	full.x = full.y = 0;
+	full.w = surface->w;
+	full.h = surface->h;
+	alpha_flag = surface->flags & SDL_SRCALPHA;
+	surface->flags &= ~SDL_SRCALPHA; /* opaque blit */
+	SDL_RLEBlit(surface, &full, surface, &full);
+	surface->flags |= alpha_flag;
+	return(SDL_TRUE);
+    }
+    return UnRLEAlpha(surface);
+}
+
 void SDL_UnRLESurface(SDL_Surface *surface, int recode)
 {
     if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
+	struct private_rleindex *index = NULL;
+
 	surface->flags &= ~SDL_RLEACCEL;
+	if ( surface->map ) {
+	    index = surface->map->sw_data->rle_index;
+	}
 
+	/* a surface suspended for locking already has its pixels */
 	if(recode && (surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	    if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
-		SDL_Rect full;
-		unsigned alpha_flag;
-
-		/* re-create the original surface */
-		surface->pixels = SDL_malloc(surface->h * surface->pitch);
-		if ( !surface->pixels ) {
-			/* Oh crap... */
-			surface->flags |= SDL_RLEACCEL;
-			return;
-		}
-
-		/* fill it with the background colour */
-		SDL_FillRect(surface, NULL, surface->format->colorkey);
-
-		/* now render the encoded surface */
-		full.x = full.y = 0;
-		full.w = surface->w;
-		full.h = surface->h;
-		alpha_flag = surface->flags & SDL_SRCALPHA;
-		surface->flags &= ~SDL_SRCALPHA; /* opaque blit */
-		SDL_RLEBlit(surface, &full, surface, &full);
-		surface->flags |= alpha_flag;
-	    } else {
-		if ( !UnRLEAlpha(surface) ) {
-		    /* Oh crap... */
-		    surface->flags |= SDL_RLEACCEL;
-		    return;
-		}
+	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE
+	   && !(index && index->suspended)) {
+	    if ( !RLEDecode(surface) ) {
+		/* Oh crap... */
+		surface->flags |= SDL_RLEACCEL;
+		return;
 	    }
 	}
 
-	if ( surface->map && surface->map->sw_data->aux_data ) {
-	    SDL_free(surface->map->sw_data->aux_data);
-	    surface->map->sw_data->aux_data = NULL;
+	RLEFree(surface);
+    }
+}
+
+/*
+ * Decode an RLE surface for locking, keeping the encoding so that only
+ * the bands modified while locked have to be encoded again on unlock.
+ */
+void SDL_SuspendRLESurface(SDL_Surface *surface)
+{
+    struct private_rleindex *index = surface->map->sw_data->rle_index;
+
+    if ( !index ) {
+	SDL_UnRLESurface(surface, 1);
+	surface->flags |= SDL_RLEACCEL;	/* save accel'd state */
+	return;
+    }
+    if ( !index->suspended ) {
+	if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
+	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
+	    SDL_bool decoded;
+
+	    surface->flags &= ~SDL_RLEACCEL;
+	    decoded = RLEDecode(surface);
+	    surface->flags |= SDL_RLEACCEL;
+	    if ( !decoded ) {
+		/* Oh crap... */
+		return;
+	    }
 	}
+	index->suspended = 1;
     }
+    SDL_memset(index->dirty, 0, index->bands);
+    index->tracking = 0;
 }
 
+/* Encode the surface again after it has been unlocked */
+int SDL_ResumeRLESurface(SDL_Surface *surface)
+{
+    struct private_rleindex *index = surface->map->sw_data->rle_index;
+    RLEEncoder enc;
+
+    surface->flags &= ~SDL_RLEACCEL;
+    if ( !index || !index->suspended ) {
+	RLEFree(surface);
+	return SDL_RLESurface(surface);
+    }
 
+    /* without any dirty rows, the whole surface may have been changed */
+    if ( !index->tracking ) {
+	SDL_memset(index->dirty, 1, index->bands);
+    }
+    if ( RLESetup(&enc, surface) < 0 || RLEEncode(&enc) < 0 ) {
+	RLEFree(surface);
+	return -1;
+    }
+    surface->flags |= SDL_RLEACCEL;
+    return 0;
+}
+
+/*
+ * Record rows of a locked RLE surface as modified.  Unless 'always' is set,
+ * the rows are ignored if the surface was already locked by someone else
+ * who isn't tracking rows, since then anything may have been changed.
+ */
+void SDL_DirtyRLESurface(SDL_Surface *surface, int y, int h, int always)
+{
+    struct private_rleindex *index;
+    int band;
+
+    if ( !surface->map || !surface->map->sw_data ) {
+	return;
+    }
+    index = surface->map->sw_data->rle_index;
+    if ( !index || !index->suspended ) {
+	return;
+    }
+    if ( !always && surface->locked > 1 && !index->tracking ) {
+	return;
+    }
+    index->tracking = 1;
+
+    if ( y < 0 ) {
+	h += y;
+	y = 0;
+    }
+    if ( y + h > surface->h ) {
+	h = surface->h - y;
+    }
+    if ( h <= 0 ) {
+	return;
+    }
+    for ( band = y / RLE_BAND_ROWS;
+          band <= (y + h - 1) / RLE_BAND_ROWS; ++band ) {
+	index->dirty[band] = 1;
+    }
+}
@@ -29,3 +29,6 @@ extern int SDL_RLEBlit(SDL_Surface *src, SDL_Rect *srcrect,
 extern int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
 			    SDL_Surface *dst, SDL_Rect *dstrect);
 extern void SDL_UnRLESurface(SDL_Surface *surface, int recode);
+extern void SDL_SuspendRLESurface(SDL_Surface *surface);
+extern int SDL_ResumeRLESurface(SDL_Surface *surface);
+extern void SDL_DirtyRLESurface(SDL_Surface *surface, int y, int h, int always);
@@ -57,6 +57,10 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 			okay = 0;
 		} else {
 			dst_locked = 1;
+			if ( dst->flags & SDL_RLEACCEL ) {
+				SDL_DirtyRLESurface(dst, dstrect->y,
+				                    dstrect->h, 0);
+			}
 		}
 	}
 	/* Lock the source if it's in hardware */
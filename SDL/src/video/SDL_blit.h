@@ -49,6 +49,7 @@ typedef void (*SDL_loblit)(SDL_BlitInfo *info);
 struct private_swaccel {
 	SDL_loblit blit;
 	void *aux_data;
+	struct private_rleindex *rle_index;
 };
 
 /* Blit mapping definition */
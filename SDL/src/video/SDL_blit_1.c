@@ -22,10 +22,20 @@
 #include "SDL_config.h"
 
 #include "SDL_video.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_blit.h"
 #include "SDL_sysvideo.h"
 #include "SDL_endian.h"
 
+/* The AVX2 gathers are built with a target attribute, so they don't need
+   the whole library compiled for AVX2, and picked at run time.
+*/
+#if SDL_ASSEMBLY_ROUTINES && (defined(__i386__) || defined(__x86_64__)) && \
+    (((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) || defined(__clang__))
+#define AVX2_BLIT1
+#include <immintrin.h>
+#endif
+
 /* Functions to blit from 8-bit surfaces to other surfaces */
 
 static void Blit1to1(SDL_BlitInfo *info)
@@ -483,6 +493,166 @@ static void Blit1toNAlphaKey(SDL_BlitInfo *info)
 	}
 }
 
+#ifdef AVX2_BLIT1
+/* Expand 16 palette indices at a time with gathers.  The 16-bit table is
+   gathered a dword at a time from each entry, which is why Map1toN pads
+   the table, and the low halves are packed back together.
+*/
+#define AVX2_FUNC	__attribute__((target("avx2")))
+
+static AVX2_FUNC __m256i Gather16(const Uint16 *map, __m128i idx)
+{
+	__m256i lo, hi;
+
+	lo = _mm256_i32gather_epi32((const int *)map,
+	                            _mm256_cvtepu8_epi32(idx), 2);
+	hi = _mm256_i32gather_epi32((const int *)map,
+	                            _mm256_cvtepu8_epi32(_mm_srli_si128(idx, 8)), 2);
+	lo = _mm256_and_si256(lo, _mm256_set1_epi32(0xFFFF));
+	hi = _mm256_and_si256(hi, _mm256_set1_epi32(0xFFFF));
+	/* packus works within 128-bit lanes, put the quarters back in order */
+	return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+}
+
+static AVX2_FUNC void Blit1to2AVX2(SDL_BlitInfo *info)
+{
+	int c;
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip/2;
+	Uint16 *map = (Uint16 *)info->table;
+
+	while ( height-- ) {
+		for ( c=width; c >= 16; c -= 16 ) {
+			__m128i idx = _mm_loadu_si128((const __m128i *)src);
+			_mm256_storeu_si256((__m256i *)dst, Gather16(map, idx));
+			src += 16;
+			dst += 16;
+		}
+		for ( ; c; --c ) {
+			*dst++ = map[*src++];
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+static AVX2_FUNC void Blit1to4AVX2(SDL_BlitInfo *info)
+{
+	int c;
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip/4;
+	const int *map = (const int *)info->table;
+
+	while ( height-- ) {
+		for ( c=width; c >= 16; c -= 16 ) {
+			__m128i idx = _mm_loadu_si128((const __m128i *)src);
+			_mm256_storeu_si256((__m256i *)dst,
+				_mm256_i32gather_epi32(map,
+					_mm256_cvtepu8_epi32(idx), 4));
+			_mm256_storeu_si256((__m256i *)(dst + 8),
+				_mm256_i32gather_epi32(map,
+					_mm256_cvtepu8_epi32(_mm_srli_si128(idx, 8)), 4));
+			src += 16;
+			dst += 16;
+		}
+		for ( ; c; --c ) {
+			*dst++ = map[*src++];
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+static AVX2_FUNC void Blit1to2KeyAVX2(SDL_BlitInfo *info)
+{
+	int c;
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip/2;
+	Uint16 *map = (Uint16 *)info->table;
+	Uint32 ckey = info->src->colorkey;
+	__m128i key = _mm_set1_epi8((char)ckey);
+
+	if ( ckey > 0xFF ) {	/* No pixel can match it */
+		Blit1to2AVX2(info);
+		return;
+	}
+	while ( height-- ) {
+		for ( c=width; c >= 16; c -= 16 ) {
+			__m128i idx = _mm_loadu_si128((const __m128i *)src);
+			__m256i keep = _mm256_cvtepi8_epi16(_mm_cmpeq_epi8(idx, key));
+			__m256i old = _mm256_loadu_si256((const __m256i *)dst);
+			_mm256_storeu_si256((__m256i *)dst,
+				_mm256_blendv_epi8(Gather16(map, idx), old, keep));
+			src += 16;
+			dst += 16;
+		}
+		for ( ; c; --c ) {
+			if ( *src != ckey ) {
+				*dst = map[*src];
+			}
+			src++;
+			dst++;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+static AVX2_FUNC void Blit1to4KeyAVX2(SDL_BlitInfo *info)
+{
+	int c;
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip/4;
+	const int *map = (const int *)info->table;
+	Uint32 ckey = info->src->colorkey;
+	__m256i key = _mm256_set1_epi32(ckey);
+	__m256i idx8, pix, old;
+	int i;
+
+	while ( height-- ) {
+		for ( c=width; c >= 16; c -= 16 ) {
+			__m128i idx = _mm_loadu_si128((const __m128i *)src);
+			for ( i=0; i<2; ++i ) {
+				idx8 = _mm256_cvtepu8_epi32(idx);
+				pix = _mm256_i32gather_epi32(map, idx8, 4);
+				old = _mm256_loadu_si256((const __m256i *)dst);
+				_mm256_storeu_si256((__m256i *)dst,
+					_mm256_blendv_epi8(pix, old,
+						_mm256_cmpeq_epi32(idx8, key)));
+				idx = _mm_srli_si128(idx, 8);
+				dst += 8;
+			}
+			src += 16;
+		}
+		for ( ; c; --c ) {
+			if ( *src != ckey ) {
+				*dst = map[*src];
+			}
+			src++;
+			dst++;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* AVX2_BLIT1 */
+
 static SDL_loblit one_blit[] = {
 	NULL, Blit1to1, Blit1to2, Blit1to3, Blit1to4
 };
@@ -504,9 +674,19 @@ SDL_loblit SDL_CalculateBlit1(SDL_Surface *surface, int blit_index)
 	}
 	switch(blit_index) {
 	case 0:			/* copy */
+#ifdef AVX2_BLIT1
+	    if ( (which == 2 || which == 4) && SDL_HasAVX2() ) {
+		return which == 2 ? Blit1to2AVX2 : Blit1to4AVX2;
+	    }
+#endif
 	    return one_blit[which];
 
 	case 1:			/* colorkey */
+#ifdef AVX2_BLIT1
+	    if ( (which == 2 || which == 4) && SDL_HasAVX2() ) {
+		return which == 2 ? Blit1to2KeyAVX2 : Blit1to4KeyAVX2;
+	    }
+#endif
 	    return one_blitkey[which];
 
 	case 2:			/* alpha */
@@ -0,0 +1,277 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Direct conversion between RGB surfaces for SDL_ConvertSurface()
+
+   Going through SDL_LowerBlit() means taking the colour key and alpha
+   off the source, building a blit map to the new surface and putting
+   everything back, which also throws away the map the source had.  The
+   generic blitters only move bits around with masks and shifts, and
+   those distribute over OR, so a destination pixel is the OR of what
+   each byte of the source pixel contributes.  A table of 256 entries per
+   source byte gives the same result as the blitter for any pair of RGB
+   formats, and the few pairs with blitters of their own are left to them.
+*/
+
+#include "SDL_video.h"
+#include "SDL_blit.h"
+#include "SDL_convert_c.h"
+
+/* Is the mask a whole byte that a three byte pixel can store? */
+#define BYTE_CHANNEL(mask, shift) \
+	((mask) == (Uint32)0xFF << (shift) && ((shift) & 7) == 0)
+
+/* Channels wider than 8 bits have a negative loss that can't be shifted */
+#define NARROW_FORMAT(fmt) \
+	(((fmt)->Rmask >> (fmt)->Rshift) <= 0xFF && \
+	 ((fmt)->Gmask >> (fmt)->Gshift) <= 0xFF && \
+	 ((fmt)->Bmask >> (fmt)->Bshift) <= 0xFF && \
+	 ((fmt)->Amask >> (fmt)->Ashift) <= 0xFF)
+
+void SDL_PlanConvert(SDL_ConvertPlan *plan,
+                     SDL_Surface *src, SDL_Surface *dst, int keyed)
+{
+	SDL_PixelFormat *srcfmt = src->format;
+	SDL_PixelFormat *dstfmt = dst->format;
+
+	plan->mode = SDL_CONVERT_BLIT;
+	plan->srcbpp = srcfmt->BytesPerPixel;
+	plan->dstbpp = dstfmt->BytesPerPixel;
+	plan->keyed = keyed;
+	plan->rgbmask = ~srcfmt->Amask;
+	plan->ckey = srcfmt->colorkey & plan->rgbmask;
+	plan->mask = 0xFFFFFFFF;
+	plan->set = 0;
+	plan->copy_alpha = (srcfmt->Amask && dstfmt->Amask);
+
+	/* Only RGB surfaces whose pixels can be used without locking */
+	if ( srcfmt->palette || dstfmt->palette ||
+	     plan->srcbpp < 2 || plan->dstbpp < 2 ||
+	     !NARROW_FORMAT(srcfmt) || !NARROW_FORMAT(dstfmt) ||
+	     SDL_MUSTLOCK(src) || SDL_MUSTLOCK(dst) ) {
+		return;
+	}
+
+	/* Three byte pixels are stored a channel at a time */
+	if ( plan->dstbpp == 3 ) {
+		if ( dstfmt->Amask ||
+		     !BYTE_CHANNEL(dstfmt->Rmask, dstfmt->Rshift) ||
+		     !BYTE_CHANNEL(dstfmt->Gmask, dstfmt->Gshift) ||
+		     !BYTE_CHANNEL(dstfmt->Bmask, dstfmt->Bshift) ) {
+			return;
+		}
+	}
+
+	if ( keyed ) {
+		/* Blitting would RLE encode the source, and Blit2to2Key
+		   copies the source pixels as they are */
+		if ( (src->flags & SDL_RLEACCELOK) ||
+		     (plan->srcbpp == 2 && FORMAT_EQUAL(srcfmt, dstfmt)) ) {
+			return;
+		}
+	} else {
+		if ( FORMAT_EQUAL(srcfmt, dstfmt) ) {
+			plan->mode = SDL_CONVERT_COPY;
+			return;
+		}
+		/* Blit4to4MaskAlpha, used when the RGB masks match */
+		if ( plan->srcbpp == 4 && plan->dstbpp == 4 &&
+		     srcfmt->Rmask == dstfmt->Rmask &&
+		     srcfmt->Gmask == dstfmt->Gmask &&
+		     srcfmt->Bmask == dstfmt->Bmask ) {
+			if ( dstfmt->Amask ) {
+				plan->set = (Uint32)(srcfmt->alpha >>
+				                     dstfmt->Aloss) << dstfmt->Ashift;
+			} else {
+				plan->mask = srcfmt->Rmask |
+				             srcfmt->Gmask | srcfmt->Bmask;
+			}
+			plan->mode = SDL_CONVERT_MASK;
+			return;
+		}
+		/* RGB565 to 32 bits with alpha goes through lookup tables
+		   that round differently */
+		if ( plan->srcbpp == 2 && plan->dstbpp == 4 &&
+		     dstfmt->Amask && !srcfmt->Amask &&
+		     srcfmt->Rmask == 0xF800 && srcfmt->Gmask == 0x07E0 &&
+		     srcfmt->Bmask == 0x001F ) {
+			return;
+		}
+		/* RGB888 to RGB565 and RGB555 have faster blitters */
+		if ( plan->srcbpp == 4 && plan->dstbpp == 2 &&
+		     !dstfmt->Amask &&
+		     srcfmt->Rmask == 0x00FF0000 &&
+		     srcfmt->Gmask == 0x0000FF00 &&
+		     srcfmt->Bmask == 0x000000FF &&
+		     dstfmt->Bmask == 0x001F &&
+		     ((dstfmt->Rmask == 0xF800 && dstfmt->Gmask == 0x07E0) ||
+		      (dstfmt->Rmask == 0x7C00 && dstfmt->Gmask == 0x03E0)) ) {
+			return;
+		}
+	}
+	if ( dstfmt->Amask && !plan->copy_alpha ) {
+		plan->set = (Uint32)(srcfmt->alpha >> dstfmt->Aloss)
+		            << dstfmt->Ashift;
+	}
+	plan->mode = SDL_CONVERT_TABLE;
+}
+
+/* Fill in what each byte of a source pixel turns into */
+static void BuildTables(const SDL_ConvertPlan *plan,
+                        SDL_PixelFormat *srcfmt, SDL_PixelFormat *dstfmt,
+                        Uint32 table[4][256])
+{
+	int k, v;
+
+	for ( k = 0; k < plan->srcbpp; ++k ) {
+		for ( v = 0; v < 256; ++v ) {
+			Uint32 Pixel = (Uint32)v << (8 * k);
+			unsigned r, g, b, a;
+
+			RGBA_FROM_PIXEL(Pixel, srcfmt, r, g, b, a);
+			if ( !plan->copy_alpha ) {
+				a = 0;
+			}
+			PIXEL_FROM_RGBA(Pixel, dstfmt, r, g, b, a);
+			table[k][v] = Pixel;
+		}
+	}
+}
+
+#define LOOKUP_PIXEL(Pixel, srcbpp)					\
+	(table[0][(Pixel) & 0xFF] | table[1][((Pixel) >> 8) & 0xFF] |	\
+	 ((srcbpp) > 2 ? table[2][((Pixel) >> 16) & 0xFF] : 0) |	\
+	 ((srcbpp) > 3 ? table[3][(Pixel) >> 24] : 0) | set)
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define STORE_PIXEL24(buf, Pixel)					\
+	{ (buf)[0] = (Uint8)(Pixel); (buf)[1] = (Uint8)((Pixel) >> 8);	\
+	  (buf)[2] = (Uint8)((Pixel) >> 16); }
+#else
+#define STORE_PIXEL24(buf, Pixel)					\
+	{ (buf)[0] = (Uint8)((Pixel) >> 16); (buf)[1] = (Uint8)((Pixel) >> 8); \
+	  (buf)[2] = (Uint8)(Pixel); }
+#endif
+
+#define STORE_PIXEL(buf, dstbpp, Pixel)					\
+	switch (dstbpp) {						\
+	    case 2:							\
+		*(Uint16 *)(buf) = (Uint16)(Pixel);			\
+		break;							\
+	    case 3:							\
+		STORE_PIXEL24(buf, Pixel);				\
+		break;							\
+	    default:							\
+		*(Uint32 *)(buf) = (Pixel);				\
+		break;							\
+	}
+
+/* The loop for one pair of pixel sizes, with the sizes as constants */
+#define CONVERT_TABLE(srcbpp, dstbpp)					\
+	while ( height-- ) {						\
+		Uint8 *s = src;						\
+		Uint8 *d = dst;						\
+		int n;							\
+		for ( n = width; n; --n ) {				\
+			Uint32 Pixel;					\
+			RETRIEVE_RGB_PIXEL(s, srcbpp, Pixel);		\
+			if ( !keyed || (Pixel & rgbmask) != ckey ) {	\
+				Pixel = LOOKUP_PIXEL(Pixel, srcbpp);	\
+				STORE_PIXEL(d, dstbpp, Pixel);		\
+			}						\
+			s += srcbpp;					\
+			d += dstbpp;					\
+		}							\
+		src += srcpitch;					\
+		dst += dstpitch;					\
+	}
+
+static void ConvertTable(const SDL_ConvertPlan *plan,
+                         SDL_PixelFormat *srcfmt, SDL_PixelFormat *dstfmt,
+                         Uint8 *src, int srcpitch, Uint8 *dst, int dstpitch,
+                         int width, int height)
+{
+	Uint32 table[4][256];
+	const int keyed = plan->keyed;
+	const Uint32 rgbmask = plan->rgbmask;
+	const Uint32 ckey = plan->ckey;
+	const Uint32 set = plan->set;
+
+	BuildTables(plan, srcfmt, dstfmt, table);
+	switch (plan->srcbpp * 4 + plan->dstbpp) {
+	    case 2*4+2: CONVERT_TABLE(2, 2); break;
+	    case 2*4+3: CONVERT_TABLE(2, 3); break;
+	    case 2*4+4: CONVERT_TABLE(2, 4); break;
+	    case 3*4+2: CONVERT_TABLE(3, 2); break;
+	    case 3*4+3: CONVERT_TABLE(3, 3); break;
+	    case 3*4+4: CONVERT_TABLE(3, 4); break;
+	    case 4*4+2: CONVERT_TABLE(4, 2); break;
+	    case 4*4+3: CONVERT_TABLE(4, 3); break;
+	    case 4*4+4: CONVERT_TABLE(4, 4); break;
+	}
+}
+
+void SDL_RunConvert(const SDL_ConvertPlan *plan,
+                    SDL_Surface *src, SDL_Surface *dst)
+{
+	Uint8 *srcp = (Uint8 *)src->pixels;
+	Uint8 *dstp = (Uint8 *)dst->pixels;
+	int width = src->w;
+	int height = src->h;
+
+	if ( width <= 0 || height <= 0 ) {
+		return;
+	}
+	switch (plan->mode) {
+	    case SDL_CONVERT_COPY:
+		while ( height-- ) {
+			SDL_memcpy(dstp, srcp, width * plan->srcbpp);
+			srcp += src->pitch;
+			dstp += dst->pitch;
+		}
+		break;
+
+	    case SDL_CONVERT_MASK: {
+		const Uint32 mask = plan->mask;
+		const Uint32 set = plan->set;
+
+		while ( height-- ) {
+			const Uint32 *s = (const Uint32 *)srcp;
+			Uint32 *d = (Uint32 *)dstp;
+			int n;
+
+			for ( n = width; n; --n ) {
+				*d++ = (*s++ & mask) | set;
+			}
+			srcp += src->pitch;
+			dstp += dst->pitch;
+		}
+	    }
+		break;
+
+	    case SDL_CONVERT_TABLE:
+		ConvertTable(plan, src->format, dst->format,
+		             srcp, src->pitch, dstp, dst->pitch, width, height);
+		break;
+	}
+}
@@ -0,0 +1,58 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Direct pixel conversion for SDL_ConvertSurface(), from SDL_convert.c */
+
+#include "SDL_video.h"
+
+#define SDL_CONVERT_BLIT	0	/* Not possible, use SDL_LowerBlit() */
+#define SDL_CONVERT_COPY	1	/* Same format, copy the rows */
+#define SDL_CONVERT_MASK	2	/* dst = (src & mask) | set */
+#define SDL_CONVERT_TABLE	3	/* dst = OR of a table entry per byte */
+
+typedef struct SDL_ConvertPlan {
+	int mode;
+	int srcbpp;
+	int dstbpp;
+	int keyed;		/* Leave out pixels matching the colour key */
+	Uint32 ckey;		/* Colour key, compared under rgbmask */
+	Uint32 rgbmask;
+	Uint32 mask;
+	Uint32 set;
+	Uint32 copy_alpha;	/* Tables carry the source alpha */
+} SDL_ConvertPlan;
+
+/* Work out how the pixels of 'src' can be converted into 'dst' with the
+   same result as SDL_LowerBlit() would give with the flags and colour key
+   SDL_ConvertSurface() leaves on the source.  'keyed' is set when colour
+   keyed pixels are to be left out instead of copied.  The plan's mode is
+   SDL_CONVERT_BLIT if the surfaces have to be blitted.
+ */
+extern void SDL_PlanConvert(SDL_ConvertPlan *plan,
+                            SDL_Surface *src, SDL_Surface *dst, int keyed);
+
+/* Convert the pixels as planned.  Only the pixels of the two surfaces are
+   touched, so several conversions can run at the same time.
+ */
+extern void SDL_RunConvert(const SDL_ConvertPlan *plan,
+                           SDL_Surface *src, SDL_Surface *dst);
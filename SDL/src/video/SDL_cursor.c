@@ -40,6 +40,8 @@ SDL_Cursor *SDL_cursor = NULL;
 static SDL_Cursor *SDL_defcursor = NULL;
 SDL_mutex *SDL_cursorlock = NULL;
 
+static void SDL_FreeCursorSprites(SDL_Cursor *cursor);
+
 /* Public functions */
 void SDL_CursorQuit(void)
 {
@@ -213,6 +215,7 @@ void SDL_SetCursor (SDL_Cursor *cursor)
 				SDL_GetMouseState(&x, &y);
 				SDL_cursor->area.x = (x - SDL_cursor->hot_x);
 				SDL_cursor->area.y = (y - SDL_cursor->hot_y);
+				SDL_cursorstate &= ~CURSOR_MOVED;
 			}
 			SDL_DrawCursor(SDL_VideoSurface);
 		}
@@ -246,6 +249,7 @@ void SDL_FreeCursor (SDL_Cursor *cursor)
 			SDL_VideoDevice *video = current_video;
 			SDL_VideoDevice *this  = current_video;
 
+			SDL_FreeCursorSprites(cursor);
 			if ( cursor->data ) {
 				SDL_free(cursor->data);
 			}
@@ -318,24 +322,122 @@ void SDL_WarpMouse (Uint16 x, Uint16 y)
 	}
 }
 
+/* Where the software cursor is going, see SDL_ApplyCursorMotion() */
+static int cursor_x, cursor_y;
+
 void SDL_MoveCursor(int x, int y)
 {
 	SDL_VideoDevice *video = current_video;
 
-	/* Erase and update the current mouse position */
+	/* Remember the new mouse position, the cursor is moved there along
+	   with the next screen update, or at the next event pump if there
+	   is none, so a burst of motion only redraws it once.
+	 */
 	if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
-		/* Erase and redraw mouse cursor in new position */
 		SDL_LockCursor();
-		SDL_EraseCursor(SDL_VideoSurface);
-		SDL_cursor->area.x = (x - SDL_cursor->hot_x);
-		SDL_cursor->area.y = (y - SDL_cursor->hot_y);
-		SDL_DrawCursor(SDL_VideoSurface);
+		cursor_x = x;
+		cursor_y = y;
+		SDL_cursorstate |= CURSOR_MOVED;
 		SDL_UnlockCursor();
 	} else if ( video->MoveWMCursor ) {
 		video->MoveWMCursor(video, x, y);
 	}
 }
 
+int SDL_ApplyCursorMotion(SDL_Rect *areas)
+{
+	SDL_Surface *screen = SDL_VideoSurface;
+	int n = 0;
+
+	SDL_LockCursor();
+	if ( SDL_cursorstate & CURSOR_MOVED ) {
+		SDL_cursorstate &= ~CURSOR_MOVED;
+		if ( screen && SDL_cursor && SHOULD_DRAWCURSOR(SDL_cursorstate) &&
+		     (!SDL_MUSTLOCK(screen) || (SDL_LockSurface(screen) == 0)) ) {
+			SDL_MouseRect(&areas[n]);
+			if ( areas[n].w && areas[n].h ) {
+				++n;
+			}
+			SDL_EraseCursorNoLock(screen);
+			SDL_cursor->area.x = (cursor_x - SDL_cursor->hot_x);
+			SDL_cursor->area.y = (cursor_y - SDL_cursor->hot_y);
+			SDL_DrawCursorNoLock(screen);
+			SDL_MouseRect(&areas[n]);
+			if ( areas[n].w && areas[n].h ) {
+				++n;
+			}
+			if ( SDL_MUSTLOCK(screen) ) {
+				SDL_UnlockSurface(screen);
+			}
+
+			/* Small moves are sent as one rectangle */
+			if ( (n == 2) &&
+			     (areas[0].x < areas[1].x+areas[1].w) &&
+			     (areas[1].x < areas[0].x+areas[0].w) &&
+			     (areas[0].y < areas[1].y+areas[1].h) &&
+			     (areas[1].y < areas[0].y+areas[0].h) ) {
+				int x1 = SDL_min(areas[0].x, areas[1].x);
+				int y1 = SDL_min(areas[0].y, areas[1].y);
+				int x2 = SDL_max(areas[0].x+areas[0].w,
+				                 areas[1].x+areas[1].w);
+				int y2 = SDL_max(areas[0].y+areas[0].h,
+				                 areas[1].y+areas[1].h);
+				areas[0].x = (Sint16)x1;
+				areas[0].y = (Sint16)y1;
+				areas[0].w = (Uint16)(x2 - x1);
+				areas[0].h = (Uint16)(y2 - y1);
+				n = 1;
+			}
+		}
+	}
+	SDL_UnlockCursor();
+	return(n);
+}
+
+void SDL_FlushCursorMotion(void)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+	SDL_Surface *screen = SDL_VideoSurface;
+	SDL_Rect areas[2];
+	int i, n;
+
+	if ( !(SDL_cursorstate & CURSOR_MOVED) || !video ) {
+		return;
+	}
+	n = SDL_ApplyCursorMotion(areas);
+	if ( n && ((screen->flags & SDL_HWSURFACE) != SDL_HWSURFACE) &&
+	     video->UpdateRects ) {
+		if ( screen->offset ) {
+			for ( i=0; i<n; ++i ) {
+				areas[i].x += video->offset_x;
+				areas[i].y += video->offset_y;
+			}
+		}
+		video->UpdateRects(this, n, areas);
+	}
+}
+
+int SDL_CursorInRects(int numrects, const SDL_Rect *rects)
+{
+	SDL_Rect area;
+	int i;
+
+	SDL_MouseRect(&area);
+	if ( (area.w == 0) || (area.h == 0) ) {
+		return(0);
+	}
+	for ( i=0; i<numrects; ++i ) {
+		if ( (rects[i].x < area.x+area.w) &&
+		     (area.x < rects[i].x+rects[i].w) &&
+		     (rects[i].y < area.y+area.h) &&
+		     (area.y < rects[i].y+rects[i].h) ) {
+			return(1);
+		}
+	}
+	return(0);
+}
+
 /* Keep track of the current cursor colors */
 static int palette_changed = 1;
 static Uint8 pixels8[2];
@@ -368,129 +470,165 @@ void SDL_MouseRect(SDL_Rect *area)
 	}
 }
 
-static void SDL_DrawCursorFast(SDL_Surface *screen, SDL_Rect *area)
+/* The current cursor rendered in the pixel formats it has been drawn in,
+   with the runs of opaque pixels on each of its rows, so drawing it is a
+   handful of copies.  A shadow surface and the video surface can differ
+   in format, so a few are kept.
+ */
+#define CURSOR_SPRITES	4
+
+typedef struct {
+	SDL_Cursor *cursor;
+	int bpp;
+	Uint8 white, black;	/* Pixel bytes the cursor is drawn with */
+	Uint8 *pixels;
+	Uint16 *runs;		/* For each row, a count and start, length pairs */
+	Uint32 used;
+} SDL_CursorSprite;
+
+static SDL_CursorSprite sprites[CURSOR_SPRITES];
+static Uint32 sprite_clock = 0;
+
+static void SDL_FreeCursorSprite(SDL_CursorSprite *sprite)
 {
-	const Uint32 pixels[2] = { 0xFFFFFFFF, 0x00000000 };
-	int i, w, h;
-	Uint8 *data, datab;
-	Uint8 *mask, maskb;
+	if ( sprite->pixels ) {
+		SDL_free(sprite->pixels);
+	}
+	SDL_memset(sprite, 0, sizeof(*sprite));
+}
 
-	data = SDL_cursor->data + area->y * SDL_cursor->area.w/8;
-	mask = SDL_cursor->mask + area->y * SDL_cursor->area.w/8;
-	switch (screen->format->BytesPerPixel) {
+static void SDL_FreeCursorSprites(SDL_Cursor *cursor)
+{
+	int i;
 
-	    case 1: {
-		Uint8 *dst;
-		int dstskip;
+	for ( i=0; i<CURSOR_SPRITES; ++i ) {
+		if ( sprites[i].cursor == cursor ) {
+			SDL_FreeCursorSprite(&sprites[i]);
+		}
+	}
+}
 
+static SDL_CursorSprite *SDL_GetCursorSprite(SDL_Surface *screen)
+{
+	SDL_CursorSprite *sprite;
+	const int bpp = screen->format->BytesPerPixel;
+	const int w = SDL_cursor->area.w;
+	const int h = SDL_cursor->area.h;
+	Uint8 white, black;
+	Uint8 *dst, *data, *mask;
+	Uint16 *runs;
+	int i, x, y, start;
+
+	/* The 8-bit cursor colors depend on the palette, the others are
+	   drawn with all bits set or clear, like the old drawing code */
+	if ( bpp == 1 ) {
 		if ( palette_changed ) {
 			pixels8[0] = (Uint8)SDL_MapRGB(screen->format, 255, 255, 255);
 			pixels8[1] = (Uint8)SDL_MapRGB(screen->format, 0, 0, 0);
 			palette_changed = 0;
 		}
-		dst = (Uint8 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch +
-                       SDL_cursor->area.x;
-		dstskip = screen->pitch-area->w;
-
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						*dst = pixels8[datab>>7];
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst++;
-				}
-			}
-			dst += dstskip;
+		white = pixels8[0];
+		black = pixels8[1];
+	} else {
+		white = 0xFF;
+		black = 0x00;
+	}
+
+	sprite = &sprites[0];
+	for ( i=0; i<CURSOR_SPRITES; ++i ) {
+		if ( (sprites[i].cursor == SDL_cursor) &&
+		     (sprites[i].bpp == bpp) &&
+		     (sprites[i].white == white) &&
+		     (sprites[i].black == black) ) {
+			sprites[i].used = ++sprite_clock;
+			return(&sprites[i]);
 		}
-	    }
-	    break;
-
-	    case 2: {
-		Uint16 *dst;
-		int dstskip;
-
-		dst = (Uint16 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch/2 +
-                       SDL_cursor->area.x;
-		dstskip = (screen->pitch/2)-area->w;
+		if ( sprites[i].used < sprite->used ) {
+			sprite = &sprites[i];
+		}
+	}
 
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						*dst = (Uint16)pixels[datab>>7];
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst++;
+	/* Render the cursor over the least recently used sprite */
+	SDL_FreeCursorSprite(sprite);
+	sprite->pixels = (Uint8 *)SDL_malloc(w*h*bpp + h*(w+1)*sizeof(Uint16));
+	if ( sprite->pixels == NULL ) {
+		return(NULL);
+	}
+	sprite->runs = (Uint16 *)(sprite->pixels + w*h*bpp);
+	sprite->cursor = SDL_cursor;
+	sprite->bpp = bpp;
+	sprite->white = white;
+	sprite->black = black;
+	sprite->used = ++sprite_clock;
+
+	dst = sprite->pixels;
+	runs = sprite->runs;
+	data = SDL_cursor->data;
+	mask = SDL_cursor->mask;
+	for ( y=0; y<h; ++y ) {
+		runs[0] = 0;
+		start = -1;
+		for ( x=0; x<w; ++x ) {
+			Uint8 bit = (0x80 >> (x%8));
+
+			SDL_memset(dst, (data[x/8] & bit) ? black : white, bpp);
+			dst += bpp;
+			if ( mask[x/8] & bit ) {
+				if ( start < 0 ) {
+					start = x;
 				}
+			} else if ( start >= 0 ) {
+				runs[1+runs[0]*2] = (Uint16)start;
+				runs[2+runs[0]*2] = (Uint16)(x - start);
+				++runs[0];
+				start = -1;
 			}
-			dst += dstskip;
 		}
-	    }
-	    break;
-
-	    case 3: {
-		Uint8 *dst;
-		int dstskip;
+		if ( start >= 0 ) {
+			runs[1+runs[0]*2] = (Uint16)start;
+			runs[2+runs[0]*2] = (Uint16)(w - start);
+			++runs[0];
+		}
+		runs += (w+1);
+		data += w/8;
+		mask += w/8;
+	}
+	return(sprite);
+}
 
-		dst = (Uint8 *)screen->pixels +
+static void SDL_DrawCursorSprite(SDL_Surface *screen, SDL_CursorSprite *sprite,
+                                 SDL_Rect *area)
+{
+	const int bpp = sprite->bpp;
+	const int w = SDL_cursor->area.w;
+	const int minx = area->x;
+	const int maxx = area->x+area->w;
+	Uint8 *src, *dst;
+	Uint16 *runs;
+	int h, i, x1, x2;
+
+	src = sprite->pixels + area->y*w*bpp;
+	runs = sprite->runs + area->y*(w+1);
+	dst = (Uint8 *)screen->pixels +
                        (SDL_cursor->area.y+area->y)*screen->pitch +
-                       SDL_cursor->area.x*3;
-		dstskip = screen->pitch-area->w*3;
-
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						SDL_memset(dst,pixels[datab>>7],3);
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst += 3;
-				}
+                       SDL_cursor->area.x*bpp;
+	for ( h=area->h; h; h-- ) {
+		for ( i=0; i<runs[0]; ++i ) {
+			x1 = runs[1+i*2];
+			x2 = x1 + runs[2+i*2];
+			if ( x1 < minx ) {
+				x1 = minx;
 			}
-			dst += dstskip;
-		}
-	    }
-	    break;
-
-	    case 4: {
-		Uint32 *dst;
-		int dstskip;
-
-		dst = (Uint32 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch/4 +
-                       SDL_cursor->area.x;
-		dstskip = (screen->pitch/4)-area->w;
-
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						*dst = pixels[datab>>7];
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst++;
-				}
+			if ( x2 > maxx ) {
+				x2 = maxx;
+			}
+			if ( x1 < x2 ) {
+				SDL_memcpy(dst+x1*bpp, src+x1*bpp, (x2-x1)*bpp);
 			}
-			dst += dstskip;
 		}
-	    }
-	    break;
+		src += w*bpp;
+		runs += (w+1);
+		dst += screen->pitch;
 	}
 }
 
@@ -594,6 +732,7 @@ static void SDL_ConvertCursorSave(SDL_Surface *screen, int w, int h)
 
 void SDL_DrawCursorNoLock(SDL_Surface *screen)
 {
+	SDL_CursorSprite *sprite;
 	SDL_Rect area;
 
 	/* Get the mouse rectangle, clipped to the screen */
@@ -630,8 +769,9 @@ void SDL_DrawCursorNoLock(SDL_Surface *screen)
 	/* Draw the mouse cursor */
 	area.x -= SDL_cursor->area.x;
 	area.y -= SDL_cursor->area.y;
-	if ( (area.x == 0) && (area.w == SDL_cursor->area.w) ) {
-		SDL_DrawCursorFast(screen, &area);
+	sprite = SDL_GetCursorSprite(screen);
+	if ( sprite ) {
+		SDL_DrawCursorSprite(screen, sprite, &area);
 	} else {
 		SDL_DrawCursorSlow(screen, &area);
 	}
@@ -754,5 +894,6 @@ void SDL_ResetCursor(void)
 		SDL_cursor->area.x = 0;
 		SDL_cursor->area.y = 0;
 		SDL_memset(SDL_cursor->save[0], 0, savelen);
+		SDL_cursorstate &= ~CURSOR_MOVED;
 	}
 }
@@ -33,6 +33,17 @@ extern void SDL_EraseCursorNoLock(SDL_Surface *screen);
 extern void SDL_UpdateCursor(SDL_Surface *screen);
 extern void SDL_ResetCursor(void);
 extern void SDL_MoveCursor(int x, int y);
+
+/* Moves of the software cursor are put off until the next screen update
+   or event pump.  SDL_ApplyCursorMotion() moves it on the video surface
+   and stores the (at most two) areas that changed, returning how many;
+   SDL_FlushCursorMotion() also sends them to the display.
+ */
+extern int SDL_ApplyCursorMotion(SDL_Rect *areas);
+extern void SDL_FlushCursorMotion(void);
+
+/* Whether the software cursor overlaps any of the rectangles */
+extern int SDL_CursorInRects(int numrects, const SDL_Rect *rects);
 extern void SDL_CursorQuit(void);
 
 #define INLINE_MOUSELOCK
@@ -66,6 +77,7 @@ extern void SDL_MouseRect(SDL_Rect *area);
 /* State definitions for the SDL cursor */
 #define CURSOR_VISIBLE	0x01
 #define CURSOR_USINGSW	0x10
+#define CURSOR_MOVED	0x20	/* The software cursor has yet to follow */
 #define SHOULD_DRAWCURSOR(X) 						\
 			(((X)&(CURSOR_VISIBLE|CURSOR_USINGSW)) ==  	\
 					(CURSOR_VISIBLE|CURSOR_USINGSW))
@@ -0,0 +1,76 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Simple band-parallel execution for the software pixel loops, on the
+   job threads */
+
+#include "SDL_thread.h"
+#include "SDL_parallel_c.h"
+#include "../thread/SDL_thread_c.h"
+
+int SDL_ParallelThreads(void)
+{
+	static int num_threads = 0;
+
+	if ( !num_threads ) {
+		const char *env = SDL_getenv("SDL_VIDEO_THREADS");
+		if ( env ) {
+			num_threads = SDL_atoi(env);
+		} else {
+			num_threads = SDL_GetJobThreads();
+		}
+		if ( num_threads <= 0 ) {
+			num_threads = 1;
+		}
+	}
+	return num_threads;
+}
+
+typedef struct {
+	SDL_BandFunc func;
+	void *data;
+} SDL_BandJob;
+
+static void SDLCALL RunBands(void *arg, int start, int end)
+{
+	SDL_BandJob *job = (SDL_BandJob *)arg;
+	int band;
+
+	for ( band = start; band < end; ++band ) {
+		job->func(job->data, band);
+	}
+}
+
+void SDL_ParallelBands(int bands, int threads, SDL_BandFunc func, void *data)
+{
+	SDL_BandJob job;
+
+	job.func = func;
+	job.data = data;
+	if ( threads <= 1 ) {
+		RunBands(&job, 0, bands);
+	} else {
+		/* One band at a time, so they're handed out in order */
+		SDL_ParallelForThreads(0, bands, 1, threads, RunBands, &job);
+	}
+}
@@ -0,0 +1,37 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Band-parallel helpers for the software pixel loops */
+
+typedef void (*SDL_BandFunc)(void *data, int band);
+
+/* Number of threads worth using for pixel work; SDL_VIDEO_THREADS
+   overrides the number of processors in the system. */
+extern int SDL_ParallelThreads(void);
+
+/* Call func(data, band) for every band in [0, bands) on up to 'threads'
+   threads, the calling thread included, and return when all are done.
+   Bands are handed out in order, so neighbouring bands tend to be
+   processed at the same time and share the caches. */
+extern void SDL_ParallelBands(int bands, int threads,
+                              SDL_BandFunc func, void *data);
@@ -24,6 +24,7 @@
 /* General (mostly internal) pixel/color manipulation routines for SDL */
 
 #include "SDL_endian.h"
+#include "SDL_atomic.h"
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
@@ -235,16 +236,36 @@ SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
 /*
  * Change any previous mappings from/to the new surface format
  */
-void SDL_FormatChanged(SDL_Surface *surface)
+static int format_version = 0;
+
+static void NextFormatVersion(SDL_Surface *surface)
 {
-	static int format_version = 0;
 	++format_version;
 	if ( format_version < 0 ) { /* It wrapped... */
 		format_version = 1;
 	}
 	surface->format_version = format_version;
+}
+void SDL_FormatChanged(SDL_Surface *surface)
+{
+	NextFormatVersion(surface);
 	SDL_InvalidateMap(surface->map);
 }
+/*
+ * Like SDL_FormatChanged(), after some palette entries of the surface
+ * changed.  Mappings to the surface are rebuilt, but its own translation
+ * table is patched with 'colors' for those entries.  If 'colors' is NULL
+ * the caller takes care of the table.
+ */
+void SDL_PaletteChanged(SDL_Surface *surface, const SDL_Color *colors,
+                        int firstcolor, int ncolors)
+{
+	NextFormatVersion(surface);
+	if ( colors &&
+	     SDL_PatchMapColors(surface, colors, firstcolor, ncolors) < 0 ) {
+		SDL_InvalidateMap(surface->map);
+	}
+}
 /*
  * Free a previously allocated format structure
  */
@@ -253,6 +274,8 @@ void SDL_FreeFormat(SDL_PixelFormat *format)
 	if ( format ) {
 		if ( format->palette ) {
 			if ( format->palette->colors ) {
+				SDL_InvalidatePaletteLookup(
+					format->palette->colors);
 				SDL_free(format->palette->colors);
 			}
 			SDL_free(format->palette);
@@ -284,6 +307,7 @@ void SDL_DitherColors(SDL_Color *colors, int bpp)
 		b |= b << 4;
 		colors[i].b = b;
 	}
+	SDL_InvalidatePaletteLookup(colors);
 }
 /* 
  * Calculate the pad-aligned scanline width of a surface
@@ -308,9 +332,9 @@ Uint16 SDL_CalculatePitch(SDL_Surface *surface)
 	return(pitch);
 }
 /*
- * Match an RGB value to a particular palette index
+ * Search the whole palette for the entry closest to an RGB value
  */
-Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+static Uint8 FindNearestColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 {
 	/* Do colorspace distance matching */
 	unsigned int smallest;
@@ -336,6 +360,248 @@ Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 	return(pixel);
 }
 
+/*
+ * The inverse colour map of a palette: a 32x32x32 cube where each cell
+ * lists the palette entries that can be the nearest one to some colour
+ * in the cell.  Searching that short list in palette order gives exactly
+ * the entry FindNearestColor() would.  Cells are filled in the first time
+ * they are looked up, so changing the palette only costs clearing a bit
+ * per cell.
+ *
+ * The maps are kept here for the last few colour arrays looked up in,
+ * found by the colours pointer and count.  Whatever changes the colours
+ * behind a pointer must call SDL_InvalidatePaletteLookup(), as
+ * SDL_SetPalette() does.
+ */
+#define LOOKUP_BITS	5
+#define LOOKUP_CELLS	(1<<(3*LOOKUP_BITS))
+#define LOOKUP_SIZE	(1<<(8-LOOKUP_BITS))	/* Channel values per cell */
+#define NUM_LOOKUPS	4
+
+struct private_palettelookup {
+	const SDL_Color *colors;	/* The colours this map is for, or NULL */
+	int ncolors;
+	Uint8 cell_known[LOOKUP_CELLS/8];
+	Uint32 cell[LOOKUP_CELLS];	/* First candidate << 9 | count */
+	Uint8 *candidates;
+	int numcandidates;
+	int maxcandidates;
+};
+
+/* Most recently used first */
+static struct private_palettelookup *SDL_palette_lookups[NUM_LOOKUPS];
+static SDL_SpinLock SDL_palette_lookup_lock;
+
+/*
+ * Find or make the inverse colour map for the colours of a palette,
+ * called with the lookup lock held
+ */
+static struct private_palettelookup *GetPaletteLookup(SDL_Palette *pal)
+{
+	struct private_palettelookup *lookup;
+	int i;
+
+	lookup = SDL_palette_lookups[0];
+	if ( lookup && lookup->colors == pal->colors &&
+	     lookup->ncolors == pal->ncolors ) {
+		return(lookup);
+	}
+	for ( i=1; i<NUM_LOOKUPS && SDL_palette_lookups[i]; ++i ) {
+		lookup = SDL_palette_lookups[i];
+		if ( lookup->colors == pal->colors &&
+		     lookup->ncolors == pal->ncolors ) {
+			break;
+		}
+	}
+	if ( i == NUM_LOOKUPS || !SDL_palette_lookups[i] ) {
+		/* Use an invalidated map, a new one or the least recent one */
+		for ( i=0; i<NUM_LOOKUPS && SDL_palette_lookups[i]; ++i ) {
+			if ( !SDL_palette_lookups[i]->colors ) {
+				break;
+			}
+		}
+		if ( i == NUM_LOOKUPS ) {
+			--i;
+		}
+		lookup = SDL_palette_lookups[i];
+		if ( !lookup ) {
+			lookup = (struct private_palettelookup *)
+					SDL_malloc(sizeof(*lookup));
+			if ( lookup == NULL ) {
+				return(NULL);
+			}
+			lookup->candidates = NULL;
+			lookup->maxcandidates = 0;
+		}
+		lookup->colors = pal->colors;
+		lookup->ncolors = pal->ncolors;
+		lookup->numcandidates = 0;
+		SDL_memset(lookup->cell_known, 0, sizeof(lookup->cell_known));
+	}
+	SDL_memmove(&SDL_palette_lookups[1], &SDL_palette_lookups[0],
+	            i * sizeof(SDL_palette_lookups[0]));
+	SDL_palette_lookups[0] = lookup;
+	return(lookup);
+}
+
+/*
+ * List the palette entries that can be nearest to a colour in a cell:
+ * no colour in the cell is further from the entry closest to the whole
+ * cell than 'bound', so only entries that come within 'bound' of the cell
+ * can win.  Returns -1 if out of memory.
+ */
+static int FillPaletteCell(struct private_palettelookup *lookup,
+                           SDL_Palette *pal, int cell, int r, int g, int b)
+{
+	unsigned int mindist[256];
+	unsigned int bound, maxdist;
+	int lo[3], c[3];
+	int i, j, d, far;
+	int first, count;
+
+	lo[0] = r & ~(LOOKUP_SIZE-1);
+	lo[1] = g & ~(LOOKUP_SIZE-1);
+	lo[2] = b & ~(LOOKUP_SIZE-1);
+	bound = ~0;
+	for ( i=0; i<pal->ncolors; ++i ) {
+		c[0] = pal->colors[i].r;
+		c[1] = pal->colors[i].g;
+		c[2] = pal->colors[i].b;
+		mindist[i] = 0;
+		maxdist = 0;
+		for ( j=0; j<3; ++j ) {
+			if ( c[j] < lo[j] ) {
+				d = lo[j] - c[j];
+			} else if ( c[j] > lo[j]+LOOKUP_SIZE-1 ) {
+				d = c[j] - (lo[j]+LOOKUP_SIZE-1);
+			} else {
+				d = 0;
+			}
+			mindist[i] += d*d;
+			far = c[j] - lo[j];
+			if ( (lo[j]+LOOKUP_SIZE-1) - c[j] > far ) {
+				far = (lo[j]+LOOKUP_SIZE-1) - c[j];
+			}
+			maxdist += far*far;
+		}
+		if ( maxdist < bound ) {
+			bound = maxdist;
+		}
+	}
+
+	if ( lookup->numcandidates + pal->ncolors > lookup->maxcandidates ) {
+		Uint8 *candidates;
+		int size = lookup->maxcandidates ? lookup->maxcandidates*2 : 4096;
+
+		candidates = (Uint8 *)SDL_realloc(lookup->candidates, size);
+		if ( candidates == NULL ) {
+			return(-1);
+		}
+		lookup->candidates = candidates;
+		lookup->maxcandidates = size;
+	}
+	first = lookup->numcandidates;
+	count = 0;
+	for ( i=0; i<pal->ncolors; ++i ) {
+		if ( mindist[i] <= bound ) {
+			lookup->candidates[first+count] = i;
+			++count;
+		}
+	}
+	lookup->numcandidates += count;
+	lookup->cell[cell] = ((Uint32)first << 9) | count;
+	lookup->cell_known[cell >> 3] |= (1 << (cell & 7));
+	return(0);
+}
+
+/*
+ * Forget the inverse colour map made for an array of colours, after the
+ * colours were changed or the array was freed
+ */
+void SDL_InvalidatePaletteLookup(const SDL_Color *colors)
+{
+	int i;
+
+	SDL_AtomicLock(&SDL_palette_lookup_lock);
+	for ( i=0; i<NUM_LOOKUPS && SDL_palette_lookups[i]; ++i ) {
+		if ( SDL_palette_lookups[i]->colors == colors ) {
+			SDL_palette_lookups[i]->colors = NULL;
+		}
+	}
+	SDL_AtomicUnlock(&SDL_palette_lookup_lock);
+}
+
+/*
+ * Free the inverse colour maps
+ */
+void SDL_FreePaletteLookups(void)
+{
+	int i;
+
+	SDL_AtomicLock(&SDL_palette_lookup_lock);
+	for ( i=0; i<NUM_LOOKUPS; ++i ) {
+		if ( SDL_palette_lookups[i] ) {
+			if ( SDL_palette_lookups[i]->candidates ) {
+				SDL_free(SDL_palette_lookups[i]->candidates);
+			}
+			SDL_free(SDL_palette_lookups[i]);
+			SDL_palette_lookups[i] = NULL;
+		}
+	}
+	SDL_AtomicUnlock(&SDL_palette_lookup_lock);
+}
+
+/*
+ * Match an RGB value to a particular palette index
+ */
+Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+{
+	struct private_palettelookup *lookup;
+	const Uint8 *candidates;
+	unsigned int smallest;
+	unsigned int distance;
+	int rd, gd, bd;
+	int cell, i, n;
+	Uint8 pixel;
+
+	if ( pal->ncolors <= 0 || pal->ncolors > 256 ) {
+		return FindNearestColor(pal, r, g, b);
+	}
+
+	SDL_AtomicLock(&SDL_palette_lookup_lock);
+	lookup = GetPaletteLookup(pal);
+	cell = ((r >> (8-LOOKUP_BITS)) << (2*LOOKUP_BITS)) |
+	       ((g >> (8-LOOKUP_BITS)) << LOOKUP_BITS) |
+	        (b >> (8-LOOKUP_BITS));
+	if ( lookup == NULL ||
+	     (!(lookup->cell_known[cell >> 3] & (1 << (cell & 7))) &&
+	      FillPaletteCell(lookup, pal, cell, r, g, b) < 0) ) {
+		SDL_AtomicUnlock(&SDL_palette_lookup_lock);
+		return FindNearestColor(pal, r, g, b);
+	}
+
+	/* The same search as FindNearestColor(), over the candidates */
+	candidates = lookup->candidates + (lookup->cell[cell] >> 9);
+	n = (lookup->cell[cell] & 0x1FF);
+	smallest = ~0;
+	pixel = candidates[0];
+	for ( i=0; i<n; ++i ) {
+		rd = pal->colors[candidates[i]].r - r;
+		gd = pal->colors[candidates[i]].g - g;
+		bd = pal->colors[candidates[i]].b - b;
+		distance = (rd*rd)+(gd*gd)+(bd*bd);
+		if ( distance < smallest ) {
+			pixel = candidates[i];
+			if ( distance == 0 ) { /* Perfect match! */
+				break;
+			}
+			smallest = distance;
+		}
+	}
+	SDL_AtomicUnlock(&SDL_palette_lookup_lock);
+	return(pixel);
+}
+
 /* Find the opaque pixel value corresponding to an RGB triple */
 Uint32 SDL_MapRGB
 (const SDL_PixelFormat * const format,
@@ -470,7 +736,8 @@ static Uint8 *Map1toN(SDL_PixelFormat *src, SDL_PixelFormat *dst)
 	SDL_Palette *pal = src->palette;
 
 	bpp = ((dst->BytesPerPixel == 3) ? 4 : dst->BytesPerPixel);
-	map = (Uint8 *)SDL_malloc(pal->ncolors*bpp);
+	/* The SIMD blitters read a whole dword at the last entry */
+	map = (Uint8 *)SDL_malloc(pal->ncolors*bpp+sizeof(Uint32));
 	if ( map == NULL ) {
 		SDL_OutOfMemory();
 		return(NULL);
@@ -539,6 +806,57 @@ void SDL_InvalidateMap(SDL_BlitMap *map)
 		map->table = NULL;
 	}
 }
+/*
+ * Update the translation table of a palettized surface after palette
+ * entries firstcolor..firstcolor+ncolors-1 changed to 'colors'.
+ * Returns -1 if the mapping can't be patched and has to be rebuilt.
+ */
+int SDL_PatchMapColors(SDL_Surface *src, const SDL_Color *colors,
+                       int firstcolor, int ncolors)
+{
+	SDL_BlitMap *map = src->map;
+	SDL_PixelFormat *dstfmt;
+	unsigned alpha;
+	int i, bpp;
+
+	/* Nothing to patch if the mapping gets rebuilt anyway */
+	if ( (map->dst == NULL) ||
+	     (map->dst->format_version != map->format_version) ) {
+		return(0);
+	}
+	/* Identity mappings may be RLE encoded, and hardware blits may
+	   keep their own copy of the colours */
+	if ( map->identity || (map->table == NULL) ||
+	     ((src->flags & SDL_HWACCEL) == SDL_HWACCEL) ) {
+		return(-1);
+	}
+	if ( firstcolor < 0 || firstcolor+ncolors > src->format->palette->ncolors ) {
+		return(-1);
+	}
+
+	dstfmt = map->dst->format;
+	if ( dstfmt->BytesPerPixel == 1 ) {
+		/* Palette --> Palette */
+		if ( dstfmt->palette == NULL ) {
+			return(-1);
+		}
+		for ( i=0; i<ncolors; ++i ) {
+			map->table[firstcolor+i] = SDL_FindColor(dstfmt->palette,
+				colors[i].r, colors[i].g, colors[i].b);
+		}
+	} else {
+		/* Palette --> BitField, laid out like Map1toN() */
+		bpp = ((dstfmt->BytesPerPixel == 3) ? 4 : dstfmt->BytesPerPixel);
+		alpha = dstfmt->Amask ? src->format->alpha : 0;
+		for ( i=0; i<ncolors; ++i ) {
+			ASSEMBLE_RGBA(&map->table[(firstcolor+i)*bpp],
+				      dstfmt->BytesPerPixel, dstfmt,
+				      colors[i].r, colors[i].g, colors[i].b,
+				      alpha);
+		}
+	}
+	return(0);
+}
 int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 {
 	SDL_PixelFormat *srcfmt;
@@ -31,16 +31,22 @@ extern SDL_PixelFormat *SDL_AllocFormat(int bpp,
 extern SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
 		Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask);
 extern void SDL_FormatChanged(SDL_Surface *surface);
+extern void SDL_PaletteChanged(SDL_Surface *surface, const SDL_Color *colors,
+		int firstcolor, int ncolors);
 extern void SDL_FreeFormat(SDL_PixelFormat *format);
 
 /* Blit mapping functions */
 extern SDL_BlitMap *SDL_AllocBlitMap(void);
 extern void SDL_InvalidateMap(SDL_BlitMap *map);
 extern int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst);
+extern int SDL_PatchMapColors(SDL_Surface *src, const SDL_Color *colors,
+		int firstcolor, int ncolors);
 extern void SDL_FreeBlitMap(SDL_BlitMap *map);
 
 /* Miscellaneous functions */
 extern Uint16 SDL_CalculatePitch(SDL_Surface *surface);
 extern void SDL_DitherColors(SDL_Color *colors, int bpp);
 extern Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b);
+extern void SDL_InvalidatePaletteLookup(const SDL_Color *colors);
+extern void SDL_FreePaletteLookups(void);
 extern void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output, int ncolors);
@@ -0,0 +1,190 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* The asynchronous presenter.
+
+   The application draws into ordinary memory, and each update copies the
+   changed rectangles into one of the present buffers, which a separate
+   thread hands to the driver.  The caller only waits when every buffer
+   is still being presented.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_timer.h"
+#include "SDL_present_c.h"
+
+static int SDL_PresentThread(void *data)
+{
+	SDL_Presenter *presenter = (SDL_Presenter *)data;
+	SDL_VideoDevice *video = presenter->video;
+	SDL_PresentBuffer *buffer;
+	Uint32 latency;
+
+	SDL_mutexP(presenter->lock);
+	for ( ; ; ) {
+		while ( !presenter->pending && !presenter->quit ) {
+			SDL_CondWait(presenter->cond, presenter->lock);
+		}
+		/* Finish the queued frames before quitting */
+		if ( !presenter->pending ) {
+			break;
+		}
+		buffer = &presenter->buffers[presenter->head];
+		SDL_mutexV(presenter->lock);
+
+		presenter->Present(video, buffer);
+
+		SDL_mutexP(presenter->lock);
+		latency = SDL_GetTicks() - buffer->queued;
+		SDL_AtomicLock(&video->update_stats_lock);
+		++video->update_stats.frames_presented;
+		video->update_stats.present_latency += latency;
+		if ( latency > video->update_stats.present_latency_max ) {
+			video->update_stats.present_latency_max = latency;
+		}
+		SDL_AtomicUnlock(&video->update_stats_lock);
+		buffer->busy = 0;
+		presenter->head = (presenter->head+1) % SDL_NUM_PRESENT_BUFFERS;
+		--presenter->pending;
+		SDL_CondBroadcast(presenter->cond);
+	}
+	SDL_mutexV(presenter->lock);
+	return(0);
+}
+
+int SDL_StartPresenter(SDL_VideoDevice *video, SDL_Presenter *presenter)
+{
+	presenter->video = video;
+	presenter->lock = SDL_CreateMutex();
+	presenter->cond = SDL_CreateCond();
+	if ( !presenter->lock || !presenter->cond ) {
+		return(-1);
+	}
+	presenter->thread = SDL_CreateThread(SDL_PresentThread, presenter);
+	if ( presenter->thread == NULL ) {
+		return(-1);
+	}
+	return(0);
+}
+
+void SDL_StopPresenter(SDL_Presenter *presenter)
+{
+	int i;
+
+	if ( presenter->thread ) {
+		SDL_mutexP(presenter->lock);
+		presenter->quit = 1;
+		SDL_CondBroadcast(presenter->cond);
+		SDL_mutexV(presenter->lock);
+		SDL_WaitThread(presenter->thread, NULL);
+		presenter->thread = NULL;
+	}
+	for ( i=0; i<SDL_NUM_PRESENT_BUFFERS; ++i ) {
+		if ( presenter->buffers[i].rects ) {
+			SDL_free(presenter->buffers[i].rects);
+			presenter->buffers[i].rects = NULL;
+		}
+	}
+	if ( presenter->cond ) {
+		SDL_DestroyCond(presenter->cond);
+		presenter->cond = NULL;
+	}
+	if ( presenter->lock ) {
+		SDL_DestroyMutex(presenter->lock);
+		presenter->lock = NULL;
+	}
+}
+
+void SDL_QueuePresent(SDL_Presenter *presenter, SDL_Surface *screen,
+                      int numrects, SDL_Rect *rects)
+{
+	SDL_VideoDevice *video = presenter->video;
+	SDL_PresentBuffer *buffer;
+	int bpp = screen->format->BytesPerPixel;
+	Uint8 *src, *dst;
+	int i, n, y, len;
+
+	buffer = &presenter->buffers[presenter->next];
+	SDL_mutexP(presenter->lock);
+	if ( buffer->busy ) {
+		SDL_AtomicLock(&video->update_stats_lock);
+		++video->update_stats.present_waits;
+		SDL_AtomicUnlock(&video->update_stats_lock);
+		do {
+			SDL_CondWait(presenter->cond, presenter->lock);
+		} while ( buffer->busy );
+	}
+	SDL_mutexV(presenter->lock);
+
+	/* The buffer is ours now, copy the changed areas into it */
+	if ( numrects > buffer->maxrects ) {
+		SDL_Rect *newrects;
+
+		newrects = (SDL_Rect *)SDL_realloc(buffer->rects,
+		                                   numrects*sizeof(*newrects));
+		if ( newrects == NULL ) {
+			SDL_OutOfMemory();
+			return;
+		}
+		buffer->rects = newrects;
+		buffer->maxrects = numrects;
+	}
+	n = 0;
+	for ( i=0; i<numrects; ++i ) {
+		if ( rects[i].w == 0 || rects[i].h == 0 ) { /* Clipped? */
+			continue;
+		}
+		src = (Uint8 *)screen->pixels +
+		      rects[i].y*screen->pitch + rects[i].x*bpp;
+		dst = buffer->pixels +
+		      rects[i].y*buffer->pitch + rects[i].x*bpp;
+		len = rects[i].w*bpp;
+		for ( y=rects[i].h; y; --y ) {
+			SDL_memcpy(dst, src, len);
+			src += screen->pitch;
+			dst += buffer->pitch;
+		}
+		buffer->rects[n++] = rects[i];
+	}
+	if ( n == 0 ) {
+		return;
+	}
+	buffer->numrects = n;
+
+	SDL_mutexP(presenter->lock);
+	buffer->busy = 1;
+	buffer->queued = SDL_GetTicks();
+	presenter->next = (presenter->next+1) % SDL_NUM_PRESENT_BUFFERS;
+	++presenter->pending;
+	SDL_CondBroadcast(presenter->cond);
+	SDL_mutexV(presenter->lock);
+}
+
+void SDL_WaitPresenter(SDL_Presenter *presenter)
+{
+	SDL_mutexP(presenter->lock);
+	while ( presenter->pending ) {
+		SDL_CondWait(presenter->cond, presenter->lock);
+	}
+	SDL_mutexV(presenter->lock);
+}
@@ -0,0 +1,76 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* The asynchronous presenter, used by video drivers which can hand
+   finished frames to a separate thread instead of waiting for the display.
+ */
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_sysvideo.h"
+
+#define SDL_NUM_PRESENT_BUFFERS	2
+
+typedef struct SDL_PresentBuffer {
+	Uint8 *pixels;		/* Set up by the driver before starting */
+	int pitch;
+	void *driverdata;
+	SDL_Rect *rects;	/* The areas changed in this frame */
+	int numrects;
+	int maxrects;
+	int busy;
+	Uint32 queued;		/* SDL_GetTicks() when handed to the thread */
+} SDL_PresentBuffer;
+
+typedef struct SDL_Presenter {
+	/* Called on the presenter thread to put the changed areas of a
+	   buffer on the display.  The buffer is reused once it returns.
+	 */
+	void (*Present)(SDL_VideoDevice *video, SDL_PresentBuffer *buffer);
+
+	SDL_VideoDevice *video;
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *cond;		/* Signaled when a buffer is queued or done */
+	int quit;
+	int next;		/* Next buffer to fill */
+	int head;		/* Next buffer to present */
+	int pending;		/* Buffers queued for the thread */
+	SDL_PresentBuffer buffers[SDL_NUM_PRESENT_BUFFERS];
+} SDL_Presenter;
+
+/* Start the presenter thread once Present and the buffer pixels are set */
+extern int SDL_StartPresenter(SDL_VideoDevice *video, SDL_Presenter *presenter);
+
+/* Present the queued frames and stop the thread.  This also cleans up
+   after a failed SDL_StartPresenter(), the driver frees the pixels.
+ */
+extern void SDL_StopPresenter(SDL_Presenter *presenter);
+
+/* Copy the rectangles of the screen into the next free buffer and queue
+   it, waiting if every buffer is still being presented.
+ */
+extern void SDL_QueuePresent(SDL_Presenter *presenter, SDL_Surface *screen,
+                             int numrects, SDL_Rect *rects);
+
+/* Wait until every queued frame has been presented */
+extern void SDL_WaitPresenter(SDL_Presenter *presenter);
@@ -29,194 +29,563 @@
 
 #include "SDL_video.h"
 #include "SDL_blit.h"
+#include "SDL_RLEaccel_c.h"
+#include "SDL_cpuinfo.h"
 
 /* This isn't ready for general consumption yet - it should be folded
    into the general blitting mechanism.
 */
 
-#if ((defined(_MFC_VER) && defined(_M_IX86)/* && !defined(_WIN32_WCE) still needed? */) || \
-     defined(__WATCOMC__) || \
-     (defined(__GNUC__) && defined(__i386__))) && SDL_ASSEMBLY_ROUTINES
-/* There's a bug with gcc 4.4.1 and -O2 where srcp doesn't get the correct
- * value after the first scanline.  FIXME? */
-/*#define USE_ASM_STRETCH*/
+/* Every filter works from tables computed once per call: for each
+   destination column (and row) the first source sample, the second
+   source sample and the weight of the second one.  The filtered paths
+   operate on rows of 32-bit pixels with four 8-bit channels; 32-bpp
+   surfaces are read and written in place, 16-bpp rows are expanded
+   into a working row first and packed back afterwards.
+*/
+
+#if SDL_ASSEMBLY_ROUTINES && defined(__GNUC__) && defined(__SSE2__)
+#define SSE2_STRETCH
+#include <emmintrin.h>
 #endif
 
-#ifdef USE_ASM_STRETCH
+typedef struct {
+	int *index;	/* First source sample for each destination sample */
+	int *index2;	/* Second source sample (bilinear) */
+	int *weight;	/* Bilinear: weight of index2 (0-256), box: sample count */
+} SDL_StretchAxis;
 
-#ifdef HAVE_MPROTECT
-#include <sys/types.h>
-#include <sys/mman.h>
-#endif
-#ifdef __GNUC__
-#define PAGE_ALIGNED __attribute__((__aligned__(4096)))
-#else
-#define PAGE_ALIGNED
+/* Same stepping the original row copier used, so the output of the
+   nearest filter is unchanged.
+ */
+void SDL_StretchNearestIndex(int *index, int src_len, int dst_len)
+{
+	int i;
+	int pos, inc;
+	int sample = -1;
+
+	pos = 0x10000;
+	inc = (src_len << 16) / dst_len;
+	for ( i=0; i<dst_len; ++i ) {
+		while ( pos >= 0x10000L ) {
+			++sample;
+			pos -= 0x10000L;
+		}
+		index[i] = sample;
+		pos += inc;
+	}
+}
+
+static void SetupNearest(SDL_StretchAxis *axis, int src_len, int dst_len)
+{
+	SDL_StretchNearestIndex(axis->index, src_len, dst_len);
+}
+
+/* Sample at the destination pixel centers */
+static void SetupBilinear(SDL_StretchAxis *axis, int src_len, int dst_len)
+{
+	int i;
+	int pos, inc;
+	int sample, weight;
+
+	inc = (src_len << 16) / dst_len;
+	pos = (inc / 2) - 0x8000;
+	for ( i=0; i<dst_len; ++i ) {
+		if ( pos < 0 ) {
+			sample = 0;
+			weight = 0;
+		} else {
+			sample = (pos >> 16);
+			weight = (pos & 0xFFFF) >> 8;
+		}
+		if ( sample >= src_len-1 ) {
+			sample = src_len-1;
+			weight = 0;
+		}
+		axis->index[i] = sample;
+		axis->index2[i] = (weight ? sample+1 : sample);
+		axis->weight[i] = weight;
+		pos += inc;
+	}
+}
+
+/* Each destination sample covers [i*src/dst, (i+1)*src/dst) */
+static void SetupBox(SDL_StretchAxis *axis, int src_len, int dst_len)
+{
+	int i;
+	int start, end;
+
+	for ( i=0; i<dst_len; ++i ) {
+		start = (int)(((Uint32)i * src_len) / dst_len);
+		end = (int)(((Uint32)(i+1) * src_len) / dst_len);
+		if ( end <= start ) {
+			end = start+1;
+		}
+		axis->index[i] = start;
+		axis->weight[i] = end - start;
+	}
+}
+
+/* Interpolate between two pixels, two channels at a time */
+static __inline__ Uint32 Lerp8888(Uint32 a, Uint32 b, Uint32 w)
+{
+	Uint32 iw = 256 - w;
+	Uint32 rb, ag;
+
+	rb = ((a & 0x00FF00FF) * iw + (b & 0x00FF00FF) * w) >> 8;
+	ag = (((a >> 8) & 0x00FF00FF) * iw + ((b >> 8) & 0x00FF00FF) * w) >> 8;
+	return (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+}
+
+/* Convert a row of 16-bit pixels to and from 8-bit channels.
+   The SSE2 code handles formats without alpha, like 565 and 555, with
+   the same shifts and masks as the scalar code.
+ */
+static void Expand16Row(const Uint16 *src, Uint32 *dst, int width,
+                        const SDL_PixelFormat *fmt, int simd)
+{
+	int i = 0;
+	Uint32 pixel;
+
+#ifdef SSE2_STRETCH
+	if ( simd && !fmt->Amask ) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rmask = _mm_set1_epi32(fmt->Rmask);
+		const __m128i gmask = _mm_set1_epi32(fmt->Gmask);
+		const __m128i bmask = _mm_set1_epi32(fmt->Bmask);
+		const __m128i rshift = _mm_cvtsi32_si128(fmt->Rshift);
+		const __m128i gshift = _mm_cvtsi32_si128(fmt->Gshift);
+		const __m128i bshift = _mm_cvtsi32_si128(fmt->Bshift);
+		const __m128i rloss = _mm_cvtsi32_si128(fmt->Rloss+16);
+		const __m128i gloss = _mm_cvtsi32_si128(fmt->Gloss+8);
+		const __m128i bloss = _mm_cvtsi32_si128(fmt->Bloss);
+		__m128i p, v[2];
+		int j;
+
+		for ( ; i+8 <= width; i += 8 ) {
+			p = _mm_loadu_si128((const __m128i *)(src+i));
+			v[0] = _mm_unpacklo_epi16(p, zero);
+			v[1] = _mm_unpackhi_epi16(p, zero);
+			for ( j=0; j<2; ++j ) {
+				p = v[j];
+				v[j] = _mm_or_si128(_mm_or_si128(
+				    _mm_sll_epi32(_mm_srl_epi32(_mm_and_si128(p, rmask),
+				                                rshift), rloss),
+				    _mm_sll_epi32(_mm_srl_epi32(_mm_and_si128(p, gmask),
+				                                gshift), gloss)),
+				    _mm_sll_epi32(_mm_srl_epi32(_mm_and_si128(p, bmask),
+				                                bshift), bloss));
+			}
+			_mm_storeu_si128((__m128i *)(dst+i), v[0]);
+			_mm_storeu_si128((__m128i *)(dst+i+4), v[1]);
+		}
+	}
 #endif
+	for ( ; i<width; ++i ) {
+		pixel = src[i];
+		dst[i] = ((((pixel & fmt->Rmask) >> fmt->Rshift) << fmt->Rloss) << 16)
+		       | ((((pixel & fmt->Gmask) >> fmt->Gshift) << fmt->Gloss) << 8)
+		       | (((pixel & fmt->Bmask) >> fmt->Bshift) << fmt->Bloss)
+		       | ((((pixel & fmt->Amask) >> fmt->Ashift) << fmt->Aloss) << 24);
+	}
+}
 
-#if defined(_M_IX86) || defined(i386)
-#define PREFIX16	0x66
-#define STORE_BYTE	0xAA
-#define STORE_WORD	0xAB
-#define LOAD_BYTE	0xAC
-#define LOAD_WORD	0xAD
-#define RETURN		0xC3
-#else
-#error Need assembly opcodes for this architecture
+static void Pack16Row(const Uint32 *src, Uint16 *dst, int width,
+                      const SDL_PixelFormat *fmt, int simd)
+{
+	int i = 0;
+	Uint32 pixel;
+
+#ifdef SSE2_STRETCH
+	if ( simd && !fmt->Amask ) {
+		const __m128i rmask = _mm_set1_epi32(0x00FF0000);
+		const __m128i gmask = _mm_set1_epi32(0x0000FF00);
+		const __m128i bmask = _mm_set1_epi32(0x000000FF);
+		const __m128i rloss = _mm_cvtsi32_si128(fmt->Rloss+16);
+		const __m128i gloss = _mm_cvtsi32_si128(fmt->Gloss+8);
+		const __m128i bloss = _mm_cvtsi32_si128(fmt->Bloss);
+		const __m128i rshift = _mm_cvtsi32_si128(fmt->Rshift);
+		const __m128i gshift = _mm_cvtsi32_si128(fmt->Gshift);
+		const __m128i bshift = _mm_cvtsi32_si128(fmt->Bshift);
+		__m128i p, v[2];
+		int j;
+
+		for ( ; i+8 <= width; i += 8 ) {
+			v[0] = _mm_loadu_si128((const __m128i *)(src+i));
+			v[1] = _mm_loadu_si128((const __m128i *)(src+i+4));
+			for ( j=0; j<2; ++j ) {
+				p = v[j];
+				p = _mm_or_si128(_mm_or_si128(
+				    _mm_sll_epi32(_mm_srl_epi32(_mm_and_si128(p, rmask),
+				                                rloss), rshift),
+				    _mm_sll_epi32(_mm_srl_epi32(_mm_and_si128(p, gmask),
+				                                gloss), gshift)),
+				    _mm_sll_epi32(_mm_srl_epi32(_mm_and_si128(p, bmask),
+				                                bloss), bshift));
+				/* Sign extend the low 16 bits so the pack truncates */
+				v[j] = _mm_srai_epi32(_mm_slli_epi32(p, 16), 16);
+			}
+			_mm_storeu_si128((__m128i *)(dst+i),
+			                 _mm_packs_epi32(v[0], v[1]));
+		}
+	}
 #endif
+	for ( ; i<width; ++i ) {
+		pixel = src[i];
+		dst[i] = (Uint16)(
+		    ((((pixel >> 16) & 0xFF) >> fmt->Rloss) << fmt->Rshift)
+		  | ((((pixel >> 8) & 0xFF) >> fmt->Gloss) << fmt->Gshift)
+		  | (((pixel & 0xFF) >> fmt->Bloss) << fmt->Bshift)
+		  | (((((pixel >> 24) & 0xFF) >> fmt->Aloss) << fmt->Ashift) & fmt->Amask));
+	}
+}
 
-static unsigned char copy_row[4096] PAGE_ALIGNED;
+/* Nearest neighbour row copiers, driven by the column table */
+#define DEFINE_COPY_ROW(name, type)				\
+static void name(const type *src, type *dst, const int *index, int width) \
+{								\
+	int i;							\
+	for ( i=0; i<width; ++i ) {				\
+		dst[i] = src[index[i]];				\
+	}							\
+}
+DEFINE_COPY_ROW(copy_row1, Uint8)
+DEFINE_COPY_ROW(copy_row2, Uint16)
+DEFINE_COPY_ROW(copy_row4, Uint32)
 
-static int generate_rowbytes(int src_w, int dst_w, int bpp)
+static void copy_row3(const Uint8 *src, Uint8 *dst, const int *index, int width)
 {
-	static struct {
-		int bpp;
-		int src_w;
-		int dst_w;
-		int status;
-	} last;
-
 	int i;
-	int pos, inc;
-	unsigned char *eip, *fence;
-	unsigned char load, store;
+	const Uint8 *pixel;
 
-	/* See if we need to regenerate the copy buffer */
-	if ( (src_w == last.src_w) &&
-	     (dst_w == last.dst_w) && (bpp == last.bpp) ) {
-		return(last.status);
+	for ( i=0; i<width; ++i ) {
+		pixel = src + index[i]*3;
+		*dst++ = pixel[0];
+		*dst++ = pixel[1];
+		*dst++ = pixel[2];
 	}
-	last.bpp = bpp;
-	last.src_w = src_w;
-	last.dst_w = dst_w;
-	last.status = -1;
+}
 
+void SDL_StretchRowNearest(const Uint8 *src, Uint8 *dst, const int *index,
+                           int width, int bpp)
+{
 	switch (bpp) {
 	    case 1:
-		load = LOAD_BYTE;
-		store = STORE_BYTE;
+		copy_row1(src, dst, index, width);
 		break;
 	    case 2:
+		copy_row2((const Uint16 *)src, (Uint16 *)dst, index, width);
+		break;
+	    case 3:
+		copy_row3(src, dst, index, width);
+		break;
 	    case 4:
-		load = LOAD_WORD;
-		store = STORE_WORD;
+		copy_row4((const Uint32 *)src, (Uint32 *)dst, index, width);
 		break;
-	    default:
-		SDL_SetError("ASM stretch of %d bytes isn't supported\n", bpp);
-		return(-1);
 	}
-#ifdef HAVE_MPROTECT
-	/* Make the code writeable */
-	if ( mprotect(copy_row, sizeof(copy_row), PROT_READ|PROT_WRITE) < 0 ) {
-		SDL_SetError("Couldn't make copy buffer writeable");
-		return(-1);
+}
+
+/* Horizontal and vertical bilinear passes over 8888 rows */
+static void ScaleRowBilinear(const Uint32 *src, Uint32 *dst,
+                             const SDL_StretchAxis *axis, int width, int simd)
+{
+	int i = 0;
+
+#ifdef SSE2_STRETCH
+	if ( simd ) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i full = _mm_set1_epi16(256);
+		for ( ; i+2 <= width; i += 2 ) {
+			__m128i a, b, w;
+			a = _mm_unpacklo_epi8(_mm_set_epi32(0, 0,
+			        src[axis->index[i+1]], src[axis->index[i]]), zero);
+			b = _mm_unpacklo_epi8(_mm_set_epi32(0, 0,
+			        src[axis->index2[i+1]], src[axis->index2[i]]), zero);
+			w = _mm_unpacklo_epi64(_mm_set1_epi16((short)axis->weight[i]),
+			                       _mm_set1_epi16((short)axis->weight[i+1]));
+			a = _mm_add_epi16(_mm_mullo_epi16(a, _mm_sub_epi16(full, w)),
+			                  _mm_mullo_epi16(b, w));
+			a = _mm_srli_epi16(a, 8);
+			_mm_storel_epi64((__m128i *)(dst+i), _mm_packus_epi16(a, a));
+		}
 	}
 #endif
-	pos = 0x10000;
-	inc = (src_w << 16) / dst_w;
-	eip = copy_row;
-	fence = copy_row+sizeof(copy_row)-2;
-	for ( i=0; i<dst_w && eip < end; ++i ) {
-		while ( pos >= 0x10000L ) {
-			if ( eip == fence ) {
-				return -1;
-			}
-			if ( bpp == 2 ) {
-				*eip++ = PREFIX16;
-			}
-			*eip++ = load;
-			pos -= 0x10000L;
-		}
-		if ( eip == fence ) {
-			return -1;
+	for ( ; i<width; ++i ) {
+		dst[i] = Lerp8888(src[axis->index[i]], src[axis->index2[i]],
+		                  axis->weight[i]);
+	}
+}
+
+static void BlendRows(const Uint32 *row1, const Uint32 *row2, Uint32 *dst,
+                      int width, int weight, int simd)
+{
+	int i = 0;
+
+	if ( weight == 0 ) {
+		if ( dst != row1 ) {
+			SDL_memcpy(dst, row1, width*sizeof(Uint32));
 		}
-		if ( bpp == 2 ) {
-			*eip++ = PREFIX16;
+		return;
+	}
+#ifdef SSE2_STRETCH
+	if ( simd ) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i w = _mm_set1_epi16((short)weight);
+		const __m128i iw = _mm_set1_epi16((short)(256 - weight));
+		for ( ; i+4 <= width; i += 4 ) {
+			__m128i a = _mm_loadu_si128((const __m128i *)(row1+i));
+			__m128i b = _mm_loadu_si128((const __m128i *)(row2+i));
+			__m128i lo, hi;
+			lo = _mm_add_epi16(
+			       _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), iw),
+			       _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w));
+			hi = _mm_add_epi16(
+			       _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), iw),
+			       _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w));
+			lo = _mm_srli_epi16(lo, 8);
+			hi = _mm_srli_epi16(hi, 8);
+			_mm_storeu_si128((__m128i *)(dst+i), _mm_packus_epi16(lo, hi));
 		}
-		*eip++ = store;
-		pos += inc;
 	}
-	*eip++ = RETURN;
+#endif
+	for ( ; i<width; ++i ) {
+		dst[i] = Lerp8888(row1[i], row2[i], weight);
+	}
+}
 
-#ifdef HAVE_MPROTECT
-	/* Make the code executable but not writeable */
-	if ( mprotect(copy_row, sizeof(copy_row), PROT_READ|PROT_EXEC) < 0 ) {
-		SDL_SetError("Couldn't make copy buffer executable");
-		return(-1);
+/* Add a row of 8888 pixels into per-channel 32-bit sums */
+static void AccumulateRow(const Uint32 *src, Uint32 *sums, int width, int simd)
+{
+	int i = 0;
+	Uint32 pixel;
+
+#ifdef SSE2_STRETCH
+	if ( simd ) {
+		const __m128i zero = _mm_setzero_si128();
+		for ( ; i+4 <= width; i += 4 ) {
+			__m128i p = _mm_loadu_si128((const __m128i *)(src+i));
+			__m128i lo = _mm_unpacklo_epi8(p, zero);
+			__m128i hi = _mm_unpackhi_epi8(p, zero);
+			__m128i *acc = (__m128i *)(sums + i*4);
+			_mm_storeu_si128(acc+0, _mm_add_epi32(_mm_loadu_si128(acc+0),
+			                        _mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_si128(acc+1, _mm_add_epi32(_mm_loadu_si128(acc+1),
+			                        _mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_si128(acc+2, _mm_add_epi32(_mm_loadu_si128(acc+2),
+			                        _mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_si128(acc+3, _mm_add_epi32(_mm_loadu_si128(acc+3),
+			                        _mm_unpackhi_epi16(hi, zero)));
+		}
 	}
 #endif
-	last.status = 0;
-	return(0);
+	for ( ; i<width; ++i ) {
+		pixel = src[i];
+		sums[i*4+0] += (pixel & 0xFF);
+		sums[i*4+1] += ((pixel >> 8) & 0xFF);
+		sums[i*4+2] += ((pixel >> 16) & 0xFF);
+		sums[i*4+3] += (pixel >> 24);
+	}
 }
 
-#endif /* USE_ASM_STRETCH */
-
-#define DEFINE_COPY_ROW(name, type)			\
-void name(type *src, int src_w, type *dst, int dst_w)	\
-{							\
-	int i;						\
-	int pos, inc;					\
-	type pixel = 0;					\
-							\
-	pos = 0x10000;					\
-	inc = (src_w << 16) / dst_w;			\
-	for ( i=dst_w; i>0; --i ) {			\
-		while ( pos >= 0x10000L ) {		\
-			pixel = *src++;			\
-			pos -= 0x10000L;		\
-		}					\
-		*dst++ = pixel;				\
-		pos += inc;				\
-	}						\
+/* Average the column sums over each destination footprint */
+static void ResolveBoxRow(const Uint32 *sums, Uint32 *dst,
+                          const SDL_StretchAxis *axis, int width, int rows)
+{
+	int i, x, count;
+	Uint32 area;
+	Uint32 c0, c1, c2, c3;
+	const Uint32 *column;
+
+	for ( i=0; i<width; ++i ) {
+		column = sums + axis->index[i]*4;
+		count = axis->weight[i];
+		c0 = c1 = c2 = c3 = 0;
+		for ( x=0; x<count; ++x, column += 4 ) {
+			c0 += column[0];
+			c1 += column[1];
+			c2 += column[2];
+			c3 += column[3];
+		}
+		area = (Uint32)count * rows;
+		c0 = (c0 + area/2) / area;
+		c1 = (c1 + area/2) / area;
+		c2 = (c2 + area/2) / area;
+		c3 = (c3 + area/2) / area;
+		dst[i] = c0 | (c1 << 8) | (c2 << 16) | (c3 << 24);
+	}
 }
-DEFINE_COPY_ROW(copy_row1, Uint8)
-DEFINE_COPY_ROW(copy_row2, Uint16)
-DEFINE_COPY_ROW(copy_row4, Uint32)
 
-/* The ASM code doesn't handle 24-bpp stretch blits */
-void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
+static void StretchNearest(SDL_Surface *src, SDL_Rect *srcrect,
+                           SDL_Surface *dst, SDL_Rect *dstrect,
+                           const SDL_StretchAxis *xaxis,
+                           const SDL_StretchAxis *yaxis)
 {
-	int i;
-	int pos, inc;
-	Uint8 pixel[3] = { 0, 0, 0 };
+	const int bpp = dst->format->BytesPerPixel;
+	int dst_row;
+	int src_row, last_row = -1;
+	Uint8 *srcp;
+	Uint8 *dstp;
+	Uint8 *lastp = NULL;
 
-	pos = 0x10000;
-	inc = (src_w << 16) / dst_w;
-	for ( i=dst_w; i>0; --i ) {
-		while ( pos >= 0x10000L ) {
-			pixel[0] = *src++;
-			pixel[1] = *src++;
-			pixel[2] = *src++;
-			pos -= 0x10000L;
+	for ( dst_row=0; dst_row<dstrect->h; ++dst_row ) {
+		dstp = (Uint8 *)dst->pixels + (dstrect->y+dst_row)*dst->pitch
+		                            + dstrect->x*bpp;
+		src_row = srcrect->y + yaxis->index[dst_row];
+
+		/* Enlarging vertically repeats the row we just produced */
+		if ( src_row == last_row ) {
+			SDL_memcpy(dstp, lastp, dstrect->w*bpp);
+			continue;
 		}
-		*dst++ = pixel[0];
-		*dst++ = pixel[1];
-		*dst++ = pixel[2];
-		pos += inc;
+		srcp = (Uint8 *)src->pixels + src_row*src->pitch
+		                            + srcrect->x*bpp;
+		if ( srcrect->w == dstrect->w ) {
+			SDL_memcpy(dstp, srcp, dstrect->w*bpp);
+		} else {
+			SDL_StretchRowNearest(srcp, dstp, xaxis->index,
+			                      dstrect->w, bpp);
+		}
+		last_row = src_row;
+		lastp = dstp;
 	}
 }
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
-*/
+/* Fetch a source row as 8888, expanding it into 'work' if needed */
+static const Uint32 *GetSourceRow(SDL_Surface *src, SDL_Rect *srcrect,
+                                  int row, Uint32 *work, int simd)
+{
+	Uint8 *srcp = (Uint8 *)src->pixels + (srcrect->y+row)*src->pitch
+	                                   + srcrect->x*src->format->BytesPerPixel;
+	if ( src->format->BytesPerPixel == 2 ) {
+		Expand16Row((Uint16 *)srcp, work, srcrect->w, src->format, simd);
+		return work;
+	}
+	return (const Uint32 *)srcp;
+}
+
+/* Write an 8888 row to the destination, packing it if needed */
+static void PutDestRow(SDL_Surface *dst, SDL_Rect *dstrect,
+                       int row, const Uint32 *pixels, int simd)
+{
+	Uint8 *dstp = (Uint8 *)dst->pixels + (dstrect->y+row)*dst->pitch
+	                                   + dstrect->x*dst->format->BytesPerPixel;
+	if ( dst->format->BytesPerPixel == 2 ) {
+		Pack16Row(pixels, (Uint16 *)dstp, dstrect->w, dst->format, simd);
+	} else if ( (Uint8 *)pixels != dstp ) {
+		SDL_memcpy(dstp, pixels, dstrect->w*sizeof(Uint32));
+	}
+}
+
+static Uint32 *GetDestRow(SDL_Surface *dst, SDL_Rect *dstrect,
+                          int row, Uint32 *work)
+{
+	if ( dst->format->BytesPerPixel == 4 ) {
+		return (Uint32 *)((Uint8 *)dst->pixels + (dstrect->y+row)*dst->pitch
+		                                       + dstrect->x*4);
+	}
+	return work;
+}
+
+static void StretchBilinear(SDL_Surface *src, SDL_Rect *srcrect,
+                            SDL_Surface *dst, SDL_Rect *dstrect,
+                            const SDL_StretchAxis *xaxis,
+                            const SDL_StretchAxis *yaxis,
+                            Uint32 *work, int simd)
+{
+	Uint32 *srcwork = work;
+	Uint32 *rows[2];
+	Uint32 *dstwork;
+	Uint32 *swap;
+	Uint32 *dstp;
+	int cached[2];
+	int dst_row, y1, y2;
+
+	rows[0] = srcwork + srcrect->w;
+	rows[1] = rows[0] + dstrect->w;
+	dstwork = rows[1] + dstrect->w;
+	cached[0] = cached[1] = -1;
+
+	for ( dst_row=0; dst_row<dstrect->h; ++dst_row ) {
+		y1 = yaxis->index[dst_row];
+		y2 = yaxis->index2[dst_row];
+
+		/* Reuse horizontally scaled rows while moving down the source */
+		if ( cached[0] != y1 ) {
+			if ( cached[1] == y1 ) {
+				swap = rows[0]; rows[0] = rows[1]; rows[1] = swap;
+				cached[1] = cached[0];
+				cached[0] = y1;
+			} else {
+				ScaleRowBilinear(
+				    GetSourceRow(src, srcrect, y1, srcwork, simd),
+				    rows[0], xaxis, dstrect->w, simd);
+				cached[0] = y1;
+			}
+		}
+		if ( y2 != y1 && cached[1] != y2 ) {
+			ScaleRowBilinear(
+			    GetSourceRow(src, srcrect, y2, srcwork, simd),
+			    rows[1], xaxis, dstrect->w, simd);
+			cached[1] = y2;
+		}
+
+		dstp = GetDestRow(dst, dstrect, dst_row, dstwork);
+		BlendRows(rows[0], rows[1], dstp, dstrect->w,
+		          (y2 != y1) ? yaxis->weight[dst_row] : 0, simd);
+		PutDestRow(dst, dstrect, dst_row, dstp, simd);
+	}
+}
+
+static void StretchBox(SDL_Surface *src, SDL_Rect *srcrect,
+                       SDL_Surface *dst, SDL_Rect *dstrect,
+                       const SDL_StretchAxis *xaxis,
+                       const SDL_StretchAxis *yaxis,
+                       Uint32 *work, int simd)
+{
+	Uint32 *srcwork = work;
+	Uint32 *sums = srcwork + srcrect->w;
+	Uint32 *dstwork = sums + srcrect->w*4;
+	Uint32 *dstp;
+	int dst_row, row, rows;
+
+	for ( dst_row=0; dst_row<dstrect->h; ++dst_row ) {
+		row = yaxis->index[dst_row];
+		rows = yaxis->weight[dst_row];
+
+		SDL_memset(sums, 0, srcrect->w*4*sizeof(Uint32));
+		while ( rows-- ) {
+			AccumulateRow(
+			    GetSourceRow(src, srcrect, row++, srcwork, simd),
+			    sums, srcrect->w, simd);
+		}
+		dstp = GetDestRow(dst, dstrect, dst_row, dstwork);
+		ResolveBoxRow(sums, dstp, xaxis, dstrect->w,
+		              yaxis->weight[dst_row]);
+		PutDestRow(dst, dstrect, dst_row, dstp, simd);
+	}
+}
+
+/* Perform a stretch blit between two surfaces of the same format */
 int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                     SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	return SDL_SoftStretchFiltered(src, srcrect, dst, dstrect,
+	                               SDL_STRETCH_NEAREST);
+}
+
+int SDL_SoftStretchFiltered(SDL_Surface *src, SDL_Rect *srcrect,
+                            SDL_Surface *dst, SDL_Rect *dstrect,
+                            SDL_StretchFilter filter)
 {
 	int src_locked;
 	int dst_locked;
-	int pos, inc;
-	int dst_maxrow;
-	int src_row, dst_row;
-	Uint8 *srcp = NULL;
-	Uint8 *dstp;
+	int simd = 0;
+	size_t tablesize, worksize;
+	int *tables;
+	Uint32 *work;
+	SDL_StretchAxis xaxis, yaxis;
 	SDL_Rect full_src;
 	SDL_Rect full_dst;
-#ifdef USE_ASM_STRETCH
-	SDL_bool use_asm = SDL_TRUE;
-#ifdef __GNUC__
-	int u1, u2;
-#endif
-#endif /* USE_ASM_STRETCH */
 	const int bpp = dst->format->BytesPerPixel;
 
 	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
@@ -224,6 +593,18 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		return(-1);
 	}
 
+	/* Filtering needs separable channels, otherwise use nearest */
+	if ( (bpp != 2) && (bpp != 4) ) {
+		filter = SDL_STRETCH_NEAREST;
+	}
+	if ( (filter != SDL_STRETCH_NEAREST) && (bpp == 4) &&
+	     ((src->format->Rmask != dst->format->Rmask) ||
+	      (src->format->Gmask != dst->format->Gmask) ||
+	      (src->format->Bmask != dst->format->Bmask)) ) {
+		SDL_SetError("Only works with same format surfaces");
+		return(-1);
+	}
+
 	/* Verify the blit rectangles */
 	if ( srcrect ) {
 		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
@@ -253,15 +634,67 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		full_dst.h = dst->h;
 		dstrect = &full_dst;
 	}
+	if ( !srcrect->w || !srcrect->h || !dstrect->w || !dstrect->h ) {
+		return(0);
+	}
+
+	/* Build the coordinate tables and the working rows */
+	tablesize = 3 * (dstrect->w + dstrect->h);
+	switch (filter) {
+	    case SDL_STRETCH_BILINEAR:
+		worksize = srcrect->w + 3*dstrect->w;
+		break;
+	    case SDL_STRETCH_BOX:
+		worksize = srcrect->w*5 + dstrect->w;
+		break;
+	    default:
+		worksize = 0;
+		break;
+	}
+	tables = (int *)SDL_malloc(tablesize*sizeof(int) +
+	                           worksize*sizeof(Uint32));
+	if ( !tables ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	xaxis.index = tables;
+	xaxis.index2 = xaxis.index + dstrect->w;
+	xaxis.weight = xaxis.index2 + dstrect->w;
+	yaxis.index = xaxis.weight + dstrect->w;
+	yaxis.index2 = yaxis.index + dstrect->h;
+	yaxis.weight = yaxis.index2 + dstrect->h;
+	work = (Uint32 *)(yaxis.weight + dstrect->h);
+
+	switch (filter) {
+	    case SDL_STRETCH_BILINEAR:
+		SetupBilinear(&xaxis, srcrect->w, dstrect->w);
+		SetupBilinear(&yaxis, srcrect->h, dstrect->h);
+		break;
+	    case SDL_STRETCH_BOX:
+		SetupBox(&xaxis, srcrect->w, dstrect->w);
+		SetupBox(&yaxis, srcrect->h, dstrect->h);
+		break;
+	    default:
+		SetupNearest(&xaxis, srcrect->w, dstrect->w);
+		SetupNearest(&yaxis, srcrect->h, dstrect->h);
+		break;
+	}
+#ifdef SSE2_STRETCH
+	simd = SDL_HasSSE2();
+#endif
 
 	/* Lock the destination if it's in hardware */
 	dst_locked = 0;
 	if ( SDL_MUSTLOCK(dst) ) {
 		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_free(tables);
 			SDL_SetError("Unable to lock destination surface");
 			return(-1);
 		}
 		dst_locked = 1;
+		if ( dst->flags & SDL_RLEACCEL ) {
+			SDL_DirtyRLESurface(dst, dstrect->y, dstrect->h, 0);
+		}
 	}
 	/* Lock the source if it's in hardware */
 	src_locked = 0;
@@ -270,80 +703,681 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 			if ( dst_locked ) {
 				SDL_UnlockSurface(dst);
 			}
+			SDL_free(tables);
 			SDL_SetError("Unable to lock source surface");
 			return(-1);
 		}
 		src_locked = 1;
 	}
 
-	/* Set up the data... */
-	pos = 0x10000;
-	inc = (srcrect->h << 16) / dstrect->h;
-	src_row = srcrect->y;
-	dst_row = dstrect->y;
+	/* Perform the stretch blit */
+	switch (filter) {
+	    case SDL_STRETCH_BILINEAR:
+		StretchBilinear(src, srcrect, dst, dstrect,
+		                &xaxis, &yaxis, work, simd);
+		break;
+	    case SDL_STRETCH_BOX:
+		StretchBox(src, srcrect, dst, dstrect,
+		           &xaxis, &yaxis, work, simd);
+		break;
+	    default:
+		StretchNearest(src, srcrect, dst, dstrect, &xaxis, &yaxis);
+		break;
+	}
 
-#ifdef USE_ASM_STRETCH
-	/* Write the opcodes for this stretch */
-	if ( (bpp == 3) ||
-	     (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0) ) {
-		use_asm = SDL_FALSE;
+	/* We need to unlock the surfaces if they're locked */
+	if ( dst_locked ) {
+		SDL_UnlockSurface(dst);
 	}
-#endif
+	if ( src_locked ) {
+		SDL_UnlockSurface(src);
+	}
+	SDL_free(tables);
+	return(0);
+}
 
-	/* Perform the stretch blit */
-	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
-		dstp = (Uint8 *)dst->pixels + (dst_row*dst->pitch)
-		                            + (dstrect->x*bpp);
-		while ( pos >= 0x10000L ) {
-			srcp = (Uint8 *)src->pixels + (src_row*src->pitch)
-			                            + (srcrect->x*bpp);
-			++src_row;
-			pos -= 0x10000L;
+/* Integer factor upscaling for pixel art.  Each source row is expanded
+   once into the first of its destination rows and the rest of the rows
+   are copied from it.  The Scale2x/Scale3x filters are the edge
+   detecting rules from the AdvanceMAME project.
+*/
+
+#define DEFINE_REPLICATE_ROW(name, type)				\
+static void name(const type *src, type *dst, int x, int width, int factor) \
+{									\
+	int n;								\
+	type pixel;							\
+									\
+	dst += x*factor;						\
+	for ( ; x<width; ++x ) {					\
+		pixel = src[x];						\
+		for ( n=factor; n; --n ) {				\
+			*dst++ = pixel;					\
+		}							\
+	}								\
+}
+DEFINE_REPLICATE_ROW(replicate_row1, Uint8)
+DEFINE_REPLICATE_ROW(replicate_row2, Uint16)
+DEFINE_REPLICATE_ROW(replicate_row4, Uint32)
+
+#define DEFINE_SCALE2X_ROW(name, type)					\
+static void name(const type *B, const type *E, const type *H,		\
+                 type *dst0, type *dst1, int x, int end, int width)	\
+{									\
+	type D, F;							\
+									\
+	for ( ; x<end; ++x ) {						\
+		D = E[(x > 0) ? x-1 : x];				\
+		F = E[(x < width-1) ? x+1 : x];				\
+		if ( (B[x] != H[x]) && (D != F) ) {			\
+			dst0[2*x]   = (D == B[x]) ? D : E[x];		\
+			dst0[2*x+1] = (B[x] == F) ? F : E[x];		\
+			dst1[2*x]   = (D == H[x]) ? D : E[x];		\
+			dst1[2*x+1] = (H[x] == F) ? F : E[x];		\
+		} else {						\
+			dst0[2*x] = dst0[2*x+1] = E[x];			\
+			dst1[2*x] = dst1[2*x+1] = E[x];			\
+		}							\
+	}								\
+}
+DEFINE_SCALE2X_ROW(scale2x_row1, Uint8)
+DEFINE_SCALE2X_ROW(scale2x_row2, Uint16)
+DEFINE_SCALE2X_ROW(scale2x_row4, Uint32)
+
+#define DEFINE_SCALE3X_ROW(name, type)					\
+static void name(const type *up, const type *row, const type *down,	\
+                 type *dst0, type *dst1, type *dst2,			\
+                 int x, int end, int width)				\
+{									\
+	int l, r;							\
+	type A, B, C, D, E, F, G, H, I;					\
+									\
+	for ( ; x<end; ++x ) {						\
+		l = (x > 0) ? x-1 : x;					\
+		r = (x < width-1) ? x+1 : x;				\
+		A = up[l];   B = up[x];   C = up[r];			\
+		D = row[l];  E = row[x];  F = row[r];			\
+		G = down[l]; H = down[x]; I = down[r];			\
+		if ( (B != H) && (D != F) ) {				\
+			dst0[3*x]   = (D == B) ? D : E;			\
+			dst0[3*x+1] = ((D == B && E != C) ||		\
+			               (B == F && E != A)) ? B : E;	\
+			dst0[3*x+2] = (B == F) ? F : E;			\
+			dst1[3*x]   = ((D == B && E != G) ||		\
+			               (D == H && E != A)) ? D : E;	\
+			dst1[3*x+1] = E;				\
+			dst1[3*x+2] = ((B == F && E != I) ||		\
+			               (H == F && E != C)) ? F : E;	\
+			dst2[3*x]   = (D == H) ? D : E;			\
+			dst2[3*x+1] = ((D == H && E != I) ||		\
+			               (H == F && E != G)) ? H : E;	\
+			dst2[3*x+2] = (H == F) ? F : E;			\
+		} else {						\
+			dst0[3*x] = dst0[3*x+1] = dst0[3*x+2] = E;	\
+			dst1[3*x] = dst1[3*x+1] = dst1[3*x+2] = E;	\
+			dst2[3*x] = dst2[3*x+1] = dst2[3*x+2] = E;	\
+		}							\
+	}								\
+}
+DEFINE_SCALE3X_ROW(scale3x_row1, Uint8)
+DEFINE_SCALE3X_ROW(scale3x_row2, Uint16)
+DEFINE_SCALE3X_ROW(scale3x_row4, Uint32)
+
+#ifdef SSE2_STRETCH
+/* Interleave a vector with itself, doubling every 'size' byte element */
+static __inline__ void Double128(__m128i p, int size, __m128i *lo, __m128i *hi)
+{
+	switch (size) {
+	    case 1:
+		*lo = _mm_unpacklo_epi8(p, p);
+		*hi = _mm_unpackhi_epi8(p, p);
+		break;
+	    case 2:
+		*lo = _mm_unpacklo_epi16(p, p);
+		*hi = _mm_unpackhi_epi16(p, p);
+		break;
+	    case 4:
+		*lo = _mm_unpacklo_epi32(p, p);
+		*hi = _mm_unpackhi_epi32(p, p);
+		break;
+	    default:
+		*lo = _mm_unpacklo_epi64(p, p);
+		*hi = _mm_unpackhi_epi64(p, p);
+		break;
+	}
+}
+
+/* Interleave three vectors of 'size' byte elements, a0 b0 c0 a1 b1 c1 ...
+   The 8 and 16-bit elements are widened to 32 bits, interleaved there and
+   narrowed again, as SSE2 has no byte shuffle.
+ */
+static __inline__ void Interleave3x32(__m128i a, __m128i b, __m128i c,
+                                      __m128i *out)
+{
+	out[0] = _mm_castps_si128(_mm_shuffle_ps(
+			_mm_castsi128_ps(_mm_unpacklo_epi32(a, b)),
+			_mm_castsi128_ps(_mm_unpacklo_epi32(c, a)),
+			_MM_SHUFFLE(3, 0, 1, 0)));
+	out[1] = _mm_castps_si128(_mm_shuffle_ps(
+			_mm_castsi128_ps(_mm_unpacklo_epi32(b, c)),
+			_mm_castsi128_ps(_mm_unpackhi_epi32(a, b)),
+			_MM_SHUFFLE(1, 0, 3, 2)));
+	out[2] = _mm_castps_si128(_mm_shuffle_ps(
+			_mm_castsi128_ps(_mm_unpackhi_epi32(c, a)),
+			_mm_castsi128_ps(_mm_unpackhi_epi32(b, c)),
+			_MM_SHUFFLE(3, 2, 3, 0)));
+}
+
+/* Narrow 32-bit elements to 16 bits, without signed saturation */
+static __inline__ __m128i Pack32to16(__m128i lo, __m128i hi)
+{
+	const __m128i bias = _mm_set1_epi32(0x8000);
+
+	return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo, bias),
+	                                     _mm_sub_epi32(hi, bias)),
+	                     _mm_set1_epi16((short)0x8000));
+}
+
+static __inline__ void Interleave3x16(__m128i a, __m128i b, __m128i c,
+                                      __m128i *out)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo[3], hi[3];
+
+	Interleave3x32(_mm_unpacklo_epi16(a, zero), _mm_unpacklo_epi16(b, zero),
+	               _mm_unpacklo_epi16(c, zero), lo);
+	Interleave3x32(_mm_unpackhi_epi16(a, zero), _mm_unpackhi_epi16(b, zero),
+	               _mm_unpackhi_epi16(c, zero), hi);
+	out[0] = Pack32to16(lo[0], lo[1]);
+	out[1] = Pack32to16(lo[2], hi[0]);
+	out[2] = Pack32to16(hi[1], hi[2]);
+}
+
+static __inline__ void Interleave3x8(__m128i a, __m128i b, __m128i c,
+                                     __m128i *out)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo[3], hi[3];
+
+	Interleave3x16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero),
+	               _mm_unpacklo_epi8(c, zero), lo);
+	Interleave3x16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero),
+	               _mm_unpackhi_epi8(c, zero), hi);
+	out[0] = _mm_packus_epi16(lo[0], lo[1]);
+	out[1] = _mm_packus_epi16(lo[2], hi[0]);
+	out[2] = _mm_packus_epi16(hi[1], hi[2]);
+}
+
+static __inline__ void Interleave3(__m128i a, __m128i b, __m128i c,
+                                   int size, __m128i *out)
+{
+	switch (size) {
+	    case 1:
+		Interleave3x8(a, b, c, out);
+		break;
+	    case 2:
+		Interleave3x16(a, b, c, out);
+		break;
+	    default:
+		Interleave3x32(a, b, c, out);
+		break;
+	}
+}
+
+/* Returns the number of source pixels handled */
+static int ReplicateRowSSE2(const Uint8 *src, Uint8 *dst,
+                            int width, int bpp, int factor)
+{
+	const int n = 16 / bpp;
+	int x;
+	__m128i lo, hi, a, b;
+	__m128i *out = (__m128i *)dst;
+
+	if ( factor == 2 ) {
+		for ( x=0; x+n <= width; x += n, src += 16 ) {
+			Double128(_mm_loadu_si128((const __m128i *)src), bpp,
+			          &lo, &hi);
+			_mm_storeu_si128(out++, lo);
+			_mm_storeu_si128(out++, hi);
 		}
-#ifdef USE_ASM_STRETCH
-		if (use_asm) {
-#ifdef __GNUC__
-			__asm__ __volatile__ (
-			"call *%4"
-			: "=&D" (u1), "=&S" (u2)
-			: "0" (dstp), "1" (srcp), "r" (copy_row)
-			: "memory" );
-#elif defined(_MSC_VER) || defined(__WATCOMC__)
-		{ void *code = copy_row;
-			__asm {
-				push edi
-				push esi
-	
-				mov edi, dstp
-				mov esi, srcp
-				call dword ptr code
-
-				pop esi
-				pop edi
-			}
+		return x;
+	}
+	if ( factor == 3 ) {
+		__m128i v[3];
+
+		for ( x=0; x+n <= width; x += n, src += 16 ) {
+			a = _mm_loadu_si128((const __m128i *)src);
+			Interleave3(a, a, a, bpp, v);
+			_mm_storeu_si128(out++, v[0]);
+			_mm_storeu_si128(out++, v[1]);
+			_mm_storeu_si128(out++, v[2]);
+		}
+		return x;
+	}
+	if ( factor == 4 ) {
+		for ( x=0; x+n <= width; x += n, src += 16 ) {
+			Double128(_mm_loadu_si128((const __m128i *)src), bpp,
+			          &lo, &hi);
+			Double128(lo, bpp*2, &a, &b);
+			_mm_storeu_si128(out++, a);
+			_mm_storeu_si128(out++, b);
+			Double128(hi, bpp*2, &a, &b);
+			_mm_storeu_si128(out++, a);
+			_mm_storeu_si128(out++, b);
+		}
+		return x;
+	}
+	return 0;
+}
+
+/* Scale2x on the interior of a row, n pixels at a time.
+   Returns the first pixel left for the scalar code.
+ */
+#define DEFINE_SCALE2X_SSE2(name, type, cmpeq, unpacklo, unpackhi)	\
+static int name(const type *B, const type *E, const type *H,		\
+                type *dst0, type *dst1, int width)			\
+{									\
+	const int n = 16 / sizeof(type);				\
+	int x;								\
+	__m128i b, d, e, f, h, flat;					\
+	__m128i e0, e1, e2, e3, mask;					\
+									\
+	for ( x=1; x+n < width; x += n ) {				\
+		b = _mm_loadu_si128((const __m128i *)(B+x));		\
+		d = _mm_loadu_si128((const __m128i *)(E+x-1));		\
+		e = _mm_loadu_si128((const __m128i *)(E+x));		\
+		f = _mm_loadu_si128((const __m128i *)(E+x+1));		\
+		h = _mm_loadu_si128((const __m128i *)(H+x));		\
+		flat = _mm_or_si128(cmpeq(b, h), cmpeq(d, f));		\
+									\
+		mask = _mm_andnot_si128(flat, cmpeq(d, b));		\
+		e0 = _mm_or_si128(_mm_and_si128(mask, d),		\
+		                  _mm_andnot_si128(mask, e));		\
+		mask = _mm_andnot_si128(flat, cmpeq(b, f));		\
+		e1 = _mm_or_si128(_mm_and_si128(mask, f),		\
+		                  _mm_andnot_si128(mask, e));		\
+		mask = _mm_andnot_si128(flat, cmpeq(d, h));		\
+		e2 = _mm_or_si128(_mm_and_si128(mask, d),		\
+		                  _mm_andnot_si128(mask, e));		\
+		mask = _mm_andnot_si128(flat, cmpeq(h, f));		\
+		e3 = _mm_or_si128(_mm_and_si128(mask, f),		\
+		                  _mm_andnot_si128(mask, e));		\
+									\
+		_mm_storeu_si128((__m128i *)(dst0+2*x), unpacklo(e0, e1)); \
+		_mm_storeu_si128((__m128i *)(dst0+2*x+n), unpackhi(e0, e1)); \
+		_mm_storeu_si128((__m128i *)(dst1+2*x), unpacklo(e2, e3)); \
+		_mm_storeu_si128((__m128i *)(dst1+2*x+n), unpackhi(e2, e3)); \
+	}								\
+	return x;							\
+}
+DEFINE_SCALE2X_SSE2(scale2x_sse2_1, Uint8, _mm_cmpeq_epi8,
+                    _mm_unpacklo_epi8, _mm_unpackhi_epi8)
+DEFINE_SCALE2X_SSE2(scale2x_sse2_2, Uint16, _mm_cmpeq_epi16,
+                    _mm_unpacklo_epi16, _mm_unpackhi_epi16)
+DEFINE_SCALE2X_SSE2(scale2x_sse2_4, Uint32, _mm_cmpeq_epi32,
+                    _mm_unpacklo_epi32, _mm_unpackhi_epi32)
+
+/* Pick 'x' where the mask is set and 'e' elsewhere */
+#define SELECT_SSE2(mask, x, e) \
+	_mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, e))
+
+/* Scale3x on the interior of a row, n pixels at a time, with the same
+   rules as the scalar code.  Returns the first pixel left for it.
+ */
+#define DEFINE_SCALE3X_SSE2(name, type, cmpeq)				\
+static int name(const type *up, const type *row, const type *down,	\
+                type *dst0, type *dst1, type *dst2, int width)		\
+{									\
+	const int n = 16 / sizeof(type);				\
+	int x;								\
+	__m128i A, B, C, D, E, F, G, H, I;				\
+	__m128i db, bf, dh, hf, ea, ec, eg, ei, flat, mask;		\
+	__m128i e0, e1, e2, v[3];					\
+									\
+	for ( x=1; x+n < width; x += n ) {				\
+		A = _mm_loadu_si128((const __m128i *)(up+x-1));		\
+		B = _mm_loadu_si128((const __m128i *)(up+x));		\
+		C = _mm_loadu_si128((const __m128i *)(up+x+1));		\
+		D = _mm_loadu_si128((const __m128i *)(row+x-1));	\
+		E = _mm_loadu_si128((const __m128i *)(row+x));		\
+		F = _mm_loadu_si128((const __m128i *)(row+x+1));	\
+		G = _mm_loadu_si128((const __m128i *)(down+x-1));	\
+		H = _mm_loadu_si128((const __m128i *)(down+x));		\
+		I = _mm_loadu_si128((const __m128i *)(down+x+1));	\
+		flat = _mm_or_si128(cmpeq(B, H), cmpeq(D, F));		\
+		db = _mm_andnot_si128(flat, cmpeq(D, B));		\
+		bf = _mm_andnot_si128(flat, cmpeq(B, F));		\
+		dh = _mm_andnot_si128(flat, cmpeq(D, H));		\
+		hf = _mm_andnot_si128(flat, cmpeq(H, F));		\
+		ea = cmpeq(E, A);					\
+		ec = cmpeq(E, C);					\
+		eg = cmpeq(E, G);					\
+		ei = cmpeq(E, I);					\
+									\
+		e0 = SELECT_SSE2(db, D, E);				\
+		mask = _mm_or_si128(_mm_andnot_si128(ec, db),		\
+		                    _mm_andnot_si128(ea, bf));		\
+		e1 = SELECT_SSE2(mask, B, E);				\
+		e2 = SELECT_SSE2(bf, F, E);				\
+		Interleave3(e0, e1, e2, sizeof(type), v);		\
+		_mm_storeu_si128((__m128i *)(dst0+3*x), v[0]);		\
+		_mm_storeu_si128((__m128i *)(dst0+3*x+n), v[1]);	\
+		_mm_storeu_si128((__m128i *)(dst0+3*x+2*n), v[2]);	\
+									\
+		mask = _mm_or_si128(_mm_andnot_si128(eg, db),		\
+		                    _mm_andnot_si128(ea, dh));		\
+		e0 = SELECT_SSE2(mask, D, E);				\
+		mask = _mm_or_si128(_mm_andnot_si128(ei, bf),		\
+		                    _mm_andnot_si128(ec, hf));		\
+		e2 = SELECT_SSE2(mask, F, E);				\
+		Interleave3(e0, E, e2, sizeof(type), v);		\
+		_mm_storeu_si128((__m128i *)(dst1+3*x), v[0]);		\
+		_mm_storeu_si128((__m128i *)(dst1+3*x+n), v[1]);	\
+		_mm_storeu_si128((__m128i *)(dst1+3*x+2*n), v[2]);	\
+									\
+		e0 = SELECT_SSE2(dh, D, E);				\
+		mask = _mm_or_si128(_mm_andnot_si128(ei, dh),		\
+		                    _mm_andnot_si128(eg, hf));		\
+		e1 = SELECT_SSE2(mask, H, E);				\
+		e2 = SELECT_SSE2(hf, F, E);				\
+		Interleave3(e0, e1, e2, sizeof(type), v);		\
+		_mm_storeu_si128((__m128i *)(dst2+3*x), v[0]);		\
+		_mm_storeu_si128((__m128i *)(dst2+3*x+n), v[1]);	\
+		_mm_storeu_si128((__m128i *)(dst2+3*x+2*n), v[2]);	\
+	}								\
+	return x;							\
+}
+DEFINE_SCALE3X_SSE2(scale3x_sse2_1, Uint8, _mm_cmpeq_epi8)
+DEFINE_SCALE3X_SSE2(scale3x_sse2_2, Uint16, _mm_cmpeq_epi16)
+DEFINE_SCALE3X_SSE2(scale3x_sse2_4, Uint32, _mm_cmpeq_epi32)
+#endif /* SSE2_STRETCH */
+
+static void Replicate(const Uint8 *src, int srcpitch, Uint8 *dst, int dstpitch,
+                      int w, int h, int bpp, int factor, int simd)
+{
+	int y, n, x;
+	const int rowbytes = w*bpp*factor;
+
+	for ( y=0; y<h; ++y ) {
+		x = 0;
+#ifdef SSE2_STRETCH
+		if ( simd ) {
+			x = ReplicateRowSSE2(src, dst, w, bpp, factor);
 		}
-#else
-#error Need inline assembly for this compiler
-#endif
-		} else
 #endif
 		switch (bpp) {
 		    case 1:
-			copy_row1(srcp, srcrect->w, dstp, dstrect->w);
+			replicate_row1(src, dst, x, w, factor);
+			break;
+		    case 2:
+			replicate_row2((const Uint16 *)src, (Uint16 *)dst,
+			               x, w, factor);
+			break;
+		    case 4:
+			replicate_row4((const Uint32 *)src, (Uint32 *)dst,
+			               x, w, factor);
+			break;
+		}
+		for ( n=1; n<factor; ++n ) {
+			SDL_memcpy(dst+n*dstpitch, dst, rowbytes);
+		}
+		src += srcpitch;
+		dst += factor*dstpitch;
+	}
+}
+
+static void Scale2x(const Uint8 *src, int srcpitch, Uint8 *dst, int dstpitch,
+                    int w, int h, int bpp, int simd)
+{
+	int y, x;
+	const Uint8 *up, *down;
+	Uint8 *dst0, *dst1;
+
+	for ( y=0; y<h; ++y ) {
+		up = (y > 0) ? src-srcpitch : src;
+		down = (y < h-1) ? src+srcpitch : src;
+		dst0 = dst;
+		dst1 = dst+dstpitch;
+
+		/* The first pixel, the SIMD interior and then the rest */
+		switch (bpp) {
+		    case 1:
+			scale2x_row1(up, src, down, dst0, dst1, 0, 1, w);
+			x = 1;
+#ifdef SSE2_STRETCH
+			if ( simd ) {
+				x = scale2x_sse2_1(up, src, down, dst0, dst1, w);
+			}
+#endif
+			scale2x_row1(up, src, down, dst0, dst1, x, w, w);
 			break;
 		    case 2:
-			copy_row2((Uint16 *)srcp, srcrect->w,
-			          (Uint16 *)dstp, dstrect->w);
+			scale2x_row2((const Uint16 *)up, (const Uint16 *)src,
+			             (const Uint16 *)down, (Uint16 *)dst0,
+			             (Uint16 *)dst1, 0, 1, w);
+			x = 1;
+#ifdef SSE2_STRETCH
+			if ( simd ) {
+				x = scale2x_sse2_2((const Uint16 *)up,
+				                   (const Uint16 *)src,
+				                   (const Uint16 *)down,
+				                   (Uint16 *)dst0,
+				                   (Uint16 *)dst1, w);
+			}
+#endif
+			scale2x_row2((const Uint16 *)up, (const Uint16 *)src,
+			             (const Uint16 *)down, (Uint16 *)dst0,
+			             (Uint16 *)dst1, x, w, w);
 			break;
-		    case 3:
-			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
+		    case 4:
+			scale2x_row4((const Uint32 *)up, (const Uint32 *)src,
+			             (const Uint32 *)down, (Uint32 *)dst0,
+			             (Uint32 *)dst1, 0, 1, w);
+			x = 1;
+#ifdef SSE2_STRETCH
+			if ( simd ) {
+				x = scale2x_sse2_4((const Uint32 *)up,
+				                   (const Uint32 *)src,
+				                   (const Uint32 *)down,
+				                   (Uint32 *)dst0,
+				                   (Uint32 *)dst1, w);
+			}
+#endif
+			scale2x_row4((const Uint32 *)up, (const Uint32 *)src,
+			             (const Uint32 *)down, (Uint32 *)dst0,
+			             (Uint32 *)dst1, x, w, w);
+			break;
+		}
+		src += srcpitch;
+		dst += 2*dstpitch;
+	}
+}
+
+static void Scale3x(const Uint8 *src, int srcpitch, Uint8 *dst, int dstpitch,
+                    int w, int h, int bpp, int simd)
+{
+	int y, x;
+	const Uint8 *up, *down;
+	Uint8 *dst0, *dst1, *dst2;
+
+	for ( y=0; y<h; ++y ) {
+		up = (y > 0) ? src-srcpitch : src;
+		down = (y < h-1) ? src+srcpitch : src;
+		dst0 = dst;
+		dst1 = dst+dstpitch;
+		dst2 = dst+2*dstpitch;
+
+		/* The first pixel, the SIMD interior and then the rest */
+		switch (bpp) {
+		    case 1:
+			scale3x_row1(up, src, down, dst0, dst1, dst2, 0, 1, w);
+			x = 1;
+#ifdef SSE2_STRETCH
+			if ( simd ) {
+				x = scale3x_sse2_1(up, src, down,
+				                   dst0, dst1, dst2, w);
+			}
+#endif
+			scale3x_row1(up, src, down, dst0, dst1, dst2, x, w, w);
+			break;
+		    case 2:
+			scale3x_row2((const Uint16 *)up, (const Uint16 *)src,
+			             (const Uint16 *)down, (Uint16 *)dst0,
+			             (Uint16 *)dst1, (Uint16 *)dst2, 0, 1, w);
+			x = 1;
+#ifdef SSE2_STRETCH
+			if ( simd ) {
+				x = scale3x_sse2_2((const Uint16 *)up,
+				                   (const Uint16 *)src,
+				                   (const Uint16 *)down,
+				                   (Uint16 *)dst0, (Uint16 *)dst1,
+				                   (Uint16 *)dst2, w);
+			}
+#endif
+			scale3x_row2((const Uint16 *)up, (const Uint16 *)src,
+			             (const Uint16 *)down, (Uint16 *)dst0,
+			             (Uint16 *)dst1, (Uint16 *)dst2, x, w, w);
 			break;
 		    case 4:
-			copy_row4((Uint32 *)srcp, srcrect->w,
-			          (Uint32 *)dstp, dstrect->w);
+			scale3x_row4((const Uint32 *)up, (const Uint32 *)src,
+			             (const Uint32 *)down, (Uint32 *)dst0,
+			             (Uint32 *)dst1, (Uint32 *)dst2, 0, 1, w);
+			x = 1;
+#ifdef SSE2_STRETCH
+			if ( simd ) {
+				x = scale3x_sse2_4((const Uint32 *)up,
+				                   (const Uint32 *)src,
+				                   (const Uint32 *)down,
+				                   (Uint32 *)dst0, (Uint32 *)dst1,
+				                   (Uint32 *)dst2, w);
+			}
+#endif
+			scale3x_row4((const Uint32 *)up, (const Uint32 *)src,
+			             (const Uint32 *)down, (Uint32 *)dst0,
+			             (Uint32 *)dst1, (Uint32 *)dst2, x, w, w);
 			break;
 		}
-		pos += inc;
+		src += srcpitch;
+		dst += 3*dstpitch;
+	}
+}
+
+int SDL_SoftUpscale(SDL_Surface *src, SDL_Rect *srcrect,
+                    SDL_Surface *dst, SDL_Rect *dstrect,
+                    int factor, SDL_UpscaleFilter filter)
+{
+	int src_locked;
+	int dst_locked;
+	int simd = 0;
+	int dstx, dsty;
+	int pitch;
+	Uint8 *srcp, *dstp;
+	Uint8 *temp = NULL;
+	SDL_Rect full_src;
+	const int bpp = dst->format->BytesPerPixel;
+
+	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
+		SDL_SetError("Only works with same format surfaces");
+		return(-1);
+	}
+	if ( (bpp != 1) && (bpp != 2) && (bpp != 4) ) {
+		SDL_SetError("Upscaling %d bpp surfaces isn't supported",
+		             dst->format->BitsPerPixel);
+		return(-1);
+	}
+	if ( (factor < 1) ||
+	     ((filter == SDL_UPSCALE_SCALEX) && (factor > 4)) ) {
+		SDL_SetError("Unsupported upscale factor %d", factor);
+		return(-1);
+	}
+
+	/* Verify the blit rectangles */
+	if ( srcrect ) {
+		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
+		     ((srcrect->x+srcrect->w) > src->w) ||
+		     ((srcrect->y+srcrect->h) > src->h) ) {
+			SDL_SetError("Invalid source blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_src.x = 0;
+		full_src.y = 0;
+		full_src.w = src->w;
+		full_src.h = src->h;
+		srcrect = &full_src;
+	}
+	dstx = dstrect ? dstrect->x : 0;
+	dsty = dstrect ? dstrect->y : 0;
+	if ( (dstx < 0) || (dsty < 0) ||
+	     ((dstx+srcrect->w*factor) > dst->w) ||
+	     ((dsty+srcrect->h*factor) > dst->h) ) {
+		SDL_SetError("Invalid destination blit rectangle");
+		return(-1);
+	}
+	if ( dstrect ) {
+		dstrect->w = srcrect->w*factor;
+		dstrect->h = srcrect->h*factor;
+	}
+	if ( !srcrect->w || !srcrect->h ) {
+		return(0);
+	}
+
+	/* Scale4x is Scale2x applied twice */
+	if ( (filter == SDL_UPSCALE_SCALEX) && (factor == 4) ) {
+		temp = (Uint8 *)SDL_malloc(srcrect->w*2*srcrect->h*2*bpp);
+		if ( !temp ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+	}
+#ifdef SSE2_STRETCH
+	simd = SDL_HasSSE2();
+#endif
+
+	/* Lock the destination if it's in hardware */
+	dst_locked = 0;
+	if ( SDL_MUSTLOCK(dst) ) {
+		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_free(temp);
+			SDL_SetError("Unable to lock destination surface");
+			return(-1);
+		}
+		dst_locked = 1;
+		if ( dst->flags & SDL_RLEACCEL ) {
+			SDL_DirtyRLESurface(dst, dsty, srcrect->h*factor, 0);
+		}
+	}
+	/* Lock the source if it's in hardware */
+	src_locked = 0;
+	if ( SDL_MUSTLOCK(src) ) {
+		if ( SDL_LockSurface(src) < 0 ) {
+			if ( dst_locked ) {
+				SDL_UnlockSurface(dst);
+			}
+			SDL_free(temp);
+			SDL_SetError("Unable to lock source surface");
+			return(-1);
+		}
+		src_locked = 1;
+	}
+
+	srcp = (Uint8 *)src->pixels + srcrect->y*src->pitch + srcrect->x*bpp;
+	dstp = (Uint8 *)dst->pixels + dsty*dst->pitch + dstx*bpp;
+	if ( (filter != SDL_UPSCALE_SCALEX) || (factor == 1) ) {
+		Replicate(srcp, src->pitch, dstp, dst->pitch,
+		          srcrect->w, srcrect->h, bpp, factor, simd);
+	} else if ( factor == 2 ) {
+		Scale2x(srcp, src->pitch, dstp, dst->pitch,
+		        srcrect->w, srcrect->h, bpp, simd);
+	} else if ( factor == 3 ) {
+		Scale3x(srcp, src->pitch, dstp, dst->pitch,
+		        srcrect->w, srcrect->h, bpp, simd);
+	} else {
+		pitch = srcrect->w*2*bpp;
+		Scale2x(srcp, src->pitch, temp, pitch,
+		        srcrect->w, srcrect->h, bpp, simd);
+		Scale2x(temp, pitch, dstp, dst->pitch,
+		        srcrect->w*2, srcrect->h*2, bpp, simd);
 	}
 
 	/* We need to unlock the surfaces if they're locked */
@@ -353,6 +1387,7 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	if ( src_locked ) {
 		SDL_UnlockSurface(src);
 	}
+	SDL_free(temp);
 	return(0);
 }
 
@@ -21,9 +21,14 @@
 */
 #include "SDL_config.h"
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
-*/
+/* Perform a stretch blit between two surfaces of the same format */
 extern int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                            SDL_Surface *dst, SDL_Rect *dstrect);
 
+/* Fill 'index' with the source sample SDL_SoftStretch() picks for each
+   of 'dst_len' destination samples */
+extern void SDL_StretchNearestIndex(int *index, int src_len, int dst_len);
+
+/* Copy 'width' pixels of 'bpp' bytes, source pixel index[i] to pixel i */
+extern void SDL_StretchRowNearest(const Uint8 *src, Uint8 *dst,
+                                  const int *index, int width, int bpp);
@@ -27,8 +27,13 @@
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_convert_c.h"
+#include "SDL_parallel_c.h"
 #include "SDL_leaks.h"
 
+/* Minimum number of pixels worth handing to another thread */
+#define CONVERT_THREAD_PIXELS	(64 * 1024)
+
 
 /* Public routines */
 /*
@@ -600,6 +605,9 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	if ( SDL_LockSurface(dst) != 0 ) {
 		return(-1);
 	}
+	if ( dst->flags & SDL_RLEACCEL ) {
+		SDL_DirtyRLESurface(dst, dstrect->y, dstrect->h, 0);
+	}
 	row = (Uint8 *)dst->pixels+dstrect->y*dst->pitch+
 			dstrect->x*dst->format->BytesPerPixel;
 	if ( dst->format->palette || (color == 0) ) {
@@ -745,8 +753,7 @@ int SDL_LockSurface (SDL_Surface *surface)
 			}
 		}
 		if ( surface->flags & SDL_RLEACCEL ) {
-			SDL_UnRLESurface(surface, 1);
-			surface->flags |= SDL_RLEACCEL;	/* save accel'd state */
+			SDL_SuspendRLESurface(surface);
 		}
 		/* This needs to be done here in case pixels changes value */
 		surface->pixels = (Uint8 *)surface->pixels + surface->offset;
@@ -779,23 +786,31 @@ void SDL_UnlockSurface (SDL_Surface *surface)
 	} else {
 		/* Update RLE encoded surface with new data */
 		if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		        surface->flags &= ~SDL_RLEACCEL; /* stop lying */
-			SDL_RLESurface(surface);
+			SDL_ResumeRLESurface(surface);
 		}
 	}
 }
 
-/* 
- * Convert a surface into the specified pixel format.
+/*
+ * Record the rows of a locked surface that have been modified
  */
-SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
-					SDL_PixelFormat *format, Uint32 flags)
+void SDL_DirtySurfaceRows (SDL_Surface *surface, int y, int h)
+{
+	if ( surface->locked && (surface->flags & SDL_RLEACCEL) ) {
+		SDL_DirtyRLESurface(surface, y, h, 1);
+	}
+}
+
+/*
+ * Create the surface a conversion writes into, and plan how its pixels
+ * can be converted.
+ */
+static SDL_Surface *SDL_StartConvert(SDL_Surface *surface,
+			SDL_PixelFormat *format, Uint32 flags,
+			SDL_ConvertPlan *plan)
 {
 	SDL_Surface *convert;
-	Uint32 colorkey = 0;
-	Uint8 alpha = 0;
-	Uint32 surface_flags;
-	SDL_Rect bounds;
+	int keyed;
 
 	/* Check for empty destination palette! (results in empty image) */
 	if ( format->palette != NULL ) {
@@ -836,6 +851,29 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 		convert->format->palette->ncolors = format->palette->ncolors;
 	}
 
+	/* Colourkeyed surfaces converted to RGBA leave out the key */
+	keyed = ((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY &&
+	         (flags & SDL_SRCCOLORKEY) != SDL_SRCCOLORKEY &&
+	         format->Amask);
+	SDL_PlanConvert(plan, surface, convert, keyed);
+
+	return(convert);
+}
+
+/*
+ * Blit the pixels if they couldn't be converted directly, and give the
+ * new surface the colour key and alpha of the original.
+ */
+static void SDL_FinishConvert(SDL_Surface *surface, SDL_Surface *convert,
+			SDL_PixelFormat *format, Uint32 flags,
+			const SDL_ConvertPlan *plan)
+{
+	Uint32 colorkey = 0;
+	Uint8 alpha = 0;
+	Uint32 surface_flags;
+	SDL_Rect bounds;
+	int blit = (plan->mode == SDL_CONVERT_BLIT);
+
 	/* Save the original surface color key and alpha */
 	surface_flags = surface->flags;
 	if ( (surface_flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY ) {
@@ -845,55 +883,153 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 			surface_flags &= ~SDL_SRCCOLORKEY;
 		} else {
 			colorkey = surface->format->colorkey;
-			SDL_SetColorKey(surface, 0, 0);
+			if ( blit ) {
+				SDL_SetColorKey(surface, 0, 0);
+			}
 		}
 	}
 	if ( (surface_flags & SDL_SRCALPHA) == SDL_SRCALPHA ) {
 		/* Copy over the alpha channel to RGBA if requested */
 		if ( format->Amask ) {
-			surface->flags &= ~SDL_SRCALPHA;
+			if ( blit ) {
+				surface->flags &= ~SDL_SRCALPHA;
+			}
 		} else {
 			alpha = surface->format->alpha;
-			SDL_SetAlpha(surface, 0, 0);
+			if ( blit ) {
+				SDL_SetAlpha(surface, 0, 0);
+			}
 		}
 	}
 
-	/* Copy over the image data */
-	bounds.x = 0;
-	bounds.y = 0;
-	bounds.w = surface->w;
-	bounds.h = surface->h;
-	SDL_LowerBlit(surface, &bounds, convert, &bounds);
+	/* Copy over the image data, unless it was converted directly */
+	if ( blit ) {
+		bounds.x = 0;
+		bounds.y = 0;
+		bounds.w = surface->w;
+		bounds.h = surface->h;
+		SDL_LowerBlit(surface, &bounds, convert, &bounds);
+	}
 
 	/* Clean up the original surface, and update converted surface */
-	if ( convert != NULL ) {
-		SDL_SetClipRect(convert, &surface->clip_rect);
-	}
+	SDL_SetClipRect(convert, &surface->clip_rect);
 	if ( (surface_flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY ) {
 		Uint32 cflags = surface_flags&(SDL_SRCCOLORKEY|SDL_RLEACCELOK);
-		if ( convert != NULL ) {
-			Uint8 keyR, keyG, keyB;
+		Uint8 keyR, keyG, keyB;
 
-			SDL_GetRGB(colorkey,surface->format,&keyR,&keyG,&keyB);
-			SDL_SetColorKey(convert, cflags|(flags&SDL_RLEACCELOK),
-				SDL_MapRGB(convert->format, keyR, keyG, keyB));
+		SDL_GetRGB(colorkey,surface->format,&keyR,&keyG,&keyB);
+		SDL_SetColorKey(convert, cflags|(flags&SDL_RLEACCELOK),
+			SDL_MapRGB(convert->format, keyR, keyG, keyB));
+		if ( blit ) {
+			SDL_SetColorKey(surface, cflags, colorkey);
 		}
-		SDL_SetColorKey(surface, cflags, colorkey);
 	}
 	if ( (surface_flags & SDL_SRCALPHA) == SDL_SRCALPHA ) {
 		Uint32 aflags = surface_flags&(SDL_SRCALPHA|SDL_RLEACCELOK);
-		if ( convert != NULL ) {
-		        SDL_SetAlpha(convert, aflags|(flags&SDL_RLEACCELOK),
-				alpha);
+		SDL_SetAlpha(convert, aflags|(flags&SDL_RLEACCELOK), alpha);
+		if ( blit ) {
+			if ( format->Amask ) {
+				surface->flags |= SDL_SRCALPHA;
+			} else {
+				SDL_SetAlpha(surface, aflags, alpha);
+			}
 		}
-		if ( format->Amask ) {
-			surface->flags |= SDL_SRCALPHA;
-		} else {
-			SDL_SetAlpha(surface, aflags, alpha);
+	}
+}
+
+typedef struct {
+	SDL_Surface **surfaces;
+	SDL_Surface **converted;
+	const SDL_ConvertPlan *plans;
+} SDL_ConvertJob;
+
+static void SDL_ConvertBand(void *data, int band)
+{
+	SDL_ConvertJob *job = (SDL_ConvertJob *)data;
+
+	if ( job->converted[band] &&
+	     job->plans[band].mode != SDL_CONVERT_BLIT ) {
+		SDL_RunConvert(&job->plans[band],
+		               job->surfaces[band], job->converted[band]);
+	}
+}
+
+/* 
+ * Convert a batch of surfaces into the specified pixel format.
+ */
+int SDL_ConvertSurfaces (SDL_Surface **surfaces, int count,
+			SDL_PixelFormat *format, Uint32 flags,
+			SDL_Surface **converted)
+{
+	SDL_ConvertPlan one;
+	SDL_ConvertPlan *plans;
+	SDL_ConvertJob job;
+	Uint32 pixels;
+	int i, threads, done;
+
+	if ( count <= 0 ) {
+		return(0);
+	}
+	plans = &one;
+	if ( count > 1 ) {
+		plans = (SDL_ConvertPlan *)SDL_malloc(count*sizeof(*plans));
+		if ( plans == NULL ) {
+			for ( i=0; i<count; ++i ) {
+				converted[i] = NULL;
+			}
+			SDL_OutOfMemory();
+			return(0);
 		}
 	}
 
-	/* We're ready to go! */
+	/* Create the new surfaces, noting what can be converted directly */
+	pixels = 0;
+	for ( i=0; i<count; ++i ) {
+		converted[i] = SDL_StartConvert(surfaces[i], format, flags,
+		                                &plans[i]);
+		if ( converted[i] && plans[i].mode != SDL_CONVERT_BLIT ) {
+			pixels += (Uint32)surfaces[i]->w * surfaces[i]->h;
+		}
+	}
+
+	/* Only the pixels are touched here, so each surface can have a
+	   thread of its own when there's enough work to go round */
+	threads = 1;
+	if ( pixels >= 2 * CONVERT_THREAD_PIXELS ) {
+		threads = SDL_ParallelThreads();
+		if ( (Uint32)threads > pixels / CONVERT_THREAD_PIXELS ) {
+			threads = (int)(pixels / CONVERT_THREAD_PIXELS);
+		}
+	}
+	job.surfaces = surfaces;
+	job.converted = converted;
+	job.plans = plans;
+	SDL_ParallelBands(count, threads, SDL_ConvertBand, &job);
+
+	/* Blitting changes the original surfaces, so do the rest in turn */
+	done = 0;
+	for ( i=0; i<count; ++i ) {
+		if ( converted[i] ) {
+			SDL_FinishConvert(surfaces[i], converted[i],
+			                  format, flags, &plans[i]);
+			++done;
+		}
+	}
+	if ( plans != &one ) {
+		SDL_free(plans);
+	}
+	return(done);
+}
+
+/* 
+ * Convert a surface into the specified pixel format.
+ */
+SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
+					SDL_PixelFormat *format, Uint32 flags)
+{
+	SDL_Surface *convert;
+
+	SDL_ConvertSurfaces(&surface, 1, format, flags, &convert);
 	return(convert);
 }
 
@@ -24,6 +24,7 @@
 #ifndef _SDL_sysvideo_h
 #define _SDL_sysvideo_h
 
+#include "SDL_atomic.h"
 #include "SDL_mouse.h"
 #define SDL_PROTOTYPES_ONLY
 #include "SDL_syswm.h"
@@ -258,6 +259,13 @@ struct SDL_VideoDevice {
 	/* Handle any queued OS events */
 	void (*PumpEvents)(_THIS);
 
+	/* If not NULL, this is called by SDL_WaitEvent() to sleep until
+	   there may be OS events to pump, the timeout in milliseconds passes
+	   (forever if it's negative) or SDL_SendEventWakeup() is called.
+	   Without it, SDL_WaitEvent() pumps events every few milliseconds.
+	 */
+	void (*WaitEvents)(_THIS, int timeout);
+
 	/* * * */
 	/* Data common to all drivers */
 	SDL_Surface *screen;
@@ -271,6 +279,28 @@ struct SDL_VideoDevice {
 	int offset_y;
 	SDL_GrabMode input_grab;
 
+	/* Update rectangle merging, see SDL_update.c */
+	int merge_rects;
+	int merge_coverage;	/* Percent of the screen for a full update */
+	SDL_Rect *merged_rects;
+	int max_merged_rects;
+
+	/* Update rectangles with the software cursor's added */
+	SDL_Rect *cursor_rects;
+	int max_cursor_rects;
+
+	/* Frame difference updates, see SDL_update.c */
+	int frame_diff;
+	int diff_tile;		/* Tile size in pixels */
+	SDL_Surface *diff_surface;
+	Uint8 *diff_frame;	/* Copy of the last frame sent */
+	Uint8 *diff_tiles;
+	SDL_Rect *diff_rects;
+	int diff_w, diff_h, diff_pitch;
+	int diff_valid;
+	SDL_UpdateStats update_stats;
+	SDL_SpinLock update_stats_lock;	/* Presenter threads update the stats */
+
 	/* Driver information flags */
 	int handles_any_size;	/* Driver handles any size video mode */
 
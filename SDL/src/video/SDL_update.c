@@ -0,0 +1,553 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Helpers that reduce the work SDL_UpdateRects() hands to the driver.
+
+   Programs often pass hundreds of small, overlapping rectangles, each
+   of which costs a shadow blit and a separate request to the display.
+   When SDL_VIDEO_MERGE_RECTS is set, overlapping and touching
+   rectangles are combined as long as that doesn't add much area that
+   wasn't asked for, and if what is left covers most of the screen
+   (SDL_VIDEO_MERGE_COVERAGE percent, 75 by default) a single full
+   screen update is sent instead.
+
+   When SDL_VIDEO_FRAME_DIFF is set, a copy of the last frame sent is
+   kept and the requested area is compared against it in tiles of
+   SDL_VIDEO_FRAME_DIFF_TILE pixels (32 by default), so only the tiles
+   that really changed reach the driver.  This helps programs that
+   update the whole screen every frame while little of it changes.
+*/
+
+#include "SDL_video.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_sysvideo.h"
+#include "SDL_update_c.h"
+
+#if SDL_ASSEMBLY_ROUTINES && defined(__GNUC__) && defined(__SSE2__)
+#define SSE2_FRAMEDIFF
+#include <emmintrin.h>
+#endif
+
+#define DEFAULT_COVERAGE	75
+#define DEFAULT_TILE_SIZE	32
+
+void SDL_InitUpdateRects(SDL_VideoDevice *video)
+{
+	const char *env;
+
+	video->merge_rects = 0;
+	video->merge_coverage = DEFAULT_COVERAGE;
+	video->merged_rects = NULL;
+	video->max_merged_rects = 0;
+	video->cursor_rects = NULL;
+	video->max_cursor_rects = 0;
+	video->frame_diff = 0;
+	video->diff_tile = DEFAULT_TILE_SIZE;
+	video->diff_surface = NULL;
+	video->diff_frame = NULL;
+	video->diff_tiles = NULL;
+	video->diff_rects = NULL;
+	video->diff_valid = 0;
+	SDL_memset(&video->update_stats, 0, sizeof(video->update_stats));
+
+	env = SDL_getenv("SDL_VIDEO_MERGE_RECTS");
+	if ( env ) {
+		video->merge_rects = SDL_atoi(env);
+	}
+	env = SDL_getenv("SDL_VIDEO_MERGE_COVERAGE");
+	if ( env ) {
+		video->merge_coverage = SDL_atoi(env);
+		if ( (video->merge_coverage <= 0) ||
+		     (video->merge_coverage > 100) ) {
+			video->merge_coverage = DEFAULT_COVERAGE;
+		}
+	}
+	env = SDL_getenv("SDL_VIDEO_FRAME_DIFF");
+	if ( env ) {
+		video->frame_diff = SDL_atoi(env);
+	}
+	env = SDL_getenv("SDL_VIDEO_FRAME_DIFF_TILE");
+	if ( env ) {
+		video->diff_tile = SDL_atoi(env);
+		if ( (video->diff_tile < 8) || (video->diff_tile > 256) ) {
+			video->diff_tile = DEFAULT_TILE_SIZE;
+		}
+	}
+}
+
+static void FreeFrameDiff(SDL_VideoDevice *video)
+{
+	if ( video->diff_frame ) {
+		SDL_free(video->diff_frame);
+		video->diff_frame = NULL;
+	}
+	video->diff_tiles = NULL;
+	video->diff_rects = NULL;
+	video->diff_surface = NULL;
+	video->diff_valid = 0;
+}
+
+void SDL_QuitUpdateRects(SDL_VideoDevice *video)
+{
+	if ( video->merged_rects ) {
+		SDL_free(video->merged_rects);
+		video->merged_rects = NULL;
+	}
+	video->max_merged_rects = 0;
+	if ( video->cursor_rects ) {
+		SDL_free(video->cursor_rects);
+		video->cursor_rects = NULL;
+	}
+	video->max_cursor_rects = 0;
+	FreeFrameDiff(video);
+}
+
+int SDL_AddCursorRects(SDL_VideoDevice *video, int numrects, SDL_Rect *rects,
+                       int ncursor, SDL_Rect *cursor, SDL_Rect **out)
+{
+	SDL_Rect *all;
+
+	if ( (numrects + ncursor) > video->max_cursor_rects ) {
+		all = (SDL_Rect *)SDL_realloc(video->cursor_rects,
+		                      (numrects + ncursor)*sizeof(*all));
+		if ( !all ) {
+			/* Send the cursor on its own */
+			video->UpdateRects(video, ncursor, cursor);
+			*out = rects;
+			return numrects;
+		}
+		video->cursor_rects = all;
+		video->max_cursor_rects = numrects + ncursor;
+	}
+	all = video->cursor_rects;
+	SDL_memcpy(all, rects, numrects*sizeof(*all));
+	SDL_memcpy(all + numrects, cursor, ncursor*sizeof(*all));
+	*out = all;
+	return numrects + ncursor;
+}
+
+static __inline__ int ClipRect(SDL_Rect *rect, const SDL_Surface *screen)
+{
+	int x1 = rect->x;
+	int y1 = rect->y;
+	int x2 = x1 + rect->w;
+	int y2 = y1 + rect->h;
+
+	if ( x1 < 0 ) x1 = 0;
+	if ( y1 < 0 ) y1 = 0;
+	if ( x2 > screen->w ) x2 = screen->w;
+	if ( y2 > screen->h ) y2 = screen->h;
+	if ( (x2 <= x1) || (y2 <= y1) ) {
+		return 0;
+	}
+	rect->x = (Sint16)x1;
+	rect->y = (Sint16)y1;
+	rect->w = (Uint16)(x2 - x1);
+	rect->h = (Uint16)(y2 - y1);
+	return 1;
+}
+
+/* Rectangles that overlap or share an edge */
+static __inline__ int Touching(const SDL_Rect *a, const SDL_Rect *b)
+{
+	return (a->x <= b->x + b->w) && (b->x <= a->x + a->w) &&
+	       (a->y <= b->y + b->h) && (b->y <= a->y + a->h);
+}
+
+static __inline__ void UnionRect(const SDL_Rect *a, const SDL_Rect *b,
+                                 SDL_Rect *result)
+{
+	int x1 = SDL_min(a->x, b->x);
+	int y1 = SDL_min(a->y, b->y);
+	int x2 = SDL_max(a->x + a->w, b->x + b->w);
+	int y2 = SDL_max(a->y + a->h, b->y + b->h);
+
+	result->x = (Sint16)x1;
+	result->y = (Sint16)y1;
+	result->w = (Uint16)(x2 - x1);
+	result->h = (Uint16)(y2 - y1);
+}
+
+#define AREA(r)	((Uint32)(r)->w * (r)->h)
+
+int SDL_MergeUpdateRects(SDL_VideoDevice *video, SDL_Surface *screen,
+                         int numrects, SDL_Rect *rects, SDL_Rect **merged)
+{
+	SDL_Rect *out;
+	SDL_Rect joined;
+	int i, j, n;
+	int changed;
+	Uint32 area, screen_area;
+
+	/* Make room for the rectangles, we never produce more of them */
+	if ( numrects > video->max_merged_rects ) {
+		out = (SDL_Rect *)SDL_realloc(video->merged_rects,
+		                              numrects*sizeof(*out));
+		if ( !out ) {
+			/* Just pass the original rectangles on */
+			*merged = rects;
+			return numrects;
+		}
+		video->merged_rects = out;
+		video->max_merged_rects = numrects;
+	}
+	out = video->merged_rects;
+
+	n = 0;
+	for ( i=0; i<numrects; ++i ) {
+		out[n] = rects[i];
+		if ( ClipRect(&out[n], screen) ) {
+			++n;
+		}
+	}
+
+	/* Keep joining pairs until nothing changes.  A pair is joined
+	   if their bounding box is at most 25% bigger than the two of
+	   them, so distant rectangles don't turn into a huge one.
+	 */
+	do {
+		changed = 0;
+		for ( i=0; i<n; ++i ) {
+			for ( j=i+1; j<n; ++j ) {
+				if ( !Touching(&out[i], &out[j]) ) {
+					continue;
+				}
+				UnionRect(&out[i], &out[j], &joined);
+				if ( AREA(&joined)*4 <=
+				     (AREA(&out[i])+AREA(&out[j]))*5 ) {
+					out[i] = joined;
+					out[j] = out[--n];
+					changed = 1;
+					j = i;
+				}
+			}
+		}
+	} while ( changed );
+
+	/* Send a single update if most of the screen changed anyway */
+	area = 0;
+	for ( i=0; i<n; ++i ) {
+		area += AREA(&out[i]);
+	}
+	screen_area = (Uint32)screen->w * screen->h;
+	if ( (n > 1) && (area >= (screen_area/100)*video->merge_coverage) ) {
+		out[0].x = 0;
+		out[0].y = 0;
+		out[0].w = (Uint16)screen->w;
+		out[0].h = (Uint16)screen->h;
+		n = 1;
+		++video->update_stats.full_updates;
+	}
+	*merged = out;
+	return n;
+}
+
+void SDL_InvalidateFrameDiff(SDL_VideoDevice *video)
+{
+	video->diff_valid = 0;
+}
+
+/* Compare two blocks of rows, returns non-zero if they differ */
+static int RowsDiffer(const Uint8 *a, const Uint8 *b, int len, int simd)
+{
+#ifdef SSE2_FRAMEDIFF
+	if ( simd ) {
+		__m128i eq;
+		for ( ; len >= 64; len -= 64, a += 64, b += 64 ) {
+			eq = _mm_and_si128(
+			    _mm_and_si128(
+			      _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)a),
+			                     _mm_loadu_si128((const __m128i *)b)),
+			      _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a+16)),
+			                     _mm_loadu_si128((const __m128i *)(b+16)))),
+			    _mm_and_si128(
+			      _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a+32)),
+			                     _mm_loadu_si128((const __m128i *)(b+32))),
+			      _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a+48)),
+			                     _mm_loadu_si128((const __m128i *)(b+48)))));
+			if ( _mm_movemask_epi8(eq) != 0xFFFF ) {
+				return 1;
+			}
+		}
+		for ( ; len >= 16; len -= 16, a += 16, b += 16 ) {
+			eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)a),
+			                    _mm_loadu_si128((const __m128i *)b));
+			if ( _mm_movemask_epi8(eq) != 0xFFFF ) {
+				return 1;
+			}
+		}
+	}
+#endif
+	return (len > 0) && (SDL_memcmp(a, b, len) != 0);
+}
+
+/* Compare a tile with the last frame, and remember it if it changed */
+static int TileChanged(const SDL_Surface *screen, Uint8 *frame, int pitch,
+                       const SDL_Rect *tile, int simd)
+{
+	const int bpp = screen->format->BytesPerPixel;
+	const int len = tile->w * bpp;
+	const Uint8 *src;
+	Uint8 *dst;
+	int row;
+
+	src = (const Uint8 *)screen->pixels + tile->y*screen->pitch + tile->x*bpp;
+	dst = frame + tile->y*pitch + tile->x*bpp;
+	for ( row=0; row<tile->h; ++row ) {
+		if ( RowsDiffer(src, dst, len, simd) ) {
+			break;
+		}
+		src += screen->pitch;
+		dst += pitch;
+	}
+	if ( row == tile->h ) {
+		return 0;
+	}
+	for ( ; row<tile->h; ++row ) {
+		SDL_memcpy(dst, src, len);
+		src += screen->pitch;
+		dst += pitch;
+	}
+	return 1;
+}
+
+static int SetupFrameDiff(SDL_VideoDevice *video, SDL_Surface *screen)
+{
+	const int size = video->diff_tile;
+	int tiles_w = (screen->w + size-1) / size;
+	int tiles_h = (screen->h + size-1) / size;
+	int pitch = screen->w * screen->format->BytesPerPixel;
+
+	if ( video->diff_frame && (video->diff_surface == screen) &&
+	     (video->diff_w == screen->w) && (video->diff_h == screen->h) &&
+	     (video->diff_pitch == pitch) ) {
+		return 0;
+	}
+	FreeFrameDiff(video);
+
+	/* The frame, the tile flags and the output rectangles */
+	video->diff_frame = (Uint8 *)SDL_malloc(
+	        pitch*screen->h + tiles_w*tiles_h*(1+sizeof(SDL_Rect)));
+	if ( !video->diff_frame ) {
+		return -1;
+	}
+	video->diff_rects = (SDL_Rect *)(video->diff_frame + pitch*screen->h);
+	video->diff_tiles = (Uint8 *)(video->diff_rects + tiles_w*tiles_h);
+	video->diff_surface = screen;
+	video->diff_w = screen->w;
+	video->diff_h = screen->h;
+	video->diff_pitch = pitch;
+	video->diff_valid = 0;
+	return 0;
+}
+
+int SDL_DiffUpdateRects(SDL_VideoDevice *video, SDL_Surface *screen,
+                        int numrects, SDL_Rect *rects, SDL_Rect **changed)
+{
+	const int size = video->diff_tile;
+	const int pitch = screen->w * screen->format->BytesPerPixel;
+	int tiles_w, tiles_h;
+	int tx, ty, tx1, ty1, tx2, ty2;
+	int i, n, run, dirty;
+	int simd = 0;
+	SDL_Rect rect, tile;
+	SDL_Rect *out;
+	Uint8 *flags;
+	Uint8 *src, *dst;
+
+	/* We need to read the pixels directly */
+	if ( (screen->flags & (SDL_HWSURFACE|SDL_OPENGLBLIT)) ||
+	     !screen->w || !screen->h || (SetupFrameDiff(video, screen) < 0) ) {
+		*changed = rects;
+		return numrects;
+	}
+	tiles_w = (screen->w + size-1) / size;
+	tiles_h = (screen->h + size-1) / size;
+	out = video->diff_rects;
+	flags = video->diff_tiles;
+
+	/* Without a valid last frame, send and remember everything */
+	if ( !video->diff_valid ) {
+		src = (Uint8 *)screen->pixels;
+		dst = video->diff_frame;
+		for ( i=0; i<screen->h; ++i ) {
+			SDL_memcpy(dst, src, pitch);
+			src += screen->pitch;
+			dst += pitch;
+		}
+		video->diff_valid = 1;
+		out[0].x = 0;
+		out[0].y = 0;
+		out[0].w = (Uint16)screen->w;
+		out[0].h = (Uint16)screen->h;
+		*changed = out;
+		return 1;
+	}
+
+	/* Flag the tiles touched by the requested rectangles */
+	SDL_memset(flags, 0, tiles_w*tiles_h);
+	for ( i=0; i<numrects; ++i ) {
+		rect = rects[i];
+		tx1 = SDL_max(rect.x, 0) / size;
+		ty1 = SDL_max(rect.y, 0) / size;
+		tx2 = SDL_min(rect.x + rect.w, screen->w);
+		ty2 = SDL_min(rect.y + rect.h, screen->h);
+		if ( (tx2 <= rect.x) || (ty2 <= rect.y) ||
+		     (tx2 <= 0) || (ty2 <= 0) ) {
+			continue;
+		}
+		tx2 = (tx2 + size-1) / size;
+		ty2 = (ty2 + size-1) / size;
+		for ( ty=ty1; ty<ty2; ++ty ) {
+			SDL_memset(flags + ty*tiles_w + tx1, 1, tx2-tx1);
+		}
+	}
+
+#ifdef SSE2_FRAMEDIFF
+	simd = SDL_HasSSE2();
+#endif
+
+	/* Compare the flagged tiles, joining changed tiles into runs
+	   along each row and runs into columns of rows */
+	n = 0;
+	for ( ty=0; ty<tiles_h; ++ty ) {
+		tile.y = ty*size;
+		tile.h = SDL_min(size, screen->h - tile.y);
+		run = -1;
+		for ( tx=0; tx<=tiles_w; ++tx ) {
+			dirty = 0;
+			if ( (tx < tiles_w) && flags[ty*tiles_w + tx] ) {
+				tile.x = tx*size;
+				tile.w = SDL_min(size, screen->w - tile.x);
+				++video->update_stats.tiles_compared;
+				dirty = TileChanged(screen, video->diff_frame,
+				                    pitch, &tile, simd);
+			}
+			if ( dirty ) {
+				++video->update_stats.tiles_sent;
+				if ( run < 0 ) {
+					run = tx;
+				}
+				continue;
+			}
+			if ( run < 0 ) {
+				continue;
+			}
+			rect.x = run*size;
+			rect.y = tile.y;
+			rect.w = SDL_min(tx*size, screen->w) - rect.x;
+			rect.h = tile.h;
+			run = -1;
+
+			/* Extend a run of the rows above if it lines up */
+			for ( i=0; i<n; ++i ) {
+				if ( (out[i].x == rect.x) && (out[i].w == rect.w) &&
+				     (out[i].y + out[i].h == rect.y) ) {
+					out[i].h += rect.h;
+					break;
+				}
+			}
+			if ( i == n ) {
+				out[n++] = rect;
+			}
+		}
+	}
+	*changed = out;
+	return n;
+}
+
+/* Check whether a row of 8-bit pixels uses any colour from lo to lo+range */
+static int RowUsesColors(const Uint8 *row, int len, Uint8 lo, Uint8 range,
+                         int simd)
+{
+#ifdef SSE2_FRAMEDIFF
+	if ( simd ) {
+		__m128i vlo = _mm_set1_epi8((char)lo);
+		__m128i vrange = _mm_set1_epi8((char)range);
+		__m128i v;
+		for ( ; len >= 16; len -= 16, row += 16 ) {
+			/* (pixel - lo) <= range, unsigned */
+			v = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)row), vlo);
+			v = _mm_cmpeq_epi8(_mm_min_epu8(v, vrange), v);
+			if ( _mm_movemask_epi8(v) ) {
+				return 1;
+			}
+		}
+	}
+#endif
+	for ( ; len > 0; --len, ++row ) {
+		if ( (Uint8)(*row - lo) <= range ) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int SDL_FindColorRows(SDL_Surface *screen, int lo, int hi,
+                      SDL_Rect *rects, int maxrects)
+{
+	const Uint8 *row;
+	SDL_Rect *last;
+	int y, n, simd;
+
+	if ( (screen->format->BitsPerPixel != 8) || (lo > hi) ) {
+		return 0;
+	}
+	simd = SDL_HasSSE2();
+	row = (const Uint8 *)screen->pixels;
+	n = 0;
+	last = NULL;
+	for ( y=0; y<screen->h; ++y, row += screen->pitch ) {
+		if ( !RowUsesColors(row, screen->w, lo, hi-lo, simd) ) {
+			continue;
+		}
+		if ( last && ((last->y + last->h == y) || (n == maxrects)) ) {
+			/* Extend the band, or join it if there are too many */
+			last->h = y + 1 - last->y;
+			continue;
+		}
+		last = &rects[n++];
+		last->x = 0;
+		last->y = y;
+		last->w = screen->w;
+		last->h = 1;
+	}
+	return n;
+}
+
+void SDL_GetUpdateStats(SDL_UpdateStats *stats, int reset)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( !video ) {
+		SDL_memset(stats, 0, sizeof(*stats));
+		return;
+	}
+	SDL_AtomicLock(&video->update_stats_lock);
+	*stats = video->update_stats;
+	if ( reset ) {
+		SDL_memset(&video->update_stats, 0,
+		           sizeof(video->update_stats));
+	}
+	SDL_AtomicUnlock(&video->update_stats_lock);
+}
@@ -0,0 +1,66 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Useful functions from SDL_update.c, used by SDL_UpdateRects() */
+#include "SDL_sysvideo.h"
+
+/* Read the update options from the environment */
+extern void SDL_InitUpdateRects(SDL_VideoDevice *video);
+
+/* Free the memory used by the update helpers */
+extern void SDL_QuitUpdateRects(SDL_VideoDevice *video);
+
+/* Clip the rectangles to the screen and merge overlapping or adjacent
+   ones, falling back to a single full screen rectangle if they cover
+   enough of it.  Returns the new number of rectangles, which are stored
+   in scratch space owned by the video device.
+ */
+extern int SDL_MergeUpdateRects(SDL_VideoDevice *video, SDL_Surface *screen,
+                                int numrects, SDL_Rect *rects,
+                                SDL_Rect **merged);
+
+/* Add the areas the software cursor moved through to the rectangles, so
+   they go to the display in the same update.  Returns the new number of
+   rectangles, which are stored in scratch space owned by the video device.
+ */
+extern int SDL_AddCursorRects(SDL_VideoDevice *video, int numrects,
+                              SDL_Rect *rects, int ncursor, SDL_Rect *cursor,
+                              SDL_Rect **out);
+
+/* Compare the area covered by the rectangles with the last frame sent,
+   returning rectangles around the tiles that changed.  The rectangles
+   are stored in scratch space owned by the video device.
+ */
+extern int SDL_DiffUpdateRects(SDL_VideoDevice *video, SDL_Surface *screen,
+                               int numrects, SDL_Rect *rects,
+                               SDL_Rect **changed);
+
+/* Forget the last frame, the next update is sent in full */
+extern void SDL_InvalidateFrameDiff(SDL_VideoDevice *video);
+
+/* Find the bands of rows of an 8-bit surface that use palette entries lo
+   to hi, so a palette change only redraws those.  Returns the number of
+   rectangles stored, at most maxrects.
+ */
+extern int SDL_FindColorRows(SDL_Surface *screen, int lo, int hi,
+                             SDL_Rect *rects, int maxrects);
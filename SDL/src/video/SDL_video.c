@@ -28,6 +28,7 @@
 #include "SDL_blit.h"
 #include "SDL_pixels_c.h"
 #include "SDL_cursor_c.h"
+#include "SDL_update_c.h"
 #include "../events/SDL_sysevents.h"
 #include "../events/SDL_events_c.h"
 
@@ -217,6 +218,7 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 	video->offset_x = 0;
 	video->offset_y = 0;
 	SDL_memset(&video->info, 0, (sizeof video->info));
+	SDL_InitUpdateRects(video);
 	
 	video->displayformatalphapixel = NULL;
 
@@ -664,11 +666,13 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 		SDL_FreeSurface(ready_to_go);
 	}
 	if ( video->physpal ) {
+		SDL_InvalidatePaletteLookup(video->physpal->colors);
 		SDL_free(video->physpal->colors);
 		SDL_free(video->physpal);
 		video->physpal = NULL;
 	}
 	if( video->gammacols) {
+		SDL_InvalidatePaletteLookup(video->gammacols);
 		SDL_free(video->gammacols);
 		video->gammacols = NULL;
 	}
@@ -916,6 +920,7 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 	video->info.vfmt = SDL_VideoSurface->format;
 	video->info.current_w = SDL_VideoSurface->w;
 	video->info.current_h = SDL_VideoSurface->h;
+	SDL_InvalidateFrameDiff(video);
 
 	/* We're done! */
 	return(SDL_PublicSurface);
@@ -1037,6 +1042,8 @@ void SDL_UpdateRect(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h)
 void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 {
 	int i;
+	int ncursor;
+	SDL_Rect cursor[2];
 	SDL_VideoDevice *video = current_video;
 	SDL_VideoDevice *this = current_video;
 
@@ -1044,6 +1051,30 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 		SDL_SetError("OpenGL active, use SDL_GL_SwapBuffers()");
 		return;
 	}
+	video->update_stats.rects_in += numrects;
+	if ( (screen == SDL_ShadowSurface) || (screen == SDL_VideoSurface) ) {
+		if ( video->frame_diff ) {
+			numrects = SDL_DiffUpdateRects(this, screen,
+			                               numrects, rects, &rects);
+			if ( numrects == 0 ) {
+				return;
+			}
+		}
+		if ( video->merge_rects ) {
+			numrects = SDL_MergeUpdateRects(this, screen,
+			                                numrects, rects, &rects);
+		}
+	}
+	video->update_stats.rects_out += numrects;
+
+	/* Catch the software cursor up with the mouse now, so a burst of
+	   motion draws it once and it goes out with this update */
+	ncursor = 0;
+	if ( (SDL_cursorstate & CURSOR_MOVED) &&
+	     ((screen == SDL_ShadowSurface) || (screen == SDL_VideoSurface)) ) {
+		ncursor = SDL_ApplyCursorMotion(cursor);
+	}
+
 	if ( screen == SDL_ShadowSurface ) {
 		/* Blit the shadow surface using saved mapping */
 		SDL_Palette *pal = screen->format->palette;
@@ -1060,13 +1091,22 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 			}
 		}
 		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+			/* The cursor only needs to go through the shadow
+			   surface if it is in the area being copied */
+			int drawcursor;
+
 			SDL_LockCursor();
-			SDL_DrawCursor(SDL_ShadowSurface);
+			drawcursor = SDL_CursorInRects(numrects, rects);
+			if ( drawcursor ) {
+				SDL_DrawCursor(SDL_ShadowSurface);
+			}
 			for ( i=0; i<numrects; ++i ) {
 				SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
 						SDL_VideoSurface, &rects[i]);
 			}
-			SDL_EraseCursor(SDL_ShadowSurface);
+			if ( drawcursor ) {
+				SDL_EraseCursor(SDL_ShadowSurface);
+			}
 			SDL_UnlockCursor();
 		} else {
 			for ( i=0; i<numrects; ++i ) {
@@ -1082,6 +1122,11 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 		screen = SDL_VideoSurface;
 	}
 	if ( screen == SDL_VideoSurface ) {
+		if ( ncursor ) {
+			numrects = SDL_AddCursorRects(this, numrects, rects,
+			                              ncursor, cursor, &rects);
+		}
+
 		/* Update the video surface */
 		if ( screen->offset ) {
 			for ( i=0; i<numrects; ++i ) {
@@ -1105,6 +1150,14 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 int SDL_Flip(SDL_Surface *screen)
 {
 	SDL_VideoDevice *video = current_video;
+
+	/* Let SDL_UpdateRects() find out what changed in the frame */
+	if ( video->frame_diff &&
+	     !(SDL_VideoSurface->flags & SDL_DOUBLEBUF) &&
+	     ((screen == SDL_ShadowSurface) || (screen == SDL_VideoSurface)) ) {
+		SDL_UpdateRect(screen, 0, 0, 0, 0);
+		return(0);
+	}
 	/* Copy the shadow surface to the video surface */
 	if ( screen == SDL_ShadowSurface ) {
 		SDL_Rect rect;
@@ -1158,11 +1211,17 @@ static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
 {
 	SDL_Palette *pal = screen->format->palette;
 	SDL_Palette *vidpal;
+	int changed = 1;
 
 	if ( colors != (pal->colors + firstcolor) ) {
+		changed = (SDL_memcmp(pal->colors + firstcolor, colors,
+		                      ncolors * sizeof(*colors)) != 0);
 		SDL_memcpy(pal->colors + firstcolor, colors,
 		       ncolors * sizeof(*colors));
 	}
+	if ( changed ) {
+		SDL_InvalidatePaletteLookup(pal->colors);
+	}
 
 	if ( current_video && SDL_VideoSurface ) {
 		vidpal = SDL_VideoSurface->format->palette;
@@ -1175,13 +1234,80 @@ static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
 			 */
 			SDL_memcpy(vidpal->colors + firstcolor, colors,
 			       ncolors * sizeof(*colors));
+			SDL_InvalidatePaletteLookup(vidpal->colors);
+		}
+	}
+	if ( !changed ) {
+		return;
+	}
+	if ( current_video && (screen == SDL_ShadowSurface) &&
+	     (screen->map->dst == SDL_VideoSurface) &&
+	     !(SDL_VideoSurface->flags & SDL_HWPALETTE) &&
+	     (current_video->gammacols || current_video->physpal) ) {
+		/* The shadow is mapped with the physical colours */
+		SDL_PaletteChanged(screen, NULL, firstcolor, ncolors);
+	} else {
+		SDL_PaletteChanged(screen, pal->colors + firstcolor,
+		                   firstcolor, ncolors);
+	}
+}
+
+/*
+ * Find the range of palette entries that a change really affects,
+ * returns 0 if none of the colours differ.
+ */
+static int FindChangedColors(SDL_Palette *pal, SDL_Color *colors,
+                             int firstcolor, int ncolors, int *lo, int *hi)
+{
+	int i;
+
+	if ( colors == (pal->colors + firstcolor) ) {
+		/* Changed in place, we can't tell */
+		*lo = firstcolor;
+		*hi = firstcolor + ncolors - 1;
+		return(ncolors > 0);
+	}
+	*lo = -1;
+	*hi = -1;
+	for ( i=0; i<ncolors; ++i ) {
+		if ( SDL_memcmp(&pal->colors[firstcolor+i], &colors[i],
+		                sizeof(*colors)) != 0 ) {
+			if ( *lo < 0 ) {
+				*lo = firstcolor + i;
+			}
+			*hi = firstcolor + i;
 		}
 	}
-	SDL_FormatChanged(screen);
+	return(*lo >= 0);
+}
+
+/*
+ * Redraw the parts of a simulated 8-bit screen that use the palette
+ * entries lo to hi, which are the only ones that changed.
+ */
+#define MAX_COLOR_RECTS	32
+
+static void UpdateColorRange(SDL_VideoDevice *video, SDL_Surface *screen,
+                             int lo, int hi)
+{
+	SDL_Rect rects[MAX_COLOR_RECTS];
+	int numrects;
+
+	if ( video->frame_diff ) {
+		/* The pixels didn't change, only what they look like */
+		SDL_InvalidateFrameDiff(video);
+		SDL_UpdateRect(screen, 0, 0, 0, 0);
+		return;
+	}
+	numrects = SDL_FindColorRows(screen, lo, hi, rects, MAX_COLOR_RECTS);
+	if ( numrects ) {
+		SDL_UpdateRects(screen, numrects, rects);
+	}
 }
 
 static int SetPalette_physical(SDL_Surface *screen,
-                               SDL_Color *colors, int firstcolor, int ncolors)
+                               SDL_Color *colors, int firstcolor, int ncolors,
+                               int lo, int hi)
 {
 	SDL_VideoDevice *video = current_video;
 	int gotall = 1;
@@ -1192,6 +1318,7 @@ static int SetPalette_physical(SDL_Surface *screen,
 		 */
 		SDL_memcpy(video->physpal->colors + firstcolor,
 		       colors, ncolors * sizeof(*colors));
+		SDL_InvalidatePaletteLookup(video->physpal->colors);
 	}
 	if ( screen == SDL_ShadowSurface ) {
 		if ( SDL_VideoSurface->flags & SDL_HWPALETTE ) {
@@ -1204,11 +1331,12 @@ static int SetPalette_physical(SDL_Surface *screen,
 			screen = SDL_VideoSurface;
 		} else {
 			/*
-			 * The video surface is not indexed - invalidate any
-			 * active shadow-to-video blit mappings.
+			 * The video surface is not indexed - patch any
+			 * active shadow-to-video blit mapping with the
+			 * colours that are shown, and redraw what uses them.
 			 */
-			if ( screen->map->dst == SDL_VideoSurface ) {
-				SDL_InvalidateMap(screen->map);
+			if ( lo < 0 ) {
+				return gotall;	/* Nothing to show */
 			}
 			if ( video->gamma ) {
 				if( ! video->gammacols ) {
@@ -1227,8 +1355,24 @@ static int SetPalette_physical(SDL_Surface *screen,
 						       + firstcolor,
 						       ncolors);
 				}
+				SDL_InvalidatePaletteLookup(video->gammacols);
+			}
+			if ( screen->map->dst == SDL_VideoSurface ) {
+				SDL_Color *shown;
+
+				if ( video->gammacols ) {
+					shown = video->gammacols;
+				} else if ( video->physpal ) {
+					shown = video->physpal->colors;
+				} else {
+					shown = screen->format->palette->colors;
+				}
+				if ( SDL_PatchMapColors(screen, shown + lo,
+				                        lo, hi - lo + 1) < 0 ) {
+					SDL_InvalidateMap(screen->map);
+				}
 			}
-			SDL_UpdateRect(screen, 0, 0, 0, 0);
+			UpdateColorRange(video, screen, lo, hi);
 		}
 	}
 
@@ -1267,6 +1411,7 @@ int SDL_SetPalette(SDL_Surface *screen, int which,
 	SDL_Palette *pal;
 	int gotall;
 	int palsize;
+	int lo, hi;
 
 	if ( !screen ) {
 		return 0;
@@ -1291,6 +1436,16 @@ int SDL_SetPalette(SDL_Surface *screen, int which,
 		gotall = 0;
 	}
 
+	/* Only the colours that really change need to be shown */
+	lo = hi = -1;
+	if ( which & SDL_PHYSPAL ) {
+		SDL_Palette *shown = current_video->physpal;
+		if ( !shown ) {
+			shown = pal;
+		}
+		FindChangedColors(shown, colors, firstcolor, ncolors, &lo, &hi);
+	}
+
 	if ( which & SDL_LOGPAL ) {
 		/*
 		 * Logical palette change: The actual screen isn't affected,
@@ -1323,8 +1478,8 @@ int SDL_SetPalette(SDL_Surface *screen, int which,
 			}
 			SDL_memcpy(pp->colors, pal->colors, size);
 		}
-		if ( ! SetPalette_physical(screen,
-		                           colors, firstcolor, ncolors) ) {
+		if ( ! SetPalette_physical(screen, colors, firstcolor,
+		                           ncolors, lo, hi) ) {
 			gotall = 0;
 		}
 	}
@@ -1385,6 +1540,7 @@ void SDL_VideoQuit (void)
 			SDL_free(video->gammacols);
 			video->gammacols = NULL;
 		}
+		SDL_FreePaletteLookups();
 		if ( video->gamma ) {
 			SDL_free(video->gamma);
 			video->gamma = NULL;
@@ -1397,6 +1553,7 @@ void SDL_VideoQuit (void)
 			SDL_free(video->wm_icon);
 			video->wm_icon = NULL;
 		}
+		SDL_QuitUpdateRects(video);
 
 		/* Finish cleaning up video subsystem */
 		video->free(this);
@@ -85,10 +85,25 @@
 
 #include "SDL_video.h"
 #include "SDL_cpuinfo.h"
+#include "SDL_parallel_c.h"
 #include "SDL_stretch_c.h"
 #include "SDL_yuvfuncs.h"
 #include "SDL_yuv_sw_c.h"
 
+/* The SSE2 converters follow the rest of the library and are only built
+   when the compiler targets SSE2, the AVX2 ones are built with a target
+   attribute and picked at run time.
+*/
+#if SDL_ASSEMBLY_ROUTINES && defined(__GNUC__) && defined(__SSE2__)
+#define SSE2_YUV
+#include <emmintrin.h>
+#endif
+#if SDL_ASSEMBLY_ROUTINES && defined(SSE2_YUV) && \
+    (((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) || defined(__clang__))
+#define AVX2_YUV
+#include <immintrin.h>
+#endif
+
 /* The functions used to manipulate software video overlays */
 static struct private_yuvhwfuncs sw_yuvfuncs = {
 	SDL_LockYUV_SW,
@@ -97,10 +112,19 @@ static struct private_yuvhwfuncs sw_yuvfuncs = {
 	SDL_FreeYUV_SW
 };
 
+/* Minimum number of pixels worth handing to another thread */
+#define YUV_THREAD_PIXELS	(128 * 1024)
+
 /* RGB conversion lookup tables */
 struct private_yuvhwdata {
-	SDL_Surface *stretch;
 	SDL_Surface *display;
+	Uint8 *rows;		/* Source rows converted for scaling */
+	int row_size;		/* Bytes of scratch rows for each band */
+	int row_count;		/* Number of bands there are rows for */
+	int *index;		/* Source column, then row, of each dst pixel */
+	int index_size;
+	int chroma_bilinear;	/* Interpolate the chroma when scaling */
+	int simd;		/* The vector converters can be used */
 	Uint8 *pixels;
 	int *colortab;
 	Uint32 *rgb_2_pix;
@@ -791,7 +815,7 @@ static void Color16DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row++;
 
         }
-        row += next_row;
+        row += next_row + mod/2;
     }
 }
 
@@ -847,7 +871,7 @@ static void Color24DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row += 2*3;
 
         }
-        row += next_row;
+        row += next_row + mod*3;
     }
 }
 
@@ -863,7 +887,6 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
     int crb_g;
     int cb_b;
     int cols_2 = cols / 2;
-    mod+=mod;
     y = rows;
     while( y-- )
     {
@@ -895,7 +918,7 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
 
         }
 
-        row += next_row;
+        row += next_row + mod;
     }
 }
 
@@ -922,6 +945,598 @@ static int free_bits_at_bottom( Uint32 a )
     return 1 + free_bits_at_bottom ( a >> 1);
 }
 
+#ifdef SSE2_YUV
+/* Vector versions of the 1X and 2X converters for 16 and 32 bpp.
+
+   The colortab entries are (int)(k * C) with C the chroma sample - 128,
+   which is reproduced exactly for every C as sign(C) * ((2*|C| * K) >> 16)
+   with K = k * 32768 rounded.  The channels are then clamped to 0-255 and
+   shifted into place the same way the rgb_2_pix tables were built, so the
+   vector converters write the same pixels as the table lookups.  They
+   handle channels of up to 8 bits and even widths, the leftover pixels at
+   the end of a row go through the tables.
+*/
+#define YUV_K_CR_R	45919	/* 0.419/0.299 */
+#define YUV_K_CR_G	23383	/* 0.299/0.419 */
+#define YUV_K_CB_G	11286	/* 0.114/0.331 */
+#define YUV_K_CB_B	58111	/* 0.587/0.331 */
+
+typedef void (*SDL_YUVConvert)(int *colortab, Uint32 *rgb_2_pix,
+                               unsigned char *lum, unsigned char *cr,
+                               unsigned char *cb, unsigned char *out,
+                               int rows, int cols, int mod);
+
+/* Shift counts for packing the 8-bit channels into pixels */
+typedef struct {
+	__m128i loss[3];	/* Bits dropped from the channel */
+	__m128i shift[3];	/* Position of the channel in the pixel */
+} YUVPacking;
+
+static void YUVGetPacking(YUVPacking *pack, Uint32 *rgb_2_pix, int bpp)
+{
+	Uint32 mask;
+	int i, bits, shift;
+
+	for ( i = 0; i < 3; ++i ) {
+		/* The top entry of each table is the channel mask */
+		mask = rgb_2_pix[i*768 + 511];
+		if ( bpp == 2 ) {
+			mask &= 0xFFFF;
+		}
+		for ( shift = 0; mask && !(mask & 1); ++shift ) {
+			mask >>= 1;
+		}
+		for ( bits = 0; mask & 1; ++bits ) {
+			mask >>= 1;
+		}
+		pack->loss[i] = _mm_cvtsi32_si128(8 - bits);
+		pack->shift[i] = _mm_cvtsi32_si128(shift);
+	}
+}
+
+/* The table lookup, for the pixels left over at the end of a row */
+static __inline__ void YUVPutPixel(int *colortab, Uint32 *rgb_2_pix,
+                                   int L, int cr, int cb,
+                                   Uint8 *out, int pitch, int bpp, int scale)
+{
+	Uint32 pixel;
+
+	pixel = (rgb_2_pix[ L + 0*768+256 + colortab[ cr + 0*256 ] ] |
+	         rgb_2_pix[ L + 1*768+256 + colortab[ cr + 1*256 ]
+	                                  + colortab[ cb + 2*256 ] ] |
+	         rgb_2_pix[ L + 2*768+256 + colortab[ cb + 3*256 ] ]);
+	if ( bpp == 2 ) {
+		((Uint16 *)out)[0] = (Uint16)pixel;
+		if ( scale == 2 ) {
+			((Uint16 *)out)[1] = (Uint16)pixel;
+			((Uint16 *)(out+pitch))[0] = (Uint16)pixel;
+			((Uint16 *)(out+pitch))[1] = (Uint16)pixel;
+		}
+	} else {
+		((Uint32 *)out)[0] = pixel;
+		if ( scale == 2 ) {
+			((Uint32 *)out)[1] = pixel;
+			((Uint32 *)(out+pitch))[0] = pixel;
+			((Uint32 *)(out+pitch))[1] = pixel;
+		}
+	}
+}
+
+/* sign * ((abs2 * k) >> 16), abs2 being twice the magnitude */
+#define YUV_TERM_SSE2(abs2, sign, k) \
+	_mm_sub_epi16(_mm_xor_si128(_mm_mulhi_epu16(abs2, \
+	                            _mm_set1_epi16((short)(k))), sign), sign)
+
+/* The red, green and blue terms for 8 chroma samples in 16-bit lanes */
+static __inline__ void YUVChromaSSE2(__m128i cr, __m128i cb,
+                                     __m128i *r, __m128i *g, __m128i *b)
+{
+	const __m128i bias = _mm_set1_epi16(128);
+	__m128i cr_sign, cb_sign;
+
+	cr = _mm_sub_epi16(cr, bias);
+	cb = _mm_sub_epi16(cb, bias);
+	cr_sign = _mm_srai_epi16(cr, 15);
+	cb_sign = _mm_srai_epi16(cb, 15);
+	cr = _mm_slli_epi16(_mm_sub_epi16(_mm_xor_si128(cr, cr_sign), cr_sign), 1);
+	cb = _mm_slli_epi16(_mm_sub_epi16(_mm_xor_si128(cb, cb_sign), cb_sign), 1);
+	*r = YUV_TERM_SSE2(cr, cr_sign, YUV_K_CR_R);
+	*g = _mm_sub_epi16(_mm_setzero_si128(),
+	                   _mm_add_epi16(YUV_TERM_SSE2(cr, cr_sign, YUV_K_CR_G),
+	                                 YUV_TERM_SSE2(cb, cb_sign, YUV_K_CB_G)));
+	*b = YUV_TERM_SSE2(cb, cb_sign, YUV_K_CB_B);
+}
+
+/* Add the chroma terms to 8 luma samples and store the pixels, doubled
+   in both directions when scaling by 2.
+ */
+static __inline__ void YUVStoreSSE2(const YUVPacking *pack, __m128i y,
+                                    __m128i r, __m128i g, __m128i b,
+                                    Uint8 *out, int pitch, int bpp, int scale)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	__m128i p0, p1, p2, p3;
+
+	r = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, r), zero), max);
+	g = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, g), zero), max);
+	b = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, b), zero), max);
+	r = _mm_srl_epi16(r, pack->loss[0]);
+	g = _mm_srl_epi16(g, pack->loss[1]);
+	b = _mm_srl_epi16(b, pack->loss[2]);
+	if ( bpp == 2 ) {
+		p0 = _mm_or_si128(_mm_or_si128(_mm_sll_epi16(r, pack->shift[0]),
+		                               _mm_sll_epi16(g, pack->shift[1])),
+		                  _mm_sll_epi16(b, pack->shift[2]));
+		if ( scale == 1 ) {
+			_mm_storeu_si128((__m128i *)out, p0);
+			return;
+		}
+		p1 = _mm_unpackhi_epi16(p0, p0);
+		p0 = _mm_unpacklo_epi16(p0, p0);
+		_mm_storeu_si128((__m128i *)out, p0);
+		_mm_storeu_si128((__m128i *)(out+16), p1);
+		_mm_storeu_si128((__m128i *)(out+pitch), p0);
+		_mm_storeu_si128((__m128i *)(out+pitch+16), p1);
+	} else {
+		p0 = _mm_or_si128(_mm_or_si128(
+			_mm_sll_epi32(_mm_unpacklo_epi16(r, zero), pack->shift[0]),
+			_mm_sll_epi32(_mm_unpacklo_epi16(g, zero), pack->shift[1])),
+			_mm_sll_epi32(_mm_unpacklo_epi16(b, zero), pack->shift[2]));
+		p1 = _mm_or_si128(_mm_or_si128(
+			_mm_sll_epi32(_mm_unpackhi_epi16(r, zero), pack->shift[0]),
+			_mm_sll_epi32(_mm_unpackhi_epi16(g, zero), pack->shift[1])),
+			_mm_sll_epi32(_mm_unpackhi_epi16(b, zero), pack->shift[2]));
+		if ( scale == 1 ) {
+			_mm_storeu_si128((__m128i *)out, p0);
+			_mm_storeu_si128((__m128i *)(out+16), p1);
+			return;
+		}
+		p2 = _mm_unpacklo_epi32(p1, p1);
+		p3 = _mm_unpackhi_epi32(p1, p1);
+		p1 = _mm_unpackhi_epi32(p0, p0);
+		p0 = _mm_unpacklo_epi32(p0, p0);
+		_mm_storeu_si128((__m128i *)out, p0);
+		_mm_storeu_si128((__m128i *)(out+16), p1);
+		_mm_storeu_si128((__m128i *)(out+32), p2);
+		_mm_storeu_si128((__m128i *)(out+48), p3);
+		_mm_storeu_si128((__m128i *)(out+pitch), p0);
+		_mm_storeu_si128((__m128i *)(out+pitch+16), p1);
+		_mm_storeu_si128((__m128i *)(out+pitch+32), p2);
+		_mm_storeu_si128((__m128i *)(out+pitch+48), p3);
+	}
+}
+
+/* YV12 and IYUV, 16 pixels of two rows sharing 8 chroma samples at a time */
+static __inline__ void ColorYV12SSE2(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const int pitch = (cols*scale + mod) * bpp;
+	const int n = cols & ~15;
+	YUVPacking pack;
+	__m128i y, r, g, b, r0, g0, b0, r1, g1, b1;
+	unsigned char *lum2;
+	Uint8 *row1, *row2;
+	int x, i;
+
+	YUVGetPacking(&pack, rgb_2_pix, bpp);
+	for ( ; rows >= 2; rows -= 2 ) {
+		lum2 = lum + cols;
+		row1 = out;
+		row2 = out + scale*pitch;
+		for ( x = 0; x < n; x += 16 ) {
+			YUVChromaSSE2(
+			  _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)(cr+x/2)), zero),
+			  _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)(cb+x/2)), zero),
+			  &r, &g, &b);
+			r0 = _mm_unpacklo_epi16(r, r);
+			g0 = _mm_unpacklo_epi16(g, g);
+			b0 = _mm_unpacklo_epi16(b, b);
+			r1 = _mm_unpackhi_epi16(r, r);
+			g1 = _mm_unpackhi_epi16(g, g);
+			b1 = _mm_unpackhi_epi16(b, b);
+
+			y = _mm_loadu_si128((__m128i *)(lum+x));
+			YUVStoreSSE2(&pack, _mm_unpacklo_epi8(y, zero), r0, g0, b0,
+			             row1 + x*scale*bpp, pitch, bpp, scale);
+			YUVStoreSSE2(&pack, _mm_unpackhi_epi8(y, zero), r1, g1, b1,
+			             row1 + (x+8)*scale*bpp, pitch, bpp, scale);
+
+			y = _mm_loadu_si128((__m128i *)(lum2+x));
+			YUVStoreSSE2(&pack, _mm_unpacklo_epi8(y, zero), r0, g0, b0,
+			             row2 + x*scale*bpp, pitch, bpp, scale);
+			YUVStoreSSE2(&pack, _mm_unpackhi_epi8(y, zero), r1, g1, b1,
+			             row2 + (x+8)*scale*bpp, pitch, bpp, scale);
+		}
+		for ( ; x < cols; ++x ) {
+			i = x*scale*bpp;
+			YUVPutPixel(colortab, rgb_2_pix, lum[x], cr[x/2], cb[x/2],
+			            row1 + i, pitch, bpp, scale);
+			YUVPutPixel(colortab, rgb_2_pix, lum2[x], cr[x/2], cb[x/2],
+			            row2 + i, pitch, bpp, scale);
+		}
+		lum += 2*cols;
+		cr += cols/2;
+		cb += cols/2;
+		out += 2*scale*pitch;
+	}
+}
+
+/* YUY2, UYVY and YVYU, 8 pixels at a time.  The pointers all lie within
+   the first 4 bytes of the row, the luma is picked out of 16-bit lanes
+   and the chroma out of 32-bit ones, copied into both halves.
+ */
+static __inline__ void ColorYUY2SSE2(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const __m128i mask16 = _mm_set1_epi16(0xFF);
+	const __m128i mask32 = _mm_set1_epi32(0xFF);
+	const int pitch = (cols*scale + mod) * bpp;
+	const int n = cols & ~7;
+	unsigned char *base;
+	YUVPacking pack;
+	__m128i lum_shift, cr_shift, cb_shift;
+	__m128i v, y, u, w, r, g, b;
+	int x;
+
+	base = lum;
+	if ( cr < base ) base = cr;
+	if ( cb < base ) base = cb;
+	lum_shift = _mm_cvtsi32_si128((int)(lum - base) * 8);
+	cr_shift = _mm_cvtsi32_si128((int)(cr - base) * 8);
+	cb_shift = _mm_cvtsi32_si128((int)(cb - base) * 8);
+
+	YUVGetPacking(&pack, rgb_2_pix, bpp);
+	for ( ; rows > 0; --rows ) {
+		for ( x = 0; x < n; x += 8 ) {
+			v = _mm_loadu_si128((__m128i *)(base + x*2));
+			y = _mm_and_si128(_mm_srl_epi16(v, lum_shift), mask16);
+			u = _mm_and_si128(_mm_srl_epi32(v, cr_shift), mask32);
+			w = _mm_and_si128(_mm_srl_epi32(v, cb_shift), mask32);
+			YUVChromaSSE2(_mm_or_si128(u, _mm_slli_epi32(u, 16)),
+			              _mm_or_si128(w, _mm_slli_epi32(w, 16)),
+			              &r, &g, &b);
+			YUVStoreSSE2(&pack, y, r, g, b,
+			             out + x*scale*bpp, pitch, bpp, scale);
+		}
+		for ( ; x < cols; ++x ) {
+			YUVPutPixel(colortab, rgb_2_pix,
+			            lum[x*2], cr[(x/2)*4], cb[(x/2)*4],
+			            out + x*scale*bpp, pitch, bpp, scale);
+		}
+		base += cols*2;
+		lum += cols*2;
+		cr += cols*2;
+		cb += cols*2;
+		out += scale*pitch;
+	}
+}
+
+#define DEFINE_YUV_SSE2(name, core, bpp, scale) \
+static void name(int *colortab, Uint32 *rgb_2_pix, \
+                 unsigned char *lum, unsigned char *cr, \
+                 unsigned char *cb, unsigned char *out, \
+                 int rows, int cols, int mod) \
+{ \
+	core(colortab, rgb_2_pix, lum, cr, cb, out, rows, cols, mod, bpp, scale); \
+}
+DEFINE_YUV_SSE2(Color16YV12SSE2_1X, ColorYV12SSE2, 2, 1)
+DEFINE_YUV_SSE2(Color16YV12SSE2_2X, ColorYV12SSE2, 2, 2)
+DEFINE_YUV_SSE2(Color32YV12SSE2_1X, ColorYV12SSE2, 4, 1)
+DEFINE_YUV_SSE2(Color32YV12SSE2_2X, ColorYV12SSE2, 4, 2)
+DEFINE_YUV_SSE2(Color16YUY2SSE2_1X, ColorYUY2SSE2, 2, 1)
+DEFINE_YUV_SSE2(Color16YUY2SSE2_2X, ColorYUY2SSE2, 2, 2)
+DEFINE_YUV_SSE2(Color32YUY2SSE2_1X, ColorYUY2SSE2, 4, 1)
+DEFINE_YUV_SSE2(Color32YUY2SSE2_2X, ColorYUY2SSE2, 4, 2)
+
+/* [packed][32 bpp][2X] */
+static const SDL_YUVConvert yuv_sse2[2][2][2] = {
+	{ { Color16YV12SSE2_1X, Color16YV12SSE2_2X },
+	  { Color32YV12SSE2_1X, Color32YV12SSE2_2X } },
+	{ { Color16YUY2SSE2_1X, Color16YUY2SSE2_2X },
+	  { Color32YUY2SSE2_1X, Color32YUY2SSE2_2X } }
+};
+
+/* 8 pixels at a time of a row with bilinear chroma, V and U hold the
+   vertically blended chroma (4 times the sample) with the edge samples
+   repeated on either side.  Returns the number of pixels done.
+ */
+static int ColorRowChromaSSE2(Uint32 *rgb_2_pix, Uint8 *lum, int lstep,
+                              Uint16 *V, Uint16 *U, int half,
+                              Uint8 *out, int bpp)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(8);
+	const __m128i mask16 = _mm_set1_epi16(0xFF);
+	YUVPacking pack;
+	__m128i c, v, u, y, r, g, b;
+	int j, last;
+
+	/* A packed row is loaded from the luma, stop a group short so the
+	   last load doesn't reach past the end of the overlay */
+	last = (lstep == 1) ? half : (half - 1);
+
+	YUVGetPacking(&pack, rgb_2_pix, bpp);
+	for ( j = 0; j+4 <= last; j += 4 ) {
+		c = _mm_loadl_epi64((__m128i *)(V+j));
+		c = _mm_add_epi16(_mm_add_epi16(c, _mm_add_epi16(c, c)), round);
+		v = _mm_unpacklo_epi16(
+			_mm_srli_epi16(_mm_add_epi16(c,
+			               _mm_loadl_epi64((__m128i *)(V+j-1))), 4),
+			_mm_srli_epi16(_mm_add_epi16(c,
+			               _mm_loadl_epi64((__m128i *)(V+j+1))), 4));
+		c = _mm_loadl_epi64((__m128i *)(U+j));
+		c = _mm_add_epi16(_mm_add_epi16(c, _mm_add_epi16(c, c)), round);
+		u = _mm_unpacklo_epi16(
+			_mm_srli_epi16(_mm_add_epi16(c,
+			               _mm_loadl_epi64((__m128i *)(U+j-1))), 4),
+			_mm_srli_epi16(_mm_add_epi16(c,
+			               _mm_loadl_epi64((__m128i *)(U+j+1))), 4));
+		if ( lstep == 1 ) {
+			y = _mm_unpacklo_epi8(
+				_mm_loadl_epi64((__m128i *)(lum + 2*j)), zero);
+		} else {
+			y = _mm_and_si128(
+				_mm_loadu_si128((__m128i *)(lum + 4*j)), mask16);
+		}
+		YUVChromaSSE2(v, u, &r, &g, &b);
+		YUVStoreSSE2(&pack, y, r, g, b, out + 2*j*bpp, 0, bpp, 1);
+	}
+	return(2*j);
+}
+
+#ifdef AVX2_YUV
+/* The same with 16 lanes.  The chroma terms are worked out for 16 samples
+   in order, the in-lane unpacks that double them are put back in order
+   by swapping the middle quarters.
+ */
+#define AVX2_FUNC	__attribute__((target("avx2")))
+
+#define YUV_TERM_AVX2(abs2, sign, k) \
+	_mm256_sub_epi16(_mm256_xor_si256(_mm256_mulhi_epu16(abs2, \
+	                 _mm256_set1_epi16((short)(k))), sign), sign)
+
+static __inline__ AVX2_FUNC void YUVChromaAVX2(__m256i cr, __m256i cb,
+                                 __m256i *r, __m256i *g, __m256i *b)
+{
+	const __m256i bias = _mm256_set1_epi16(128);
+	__m256i cr_sign, cb_sign;
+
+	cr = _mm256_sub_epi16(cr, bias);
+	cb = _mm256_sub_epi16(cb, bias);
+	cr_sign = _mm256_srai_epi16(cr, 15);
+	cb_sign = _mm256_srai_epi16(cb, 15);
+	cr = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_xor_si256(cr, cr_sign),
+	                                        cr_sign), 1);
+	cb = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_xor_si256(cb, cb_sign),
+	                                        cb_sign), 1);
+	*r = YUV_TERM_AVX2(cr, cr_sign, YUV_K_CR_R);
+	*g = _mm256_sub_epi16(_mm256_setzero_si256(),
+	          _mm256_add_epi16(YUV_TERM_AVX2(cr, cr_sign, YUV_K_CR_G),
+	                           YUV_TERM_AVX2(cb, cb_sign, YUV_K_CB_G)));
+	*b = YUV_TERM_AVX2(cb, cb_sign, YUV_K_CB_B);
+}
+
+/* Double every lane of v, low is lanes 0-7 and high lanes 8-15 */
+static __inline__ AVX2_FUNC void YUVDouble16AVX2(__m256i v,
+                                                 __m256i *low, __m256i *high)
+{
+	__m256i lo = _mm256_unpacklo_epi16(v, v);
+	__m256i hi = _mm256_unpackhi_epi16(v, v);
+
+	*low = _mm256_permute2x128_si256(lo, hi, 0x20);
+	*high = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+static __inline__ AVX2_FUNC void YUVDouble32AVX2(__m256i v,
+                                                 __m256i *low, __m256i *high)
+{
+	__m256i lo = _mm256_unpacklo_epi32(v, v);
+	__m256i hi = _mm256_unpackhi_epi32(v, v);
+
+	*low = _mm256_permute2x128_si256(lo, hi, 0x20);
+	*high = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+static __inline__ AVX2_FUNC __m256i YUVPack32AVX2(const YUVPacking *pack,
+                                     __m128i r, __m128i g, __m128i b)
+{
+	return _mm256_or_si256(_mm256_or_si256(
+		_mm256_sll_epi32(_mm256_cvtepu16_epi32(r), pack->shift[0]),
+		_mm256_sll_epi32(_mm256_cvtepu16_epi32(g), pack->shift[1])),
+		_mm256_sll_epi32(_mm256_cvtepu16_epi32(b), pack->shift[2]));
+}
+
+static __inline__ AVX2_FUNC void YUVStoreAVX2(const YUVPacking *pack,
+                                  __m256i y, __m256i r, __m256i g, __m256i b,
+                                  Uint8 *out, int pitch, int bpp, int scale)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max = _mm256_set1_epi16(255);
+	__m256i p0, p1, p2, p3;
+
+	r = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(y, r), zero), max);
+	g = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(y, g), zero), max);
+	b = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(y, b), zero), max);
+	r = _mm256_srl_epi16(r, pack->loss[0]);
+	g = _mm256_srl_epi16(g, pack->loss[1]);
+	b = _mm256_srl_epi16(b, pack->loss[2]);
+	if ( bpp == 2 ) {
+		p0 = _mm256_or_si256(_mm256_or_si256(
+			_mm256_sll_epi16(r, pack->shift[0]),
+			_mm256_sll_epi16(g, pack->shift[1])),
+			_mm256_sll_epi16(b, pack->shift[2]));
+		if ( scale == 1 ) {
+			_mm256_storeu_si256((__m256i *)out, p0);
+			return;
+		}
+		YUVDouble16AVX2(p0, &p0, &p1);
+		_mm256_storeu_si256((__m256i *)out, p0);
+		_mm256_storeu_si256((__m256i *)(out+32), p1);
+		_mm256_storeu_si256((__m256i *)(out+pitch), p0);
+		_mm256_storeu_si256((__m256i *)(out+pitch+32), p1);
+	} else {
+		p0 = YUVPack32AVX2(pack, _mm256_castsi256_si128(r),
+		                         _mm256_castsi256_si128(g),
+		                         _mm256_castsi256_si128(b));
+		p2 = YUVPack32AVX2(pack, _mm256_extracti128_si256(r, 1),
+		                         _mm256_extracti128_si256(g, 1),
+		                         _mm256_extracti128_si256(b, 1));
+		if ( scale == 1 ) {
+			_mm256_storeu_si256((__m256i *)out, p0);
+			_mm256_storeu_si256((__m256i *)(out+32), p2);
+			return;
+		}
+		YUVDouble32AVX2(p0, &p0, &p1);
+		YUVDouble32AVX2(p2, &p2, &p3);
+		_mm256_storeu_si256((__m256i *)out, p0);
+		_mm256_storeu_si256((__m256i *)(out+32), p1);
+		_mm256_storeu_si256((__m256i *)(out+64), p2);
+		_mm256_storeu_si256((__m256i *)(out+96), p3);
+		_mm256_storeu_si256((__m256i *)(out+pitch), p0);
+		_mm256_storeu_si256((__m256i *)(out+pitch+32), p1);
+		_mm256_storeu_si256((__m256i *)(out+pitch+64), p2);
+		_mm256_storeu_si256((__m256i *)(out+pitch+96), p3);
+	}
+}
+
+static __inline__ AVX2_FUNC void ColorYV12AVX2(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const int pitch = (cols*scale + mod) * bpp;
+	const int n = cols & ~31;
+	YUVPacking pack;
+	__m256i r, g, b, r0, g0, b0, r1, g1, b1;
+	unsigned char *lum2;
+	Uint8 *row1, *row2;
+	int x, i;
+
+	YUVGetPacking(&pack, rgb_2_pix, bpp);
+	for ( ; rows >= 2; rows -= 2 ) {
+		lum2 = lum + cols;
+		row1 = out;
+		row2 = out + scale*pitch;
+		for ( x = 0; x < n; x += 32 ) {
+			YUVChromaAVX2(
+			  _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)(cr+x/2))),
+			  _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)(cb+x/2))),
+			  &r, &g, &b);
+			YUVDouble16AVX2(r, &r0, &r1);
+			YUVDouble16AVX2(g, &g0, &g1);
+			YUVDouble16AVX2(b, &b0, &b1);
+
+			YUVStoreAVX2(&pack,
+			  _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)(lum+x))),
+			  r0, g0, b0, row1 + x*scale*bpp, pitch, bpp, scale);
+			YUVStoreAVX2(&pack,
+			  _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)(lum+x+16))),
+			  r1, g1, b1, row1 + (x+16)*scale*bpp, pitch, bpp, scale);
+			YUVStoreAVX2(&pack,
+			  _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)(lum2+x))),
+			  r0, g0, b0, row2 + x*scale*bpp, pitch, bpp, scale);
+			YUVStoreAVX2(&pack,
+			  _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)(lum2+x+16))),
+			  r1, g1, b1, row2 + (x+16)*scale*bpp, pitch, bpp, scale);
+		}
+		for ( ; x < cols; ++x ) {
+			i = x*scale*bpp;
+			YUVPutPixel(colortab, rgb_2_pix, lum[x], cr[x/2], cb[x/2],
+			            row1 + i, pitch, bpp, scale);
+			YUVPutPixel(colortab, rgb_2_pix, lum2[x], cr[x/2], cb[x/2],
+			            row2 + i, pitch, bpp, scale);
+		}
+		lum += 2*cols;
+		cr += cols/2;
+		cb += cols/2;
+		out += 2*scale*pitch;
+	}
+}
+
+static __inline__ AVX2_FUNC void ColorYUY2AVX2(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const __m256i mask16 = _mm256_set1_epi16(0xFF);
+	const __m256i mask32 = _mm256_set1_epi32(0xFF);
+	const int pitch = (cols*scale + mod) * bpp;
+	const int n = cols & ~15;
+	unsigned char *base;
+	YUVPacking pack;
+	__m128i lum_shift, cr_shift, cb_shift;
+	__m256i v, y, u, w, r, g, b;
+	int x;
+
+	base = lum;
+	if ( cr < base ) base = cr;
+	if ( cb < base ) base = cb;
+	lum_shift = _mm_cvtsi32_si128((int)(lum - base) * 8);
+	cr_shift = _mm_cvtsi32_si128((int)(cr - base) * 8);
+	cb_shift = _mm_cvtsi32_si128((int)(cb - base) * 8);
+
+	YUVGetPacking(&pack, rgb_2_pix, bpp);
+	for ( ; rows > 0; --rows ) {
+		for ( x = 0; x < n; x += 16 ) {
+			v = _mm256_loadu_si256((__m256i *)(base + x*2));
+			y = _mm256_and_si256(_mm256_srl_epi16(v, lum_shift), mask16);
+			u = _mm256_and_si256(_mm256_srl_epi32(v, cr_shift), mask32);
+			w = _mm256_and_si256(_mm256_srl_epi32(v, cb_shift), mask32);
+			YUVChromaAVX2(_mm256_or_si256(u, _mm256_slli_epi32(u, 16)),
+			              _mm256_or_si256(w, _mm256_slli_epi32(w, 16)),
+			              &r, &g, &b);
+			YUVStoreAVX2(&pack, y, r, g, b,
+			             out + x*scale*bpp, pitch, bpp, scale);
+		}
+		for ( ; x < cols; ++x ) {
+			YUVPutPixel(colortab, rgb_2_pix,
+			            lum[x*2], cr[(x/2)*4], cb[(x/2)*4],
+			            out + x*scale*bpp, pitch, bpp, scale);
+		}
+		base += cols*2;
+		lum += cols*2;
+		cr += cols*2;
+		cb += cols*2;
+		out += scale*pitch;
+	}
+}
+
+#define DEFINE_YUV_AVX2(name, core, bpp, scale) \
+static AVX2_FUNC void name(int *colortab, Uint32 *rgb_2_pix, \
+                           unsigned char *lum, unsigned char *cr, \
+                           unsigned char *cb, unsigned char *out, \
+                           int rows, int cols, int mod) \
+{ \
+	core(colortab, rgb_2_pix, lum, cr, cb, out, rows, cols, mod, bpp, scale); \
+}
+DEFINE_YUV_AVX2(Color16YV12AVX2_1X, ColorYV12AVX2, 2, 1)
+DEFINE_YUV_AVX2(Color16YV12AVX2_2X, ColorYV12AVX2, 2, 2)
+DEFINE_YUV_AVX2(Color32YV12AVX2_1X, ColorYV12AVX2, 4, 1)
+DEFINE_YUV_AVX2(Color32YV12AVX2_2X, ColorYV12AVX2, 4, 2)
+DEFINE_YUV_AVX2(Color16YUY2AVX2_1X, ColorYUY2AVX2, 2, 1)
+DEFINE_YUV_AVX2(Color16YUY2AVX2_2X, ColorYUY2AVX2, 2, 2)
+DEFINE_YUV_AVX2(Color32YUY2AVX2_1X, ColorYUY2AVX2, 4, 1)
+DEFINE_YUV_AVX2(Color32YUY2AVX2_2X, ColorYUY2AVX2, 4, 2)
+
+static const SDL_YUVConvert yuv_avx2[2][2][2] = {
+	{ { Color16YV12AVX2_1X, Color16YV12AVX2_2X },
+	  { Color32YV12AVX2_1X, Color32YV12AVX2_2X } },
+	{ { Color16YUY2AVX2_1X, Color16YUY2AVX2_2X },
+	  { Color32YUY2AVX2_1X, Color32YUY2AVX2_2X } }
+};
+#endif /* AVX2_YUV */
+#endif /* SSE2_YUV */
+
 
 SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_Surface *display)
 {
@@ -937,6 +1552,10 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	int i;
 	int CR, CB;
 	Uint32 Rmask, Gmask, Bmask;
+	const char *chroma;
+#ifdef SSE2_YUV
+	const char *simd;
+#endif
 
 	/* Only RGB packed pixel conversion supported */
 	if ( (display->format->BytesPerPixel != 2) &&
@@ -983,8 +1602,17 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 		SDL_FreeYUVOverlay(overlay);
 		return(NULL);
 	}
-	swdata->stretch = NULL;
 	swdata->display = display;
+	swdata->simd = 0;
+	swdata->rows = NULL;
+	swdata->row_size = 0;
+	swdata->row_count = 0;
+	swdata->index = NULL;
+	swdata->index_size = 0;
+	/* Smoother colour edges for a little more work per pixel */
+	chroma = SDL_getenv("SDL_VIDEO_YUV_CHROMA");
+	swdata->chroma_bilinear = (chroma &&
+	                           SDL_strcasecmp(chroma, "bilinear") == 0);
 	swdata->pixels = (Uint8 *) SDL_malloc(width*height*2);
 	swdata->colortab = (int *)SDL_malloc(4*256*sizeof(int));
 	Cr_r_tab = &swdata->colortab[0*256];
@@ -1121,6 +1749,39 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 		/* We should never get here (caught above) */
 		break;
 	}
+#ifdef SSE2_YUV
+	/* The vector converters match the tables, so use them if we can.
+	   SDL_VIDEO_YUV_SIMD=0 keeps the tables and =sse2 skips AVX2, so
+	   the converters can be checked against each other.
+	 */
+	simd = SDL_getenv("SDL_VIDEO_YUV_SIMD");
+	if ( (!simd || SDL_strcmp(simd, "0") != 0) &&
+	     ((display->format->BytesPerPixel == 2) ||
+	      (display->format->BytesPerPixel == 4)) && !(width & 1) &&
+	     (number_of_bits_set(Rmask) <= 8) &&
+	     (number_of_bits_set(Gmask) <= 8) &&
+	     (number_of_bits_set(Bmask) <= 8) ) {
+		const SDL_YUVConvert (*funcs)[2][2] = NULL;
+		int packed = (format != SDL_YV12_OVERLAY &&
+		              format != SDL_IYUV_OVERLAY);
+		int depth = (display->format->BytesPerPixel == 4);
+
+#ifdef AVX2_YUV
+		if ( SDL_HasAVX2() &&
+		     !(simd && SDL_strcasecmp(simd, "sse2") == 0) ) {
+			funcs = yuv_avx2;
+		}
+#endif
+		if ( !funcs && SDL_HasSSE2() ) {
+			funcs = yuv_sse2;
+		}
+		if ( funcs ) {
+			swdata->Display1X = funcs[packed][depth][0];
+			swdata->Display2X = funcs[packed][depth][1];
+			swdata->simd = 1;
+		}
+	}
+#endif
 
 	/* Find the pitch and offset values for the overlay */
 	overlay->pitches = swdata->pitches;
@@ -1164,6 +1825,333 @@ void SDL_UnlockYUV_SW(_THIS, SDL_Overlay *overlay)
 	return;
 }
 
+/* Convert source row y with the chroma interpolated rather than repeated.
+   The chroma samples sit midway between the two luma samples they cover,
+   so each pixel mixes its own chroma sample 3:1 with the next closest one,
+   across and, for YV12 and IYUV, also down.  'blend' has room for the two
+   vertically mixed chroma rows and a sample of padding on either side.
+ */
+static void ColorRowChromaBilinear(struct private_yuvhwdata *swdata,
+                                   SDL_Overlay *overlay, Uint8 *lum,
+                                   Uint8 *cr, Uint8 *cb, int y,
+                                   Uint16 *blend, Uint8 *out)
+{
+	int *colortab = swdata->colortab;
+	Uint32 *rgb_2_pix = swdata->rgb_2_pix;
+	const int bpp = swdata->display->format->BytesPerPixel;
+	const int half = overlay->w / 2;
+	Uint16 *V = blend + 1;
+	Uint16 *U = blend + half + 3;
+	Uint32 pixel;
+	int lstep;
+	int x, j, k, k2;
+	int L, v, u;
+
+	if ( half == 0 ) {
+		return;
+	}
+	if ( overlay->planes == 3 ) {
+		const int last_row = (overlay->h > 1) ? (overlay->h/2 - 1) : 0;
+
+		k = y / 2;
+		k2 = (y & 1) ? k+1 : k-1;
+		if ( k > last_row ) k = last_row;
+		if ( k2 > last_row ) k2 = last_row;
+		if ( k2 < 0 ) k2 = 0;
+		lum += y * overlay->w;
+		for ( j = 0; j < half; ++j ) {
+			V[j] = 3*cr[k*half + j] + cr[k2*half + j];
+			U[j] = 3*cb[k*half + j] + cb[k2*half + j];
+		}
+		lstep = 1;
+	} else {
+		lum += y * overlay->w*2;
+		cr += y * overlay->w*2;
+		cb += y * overlay->w*2;
+		for ( j = 0; j < half; ++j ) {
+			V[j] = 4*cr[j*4];
+			U[j] = 4*cb[j*4];
+		}
+		lstep = 2;
+	}
+	V[-1] = V[0];
+	V[half] = V[half-1];
+	U[-1] = U[0];
+	U[half] = U[half-1];
+
+	x = 0;
+#ifdef SSE2_YUV
+	if ( swdata->simd ) {
+		x = ColorRowChromaSSE2(rgb_2_pix, lum, lstep, V, U, half, out, bpp);
+	}
+#endif
+	/* An odd last pixel picks up the padding after the last sample */
+	for ( ; x < overlay->w; ++x ) {
+		j = x / 2;
+		k = (x & 1) ? j+1 : j-1;
+		v = (3*V[j] + V[k] + 8) >> 4;
+		u = (3*U[j] + U[k] + 8) >> 4;
+		L = lum[x*lstep];
+		pixel = (rgb_2_pix[ L + 0*768+256 + colortab[ v + 0*256 ] ] |
+		         rgb_2_pix[ L + 1*768+256 + colortab[ v + 1*256 ]
+		                                  + colortab[ u + 2*256 ] ] |
+		         rgb_2_pix[ L + 2*768+256 + colortab[ u + 3*256 ] ]);
+		switch (bpp) {
+		    case 2:
+			((Uint16 *)out)[x] = (Uint16)pixel;
+			break;
+		    case 3:
+			out[x*3+0] = (pixel      ) & 0xFF;
+			out[x*3+1] = (pixel >>  8) & 0xFF;
+			out[x*3+2] = (pixel >> 16) & 0xFF;
+			break;
+		    default:
+			((Uint32 *)out)[x] = pixel;
+			break;
+		}
+	}
+}
+
+/* The converters work on pairs of pixels, so with an odd overlay width
+   they leave the last pixel of each row alone.  This converts it, with
+   the chroma of the last pair, into the row 'out' converted from row 'y'.
+ */
+static void ColorLastPixel(struct private_yuvhwdata *swdata,
+                           SDL_Overlay *overlay, Uint8 *lum,
+                           Uint8 *cr, Uint8 *cb, int y, Uint8 *out)
+{
+	int *colortab = swdata->colortab;
+	Uint32 *rgb_2_pix = swdata->rgb_2_pix;
+	const int bpp = swdata->display->format->BytesPerPixel;
+	const int w = overlay->w;
+	const int half = w / 2;
+	Uint32 pixel;
+	int L, v, u;
+
+	if ( overlay->planes == 3 ) {
+		L = lum[y*w + w-1];
+		cr += (y/2)*half + half-1;
+		cb += (y/2)*half + half-1;
+	} else {
+		L = lum[y*w*2 + (w-1)*2];
+		cr += y*w*2 + (half-1)*4;
+		cb += y*w*2 + (half-1)*4;
+	}
+	if ( half > 0 ) {
+		v = *cr;
+		u = *cb;
+	} else {
+		/* A single column has no chroma samples at all */
+		v = u = 128;
+	}
+	pixel = (rgb_2_pix[ L + 0*768+256 + colortab[ v + 0*256 ] ] |
+	         rgb_2_pix[ L + 1*768+256 + colortab[ v + 1*256 ]
+	                                  + colortab[ u + 2*256 ] ] |
+	         rgb_2_pix[ L + 2*768+256 + colortab[ u + 3*256 ] ]);
+	out += (w-1)*bpp;
+	switch (bpp) {
+	    case 2:
+		*(Uint16 *)out = (Uint16)pixel;
+		break;
+	    case 3:
+		out[0] = (pixel      ) & 0xFF;
+		out[1] = (pixel >>  8) & 0xFF;
+		out[2] = (pixel >> 16) & 0xFF;
+		break;
+	    default:
+		*(Uint32 *)out = pixel;
+		break;
+	}
+}
+
+/* Work out which source pixel lands on each destination pixel, and
+   make sure there are scratch rows for each of the bands */
+static int SetupStretchYUV(struct private_yuvhwdata *swdata,
+                           SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst,
+                           int bands)
+{
+	const int bpp = swdata->display->format->BytesPerPixel;
+	Uint8 *rows;
+	int *index;
+	int i, size;
+
+	if ( swdata->row_count < bands ) {
+		/* Room for the pair of rows YV12 and IYUV are converted in,
+		   followed by the blended chroma for the bilinear filter */
+		size = 2*overlay->w*bpp + (overlay->w+4)*sizeof(Uint16);
+		size = (size + 63) & ~63;
+		rows = (Uint8 *)SDL_realloc(swdata->rows, bands*size);
+		if ( ! rows ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		SDL_memset(rows, 0, bands*size);
+		swdata->rows = rows;
+		swdata->row_size = size;
+		swdata->row_count = bands;
+	}
+	if ( swdata->index_size < (dst->w + dst->h) ) {
+		index = (int *)SDL_realloc(swdata->index,
+		                           (dst->w + dst->h)*sizeof(int));
+		if ( ! index ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		swdata->index = index;
+		swdata->index_size = dst->w + dst->h;
+	}
+	index = swdata->index;
+	SDL_StretchNearestIndex(index, src->w, dst->w);
+	for ( i = 0; i < dst->w; ++i ) {
+		index[i] += src->x;
+	}
+	index += dst->w;
+	SDL_StretchNearestIndex(index, src->h, dst->h);
+	for ( i = 0; i < dst->h; ++i ) {
+		index[i] += src->y;
+	}
+	return(0);
+}
+
+/* Scale while converting: only the source rows that are shown get
+   converted, one at a time into a scratch row, and picked from there
+   straight into the display.  The result is the same as converting the
+   whole overlay and stretching it with SDL_SoftStretch().
+   This does destination rows [first, last) using the scratch 'rows'.
+ */
+static void StretchYUV(struct private_yuvhwdata *swdata, SDL_Overlay *overlay,
+                       Uint8 *lum, Uint8 *cr, Uint8 *cb,
+                       SDL_Rect *src, SDL_Rect *dst,
+                       int first, int last, Uint8 *rows)
+{
+	SDL_Surface *display = swdata->display;
+	const int bpp = display->format->BytesPerPixel;
+	const int w = overlay->w;
+	const int *xindex = swdata->index;
+	const int *yindex = swdata->index + dst->w;
+	Uint8 *dstp, *row;
+	Uint8 *lastp = NULL;
+	int i, y, pair;
+	int last_row = -1;
+	int last_pair = -1;
+
+	for ( i = first; i < last; ++i ) {
+		dstp = (Uint8 *)display->pixels + (dst->y+i)*display->pitch
+		                                + dst->x*bpp;
+		y = yindex[i];
+
+		/* Enlarging vertically repeats the row we just produced */
+		if ( y == last_row ) {
+			SDL_memcpy(dstp, lastp, dst->w*bpp);
+			continue;
+		}
+		if ( swdata->chroma_bilinear ) {
+			row = rows;
+			ColorRowChromaBilinear(swdata, overlay, lum, cr, cb, y,
+			                       (Uint16 *)(rows + 2*w*bpp), row);
+		} else if ( overlay->planes == 3 ) {
+			/* The planar converters work on pairs of rows */
+			pair = y / 2;
+			if ( pair != last_pair ) {
+				swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+				                  lum + pair*2*w, cr + pair*(w/2),
+				                  cb + pair*(w/2), rows,
+				                  2, w, 0);
+				if ( w & 1 ) {
+					ColorLastPixel(swdata, overlay, lum, cr, cb,
+					               pair*2, rows);
+					ColorLastPixel(swdata, overlay, lum, cr, cb,
+					               pair*2+1, rows + w*bpp);
+				}
+				last_pair = pair;
+			}
+			row = rows + (y & 1)*w*bpp;
+		} else {
+			row = rows;
+			swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+			                  lum + y*w*2, cr + y*w*2, cb + y*w*2,
+			                  row, 1, w, 0);
+			if ( w & 1 ) {
+				ColorLastPixel(swdata, overlay, lum, cr, cb, y, row);
+			}
+		}
+		if ( src->w == dst->w ) {
+			SDL_memcpy(dstp, row + src->x*bpp, dst->w*bpp);
+		} else {
+			SDL_StretchRowNearest(row, dstp, xindex, dst->w, bpp);
+		}
+		last_row = y;
+		lastp = dstp;
+	}
+}
+
+/* A frame being converted in bands of rows, possibly on several threads */
+typedef struct {
+	struct private_yuvhwdata *swdata;
+	SDL_Overlay *overlay;
+	Uint8 *lum, *cr, *cb;
+	SDL_Rect *src, *dst;
+	int stretch;
+	int scale_2x;
+	int band_rows;
+} YUVBands;
+
+static void DisplayYUVBand(void *data, int band)
+{
+	YUVBands *job = (YUVBands *)data;
+	struct private_yuvhwdata *swdata = job->swdata;
+	SDL_Overlay *overlay = job->overlay;
+	SDL_Surface *display = swdata->display;
+	const int bpp = display->format->BytesPerPixel;
+	Uint8 *lum, *cr, *cb;
+	Uint8 *dstp;
+	int y, rows, mod;
+
+	if ( job->stretch ) {
+		/* Bands of destination rows, each with its own scratch rows */
+		y = band * job->band_rows;
+		rows = job->dst->h - y;
+		if ( rows > job->band_rows ) {
+			rows = job->band_rows;
+		}
+		StretchYUV(swdata, overlay, job->lum, job->cr, job->cb,
+		           job->src, job->dst, y, y + rows,
+		           swdata->rows + band*swdata->row_size);
+		return;
+	}
+
+	/* Bands of source rows, an even number so that the planar formats
+	   start each band on a new row of chroma */
+	y = band * job->band_rows;
+	rows = overlay->h - y;
+	if ( rows > job->band_rows ) {
+		rows = job->band_rows;
+	}
+	if ( overlay->planes == 3 ) {
+		lum = job->lum + y*overlay->w;
+		cr = job->cr + (y/2)*(overlay->w/2);
+		cb = job->cb + (y/2)*(overlay->w/2);
+	} else {
+		lum = job->lum + y*overlay->w*2;
+		cr = job->cr + y*overlay->w*2;
+		cb = job->cb + y*overlay->w*2;
+	}
+	mod = (display->pitch / bpp);
+	if ( job->scale_2x ) {
+		dstp = (Uint8 *)display->pixels + job->dst->x*bpp
+		                + (job->dst->y + 2*y)*display->pitch;
+		mod -= (overlay->w * 2);
+		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
+		                  lum, cr, cb, dstp, rows, overlay->w, mod);
+	} else {
+		dstp = (Uint8 *)display->pixels + job->dst->x*bpp
+		                + (job->dst->y + y)*display->pitch;
+		mod -= overlay->w;
+		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+		                  lum, cr, cb, dstp, rows, overlay->w, mod);
+	}
+}
+
 int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 {
 	struct private_yuvhwdata *swdata;
@@ -1171,17 +2159,16 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 	int scale_2x;
 	SDL_Surface *display;
 	Uint8 *lum, *Cr, *Cb;
-	Uint8 *dstp;
-	int mod;
+	YUVBands job;
+	int pixels, threads, bands;
 
 	swdata = overlay->hwdata;
+	display = swdata->display;
 	stretch = 0;
 	scale_2x = 0;
 	if ( src->x || src->y || src->w < overlay->w || src->h < overlay->h ) {
-		/* The source rectangle has been clipped.
-		   Using a scratch surface is easier than adding clipped
-		   source support to all the blitters, plus that would
-		   slow them down in the general unclipped case.
+		/* The source rectangle has been clipped, this is handled
+		   while scaling so the converters don't need to support it.
 		*/
 		stretch = 1;
 	} else if ( (src->w != dst->w) || (src->h != dst->h) ) {
@@ -1192,23 +2179,31 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 			stretch = 1;
 		}
 	}
+	/* The converters only step through whole rows of pairs of pixels,
+	   odd widths are done a row at a time with the last pixel added.
+	 */
+	if ( swdata->chroma_bilinear || (overlay->w & 1) ) {
+		stretch = 1;
+	}
+
+	/* Large frames are split into a band of rows per thread */
+	pixels = dst->w * dst->h;
+	threads = 1;
+	if ( pixels >= 2 * YUV_THREAD_PIXELS ) {
+		threads = SDL_ParallelThreads();
+		if ( threads > pixels / YUV_THREAD_PIXELS ) {
+			threads = pixels / YUV_THREAD_PIXELS;
+		}
+	}
 	if ( stretch ) {
-		if ( ! swdata->stretch ) {
-			display = swdata->display;
-			swdata->stretch = SDL_CreateRGBSurface(
-				SDL_SWSURFACE,
-				overlay->w, overlay->h,
-				display->format->BitsPerPixel,
-				display->format->Rmask,
-				display->format->Gmask,
-				display->format->Bmask, 0);
-			if ( ! swdata->stretch ) {
-				return(-1);
-			}
+		job.band_rows = (dst->h + threads-1) / threads;
+		bands = (dst->h + job.band_rows-1) / job.band_rows;
+		if ( SetupStretchYUV(swdata, overlay, src, dst, bands) < 0 ) {
+			return(-1);
 		}
-		display = swdata->stretch;
 	} else {
-		display = swdata->display;
+		job.band_rows = (((overlay->h + threads-1) / threads) + 1) & ~1;
+		bands = (overlay->h + job.band_rows-1) / job.band_rows;
 	}
 	switch (overlay->format) {
 	    case SDL_YV12_OVERLAY:
@@ -1245,31 +2240,19 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 			return(-1);
 		}
 	}
-	if ( stretch ) {
-		dstp = (Uint8 *)swdata->stretch->pixels;
-	} else {
-		dstp = (Uint8 *)display->pixels
-			+ dst->x * display->format->BytesPerPixel
-			+ dst->y * display->pitch;
-	}
-	mod = (display->pitch / display->format->BytesPerPixel);
-
-	if ( scale_2x ) {
-		mod -= (overlay->w * 2);
-		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
-	} else {
-		mod -= overlay->w;
-		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
-	}
+	job.swdata = swdata;
+	job.overlay = overlay;
+	job.lum = lum;
+	job.cr = Cr;
+	job.cb = Cb;
+	job.src = src;
+	job.dst = dst;
+	job.stretch = stretch;
+	job.scale_2x = scale_2x;
+	SDL_ParallelBands(bands, threads, DisplayYUVBand, &job);
 	if ( SDL_MUSTLOCK(display) ) {
 		SDL_UnlockSurface(display);
 	}
-	if ( stretch ) {
-		display = swdata->display;
-		SDL_SoftStretch(swdata->stretch, src, display, dst);
-	}
 	SDL_UpdateRects(display, 1, dst);
 
 	return(0);
@@ -1281,8 +2264,11 @@ void SDL_FreeYUV_SW(_THIS, SDL_Overlay *overlay)
 
 	swdata = overlay->hwdata;
 	if ( swdata ) {
-		if ( swdata->stretch ) {
-			SDL_FreeSurface(swdata->stretch);
+		if ( swdata->rows ) {
+			SDL_free(swdata->rows);
+		}
+		if ( swdata->index ) {
+			SDL_free(swdata->index);
 		}
 		if ( swdata->pixels ) {
 			SDL_free(swdata->pixels);
@@ -38,8 +38,10 @@
 
 #include "SDL_video.h"
 #include "SDL_mouse.h"
+#include "SDL_timer.h"
 #include "../SDL_sysvideo.h"
 #include "../SDL_pixels_c.h"
+#include "../SDL_present_c.h"
 #include "../../events/SDL_events_c.h"
 
 #include "SDL_nullvideo.h"
@@ -63,6 +65,9 @@ static void DUMMY_FreeHWSurface(_THIS, SDL_Surface *surface);
 
 /* etc. */
 static void DUMMY_UpdateRects(_THIS, int numrects, SDL_Rect *rects);
+static void DUMMY_AsyncUpdate(_THIS, int numrects, SDL_Rect *rects);
+static int DUMMY_StartPresenter(_THIS, SDL_Surface *screen);
+static void DUMMY_StopPresenter(_THIS);
 
 /* DUMMY driver bootstrap functions */
 
@@ -140,6 +145,8 @@ VideoBootStrap DUMMY_bootstrap = {
 
 int DUMMY_VideoInit(_THIS, SDL_PixelFormat *vformat)
 {
+	const char *env;
+
 	/*
 	fprintf(stderr, "WARNING: You are using the SDL dummy video driver!\n");
 	*/
@@ -149,6 +156,16 @@ int DUMMY_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	vformat->BitsPerPixel = 8;
 	vformat->BytesPerPixel = 1;
 
+	/* Present through a separate thread, like a real display would */
+	env = SDL_getenv("SDL_VIDEO_DUMMY_ASYNC_PRESENT");
+	if ( env ) {
+		this->hidden->async_present = SDL_atoi(env);
+	}
+	env = SDL_getenv("SDL_VIDEO_DUMMY_PRESENT_DELAY");
+	if ( env ) {
+		this->hidden->present_delay = SDL_atoi(env);
+	}
+
 	/* We're done! */
 	return(0);
 }
@@ -161,6 +178,9 @@ SDL_Rect **DUMMY_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flags)
 SDL_Surface *DUMMY_SetVideoMode(_THIS, SDL_Surface *current,
 				int width, int height, int bpp, Uint32 flags)
 {
+	if ( this->hidden->presenter ) {
+		DUMMY_StopPresenter(this);
+	}
 	if ( this->hidden->buffer ) {
 		SDL_free( this->hidden->buffer );
 	}
@@ -189,6 +209,14 @@ SDL_Surface *DUMMY_SetVideoMode(_THIS, SDL_Surface *current,
 	this->hidden->h = current->h = height;
 	current->pitch = current->w * (bpp / 8);
 	current->pixels = this->hidden->buffer;
+	this->hidden->bpp = bpp / 8;
+
+	/* Fall back to normal updates if the presenter can't be started */
+	this->UpdateRects = DUMMY_UpdateRects;
+	if ( this->hidden->async_present &&
+	     (DUMMY_StartPresenter(this, current) == 0) ) {
+		this->UpdateRects = DUMMY_AsyncUpdate;
+	}
 
 	/* We're done */
 	return(current);
@@ -220,6 +248,88 @@ static void DUMMY_UpdateRects(_THIS, int numrects, SDL_Rect *rects)
 	/* do nothing. */
 }
 
+/* Called on the presenter thread */
+static void DUMMY_Present(_THIS, SDL_PresentBuffer *buffer)
+{
+	Uint8 *src, *dst;
+	int i, y, len;
+
+	for ( i=0; i<buffer->numrects; ++i ) {
+		src = buffer->pixels + buffer->rects[i].y*buffer->pitch +
+		      buffer->rects[i].x*this->hidden->bpp;
+		dst = this->hidden->front + buffer->rects[i].y*buffer->pitch +
+		      buffer->rects[i].x*this->hidden->bpp;
+		len = buffer->rects[i].w*this->hidden->bpp;
+		for ( y=buffer->rects[i].h; y; --y ) {
+			SDL_memcpy(dst, src, len);
+			src += buffer->pitch;
+			dst += buffer->pitch;
+		}
+	}
+	if ( this->hidden->present_delay > 0 ) {
+		SDL_Delay(this->hidden->present_delay);
+	}
+}
+
+static void DUMMY_AsyncUpdate(_THIS, int numrects, SDL_Rect *rects)
+{
+	SDL_QueuePresent(this->hidden->presenter, SDL_VideoSurface,
+	                 numrects, rects);
+}
+
+static void DUMMY_StopPresenter(_THIS)
+{
+	SDL_Presenter *presenter = this->hidden->presenter;
+	int i;
+
+	SDL_StopPresenter(presenter);
+	for ( i=0; i<SDL_NUM_PRESENT_BUFFERS; ++i ) {
+		if ( presenter->buffers[i].pixels ) {
+			SDL_free(presenter->buffers[i].pixels);
+		}
+	}
+	if ( this->hidden->front ) {
+		SDL_free(this->hidden->front);
+		this->hidden->front = NULL;
+	}
+	SDL_free(presenter);
+	this->hidden->presenter = NULL;
+}
+
+static int DUMMY_StartPresenter(_THIS, SDL_Surface *screen)
+{
+	SDL_Presenter *presenter;
+	int i, size;
+
+	presenter = (SDL_Presenter *)SDL_calloc(1, sizeof(*presenter));
+	if ( presenter == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	this->hidden->presenter = presenter;
+
+	size = screen->h * screen->pitch;
+	this->hidden->front = (Uint8 *)SDL_calloc(1, size);
+	for ( i=0; i<SDL_NUM_PRESENT_BUFFERS; ++i ) {
+		presenter->buffers[i].pixels = (Uint8 *)SDL_malloc(size);
+		presenter->buffers[i].pitch = screen->pitch;
+		if ( presenter->buffers[i].pixels == NULL ) {
+			break;
+		}
+	}
+	if ( !this->hidden->front || (i < SDL_NUM_PRESENT_BUFFERS) ) {
+		SDL_OutOfMemory();
+		DUMMY_StopPresenter(this);
+		return(-1);
+	}
+	presenter->Present = DUMMY_Present;
+	if ( SDL_StartPresenter(this, presenter) < 0 ) {
+		DUMMY_StopPresenter(this);
+		return(-1);
+	}
+	return(0);
+}
+
 int DUMMY_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 {
 	/* do nothing of note. */
@@ -231,6 +341,9 @@ int DUMMY_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 */
 void DUMMY_VideoQuit(_THIS)
 {
+	if ( this->hidden->presenter ) {
+		DUMMY_StopPresenter(this);
+	}
 	if (this->screen->pixels != NULL)
 	{
 		SDL_free(this->screen->pixels);
@@ -35,6 +35,13 @@
 struct SDL_PrivateVideoData {
     int w, h;
     void *buffer;
+
+    /* Asynchronous presentation, so the presenter can be tested */
+    int async_present;
+    int present_delay;		/* Milliseconds each frame takes */
+    int bpp;
+    struct SDL_Presenter *presenter;
+    Uint8 *front;		/* Stands in for the display */
 };
 
 #endif /* _SDL_nullvideo_h */
@@ -1087,6 +1087,19 @@ void FB_PumpEvents(_THIS)
 	} while ( posted );
 }
 
+void FB_WaitEvents(_THIS, int timeout)
+{
+	int fds[2];
+
+	/* Switching back to our console doesn't make any input */
+	if ( switched_away && (timeout < 0 || timeout > 100) ) {
+		timeout = 100;
+	}
+	fds[0] = keyboard_fd;
+	fds[1] = mouse_fd;
+	SDL_WaitEventFDs(fds, 2, timeout);
+}
+
 void FB_InitOSKeymap(_THIS)
 {
 	int i;
@@ -269,6 +269,7 @@ static SDL_VideoDevice *FB_CreateDevice(int devindex)
 	this->GetWMInfo = NULL;
 	this->InitOSKeymap = FB_InitOSKeymap;
 	this->PumpEvents = FB_PumpEvents;
+	this->WaitEvents = FB_WaitEvents;
 
 	this->free = FB_DeleteDevice;
 
@@ -2512,6 +2512,7 @@ void DX5_PaletteChanged(_THIS, HWND window)
 		palette->colors[i].g = entries[i].peGreen;
 		palette->colors[i].b = entries[i].peBlue;
 	}
+	SDL_InvalidatePaletteLookup(palette->colors);
 	SDL_stack_free(entries);
 	if ( ! colorchange_expected ) {
 		Uint8 mapping[256];
@@ -983,6 +983,33 @@ void X11_PumpEvents(_THIS)
 	}
 }
 
+void X11_WaitEvents(_THIS, int timeout)
+{
+	int x11_fd;
+
+	/* Come back for the screensaver and a fullscreen switch */
+	if ( !allow_screensaver && (timeout < 0 || timeout > 5000) ) {
+		timeout = 5000;
+	}
+	if ( switch_waiting ) {
+		int switch_timeout = (int)(switch_time - SDL_GetTicks());
+		if ( switch_timeout < 0 ) {
+			switch_timeout = 0;
+		}
+		if ( timeout < 0 || timeout > switch_timeout ) {
+			timeout = switch_timeout;
+		}
+	}
+
+	/* Events Xlib has already read won't wake up select() */
+	XFlush(SDL_Display);
+	if ( XEventsQueued(SDL_Display, QueuedAlready) ) {
+		return;
+	}
+	x11_fd = ConnectionNumber(SDL_Display);
+	SDL_WaitEventFDs(&x11_fd, 1, timeout);
+}
+
 void X11_InitKeymap(void)
 {
 	int i;
@@ -24,8 +24,10 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include "SDL_cpuinfo.h"
 #include "SDL_endian.h"
 #include "../../events/SDL_events_c.h"
+#include "../SDL_present_c.h"
 #include "SDL_x11image_c.h"
 
 #ifndef NO_SHARED_MEMORY
@@ -75,11 +77,161 @@ static void try_mitshm(_THIS, SDL_Surface *screen)
 	if ( use_mitshm )
 		screen->pixels = shminfo.shmaddr;
 }
+
+/* The asynchronous presenter, see SDL_present.c.
+
+   Each present buffer is a shared memory image which the presenter thread
+   puts on the window over its own display connection.  Xlib isn't
+   thread-safe here, so the thread never touches SDL_Display or GFX_Display.
+*/
+struct X11_Presenter {
+	SDL_Presenter present;
+	Display *display;	/* Used only by the presenter thread */
+	GC gc;
+	Window window;
+	XShmSegmentInfo segments[SDL_NUM_PRESENT_BUFFERS];
+};
+
+static void X11_Present(_THIS, SDL_PresentBuffer *buffer)
+{
+	struct X11_Presenter *presenter = x11_presenter;
+	XImage *image = (XImage *)buffer->driverdata;
+	int i;
+
+	for ( i=0; i<buffer->numrects; ++i ) {
+		XShmPutImage(presenter->display, presenter->window,
+				presenter->gc, image,
+				buffer->rects[i].x, buffer->rects[i].y,
+				buffer->rects[i].x, buffer->rects[i].y,
+				buffer->rects[i].w, buffer->rects[i].h,
+				False);
+	}
+	/* The image can be reused once the server has read it.
+	   Waiting for a ShmCompletion event would hang the thread if
+	   the window went away, so a round trip marks completion.
+	 */
+	XSync(presenter->display, False);
+}
+
+static int X11_CreatePresentBuffer(_THIS, struct X11_Presenter *presenter,
+                                   int index, SDL_Surface *screen)
+{
+	SDL_PresentBuffer *buffer = &presenter->present.buffers[index];
+	XShmSegmentInfo *segment = &presenter->segments[index];
+	XImage *image;
+
+	image = XShmCreateImage(presenter->display, SDL_Visual,
+				this->hidden->depth, ZPixmap, NULL,
+				segment, screen->w, screen->h);
+	if ( image == NULL ) {
+		return(-1);
+	}
+	segment->shmid = shmget(IPC_PRIVATE,
+			image->bytes_per_line*screen->h, IPC_CREAT | 0777);
+	if ( segment->shmid < 0 ) {
+		XDestroyImage(image);
+		return(-1);
+	}
+	segment->shmaddr = (char *)shmat(segment->shmid, 0, 0);
+	segment->readOnly = False;
+	shm_error = False;
+	if ( segment->shmaddr != (char *)-1 ) {
+		X_handler = XSetErrorHandler(shm_errhandler);
+		XShmAttach(presenter->display, segment);
+		XSync(presenter->display, False);
+		XSetErrorHandler(X_handler);
+		if ( shm_error ) {
+			shmdt(segment->shmaddr);
+		}
+	} else {
+		shm_error = True;
+	}
+	shmctl(segment->shmid, IPC_RMID, NULL);
+	if ( shm_error ) {
+		XDestroyImage(image);
+		return(-1);
+	}
+	image->data = segment->shmaddr;
+	buffer->driverdata = image;
+	buffer->pixels = (Uint8 *)image->data;
+	buffer->pitch = image->bytes_per_line;
+	return(0);
+}
+
+static void X11_StopPresenter(_THIS)
+{
+	struct X11_Presenter *presenter = x11_presenter;
+	XImage *image;
+	int i;
+
+	SDL_StopPresenter(&presenter->present);
+	for ( i=0; i<SDL_NUM_PRESENT_BUFFERS; ++i ) {
+		image = (XImage *)presenter->present.buffers[i].driverdata;
+		if ( image ) {
+			XShmDetach(presenter->display, &presenter->segments[i]);
+			XSync(presenter->display, False);
+			XDestroyImage(image);
+			shmdt(presenter->segments[i].shmaddr);
+		}
+	}
+	if ( presenter->gc ) {
+		XFreeGC(presenter->display, presenter->gc);
+	}
+	if ( presenter->display ) {
+		XCloseDisplay(presenter->display);
+	}
+	SDL_free(presenter);
+	x11_presenter = NULL;
+}
+
+static int X11_StartPresenter(_THIS, SDL_Surface *screen)
+{
+	struct X11_Presenter *presenter;
+	int i;
+
+	/* Dynamic X11 may not have SHM entry points on this box. */
+	if ( !SDL_X11_HAVE_SHM ) {
+		SDL_SetError("MIT-SHM is not available");
+		return(-1);
+	}
+
+	presenter = (struct X11_Presenter *)SDL_calloc(1, sizeof(*presenter));
+	if ( presenter == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	x11_presenter = presenter;
+
+	/* The other connection has to know about our window */
+	XSync(SDL_Display, False);
+	presenter->display = XOpenDisplay(XDisplayString(SDL_Display));
+	if ( presenter->display == NULL ) {
+		SDL_SetError("Couldn't open a display for the presenter");
+		X11_StopPresenter(this);
+		return(-1);
+	}
+	for ( i=0; i<SDL_NUM_PRESENT_BUFFERS; ++i ) {
+		if ( X11_CreatePresentBuffer(this, presenter, i, screen) < 0 ) {
+			SDL_SetError("Couldn't create shared memory image");
+			X11_StopPresenter(this);
+			return(-1);
+		}
+	}
+	presenter->window = SDL_Window;
+	presenter->gc = XCreateGC(presenter->display, SDL_Window, 0, NULL);
+	presenter->present.Present = X11_Present;
+	if ( SDL_StartPresenter(this, &presenter->present) < 0 ) {
+		X11_StopPresenter(this);
+		return(-1);
+	}
+	return(0);
+}
 #endif /* ! NO_SHARED_MEMORY */
 
 /* Various screen update functions available */
 static void X11_NormalUpdate(_THIS, int numrects, SDL_Rect *rects);
 static void X11_MITSHMUpdate(_THIS, int numrects, SDL_Rect *rects);
+static void X11_AsyncUpdate(_THIS, int numrects, SDL_Rect *rects);
 
 int X11_SetupImage(_THIS, SDL_Surface *screen)
 {
@@ -120,6 +272,12 @@ int X11_SetupImage(_THIS, SDL_Surface *screen)
 		this->UpdateRects = X11_NormalUpdate;
 	}
 	screen->pitch = SDL_Ximage->bytes_per_line;
+#ifndef NO_SHARED_MEMORY
+	/* Fall back to normal updates if the presenter can't be started */
+	if ( async_present && (X11_StartPresenter(this, screen) == 0) ) {
+		this->UpdateRects = X11_AsyncUpdate;
+	}
+#endif /* ! NO_SHARED_MEMORY */
 	return(0);
 
 error:
@@ -129,6 +287,11 @@ error:
 
 void X11_DestroyImage(_THIS, SDL_Surface *screen)
 {
+#ifndef NO_SHARED_MEMORY
+	if ( x11_presenter ) {
+		X11_StopPresenter(this);
+	}
+#endif /* ! NO_SHARED_MEMORY */
 	if ( SDL_Ximage ) {
 		XDestroyImage(SDL_Ximage);
 #ifndef NO_SHARED_MEMORY
@@ -145,39 +308,6 @@ void X11_DestroyImage(_THIS, SDL_Surface *screen)
 	}
 }
 
-/* Determine the number of CPUs in the system */
-static int num_CPU(void)
-{
-       static int num_cpus = 0;
-
-       if(!num_cpus) {
-#if defined(__LINUX__)
-           char line[BUFSIZ];
-           FILE *pstat = fopen("/proc/stat", "r");
-           if ( pstat ) {
-               while ( fgets(line, sizeof(line), pstat) ) {
-                   if (SDL_memcmp(line, "cpu", 3) == 0 && line[3] != ' ') {
-                       ++num_cpus;
-                   }
-               }
-               fclose(pstat);
-           }
-#elif defined(__IRIX__)
-	   num_cpus = sysconf(_SC_NPROC_ONLN);
-#elif defined(_SC_NPROCESSORS_ONLN)
-	   /* number of processors online (SVR4.0MP compliant machines) */
-           num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
-#elif defined(_SC_NPROCESSORS_CONF)
-	   /* number of processors configured (SVR4.0MP compliant machines) */
-           num_cpus = sysconf(_SC_NPROCESSORS_CONF);
-#endif
-           if ( num_cpus <= 0 ) {
-               num_cpus = 1;
-           }
-       }
-       return num_cpus;
-}
-
 int X11_ResizeImage(_THIS, SDL_Surface *screen, Uint32 flags)
 {
 	int retval;
@@ -194,7 +324,7 @@ int X11_ResizeImage(_THIS, SDL_Surface *screen, Uint32 flags)
 			   X server and the application.
 			   Note: Is this still true with XFree86 4.0?
 			*/
-			if ( num_CPU() > 1 ) {
+			if ( SDL_GetCPUCount() > 1 ) {
 				screen->flags |= SDL_ASYNCBLIT;
 			}
 		}
@@ -273,6 +403,14 @@ static void X11_MITSHMUpdate(_THIS, int numrects, SDL_Rect *rects)
 #endif /* ! NO_SHARED_MEMORY */
 }
 
+static void X11_AsyncUpdate(_THIS, int numrects, SDL_Rect *rects)
+{
+#ifndef NO_SHARED_MEMORY
+	SDL_QueuePresent(&x11_presenter->present, SDL_VideoSurface,
+	                 numrects, rects);
+#endif /* ! NO_SHARED_MEMORY */
+}
+
 /* There's a problem with the automatic refreshing of the display.
    Even though the XVideo code uses the GFX_Display to update the
    video memory, it appears that updating the window asynchronously
@@ -301,6 +439,10 @@ void X11_RefreshDisplay(_THIS)
 		return;
 	}
 #ifndef NO_SHARED_MEMORY
+	/* Don't let older frames land on top of the refreshed window */
+	if ( x11_presenter ) {
+		SDL_WaitPresenter(&x11_presenter->present);
+	}
 	if ( this->UpdateRects == X11_MITSHMUpdate ) {
 		XShmPutImage(SDL_Display, SDL_Window, SDL_GC, SDL_Ximage,
 				0, 0, 0, 0, this->screen->w, this->screen->h,
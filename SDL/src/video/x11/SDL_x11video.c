@@ -172,6 +172,7 @@ static SDL_VideoDevice *X11_CreateDevice(int devindex)
 		device->CheckMouseMode = X11_CheckMouseMode;
 		device->InitOSKeymap = X11_InitOSKeymap;
 		device->PumpEvents = X11_PumpEvents;
+		device->WaitEvents = X11_WaitEvents;
 
 		device->free = X11_DeleteDevice;
 	}
@@ -640,6 +641,16 @@ static int X11_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	if ( local_X11 ) {
 		use_mitshm = XShmQueryExtension(SDL_Display);
 	}
+
+	/* The asynchronous presenter takes over the shared memory */
+	async_present = 0;
+	if ( use_mitshm ) {
+		const char *env = SDL_getenv("SDL_VIDEO_X11_ASYNC_PRESENT");
+		if ( env && SDL_atoi(env) ) {
+			async_present = 1;
+			use_mitshm = 0;
+		}
+	}
 #endif /* NO_SHARED_MEMORY */
 
 	/* Get the available video modes */
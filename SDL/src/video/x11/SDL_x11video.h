@@ -75,6 +75,10 @@ struct SDL_PrivateVideoData {
     /* MIT shared memory extension information */
     int use_mitshm;
     XShmSegmentInfo shminfo;
+
+    /* Asynchronous presentation from a separate thread */
+    int async_present;
+    struct X11_Presenter *presenter;
 #endif
 
     /* The variables used for displaying graphics */
@@ -174,6 +178,8 @@ struct SDL_PrivateVideoData {
 #define using_dga		(this->hidden->using_dga)
 #define use_mitshm		(this->hidden->use_mitshm)
 #define shminfo			(this->hidden->shminfo)
+#define async_present		(this->hidden->async_present)
+#define x11_presenter		(this->hidden->presenter)
 #define SDL_Ximage		(this->hidden->Ximage)
 #define SDL_GC			(this->hidden->gc)
 #define window_w		(this->hidden->window_w)
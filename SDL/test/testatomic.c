@@ -0,0 +1,124 @@
+
+/* Test of the SDL atomic operations and spinlocks, checking the results
+   when several threads use them at once and timing them against a mutex
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+#define NUM_THREADS	4
+#define NUM_ITERATIONS	1000000
+
+static SDL_atomic_t counter;
+static SDL_SpinLock spinlock;
+static SDL_mutex *mutex;
+static int locked_counter;
+
+static int SDLCALL AddFunc(void *data)
+{
+	int i;
+
+	for ( i = 0; i < NUM_ITERATIONS; ++i ) {
+		SDL_AtomicIncRef(&counter);
+	}
+	return(0);
+}
+
+static int SDLCALL CASFunc(void *data)
+{
+	int i, value;
+
+	for ( i = 0; i < NUM_ITERATIONS; ++i ) {
+		do {
+			value = SDL_AtomicGet(&counter);
+		} while ( ! SDL_AtomicCAS(&counter, value, value + 1) );
+	}
+	return(0);
+}
+
+static int SDLCALL SpinLockFunc(void *data)
+{
+	int i;
+
+	for ( i = 0; i < NUM_ITERATIONS; ++i ) {
+		SDL_AtomicLock(&spinlock);
+		++locked_counter;
+		SDL_AtomicUnlock(&spinlock);
+	}
+	return(0);
+}
+
+static int SDLCALL MutexFunc(void *data)
+{
+	int i;
+
+	for ( i = 0; i < NUM_ITERATIONS; ++i ) {
+		SDL_mutexP(mutex);
+		++locked_counter;
+		SDL_mutexV(mutex);
+	}
+	return(0);
+}
+
+/* Run the function on several threads and return the value it counted */
+static int RunThreads(const char *what, int (SDLCALL *func)(void *),
+                      int *result)
+{
+	SDL_Thread *threads[NUM_THREADS];
+	Uint32 start;
+	int i;
+
+	SDL_AtomicSet(&counter, 0);
+	locked_counter = 0;
+	start = SDL_GetTicks();
+	for ( i = 0; i < NUM_THREADS; ++i ) {
+		threads[i] = SDL_CreateThread(func, NULL);
+	}
+	for ( i = 0; i < NUM_THREADS; ++i ) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+	printf("%-10s %d ms, counted %d, expected %d\n", what,
+	       SDL_GetTicks() - start, *result, NUM_THREADS * NUM_ITERATIONS);
+	return (*result == NUM_THREADS * NUM_ITERATIONS);
+}
+
+int main(int argc, char *argv[])
+{
+	void *pointer = NULL;
+	int value, ok = 1;
+
+	if ( SDL_Init(0) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+
+	/* The operations on their own */
+	SDL_AtomicSet(&counter, 10);
+	ok &= (SDL_AtomicAdd(&counter, 5) == 10);
+	ok &= (SDL_AtomicGet(&counter) == 15);
+	ok &= !SDL_AtomicCAS(&counter, 10, 20);
+	ok &= SDL_AtomicCAS(&counter, 15, 20);
+	ok &= (SDL_AtomicSet(&counter, 1) == 20);
+	ok &= SDL_AtomicDecRef(&counter);
+	ok &= SDL_AtomicCASPtr(&pointer, NULL, &value);
+	ok &= (SDL_AtomicSetPtr(&pointer, NULL) == &value);
+	ok &= (SDL_AtomicGetPtr(&pointer) == NULL);
+	ok &= SDL_AtomicTryLock(&spinlock);
+	ok &= !SDL_AtomicTryLock(&spinlock);
+	SDL_AtomicUnlock(&spinlock);
+	printf("Single threaded operations: %s\n", ok ? "passed" : "FAILED");
+
+	/* The same counting with several threads at once */
+	mutex = SDL_CreateMutex();
+	ok &= RunThreads("Add", AddFunc, &counter.value);
+	ok &= RunThreads("CAS", CASFunc, &counter.value);
+	ok &= RunThreads("Spinlock", SpinLockFunc, &locked_counter);
+	ok &= RunThreads("Mutex", MutexFunc, &locked_counter);
+	SDL_DestroyMutex(mutex);
+
+	printf("Atomic operations %s\n", ok ? "passed" : "FAILED");
+	SDL_Quit();
+	return(ok ? 0 : 1);
+}
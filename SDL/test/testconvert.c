@@ -0,0 +1,174 @@
+/*
+ * Benchmarks SDL_ConvertSurface() and SDL_ConvertSurfaces() for common
+ *  pairs of pixel formats, the way games prepare their sprites when a
+ *  level is loaded, and prints the time taken for each pair.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+static int testMilliseconds = 500;
+static int spriteCount = 256;
+static int spriteSize = 64;
+
+static const struct {
+    const char *name;
+    int bpp;
+    Uint32 r, g, b, a;
+    int colorkey;
+} formats[] = {
+    { "RGB24", 24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000, 0 },
+    { "XRGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000, 0 },
+    { "ARGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000, 0 },
+    { "ABGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000, 0 },
+    { "RGB565", 16, 0xF800, 0x07E0, 0x001F, 0x0000, 0 },
+    { "RGB555", 16, 0x7C00, 0x03E0, 0x001F, 0x0000, 0 },
+    { "RGB24 ck", 24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000, 1 },
+};
+#define NUM_FORMATS ((int) (sizeof(formats) / sizeof(formats[0])))
+
+static SDL_Surface *create_format(int i, int w, int h)
+{
+    return SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, formats[i].bpp,
+                                formats[i].r, formats[i].g, formats[i].b,
+                                formats[i].a);
+}
+
+static void fill_random(SDL_Surface *surface)
+{
+    Uint8 *pixels = (Uint8 *) surface->pixels;
+    int x, y;
+
+    for (y = 0; y < surface->h; y++) {
+        for (x = 0; x < surface->w * surface->format->BytesPerPixel; x++) {
+            pixels[x] = (Uint8) rand();
+        }
+        pixels += surface->pitch;
+    }
+}
+
+static void free_all(SDL_Surface **surfaces)
+{
+    int i;
+
+    for (i = 0; i < spriteCount; i++) {
+        SDL_FreeSurface(surfaces[i]);
+        surfaces[i] = NULL;
+    }
+}
+
+/* Returns microseconds per surface */
+static double bench_convert(SDL_Surface **sprites, SDL_Surface **converted,
+                            SDL_PixelFormat *format, Uint32 flags, int batch)
+{
+    Uint32 start, now;
+    int i, rounds = 0;
+
+    start = now = SDL_GetTicks();
+    while ((now - start) < (Uint32) testMilliseconds) {
+        if (batch) {
+            SDL_ConvertSurfaces(sprites, spriteCount, format, flags,
+                                converted);
+        } else {
+            for (i = 0; i < spriteCount; i++) {
+                converted[i] = SDL_ConvertSurface(sprites[i], format, flags);
+            }
+        }
+        free_all(converted);
+        rounds++;
+        now = SDL_GetTicks();
+    }
+    if (now == start)
+        now++;
+    return ((now - start) * 1000.0) / ((double) rounds * spriteCount);
+}
+
+int main(int argc, char **argv)
+{
+    static const int targets[] = { 1, 2, 4, 0 };
+    SDL_Surface **sprites, **converted, *target;
+    Uint32 flags;
+    double single, batch;
+    int i, s, t;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-count") == 0 && argv[i + 1]) {
+            spriteCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-size") == 0 && argv[i + 1]) {
+            spriteSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-threads") == 0 && argv[i + 1]) {
+            static char threads[64];
+            SDL_snprintf(threads, sizeof(threads), "SDL_VIDEO_THREADS=%s",
+                         argv[++i]);
+            SDL_putenv(threads);
+        } else if (strcmp(argv[i], "-time") == 0 && argv[i + 1]) {
+            testMilliseconds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-count n] [-size n] [-threads n] "
+                            "[-time milliseconds]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (spriteCount <= 0 || spriteSize <= 0 || testMilliseconds <= 0) {
+        fprintf(stderr, "Counts, sizes and times must be positive\n");
+        return 1;
+    }
+
+    if (SDL_Init(0) < 0) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    sprites = (SDL_Surface **) calloc(spriteCount, sizeof(*sprites));
+    converted = (SDL_Surface **) calloc(spriteCount, sizeof(*converted));
+    if (sprites == NULL || converted == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        SDL_Quit();
+        return 1;
+    }
+
+    printf("%d sprites of %dx%d, microseconds per sprite:\n",
+           spriteCount, spriteSize, spriteSize);
+    printf("  %-9s    %-9s %10s %10s\n", "source", "target",
+           "single", "batch");
+    for (s = 0; s < NUM_FORMATS; s++) {
+        for (i = 0; i < spriteCount; i++) {
+            sprites[i] = create_format(s, spriteSize, spriteSize);
+            if (sprites[i] == NULL) {
+                fprintf(stderr, "Couldn't create surface: %s\n",
+                        SDL_GetError());
+                free_all(sprites);
+                SDL_Quit();
+                return 1;
+            }
+            fill_random(sprites[i]);
+            if (formats[s].colorkey) {
+                SDL_SetColorKey(sprites[i], SDL_SRCCOLORKEY, 0);
+            }
+        }
+        for (t = 0; t < (int) (sizeof(targets) / sizeof(targets[0])); t++) {
+            target = create_format(targets[t], 1, 1);
+            if (target == NULL) {
+                continue;
+            }
+            /* Colour keyed sprites become RGBA, like SDL_DisplayFormatAlpha() */
+            flags = target->format->Amask ? SDL_SRCALPHA : 0;
+            single = bench_convert(sprites, converted, target->format,
+                                   flags, 0);
+            batch = bench_convert(sprites, converted, target->format,
+                                  flags, 1);
+            printf("  %-9s -> %-9s %10.2f %10.2f\n", formats[s].name,
+                   formats[targets[t]].name, single, batch);
+            SDL_FreeSurface(target);
+        }
+        free_all(sprites);
+    }
+
+    free(sprites);
+    free(converted);
+    SDL_Quit();
+    return 0;
+}
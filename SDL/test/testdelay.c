@@ -0,0 +1,141 @@
+
+/* Test program to measure how close to their deadlines SDL_Delay() and
+   SDL_DelayUntilNS() wake up, pacing frames the way games do, with an
+   idle machine or with threads keeping the processors busy.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL.h"
+
+static int frames = 500;
+static volatile int done = 0;
+
+static int SDLCALL busy(void *data)
+{
+	volatile Uint32 sum = 0;
+
+	while ( ! done ) {
+		++sum;
+	}
+	return((int)sum);
+}
+
+static int compare(const void *a, const void *b)
+{
+	Sint64 x = *(const Sint64 *)a;
+	Sint64 y = *(const Sint64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Print how many microseconds after each frame's deadline we woke up */
+static void print_errors(const char *what, Sint64 *errors)
+{
+	qsort(errors, frames, sizeof(*errors), compare);
+	printf("  %-18s %9.1f %9.1f %9.1f %9.1f %9.1f\n", what,
+	       errors[0] / 1000.0, errors[frames / 2] / 1000.0,
+	       errors[(frames * 9) / 10] / 1000.0,
+	       errors[(frames * 99) / 100] / 1000.0,
+	       errors[frames - 1] / 1000.0);
+}
+
+static void pace_frames(Uint64 interval, Sint64 *errors, int precise)
+{
+	Uint64 deadline, now;
+	int i;
+
+	deadline = SDL_GetTicksNS();
+	for ( i = 0; i < frames; ++i ) {
+		deadline += interval;
+		if ( precise ) {
+			SDL_DelayUntilNS(deadline);
+		} else {
+			now = SDL_GetTicksNS();
+			if ( now < deadline ) {
+				SDL_Delay((Uint32)((deadline - now) / 1000000));
+			}
+		}
+		now = SDL_GetTicksNS();
+		errors[i] = (Sint64)(now - deadline);
+
+		/* Start again from here after a missed frame */
+		if ( now > deadline + interval ) {
+			deadline = now;
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	static const Uint64 intervals[] = {
+		1000000, 2500000, 6944444, 16666667
+	};
+	SDL_Thread **threads = NULL;
+	Sint64 *errors;
+	int i, load = 0;
+
+	for ( i = 1; i < argc; ++i ) {
+		if ( strcmp(argv[i], "-frames") == 0 && argv[i+1] ) {
+			frames = atoi(argv[++i]);
+		} else if ( strcmp(argv[i], "-load") == 0 && argv[i+1] ) {
+			load = atoi(argv[++i]);
+		} else {
+			fprintf(stderr,
+			        "Usage: %s [-frames n] [-load threads]\n", argv[0]);
+			return(1);
+		}
+	}
+	if ( frames <= 0 || load < 0 ) {
+		fprintf(stderr, "Frames must be positive\n");
+		return(1);
+	}
+
+	if ( SDL_Init(SDL_INIT_TIMER) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+	errors = (Sint64 *)malloc(frames * sizeof(*errors));
+	if ( load ) {
+		threads = (SDL_Thread **)calloc(load, sizeof(*threads));
+	}
+	if ( ! errors || (load && ! threads) ) {
+		fprintf(stderr, "Out of memory\n");
+		SDL_Quit();
+		return(1);
+	}
+	for ( i = 0; i < load; ++i ) {
+		threads[i] = SDL_CreateThread(busy, NULL);
+	}
+
+	printf("%d frames with %d busy threads, wakeup error in microseconds:\n",
+	       frames, load);
+	printf("  %-18s %9s %9s %9s %9s %9s\n", "interval",
+	       "min", "median", "90%", "99%", "max");
+	for ( i = 0; i < (int)(sizeof(intervals)/sizeof(intervals[0])); ++i ) {
+		char what[64];
+
+		SDL_snprintf(what, sizeof(what), "%.3f ms Delay",
+		             intervals[i] / 1000000.0);
+		pace_frames(intervals[i], errors, 0);
+		print_errors(what, errors);
+
+		SDL_snprintf(what, sizeof(what), "%.3f ms DelayNS",
+		             intervals[i] / 1000000.0);
+		pace_frames(intervals[i], errors, 1);
+		print_errors(what, errors);
+	}
+
+	done = 1;
+	for ( i = 0; i < load; ++i ) {
+		if ( threads[i] ) {
+			SDL_WaitThread(threads[i], NULL);
+		}
+	}
+	free(threads);
+	free(errors);
+	SDL_Quit();
+	return(0);
+}
@@ -9,6 +9,11 @@
 #include "SDL_thread.h"
 
 static int alive = 0;
+static SDL_TLSID tls;
+static int destroyed = 0;
+
+#define NUM_ERROR_THREADS	4
+#define NUM_ERRORS		100000
 
 /* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
 static void quit(int rc)
@@ -17,8 +22,20 @@ static void quit(int rc)
 	exit(rc);
 }
 
+static void SDLCALL TLSDestructor(void *data)
+{
+	++destroyed;
+}
+
 int SDLCALL ThreadFunc(void *data)
 {
+	/* Each thread sees the value it stored itself */
+	SDL_TLSSet(tls, data, TLSDestructor);
+	if ( SDL_TLSGet(tls) != data ) {
+		printf("Thread '%s' got the wrong thread local value\n",
+		       (char *)data);
+	}
+
 	/* Set the child thread error string */
 	SDL_SetError("Thread %s (%d) had a problem: %s",
 			(char *)data, SDL_ThreadID(), "nevermind");
@@ -30,9 +47,27 @@ int SDLCALL ThreadFunc(void *data)
 	return(0);
 }
 
+int SDLCALL ErrorFunc(void *data)
+{
+	int i;
+
+	/* Fail over and over, like probing for files that aren't there */
+	for ( i = 0; i < NUM_ERRORS; ++i ) {
+		SDL_SetError("Couldn't open %s", (char *)data);
+		if ( *SDL_GetError() != 'C' ) {
+			printf("Thread '%s' lost its error string\n",
+			       (char *)data);
+			break;
+		}
+	}
+	return(0);
+}
+
 int main(int argc, char *argv[])
 {
-	SDL_Thread *thread;
+	SDL_Thread *thread, *threads[NUM_ERROR_THREADS];
+	Uint32 start;
+	int i;
 
 	/* Load the SDL library */
 	if ( SDL_Init(0) < 0 ) {
@@ -42,6 +77,8 @@ int main(int argc, char *argv[])
 
 	/* Set the error value for the main thread */
 	SDL_SetError("No worries");
+	tls = SDL_TLSCreate();
+	SDL_TLSSet(tls, "main", NULL);
 
 	alive = 1;
 	thread = SDL_CreateThread(ThreadFunc, "#1");
@@ -55,6 +92,20 @@ int main(int argc, char *argv[])
 	SDL_WaitThread(thread, NULL);
 
 	printf("Main thread error string: %s\n", SDL_GetError());
+	printf("Main thread local value: %s, destructors called: %d\n",
+	       (char *)SDL_TLSGet(tls), destroyed);
+
+	/* Time several threads setting errors at once */
+	start = SDL_GetTicks();
+	for ( i = 0; i < NUM_ERROR_THREADS; ++i ) {
+		threads[i] = SDL_CreateThread(ErrorFunc, "missing.dat");
+	}
+	for ( i = 0; i < NUM_ERROR_THREADS; ++i ) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+	printf("%d threads set %d errors each in %d ms\n",
+	       NUM_ERROR_THREADS, NUM_ERRORS, SDL_GetTicks() - start);
+	printf("Main thread error string: %s\n", SDL_GetError());
 
 	SDL_Quit();
 	return(0);
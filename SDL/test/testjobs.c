@@ -0,0 +1,182 @@
+
+/* Test of the SDL job threads: checks that every job runs once, that jobs
+   can wait for jobs of their own, and times parallel loops with more and
+   more threads against running them on one thread.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#define NUM_JOBS	10000
+#define NUM_NESTED	100
+#define NUM_VALUES	(1024*1024)
+
+static SDL_atomic_t counter;
+static Uint32 *values;
+
+static void SDLCALL CountJob(void *data)
+{
+	SDL_AtomicIncRef(&counter);
+}
+
+/* A job that adds jobs to a group of its own and waits for them */
+static void SDLCALL NestedJob(void *data)
+{
+	SDL_JobGroup *group = SDL_CreateJobGroup();
+	int i;
+
+	for ( i = 0; i < NUM_NESTED; ++i ) {
+		SDL_AddJob(group, CountJob, NULL);
+	}
+	SDL_DestroyJobGroup(group);
+}
+
+static void SDLCALL MarkRange(void *data, int start, int end)
+{
+	int i;
+
+	for ( i = start; i < end; ++i ) {
+		++values[i];
+	}
+}
+
+/* Something that takes a while for every value */
+static void SDLCALL HashRange(void *data, int start, int end)
+{
+	int i, j;
+	Uint32 hash;
+
+	for ( i = start; i < end; ++i ) {
+		hash = (Uint32)i;
+		for ( j = 0; j < 64; ++j ) {
+			hash = (hash ^ (hash >> 15)) * 0x2c1b3c6d;
+		}
+		values[i] = hash;
+	}
+}
+
+static int CheckJobs(void)
+{
+	SDL_JobGroup *group;
+	int i, ok = 1;
+
+	group = SDL_CreateJobGroup();
+	SDL_AtomicSet(&counter, 0);
+	for ( i = 0; i < NUM_JOBS; ++i ) {
+		SDL_AddJob(group, CountJob, NULL);
+	}
+	SDL_WaitJobGroup(group);
+	if ( SDL_AtomicGet(&counter) != NUM_JOBS ) {
+		printf("Ran %d of %d jobs\n", SDL_AtomicGet(&counter), NUM_JOBS);
+		ok = 0;
+	}
+
+	SDL_AtomicSet(&counter, 0);
+	for ( i = 0; i < NUM_NESTED; ++i ) {
+		SDL_AddJob(group, NestedJob, NULL);
+	}
+	SDL_DestroyJobGroup(group);
+	if ( SDL_AtomicGet(&counter) != NUM_NESTED * NUM_NESTED ) {
+		printf("Ran %d of %d nested jobs\n", SDL_AtomicGet(&counter),
+		       NUM_NESTED * NUM_NESTED);
+		ok = 0;
+	}
+
+	memset(values, 0, NUM_VALUES * sizeof(*values));
+	SDL_ParallelFor(0, NUM_VALUES, 0, MarkRange, NULL);
+	SDL_ParallelFor(0, NUM_VALUES, 1000, MarkRange, NULL);
+	SDL_ParallelFor(5, 5, 0, MarkRange, NULL);
+	for ( i = 0; i < NUM_VALUES; ++i ) {
+		if ( values[i] != 2 ) {
+			printf("Value %d was visited %d times\n", i, values[i]);
+			ok = 0;
+			break;
+		}
+	}
+	return ok;
+}
+
+/* Time the jobs and loops with the threads there are now */
+static void TimeJobs(Uint32 serial_ms)
+{
+	SDL_JobGroup *group;
+	Uint64 start, freq = SDL_GetPerformanceFrequency();
+	double job_ns, loop_ms;
+	int i;
+
+	group = SDL_CreateJobGroup();
+	start = SDL_GetPerformanceCounter();
+	for ( i = 0; i < NUM_JOBS; ++i ) {
+		SDL_AddJob(group, CountJob, NULL);
+	}
+	SDL_WaitJobGroup(group);
+	job_ns = (SDL_GetPerformanceCounter() - start) * 1e9 / freq / NUM_JOBS;
+	SDL_DestroyJobGroup(group);
+
+	start = SDL_GetPerformanceCounter();
+	SDL_ParallelFor(0, NUM_VALUES, 0, HashRange, NULL);
+	loop_ms = (SDL_GetPerformanceCounter() - start) * 1e3 / freq;
+
+	printf("%7d %12.0f %12.1f %9.2fx\n", SDL_GetJobThreads(), job_ns,
+	       loop_ms, loop_ms > 0.0 ? serial_ms / loop_ms : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	static char env[64];
+	Uint32 serial_ms;
+	int i, threads, max_threads = 0, ok;
+
+	for ( i = 1; i < argc; ++i ) {
+		if ( strcmp(argv[i], "-threads") == 0 && argv[i+1] ) {
+			max_threads = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [-threads max]\n", argv[0]);
+			return(1);
+		}
+	}
+
+	if ( SDL_Init(0) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+	values = (Uint32 *)malloc(NUM_VALUES * sizeof(*values));
+	if ( ! values ) {
+		fprintf(stderr, "Out of memory\n");
+		SDL_Quit();
+		return(1);
+	}
+	if ( max_threads <= 0 ) {
+		max_threads = SDL_GetJobThreads();
+	}
+
+	ok = CheckJobs();
+	printf("Jobs %s with %d threads\n", ok ? "passed" : "FAILED",
+	       SDL_GetJobThreads());
+
+	serial_ms = SDL_GetTicks();
+	HashRange(NULL, 0, NUM_VALUES);
+	serial_ms = SDL_GetTicks() - serial_ms;
+	printf("One thread without jobs: %d ms\n", serial_ms);
+
+	/* SDL_Quit() stops the job threads, and the next job starts them with
+	   the new SDL_JOB_THREADS */
+	printf("%7s %12s %12s %10s\n", "threads", "ns/job", "loop ms", "speedup");
+	for ( threads = 1; threads <= max_threads; threads *= 2 ) {
+		if ( threads > max_threads / 2 ) {
+			threads = max_threads;	/* Always time all of them */
+		}
+		SDL_snprintf(env, sizeof(env), "SDL_JOB_THREADS=%d", threads);
+		SDL_putenv(env);
+		SDL_Quit();
+		SDL_Init(0);
+		TimeJobs(serial_ms);
+	}
+
+	free(values);
+	SDL_Quit();
+	return(ok ? 0 : 1);
+}
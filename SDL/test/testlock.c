@@ -5,6 +5,7 @@
 
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "SDL.h"
 #include "SDL_mutex.h"
@@ -71,6 +72,83 @@ int SDLCALL Run(void *data)
 	return(0);
 }
 
+/* The contention benchmark, run with -bench */
+#define BENCH_LOCKS	200000
+#define BENCH_HANDOFFS	20000
+#define MAX_BENCH_THREADS	8
+
+static volatile int counter;
+static int locks_per_thread;
+
+static int SDLCALL LockLoop(void *data)
+{
+	int i;
+
+	for ( i = 0; i < locks_per_thread; ++i ) {
+		SDL_mutexP(mutex);
+		++counter;
+		SDL_mutexV(mutex);
+	}
+	return(0);
+}
+
+static SDL_cond *cond;
+static volatile int turn;
+
+/* Take turns with the other thread, waking it up on the condition */
+static int SDLCALL HandoffLoop(void *data)
+{
+	int me = (int)(uintptr_t)data;
+	int i;
+
+	SDL_mutexP(mutex);
+	for ( i = 0; i < BENCH_HANDOFFS; ++i ) {
+		while ( turn != me ) {
+			SDL_CondWait(cond, mutex);
+		}
+		turn = !me;
+		SDL_CondSignal(cond);
+	}
+	SDL_mutexV(mutex);
+	return(0);
+}
+
+static void Benchmark(void)
+{
+	SDL_Thread *bench[MAX_BENCH_THREADS];
+	Uint64 start, elapsed;
+	int i, num_threads;
+
+	printf("%7s %10s %10s\n", "threads", "ns/lock", "correct");
+	for ( num_threads = 1; num_threads <= MAX_BENCH_THREADS; num_threads *= 2 ) {
+		counter = 0;
+		locks_per_thread = BENCH_LOCKS / num_threads;
+		start = SDL_GetTicksNS();
+		for ( i = 0; i < num_threads; ++i ) {
+			bench[i] = SDL_CreateThread(LockLoop, NULL);
+		}
+		for ( i = 0; i < num_threads; ++i ) {
+			SDL_WaitThread(bench[i], NULL);
+		}
+		elapsed = SDL_GetTicksNS() - start;
+		printf("%7d %10.1f %10s\n", num_threads,
+		       (double)elapsed / (locks_per_thread * num_threads),
+		       counter == locks_per_thread * num_threads ? "yes" : "NO");
+	}
+
+	cond = SDL_CreateCond();
+	turn = 0;
+	start = SDL_GetTicksNS();
+	bench[0] = SDL_CreateThread(HandoffLoop, (void *)0);
+	bench[1] = SDL_CreateThread(HandoffLoop, (void *)1);
+	SDL_WaitThread(bench[0], NULL);
+	SDL_WaitThread(bench[1], NULL);
+	elapsed = SDL_GetTicksNS() - start;
+	printf("Condition variable handoff between two threads: %.1f us\n",
+	       elapsed / 1000.0 / (2 * BENCH_HANDOFFS));
+	SDL_DestroyCond(cond);
+}
+
 int main(int argc, char *argv[])
 {
 	int i;
@@ -83,6 +161,16 @@ int main(int argc, char *argv[])
 	}
 	atexit(SDL_Quit_Wrapper);
 
+	if ( argc > 1 && strcmp(argv[1], "-bench") == 0 ) {
+		if ( (mutex=SDL_CreateMutex()) == NULL ) {
+			fprintf(stderr, "Couldn't create mutex: %s\n", SDL_GetError());
+			exit(1);
+		}
+		Benchmark();
+		SDL_DestroyMutex(mutex);
+		return(0);
+	}
+
 	if ( (mutex=SDL_CreateMutex()) == NULL ) {
 		fprintf(stderr, "Couldn't create mutex: %s\n", SDL_GetError());
 		exit(1);
@@ -0,0 +1,238 @@
+
+/* Test program for mapping colours to 8-bit palettes: compares
+   SDL_MapRGB() with a search of the whole palette, for several kinds of
+   palettes, and checks that changing the colours is picked up.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#define SAMPLES	100000
+
+static int failures = 0;
+
+/* The entry closest to a colour, the first one if several are */
+static Uint8 Nearest(const SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+{
+	unsigned int smallest = ~0;
+	unsigned int distance;
+	int rd, gd, bd;
+	int i;
+	Uint8 pixel = 0;
+
+	for ( i = 0; i < pal->ncolors; ++i ) {
+		rd = pal->colors[i].r - r;
+		gd = pal->colors[i].g - g;
+		bd = pal->colors[i].b - b;
+		distance = (rd*rd)+(gd*gd)+(bd*bd);
+		if ( distance < smallest ) {
+			pixel = i;
+			smallest = distance;
+		}
+	}
+	return(pixel);
+}
+
+static int CheckColor(SDL_Surface *surface, const char *name,
+                      Uint8 r, Uint8 g, Uint8 b)
+{
+	Uint32 pixel = SDL_MapRGB(surface->format, r, g, b);
+	Uint8 expected = Nearest(surface->format->palette, r, g, b);
+
+	if ( pixel != expected ) {
+		printf("FAIL: %s: %d,%d,%d mapped to %u instead of %u\n",
+		       name, r, g, b, pixel, expected);
+		++failures;
+		return(0);
+	}
+	return(1);
+}
+
+/* Random colours, and colours on and around each palette entry */
+static void CheckPalette(SDL_Surface *surface, const char *name, int samples)
+{
+	SDL_Palette *pal = surface->format->palette;
+	int i, d;
+
+	for ( i = 0; i < samples; ++i ) {
+		if ( !CheckColor(surface, name, rand(), rand(), rand()) ) {
+			return;
+		}
+	}
+	for ( i = 0; i < pal->ncolors; ++i ) {
+		for ( d = -3; d <= 3; ++d ) {
+			if ( !CheckColor(surface, name,
+			                 (Uint8)(pal->colors[i].r + d),
+			                 (Uint8)(pal->colors[i].g - d),
+			                 (Uint8)(pal->colors[i].b + d)) ) {
+				return;
+			}
+		}
+	}
+}
+
+static SDL_Surface *CreatePalettized(void)
+{
+	SDL_Surface *surface;
+
+	surface = SDL_CreateRGBSurface(SDL_SWSURFACE, 16, 16, 8, 0, 0, 0, 0);
+	if ( surface == NULL ) {
+		fprintf(stderr, "Couldn't create surface: %s\n", SDL_GetError());
+		exit(1);
+	}
+	return(surface);
+}
+
+static void RandomColors(SDL_Color *colors, int ncolors)
+{
+	int i;
+
+	for ( i = 0; i < ncolors; ++i ) {
+		colors[i].r = rand();
+		colors[i].g = rand();
+		colors[i].b = rand();
+		colors[i].unused = 0;
+	}
+}
+
+static void CheckKinds(SDL_Surface *surface)
+{
+	SDL_Color colors[256];
+	int i;
+
+	RandomColors(colors, 256);
+	SDL_SetColors(surface, colors, 0, 256);
+	CheckPalette(surface, "random", SAMPLES);
+
+	/* Only a few entries spread over the cube */
+	surface->format->palette->ncolors = 16;
+	SDL_SetColors(surface, colors, 0, 16);
+	CheckPalette(surface, "16 random", SAMPLES);
+	surface->format->palette->ncolors = 2;
+	SDL_SetColors(surface, colors, 0, 2);
+	CheckPalette(surface, "2 random", SAMPLES);
+	surface->format->palette->ncolors = 256;
+
+	/* Repeated colours map to the first of them */
+	for ( i = 0; i < 256; ++i ) {
+		colors[i] = colors[i % 37];
+	}
+	SDL_SetColors(surface, colors, 0, 256);
+	CheckPalette(surface, "repeated", SAMPLES);
+
+	for ( i = 0; i < 256; ++i ) {
+		colors[i].r = colors[i].g = colors[i].b = i;
+	}
+	SDL_SetColors(surface, colors, 0, 256);
+	CheckPalette(surface, "grey ramp", SAMPLES);
+
+	/* Clustered colours, so cells have many candidates */
+	for ( i = 0; i < 256; ++i ) {
+		colors[i].r = 120 + rand() % 16;
+		colors[i].g = 120 + rand() % 16;
+		colors[i].b = 120 + rand() % 16;
+	}
+	SDL_SetColors(surface, colors, 0, 256);
+	CheckPalette(surface, "clustered", SAMPLES);
+}
+
+/* Changing the colours, in every way an application can */
+static void CheckChanges(void)
+{
+	SDL_Surface *surface, *surfaces[6];
+	SDL_Palette *pal;
+	SDL_Color colors[256];
+	SDL_Color color;
+	int i, j;
+
+	surface = CreatePalettized();
+	pal = surface->format->palette;
+	RandomColors(colors, 256);
+	SDL_SetColors(surface, colors, 0, 256);
+	CheckPalette(surface, "before changes", 1000);
+
+	/* Changing a single entry */
+	color.r = 255 - colors[0].r;
+	color.g = 255 - colors[0].g;
+	color.b = 255 - colors[0].b;
+	SDL_SetColors(surface, &color, 200, 1);
+	CheckColor(surface, "one entry set", color.r, color.g, color.b);
+	CheckPalette(surface, "one entry set", 1000);
+
+	/* Writing the colours directly, then passing them back */
+	pal->colors[10].r = 1;
+	pal->colors[10].g = 2;
+	pal->colors[10].b = 3;
+	SDL_SetColors(surface, &pal->colors[10], 10, 1);
+	CheckColor(surface, "written directly", 1, 2, 3);
+	RandomColors(pal->colors, 256);
+	SDL_SetColors(surface, pal->colors, 0, 256);
+	CheckPalette(surface, "all written directly", 1000);
+
+	/* Palette cycling */
+	for ( i = 0; i < 64; ++i ) {
+		SDL_memcpy(colors, &pal->colors[1], 255*sizeof(colors[0]));
+		colors[255] = pal->colors[0];
+		SDL_SetColors(surface, colors, 0, 256);
+		CheckPalette(surface, "cycling", 200);
+	}
+
+	/* A new surface where the old one was */
+	SDL_FreeSurface(surface);
+	surface = CreatePalettized();
+	RandomColors(colors, 256);
+	SDL_SetColors(surface, colors, 0, 256);
+	CheckPalette(surface, "new surface", 1000);
+	SDL_FreeSurface(surface);
+
+	/* More palettes in use than there are maps kept */
+	for ( i = 0; i < SDL_arraysize(surfaces); ++i ) {
+		surfaces[i] = CreatePalettized();
+		RandomColors(colors, 256);
+		SDL_SetColors(surfaces[i], colors, 0, 256);
+	}
+	for ( j = 0; j < 3; ++j ) {
+		for ( i = 0; i < SDL_arraysize(surfaces); ++i ) {
+			CheckPalette(surfaces[i], "several palettes", 500);
+		}
+	}
+	for ( i = 0; i < SDL_arraysize(surfaces); ++i ) {
+		SDL_FreeSurface(surfaces[i]);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	SDL_Surface *surface;
+	unsigned int seed = 1;
+	int i;
+
+	for ( i = 1; i < argc; ++i ) {
+		if ( strcmp(argv[i], "-seed") == 0 && argv[i+1] ) {
+			seed = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [-seed n]\n", argv[0]);
+			return(1);
+		}
+	}
+	srand(seed);
+
+	if ( SDL_Init(0) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+
+	surface = CreatePalettized();
+	CheckKinds(surface);
+	SDL_FreeSurface(surface);
+	CheckChanges();
+
+	SDL_Quit();
+	if ( failures == 0 ) {
+		printf("All tests passed\n");
+	}
+	return(failures ? 1 : 0);
+}
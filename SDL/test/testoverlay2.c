@@ -261,6 +261,234 @@ void ConvertRGBtoYUY2(SDL_Surface *s, SDL_Overlay *o, int monochrome, int lumina
 	SDL_UnlockSurface(s);
 }
 
+void ConvertRGBtoOverlay(SDL_Surface *s, SDL_Overlay *o)
+{
+    switch (o->format)
+    {
+        case SDL_YUY2_OVERLAY:
+             ConvertRGBtoYUY2(s, o, 0, 100);
+             break;
+        case SDL_YV12_OVERLAY:
+             ConvertRGBtoYV12(s, o, 0, 100);
+             break;
+        case SDL_UYVY_OVERLAY:
+             ConvertRGBtoUYVY(s, o, 0, 100);
+             break;
+        case SDL_YVYU_OVERLAY:
+             ConvertRGBtoYVYU(s, o, 0, 100);
+             break;
+        case SDL_IYUV_OVERLAY:
+             ConvertRGBtoIYUV(s, o, 0, 100);
+             break;
+    }
+}
+
+static const struct {
+    Uint32 format;
+    const char *name;
+    int bits;
+} formats[] = {
+    { SDL_YV12_OVERLAY, "YV12", 12 }, { SDL_IYUV_OVERLAY, "IYUV", 12 },
+    { SDL_YUY2_OVERLAY, "YUY2", 16 }, { SDL_UYVY_OVERLAY, "UYVY", 16 },
+    { SDL_YVYU_OVERLAY, "YVYU", 16 }
+};
+
+/* Display one moose frame, scaled up to the overlay size, as fast as
+   possible in every overlay format at 16 and 32 bpp.  The overlay is
+   shown 1:1, doubled, and scaled between 720p and 1080p.  The bandwidth
+   counts the overlay read and the display written each frame. */
+static void Benchmark(SDL_Surface *frame, int scale, int ms)
+{
+    static const int depths[] = { 16, 32 };
+    int sizes[6][4] = {
+        { 0, 0, 1, 1 }, { 0, 0, 2, 2 },
+        { 1280, 720, 1280, 720 }, { 1280, 720, 1920, 1080 },
+        { 1920, 1080, 1920, 1080 }, { 1920, 1080, 1280, 720 }
+    };
+    SDL_Surface *screen, *picture;
+    SDL_Overlay *overlay;
+    SDL_Rect rect;
+    Uint32 start, now;
+    int f, d, c, w, h, frames;
+    double fps, bytes;
+
+    /* The first two are the moose at the chosen scale, 1:1 and 2x */
+    for (c=0; c<2; c++)
+    {
+        sizes[c][2]*=MOOSEPIC_W*scale;
+        sizes[c][3]*=MOOSEPIC_H*scale;
+        sizes[c][0]=MOOSEPIC_W*scale;
+        sizes[c][1]=MOOSEPIC_H*scale;
+    }
+
+    for (d=0; d<(int)(sizeof(depths)/sizeof(depths[0])); d++)
+    {
+        for (c=0; c<(int)(sizeof(sizes)/sizeof(sizes[0])); c++)
+        {
+            w=sizes[c][0];
+            h=sizes[c][1];
+            picture = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32,
+                                           frame->format->Rmask, frame->format->Gmask,
+                                           frame->format->Bmask, 0);
+            if (picture == NULL || SDL_SoftStretch(frame, NULL, picture, NULL) < 0)
+            {
+                fprintf(stderr, "Couldn't scale picture: %s\n", SDL_GetError());
+                quit(6);
+            }
+            screen=SDL_SetVideoMode(sizes[c][2], sizes[c][3], depths[d], SDL_SWSURFACE);
+            if (screen==NULL)
+            {
+                fprintf(stderr, "Couldn't set video mode: %s\n", SDL_GetError());
+                quit(4);
+            }
+            for (f=0; f<(int)(sizeof(formats)/sizeof(formats[0])); f++)
+            {
+                overlay=SDL_CreateYUVOverlay(w, h, formats[f].format, screen);
+                if (!overlay)
+                {
+                    fprintf(stderr, "Couldn't create overlay: %s\n", SDL_GetError());
+                    quit(7);
+                }
+                ConvertRGBtoOverlay(picture, overlay);
+
+                rect.x=0;
+                rect.y=0;
+                rect.w=sizes[c][2];
+                rect.h=sizes[c][3];
+                frames=0;
+                start=now=SDL_GetTicks();
+                while ((now-start) < (Uint32)ms)
+                {
+                    SDL_DisplayYUVOverlay(overlay, &rect);
+                    frames++;
+                    now=SDL_GetTicks();
+                }
+                if (now==start)
+                    now++;
+                fps=(frames*1000.0)/(now-start);
+                bytes=(w*h*formats[f].bits)/8.0 +
+                      (double)rect.w*rect.h*screen->format->BytesPerPixel;
+                printf("  %s %s %4dx%-4d -> %4dx%-4d %2d bpp: %8.1f frames/sec, %8.1f MB/sec\n",
+                       formats[f].name, overlay->hw_overlay?"hardware":"software",
+                       w, h, rect.w, rect.h, screen->format->BitsPerPixel,
+                       fps, (fps*bytes)/1000000.0);
+                SDL_FreeYUVOverlay(overlay);
+            }
+            SDL_FreeSurface(picture);
+        }
+    }
+}
+
+/* Show an overlay of random samples and keep a copy of the screen */
+static void DisplayRandom(SDL_Surface *screen, Uint32 format, int w, int h,
+                          SDL_Rect *rect, unsigned int seed, Uint8 *pixels)
+{
+    SDL_Overlay *overlay;
+    int i, p, rows;
+
+    overlay=SDL_CreateYUVOverlay(w, h, format, screen);
+    if (!overlay)
+    {
+        fprintf(stderr, "Couldn't create overlay: %s\n", SDL_GetError());
+        quit(7);
+    }
+    srand(seed);
+    SDL_LockYUVOverlay(overlay);
+    for (p=0; p<overlay->planes; p++)
+    {
+        rows=(overlay->planes==3 && p) ? h/2 : h;
+        for (i=0; i<overlay->pitches[p]*rows; i++)
+        {
+            overlay->pixels[p][i]=(Uint8)rand();
+        }
+    }
+    SDL_UnlockYUVOverlay(overlay);
+    SDL_FillRect(screen, NULL, 0);
+    SDL_DisplayYUVOverlay(overlay, rect);
+    SDL_FreeYUVOverlay(overlay);
+    memcpy(pixels, screen->pixels, screen->pitch*screen->h);
+}
+
+/* Convert every overlay format at every depth and scale with the SSE2
+   and AVX2 code and with the lookup tables, and compare the bytes.
+   Returns the number of mismatches. */
+static int Check(void)
+{
+    static const int depths[] = { 15, 16, 24, 32 };
+    static const int sizes[][2] = {
+        { 64, 48 }, { 66, 40 }, { 318, 202 }, { 2, 2 }
+    };
+    static const char *simd[] = { "SDL_VIDEO_YUV_SIMD=sse2", "SDL_VIDEO_YUV_SIMD=avx2" };
+    static const char *chroma[] = { "SDL_VIDEO_YUV_CHROMA=", "SDL_VIDEO_YUV_CHROMA=bilinear" };
+    SDL_Surface *screen;
+    SDL_Rect rects[4];
+    Uint8 *table, *vector;
+    int d, s, f, c, r, v, w, h, size;
+    int checked=0, failed=0;
+
+    for (d=0; d<(int)(sizeof(depths)/sizeof(depths[0])); d++)
+    {
+        screen=SDL_SetVideoMode(640, 480, depths[d], SDL_SWSURFACE);
+        if (screen==NULL)
+        {
+            fprintf(stderr, "Couldn't set video mode: %s\n", SDL_GetError());
+            quit(4);
+        }
+        size=screen->pitch*screen->h;
+        table=(Uint8 *)malloc(size);
+        vector=(Uint8 *)malloc(size);
+        if (!table || !vector)
+        {
+            fprintf(stderr, "Out of memory\n");
+            quit(1);
+        }
+        for (s=0; s<(int)(sizeof(sizes)/sizeof(sizes[0])); s++)
+        {
+            w=sizes[s][0];
+            h=sizes[s][1];
+            /* 1:1, doubled, scaled up and shrunk */
+            rects[0].x=3; rects[0].y=1; rects[0].w=w; rects[0].h=h;
+            rects[1].x=0; rects[1].y=0; rects[1].w=2*w; rects[1].h=2*h;
+            rects[2].x=5; rects[2].y=7; rects[2].w=w*3/2+1; rects[2].h=h*5/4+1;
+            rects[3].x=1; rects[3].y=2; rects[3].w=w/2+1; rects[3].h=h/3+1;
+            for (f=0; f<(int)(sizeof(formats)/sizeof(formats[0])); f++)
+            {
+                for (c=0; c<2; c++)
+                {
+                    SDL_putenv((char *)chroma[c]);
+                    for (r=0; r<4; r++)
+                    {
+                        SDL_putenv("SDL_VIDEO_YUV_SIMD=0");
+                        DisplayRandom(screen, formats[f].format, w, h,
+                                      &rects[r], f*100+s+1, table);
+                        for (v=0; v<2; v++)
+                        {
+                            SDL_putenv((char *)simd[v]);
+                            DisplayRandom(screen, formats[f].format, w, h,
+                                          &rects[r], f*100+s+1, vector);
+                            checked++;
+                            if (memcmp(table, vector, size) != 0)
+                            {
+                                printf("FAIL: %s %dx%d -> %dx%d %d bpp%s with %s\n",
+                                       formats[f].name, w, h, rects[r].w, rects[r].h,
+                                       screen->format->BitsPerPixel,
+                                       c ? " bilinear" : "", simd[v]);
+                                failed++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        free(table);
+        free(vector);
+    }
+    SDL_putenv("SDL_VIDEO_YUV_SIMD=");
+    SDL_putenv("SDL_VIDEO_YUV_CHROMA=");
+    printf("%d conversions compared with the tables, %d differ\n", checked, failed);
+    return failed;
+}
+
 static void PrintUsage(char *argv0)
 {
     fprintf(stderr, "Usage: %s [arg] [arg] [arg] ...\n", argv0);
@@ -270,6 +498,9 @@ static void PrintUsage(char *argv0)
     fprintf(stderr, "	-fps <frames per second>\n");
     fprintf(stderr, "	-format <fmt> (one of the: YV12, IYUV, YUY2, UYVY, YVYU)\n");
     fprintf(stderr, "	-scale <scale factor> (initial scale of the overlay)\n");
+    fprintf(stderr, "	-benchmark <milliseconds> (time every overlay format and exit)\n");
+    fprintf(stderr, "	-check (compare the SSE2 and AVX2 conversions with the tables and exit)\n");
+    fprintf(stderr, "	-threads <count> (threads converting large overlays, sets SDL_VIDEO_THREADS)\n");
     fprintf(stderr, "	-help (shows this help)\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Press ESC to exit, or SPACE to freeze the movie while application running.\n");
@@ -293,6 +524,8 @@ int main(int argc, char **argv)
     int fpsdelay;
     int overlay_format=SDL_YUY2_OVERLAY;
     int scale=5;
+    int benchmark=0;
+    int check=0;
 
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE) < 0)
     {
@@ -378,6 +611,49 @@ int main(int argc, char **argv)
                 quit(10);
             }
         } else
+        if (strcmp(argv[1], "-benchmark") == 0)
+        {
+            if (argv[2])
+            {
+                benchmark = atoi(argv[2]);
+                if (benchmark<=0)
+                {
+                    fprintf(stderr, "The -benchmark option requires a time in milliseconds.\n");
+                    quit(10);
+                }
+                argv += 2;
+                argc -= 2;
+            }
+            else
+            {
+                fprintf(stderr, "The -benchmark option requires a time in milliseconds.\n");
+                quit(10);
+            }
+        } else
+        if (strcmp(argv[1], "-check") == 0)
+        {
+            check = 1;
+            argv += 1;
+            argc -= 1;
+        } else
+        if (strcmp(argv[1], "-threads") == 0)
+        {
+            if (argv[2] && atoi(argv[2]) > 0)
+            {
+                static char threads[64];
+
+                /* Read by SDL the first time an overlay is displayed */
+                SDL_snprintf(threads, sizeof(threads), "SDL_VIDEO_THREADS=%d", atoi(argv[2]));
+                SDL_putenv(threads);
+                argv += 2;
+                argc -= 2;
+            }
+            else
+            {
+                fprintf(stderr, "The -threads option requires a thread count.\n");
+                quit(10);
+            }
+        } else
         if ((strcmp(argv[1], "-help") == 0 ) || (strcmp(argv[1], "-h") == 0))
         {
             PrintUsage(argv[0]);
@@ -387,7 +663,11 @@ int main(int argc, char **argv)
             fprintf(stderr, "Unrecognized option: %s.\n", argv[1]);
             quit(10);
         }
-        break;
+    }
+
+    if (check)
+    {
+        quit(Check() ? 1 : 0);
     }
    
     RawMooseData=(Uint8*)malloc(MOOSEFRAME_SIZE * MOOSEFRAMES_COUNT);
@@ -475,6 +755,16 @@ int main(int argc, char **argv)
 
     free(RawMooseData);
 
+    if (benchmark)
+    {
+        Benchmark(MooseFrame[0], scale, benchmark);
+        for (i=0; i<MOOSEFRAMES_COUNT; i++)
+        {
+            SDL_FreeSurface(MooseFrame[i]);
+        }
+        quit(0);
+    }
+
     overlay=SDL_CreateYUVOverlay(MOOSEPIC_W, MOOSEPIC_H, overlay_format, screen);
     if (!overlay)
     {
@@ -556,24 +846,7 @@ int main(int argc, char **argv)
             {
                 lastftick=SDL_GetTicks();
 
-                switch (overlay_format)
-                {
-                    case SDL_YUY2_OVERLAY:
-                         ConvertRGBtoYUY2(MooseFrame[i], overlay, 0, 100);
-                         break;
-                    case SDL_YV12_OVERLAY:
-                         ConvertRGBtoYV12(MooseFrame[i], overlay, 0, 100);
-                         break;
-                    case SDL_UYVY_OVERLAY:
-                         ConvertRGBtoUYVY(MooseFrame[i], overlay, 0, 100);
-                         break;
-                    case SDL_YVYU_OVERLAY:
-                         ConvertRGBtoYVYU(MooseFrame[i], overlay, 0, 100);
-                         break;
-                    case SDL_IYUV_OVERLAY:
-                         ConvertRGBtoIYUV(MooseFrame[i], overlay, 0, 100);
-                         break;
-                }
+                ConvertRGBtoOverlay(MooseFrame[i], overlay);
 
                 SDL_DisplayYUVOverlay(overlay, &overlayrect);
                 if (!resized)
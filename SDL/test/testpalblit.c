@@ -0,0 +1,128 @@
+/*
+ * Benchmarks blits from 8-bit palettized surfaces to 16 and 32-bit
+ *  surfaces, the way emulators expand their screen every frame, with
+ *  and without palette cycling between frames.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+static int testMilliseconds = 1000;
+
+static const struct {
+    int w, h;
+} resolutions[] = {
+    { 320, 200 }, { 640, 480 }
+};
+
+static void fill_random(SDL_Surface *surface)
+{
+    SDL_Color colors[256];
+    Uint8 *pixels = (Uint8 *) surface->pixels;
+    int x, y, i;
+
+    for (i = 0; i < 256; i++) {
+        colors[i].r = (Uint8) rand();
+        colors[i].g = (Uint8) rand();
+        colors[i].b = (Uint8) rand();
+    }
+    SDL_SetColors(surface, colors, 0, 256);
+
+    for (y = 0; y < surface->h; y++) {
+        for (x = 0; x < surface->w; x++) {
+            pixels[x] = (Uint8) rand();
+        }
+        pixels += surface->pitch;
+    }
+}
+
+/* Rotate a range of colours, like the water and fire in old games */
+static void cycle_palette(SDL_Surface *surface, int first, int count)
+{
+    SDL_Color colors[256];
+    int i;
+
+    for (i = 0; i < count; i++) {
+        colors[i] = surface->format->palette->colors[first + (i + 1) % count];
+    }
+    SDL_SetColors(surface, colors, first, count);
+}
+
+static void bench_blit(SDL_Surface *src, SDL_Surface *dst, const char *name,
+                       int cycle)
+{
+    Uint32 start, now;
+    int frames = 0;
+    double fps;
+
+    start = now = SDL_GetTicks();
+    while ((now - start) < (Uint32) testMilliseconds) {
+        if (cycle) {
+            cycle_palette(src, 32, cycle);
+        }
+        if (SDL_BlitSurface(src, NULL, dst, NULL) < 0) {
+            printf("  %s failed: %s\n", name, SDL_GetError());
+            return;
+        }
+        frames++;
+        now = SDL_GetTicks();
+    }
+    if (now == start)
+        now++;
+    fps = (frames * 1000.0) / (now - start);
+    printf("  %-9s %4dx%-4d 8 -> %2d bpp: %8.1f frames/sec, %8.1f Mpixels/sec\n",
+           name, src->w, src->h, dst->format->BitsPerPixel, fps,
+           (fps * src->w * src->h) / 1000000.0);
+}
+
+int main(int argc, char **argv)
+{
+    static const int depths[] = { 16, 32 };
+    SDL_Surface *src, *dst;
+    int i, d;
+
+    if (argc > 1) {
+        testMilliseconds = atoi(argv[1]);
+        if (testMilliseconds <= 0)
+            testMilliseconds = 1000;
+    }
+
+    if (SDL_Init(0) < 0) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    for (i = 0; i < (int) (sizeof(resolutions) / sizeof(resolutions[0])); i++) {
+        src = SDL_CreateRGBSurface(SDL_SWSURFACE, resolutions[i].w,
+                                   resolutions[i].h, 8, 0, 0, 0, 0);
+        if (src == NULL) {
+            fprintf(stderr, "Couldn't create surface: %s\n", SDL_GetError());
+            SDL_Quit();
+            return 1;
+        }
+        fill_random(src);
+        for (d = 0; d < (int) (sizeof(depths) / sizeof(depths[0])); d++) {
+            dst = SDL_CreateRGBSurface(SDL_SWSURFACE, src->w, src->h,
+                                       depths[d], 0, 0, 0, 0);
+            if (dst == NULL) {
+                fprintf(stderr, "Couldn't create surface: %s\n", SDL_GetError());
+                SDL_FreeSurface(src);
+                SDL_Quit();
+                return 1;
+            }
+            SDL_SetColorKey(src, 0, 0);
+            bench_blit(src, dst, "copy", 0);
+            bench_blit(src, dst, "cycle16", 16);
+            bench_blit(src, dst, "cycle224", 224);
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY, 0);
+            bench_blit(src, dst, "colorkey", 0);
+            SDL_FreeSurface(dst);
+        }
+        SDL_FreeSurface(src);
+    }
+
+    SDL_Quit();
+    return 0;
+}
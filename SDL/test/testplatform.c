@@ -138,6 +138,18 @@ int TestCPUInfo(SDL_bool verbose)
 		printf("SSE %s\n", SDL_HasSSE() ? "detected" : "not detected");
 		printf("SSE2 %s\n", SDL_HasSSE2() ? "detected" : "not detected");
 		printf("AltiVec %s\n", SDL_HasAltiVec() ? "detected" : "not detected");
+		printf("SSE3 %s\n", SDL_HasSSE3() ? "detected" : "not detected");
+		printf("SSSE3 %s\n", SDL_HasSSSE3() ? "detected" : "not detected");
+		printf("SSE4.1 %s\n", SDL_HasSSE41() ? "detected" : "not detected");
+		printf("SSE4.2 %s\n", SDL_HasSSE42() ? "detected" : "not detected");
+		printf("AVX %s\n", SDL_HasAVX() ? "detected" : "not detected");
+		printf("AVX2 %s\n", SDL_HasAVX2() ? "detected" : "not detected");
+		printf("AVX-512F %s\n", SDL_HasAVX512F() ? "detected" : "not detected");
+		printf("%d processors, %d cores\n",
+		       SDL_GetCPUCount(), SDL_GetCPUCoreCount());
+		printf("Cache line %d bytes, L1 data %d KB, L2 %d KB, L3 %d KB\n",
+		       SDL_GetCPUCacheLineSize(), SDL_GetCPUCacheSize(1) / 1024,
+		       SDL_GetCPUCacheSize(2) / 1024, SDL_GetCPUCacheSize(3) / 1024);
 	}
 	return(0);
 }
@@ -0,0 +1,137 @@
+
+/* Test program for the asynchronous presenter: draws frames faster than
+   they can be presented, checks the present counters, and changes the
+   video mode and quits while frames are still in flight.
+
+   Without a display, run it with SDL_VIDEODRIVER=dummy.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL.h"
+
+static int frames = 100;
+
+static void DrawFrames(SDL_Surface *screen, int n)
+{
+	int i;
+
+	for ( i = 0; i < n; ++i ) {
+		SDL_FillRect(screen, NULL,
+		             SDL_MapRGB(screen->format, i*7, i*3, i*5));
+		SDL_UpdateRect(screen, 0, 0, 0, 0);
+	}
+}
+
+/* Wait for the presenter to catch up, or give up after a while */
+static void WaitForFrames(Uint32 n, SDL_UpdateStats *stats)
+{
+	Uint32 start = SDL_GetTicks();
+
+	do {
+		SDL_GetUpdateStats(stats, 0);
+		if ( stats->frames_presented >= n ) {
+			break;
+		}
+		SDL_Delay(1);
+	} while ( (SDL_GetTicks() - start) < 5000 );
+}
+
+int main(int argc, char *argv[])
+{
+	SDL_Surface *screen;
+	SDL_UpdateStats stats;
+	const char *delay = "5";
+	char env[64];
+	Uint32 start, elapsed;
+	int status = 0;
+	int i;
+
+	for ( i = 1; i < argc; ++i ) {
+		if ( strcmp(argv[i], "-frames") == 0 && argv[i+1] ) {
+			frames = atoi(argv[++i]);
+		} else if ( strcmp(argv[i], "-delay") == 0 && argv[i+1] ) {
+			delay = argv[++i];
+		} else {
+			fprintf(stderr,
+			        "Usage: %s [-frames n] [-delay ms]\n", argv[0]);
+			return(1);
+		}
+	}
+	if ( frames <= 0 ) {
+		fprintf(stderr, "Frames must be positive\n");
+		return(1);
+	}
+
+	putenv("SDL_VIDEO_X11_ASYNC_PRESENT=1");
+	putenv("SDL_VIDEO_DUMMY_ASYNC_PRESENT=1");
+	SDL_snprintf(env, sizeof(env), "SDL_VIDEO_DUMMY_PRESENT_DELAY=%s", delay);
+	putenv(env);
+
+	if ( SDL_Init(SDL_INIT_VIDEO) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+	screen = SDL_SetVideoMode(320, 240, 32, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		fprintf(stderr, "Couldn't set video mode: %s\n", SDL_GetError());
+		SDL_Quit();
+		return(1);
+	}
+
+	/* Frames are drawn faster than they are presented */
+	SDL_GetUpdateStats(&stats, 1);
+	start = SDL_GetTicks();
+	DrawFrames(screen, frames);
+	elapsed = SDL_GetTicks() - start;
+	WaitForFrames(frames, &stats);
+	if ( stats.frames_presented == 0 ) {
+		printf("The %s driver doesn't present asynchronously\n",
+		       SDL_VideoDriverName(env, sizeof(env)) ? env : "video");
+		SDL_Quit();
+		return(0);
+	}
+	printf("%d frames queued in %u ms, %u presented, %u waits\n",
+	       frames, elapsed, stats.frames_presented, stats.present_waits);
+	printf("Latency: %.1f ms average, %u ms max\n",
+	       (double)stats.present_latency / stats.frames_presented,
+	       stats.present_latency_max);
+	if ( stats.frames_presented != (Uint32)frames ) {
+		printf("FAIL: expected %d frames to be presented\n", frames);
+		status = 1;
+	}
+
+	/* Changing the mode finishes the frames in flight first */
+	SDL_GetUpdateStats(&stats, 1);
+	DrawFrames(screen, 2);
+	screen = SDL_SetVideoMode(400, 300, 32, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		fprintf(stderr, "Couldn't set video mode: %s\n", SDL_GetError());
+		SDL_Quit();
+		return(1);
+	}
+	SDL_GetUpdateStats(&stats, 0);
+	if ( stats.frames_presented < 2 ) {
+		printf("FAIL: %u of 2 frames presented across a mode change\n",
+		       stats.frames_presented);
+		status = 1;
+	} else {
+		printf("Frames in flight were presented before the mode change\n");
+	}
+	DrawFrames(screen, 4);
+	WaitForFrames(stats.frames_presented+4, &stats);
+
+	/* Quitting finishes the frames in flight and stops the thread */
+	DrawFrames(screen, 2);
+	start = SDL_GetTicks();
+	SDL_Quit();
+	printf("Quit with frames in flight took %u ms\n",
+	       SDL_GetTicks() - start);
+
+	if ( status == 0 ) {
+		printf("All tests passed\n");
+	}
+	return(status);
+}
@@ -0,0 +1,456 @@
+
+/* Test program comparing RLE accelerated blits with ordinary blits of the
+   same surface: clipped source rectangles, every pixel depth, colour keys
+   and alpha, before and after parts of the surface are changed and
+   encoded again.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#define SRC_W	600
+#define SRC_H	150
+#define DST_W	320
+#define DST_H	200
+#define BLITS	40
+
+typedef struct {
+	const char *name;
+	int bpp;
+	Uint32 Rmask, Gmask, Bmask, Amask;
+} Format;
+
+static const Format formats[] = {
+	{ "8-bit", 8, 0, 0, 0, 0 },
+	{ "RGB555", 15, 0x7C00, 0x03E0, 0x001F, 0 },
+	{ "RGB565", 16, 0xF800, 0x07E0, 0x001F, 0 },
+	{ "BGR565", 16, 0x001F, 0x07E0, 0xF800, 0 },
+	{ "RGB888 24-bit", 24, 0xFF0000, 0x00FF00, 0x0000FF, 0 },
+	{ "RGB888", 32, 0xFF0000, 0x00FF00, 0x0000FF, 0 },
+	{ "BGR888", 32, 0x0000FF, 0x00FF00, 0xFF0000, 0 }
+};
+#define NUM_FORMATS	(sizeof(formats)/sizeof(formats[0]))
+
+static const Format alpha_formats[] = {
+	{ "ARGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 },
+	{ "ABGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 },
+	{ "RGBA8888", 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF }
+};
+#define NUM_ALPHA_FORMATS	(sizeof(alpha_formats)/sizeof(alpha_formats[0]))
+
+enum {
+	MODE_KEY,
+	MODE_KEY_ALPHA,
+	MODE_PIXEL_ALPHA
+};
+static const char *mode_names[] = {
+	"colour key", "colour key and surface alpha", "pixel alpha"
+};
+
+static int failures;
+static int tests;
+static int rle_used;
+
+static SDL_Surface *CreateSurface(const Format *format, int w, int h)
+{
+	SDL_Surface *surface;
+	SDL_Color colors[256];
+	int i;
+
+	surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, format->bpp,
+	                               format->Rmask, format->Gmask,
+	                               format->Bmask, format->Amask);
+	if ( surface == NULL ) {
+		fprintf(stderr, "Couldn't create surface: %s\n", SDL_GetError());
+		exit(1);
+	}
+	if ( format->bpp == 8 ) {
+		/* The same palette everywhere, so 8-bit blits are copies */
+		for ( i = 0; i < 256; ++i ) {
+			colors[i].r = (Uint8)(i * 37);
+			colors[i].g = (Uint8)(i * 91);
+			colors[i].b = (Uint8)(i * 13);
+		}
+		SDL_SetColors(surface, colors, 0, 256);
+	}
+	return(surface);
+}
+
+static Uint32 RandomPixel(SDL_Surface *surface, int mode)
+{
+	SDL_PixelFormat *fmt = surface->format;
+	Uint8 a;
+
+	if ( mode != MODE_PIXEL_ALPHA ) {
+		return(SDL_MapRGB(fmt, rand(), rand(), rand()));
+	}
+	/* Mostly transparent or opaque, like sprites with soft edges */
+	switch (rand() % 4) {
+	    case 0:
+		a = SDL_ALPHA_TRANSPARENT;
+		break;
+	    case 1:
+		a = SDL_ALPHA_OPAQUE;
+		break;
+	    default:
+		a = (Uint8)rand();
+		break;
+	}
+	return(SDL_MapRGBA(fmt, rand(), rand(), rand(), a));
+}
+
+static void PutPixel(SDL_Surface *surface, int x, int y, Uint32 pixel)
+{
+	Uint8 *p = (Uint8 *)surface->pixels + y*surface->pitch +
+	           x*surface->format->BytesPerPixel;
+
+	switch (surface->format->BytesPerPixel) {
+	    case 1:
+		*p = (Uint8)pixel;
+		break;
+	    case 2:
+		*(Uint16 *)p = (Uint16)pixel;
+		break;
+	    case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		p[0] = (Uint8)(pixel >> 16);
+		p[1] = (Uint8)(pixel >> 8);
+		p[2] = (Uint8)pixel;
+#else
+		p[0] = (Uint8)pixel;
+		p[1] = (Uint8)(pixel >> 8);
+		p[2] = (Uint8)(pixel >> 16);
+#endif
+		break;
+	    case 4:
+		*(Uint32 *)p = pixel;
+		break;
+	}
+}
+
+/* Fill rows with runs of pixels, with the colour key in between */
+static void FillRows(SDL_Surface *surface, int y, int h, int mode,
+                     Uint32 key)
+{
+	Uint32 pixel;
+	int x, run, keyed;
+
+	for ( ; h > 0; ++y, --h ) {
+		/* Leave some rows blank, the encoder trims them */
+		if ( (rand() % 10) == 0 ) {
+			for ( x = 0; x < surface->w; ++x ) {
+				PutPixel(surface, x, y,
+				         (mode == MODE_PIXEL_ALPHA) ? 0 : key);
+			}
+			continue;
+		}
+		keyed = rand() % 2;
+		for ( x = 0; x < surface->w; ) {
+			keyed = !keyed;
+			for ( run = 1 + rand() % 40;
+			      run && x < surface->w; --run, ++x ) {
+				if ( keyed && mode != MODE_PIXEL_ALPHA ) {
+					pixel = key;
+				} else {
+					do {
+						pixel = RandomPixel(surface, mode);
+					} while ( mode != MODE_PIXEL_ALPHA &&
+					          pixel == key );
+				}
+				PutPixel(surface, x, y, pixel);
+			}
+		}
+	}
+}
+
+/* Copy rows of the reference surface into the RLE surface */
+static void CopyRows(SDL_Surface *dst, SDL_Surface *src, int y, int h)
+{
+	int len = src->w * src->format->BytesPerPixel;
+
+	for ( ; h > 0; ++y, --h ) {
+		SDL_memcpy((Uint8 *)dst->pixels + y*dst->pitch,
+		           (Uint8 *)src->pixels + y*src->pitch, len);
+	}
+}
+
+static Uint32 GetPixel(SDL_Surface *surface, int x, int y)
+{
+	Uint8 *p = (Uint8 *)surface->pixels + y*surface->pitch +
+	           x*surface->format->BytesPerPixel;
+
+	switch (surface->format->BytesPerPixel) {
+	    case 1:
+		return(*p);
+	    case 2:
+		return(*(Uint16 *)p);
+	    case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		return((p[0] << 16) | (p[1] << 8) | p[2]);
+#else
+		return(p[0] | (p[1] << 8) | (p[2] << 16));
+#endif
+	    default:
+		return(*(Uint32 *)p);
+	}
+}
+
+/* Compare two surfaces, allowing each colour component to differ by
+   up to 'tolerance' for blends which are rounded differently.
+ */
+static int CompareSurfaces(SDL_Surface *a, SDL_Surface *b, int tolerance,
+                           int *x, int *y)
+{
+	int bpp = a->format->BytesPerPixel;
+	Uint8 r1, g1, b1, r2, g2, b2;
+	Uint32 p1, p2;
+
+	for ( *y = 0; *y < a->h; ++*y ) {
+		if ( SDL_memcmp((Uint8 *)a->pixels + *y*a->pitch,
+		                (Uint8 *)b->pixels + *y*b->pitch,
+		                a->w*bpp) == 0 ) {
+			continue;
+		}
+		for ( *x = 0; *x < a->w; ++*x ) {
+			p1 = GetPixel(a, *x, *y);
+			p2 = GetPixel(b, *x, *y);
+			if ( p1 == p2 ) {
+				continue;
+			}
+			SDL_GetRGB(p1, a->format, &r1, &g1, &b1);
+			SDL_GetRGB(p2, b->format, &r2, &g2, &b2);
+			if ( abs(r1 - r2) > tolerance ||
+			     abs(g1 - g2) > tolerance ||
+			     abs(b1 - b2) > tolerance ) {
+				return(-1);
+			}
+		}
+	}
+	return(0);
+}
+
+static void RandomRect(SDL_Rect *rect, int w, int h)
+{
+	rect->x = (Sint16)(rand() % (w + w/4) - w/8);
+	rect->y = (Sint16)(rand() % (h + h/4) - h/8);
+	rect->w = (Uint16)(1 + rand() % w);
+	rect->h = (Uint16)(1 + rand() % h);
+}
+
+/* Set up a surface for one of the test modes */
+static void SetMode(SDL_Surface *surface, int mode, Uint32 key, Uint32 rle)
+{
+	switch (mode) {
+	    case MODE_KEY_ALPHA:
+		SDL_SetAlpha(surface, SDL_SRCALPHA|rle, 77);
+		/* Fall through */
+	    case MODE_KEY:
+		SDL_SetColorKey(surface, SDL_SRCCOLORKEY|rle, key);
+		break;
+	    case MODE_PIXEL_ALPHA:
+		SDL_SetAlpha(surface, SDL_SRCALPHA|rle, 0);
+		break;
+	}
+}
+
+/* Blit clipped parts of the surfaces and check the results match.
+   'src' is blitted without RLE, 'rle' has been encoded again after
+   changes and 'fresh' was encoded from scratch with the same pixels.
+ */
+static void TestBlits(SDL_Surface *src, SDL_Surface *rle, SDL_Surface *fresh,
+                      SDL_Surface *dst[3], int mode,
+                      const char *what, const char *stage)
+{
+	SDL_Rect srcrect, dstrect, cliprect, r;
+	int tolerance = 0;
+	int i, j, x, y;
+
+	/* The RLE alpha blitters keep 5 bits of alpha for 16-bit pixels,
+	   and all of them round blends a little differently.
+	 */
+	if ( mode != MODE_KEY ) {
+		tolerance = (dst[0]->format->BytesPerPixel == 2) ? 17 : 1;
+	}
+
+	/* Start from the same background */
+	FillRows(dst[0], 0, dst[0]->h, MODE_KEY, 0);
+	CopyRows(dst[1], dst[0], 0, dst[0]->h);
+	CopyRows(dst[2], dst[0], 0, dst[0]->h);
+
+	for ( i = 0; i < BLITS; ++i ) {
+		if ( i == 0 ) {
+			srcrect.x = 0;
+			srcrect.y = 0;
+			srcrect.w = src->w;
+			srcrect.h = src->h;
+		} else {
+			RandomRect(&srcrect, src->w, src->h);
+		}
+		RandomRect(&dstrect, dst[0]->w, dst[0]->h);
+		RandomRect(&cliprect, dst[0]->w, dst[0]->h);
+		for ( j = 0; j < 3; ++j ) {
+			SDL_SetClipRect(dst[j], (i % 4) == 3 ? &cliprect : NULL);
+		}
+		r = dstrect;
+		SDL_BlitSurface(src, &srcrect, dst[0], &r);
+		r = dstrect;
+		SDL_BlitSurface(rle, &srcrect, dst[1], &r);
+		r = dstrect;
+		SDL_BlitSurface(fresh, &srcrect, dst[2], &r);
+		if ( rle->flags & SDL_RLEACCEL ) {
+			++rle_used;
+		}
+		++tests;
+
+		if ( CompareSurfaces(dst[1], dst[2], 0, &x, &y) < 0 ) {
+			printf("FAIL: %s, %s: blit %d of %dx%d at %d,%d to "
+			       "%d,%d differs from a new encoding at %d,%d\n",
+			       what, stage, i, srcrect.w, srcrect.h,
+			       srcrect.x, srcrect.y, dstrect.x, dstrect.y, x, y);
+			++failures;
+			break;
+		}
+		if ( CompareSurfaces(dst[0], dst[1], tolerance, &x, &y) < 0 ) {
+			printf("FAIL: %s, %s: blit %d of %dx%d at %d,%d to "
+			       "%d,%d differs from a plain blit at %d,%d\n",
+			       what, stage, i, srcrect.w, srcrect.h,
+			       srcrect.x, srcrect.y, dstrect.x, dstrect.y, x, y);
+			++failures;
+			break;
+		}
+		/* Don't let rounding differences add up */
+		CopyRows(dst[1], dst[0], 0, dst[0]->h);
+		CopyRows(dst[2], dst[0], 0, dst[0]->h);
+	}
+	for ( j = 0; j < 3; ++j ) {
+		SDL_SetClipRect(dst[j], NULL);
+	}
+}
+
+static void TestFormats(const Format *srcfmt, const Format *dstfmt, int mode)
+{
+	SDL_Surface *src, *rle, *fresh, *dst[3];
+	SDL_Rect rect;
+	Uint32 key = 0, color;
+	char what[128];
+	int i, y, h, y2, h2;
+
+	SDL_snprintf(what, sizeof(what), "%s to %s with %s",
+	             srcfmt->name, dstfmt->name, mode_names[mode]);
+
+	src = CreateSurface(srcfmt, SRC_W, SRC_H);
+	rle = CreateSurface(srcfmt, SRC_W, SRC_H);
+	for ( i = 0; i < 3; ++i ) {
+		dst[i] = CreateSurface(dstfmt, DST_W, DST_H);
+	}
+
+	if ( mode != MODE_PIXEL_ALPHA ) {
+		key = SDL_MapRGB(src->format, 255, 0, 255);
+	}
+	FillRows(src, 0, src->h, mode, key);
+	CopyRows(rle, src, 0, src->h);
+	SetMode(src, mode, key, 0);
+	SetMode(rle, mode, key, SDL_RLEACCEL);
+	TestBlits(src, rle, rle, dst, mode, what, "first encoding");
+
+	/* Change a few rows while locked and mark them */
+	y = rand() % SRC_H;
+	h = 1 + rand() % (SRC_H - y);
+	y2 = rand() % SRC_H;
+	h2 = 1 + rand() % 3;
+	if ( y2 + h2 > SRC_H ) {
+		h2 = SRC_H - y2;
+	}
+	FillRows(src, y, h, mode, key);
+	FillRows(src, y2, h2, mode, key);
+	SDL_LockSurface(rle);
+	CopyRows(rle, src, y, h);
+	CopyRows(rle, src, y2, h2);
+	SDL_DirtySurfaceRows(rle, y, h);
+	SDL_DirtySurfaceRows(rle, y2, h2);
+	SDL_UnlockSurface(rle);
+	fresh = CreateSurface(srcfmt, SRC_W, SRC_H);
+	CopyRows(fresh, src, 0, src->h);
+	SetMode(fresh, mode, key, SDL_RLEACCEL);
+	TestBlits(src, rle, fresh, dst, mode, what, "after changing rows");
+	SDL_FreeSurface(fresh);
+
+	/* Fills mark the rows they change themselves */
+	RandomRect(&rect, SRC_W, SRC_H);
+	if ( mode == MODE_PIXEL_ALPHA ) {
+		color = SDL_MapRGBA(src->format, 0, 0, 0, 0);
+	} else {
+		color = key;
+	}
+	SDL_FillRect(src, &rect, color);
+	SDL_FillRect(rle, &rect, color);
+	RandomRect(&rect, SRC_W, SRC_H);
+	color = RandomPixel(src, mode);
+	SDL_FillRect(src, &rect, color);
+	SDL_FillRect(rle, &rect, color);
+	fresh = CreateSurface(srcfmt, SRC_W, SRC_H);
+	CopyRows(fresh, src, 0, src->h);
+	SetMode(fresh, mode, key, SDL_RLEACCEL);
+	TestBlits(src, rle, fresh, dst, mode, what, "after filling");
+	SDL_FreeSurface(fresh);
+
+	SDL_FreeSurface(src);
+	SDL_FreeSurface(rle);
+	for ( i = 0; i < 3; ++i ) {
+		SDL_FreeSurface(dst[i]);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	static char env[64];
+	unsigned int seed = 1;
+	unsigned int s, d, m;
+
+	for ( s = 1; s < (unsigned int)argc; ++s ) {
+		if ( strcmp(argv[s], "-seed") == 0 && argv[s+1] ) {
+			seed = (unsigned int)atoi(argv[++s]);
+		} else if ( strcmp(argv[s], "-threads") == 0 && argv[s+1] ) {
+			SDL_snprintf(env, sizeof(env),
+			             "SDL_VIDEO_THREADS=%s", argv[++s]);
+			putenv(env);
+		} else {
+			fprintf(stderr,
+			        "Usage: %s [-seed n] [-threads n]\n", argv[0]);
+			return(1);
+		}
+	}
+	srand(seed);
+
+	if ( SDL_Init(0) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+
+	for ( s = 0; s < NUM_FORMATS; ++s ) {
+		for ( d = 0; d < NUM_FORMATS; ++d ) {
+			for ( m = MODE_KEY; m <= MODE_KEY_ALPHA; ++m ) {
+				TestFormats(&formats[s], &formats[d], m);
+			}
+		}
+	}
+	for ( s = 0; s < NUM_ALPHA_FORMATS; ++s ) {
+		for ( d = 0; d < NUM_FORMATS; ++d ) {
+			TestFormats(&alpha_formats[s], &formats[d],
+			            MODE_PIXEL_ALPHA);
+		}
+	}
+
+	printf("%d blits compared, %d of them RLE accelerated\n",
+	       tests, rle_used);
+	SDL_Quit();
+	if ( failures ) {
+		printf("%d cases failed\n", failures);
+		return(1);
+	}
+	printf("All tests passed\n");
+	return(0);
+}
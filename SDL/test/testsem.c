@@ -9,6 +9,9 @@
 #include "SDL_thread.h"
 
 #define NUM_THREADS 10
+#define NUM_OVERHEAD_OPS 100000
+#define NUM_OVERHEAD_THREADS 4
+#define NUM_SHORT_WAITS 50
 
 static SDL_sem *sem;
 int alive = 1;
@@ -55,6 +58,113 @@ static void TestWaitTimeout(void)
 		fprintf(stderr, "Wait took %d milliseconds\n", duration);
 }
 
+/* Time many short waits, which have to run out on time to be useful */
+static void TestShortTimeouts(void)
+{
+	Uint64 start, elapsed, late, max_late = 0, total_late = 0;
+	Uint32 timeout;
+	int i;
+
+	sem = SDL_CreateSemaphore(0);
+	for ( i = 0; i < NUM_SHORT_WAITS; ++i ) {
+		timeout = 1 + (i % 5);
+		start = SDL_GetTicksNS();
+		if ( SDL_SemWaitTimeout(sem, timeout) != SDL_MUTEX_TIMEDOUT ) {
+			fprintf(stderr, "Wait of %d ms didn't time out: %s\n",
+			        timeout, SDL_GetError());
+		}
+		elapsed = SDL_GetTicksNS() - start;
+		if ( elapsed < (Uint64)timeout * 1000000 ) {
+			fprintf(stderr, "Wait of %d ms ran out after %.3f ms\n",
+			        timeout, elapsed / 1000000.0);
+			continue;
+		}
+		late = elapsed - (Uint64)timeout * 1000000;
+		total_late += late;
+		if ( late > max_late ) {
+			max_late = late;
+		}
+	}
+	printf("%d waits of 1-5 ms ran out %.1f us late on average, %.1f us at most\n",
+	       NUM_SHORT_WAITS, total_late / 1000.0 / NUM_SHORT_WAITS,
+	       max_late / 1000.0);
+	SDL_DestroySemaphore(sem);
+}
+
+/* Time posting and waiting with nothing else going on */
+static void TestOverheadUncontended(void)
+{
+	Uint64 start;
+	int i;
+
+	sem = SDL_CreateSemaphore(0);
+	start = SDL_GetTicksNS();
+	for ( i = 0; i < NUM_OVERHEAD_OPS; ++i ) {
+		SDL_SemPost(sem);
+		SDL_SemWait(sem);
+	}
+	printf("Uncontended post and wait: %.1f ns each\n",
+	       (double)(SDL_GetTicksNS() - start) / NUM_OVERHEAD_OPS);
+	SDL_DestroySemaphore(sem);
+}
+
+static SDL_atomic_t posts_left;
+static SDL_atomic_t waits_done;
+
+static int SDLCALL PostThread(void *data)
+{
+	while ( SDL_AtomicAdd(&posts_left, -1) > 0 ) {
+		SDL_SemPost(sem);
+	}
+	return 0;
+}
+
+static int SDLCALL WaitThread(void *data)
+{
+	while ( SDL_SemWaitTimeout(sem, 100) == 0 ) {
+		SDL_AtomicIncRef(&waits_done);
+	}
+	return 0;
+}
+
+/* Time threads posting to threads waiting on the same semaphore */
+static void TestOverheadContended(void)
+{
+	SDL_Thread *posters[NUM_OVERHEAD_THREADS];
+	SDL_Thread *waiters[NUM_OVERHEAD_THREADS];
+	Uint64 start, elapsed;
+	int i;
+
+	sem = SDL_CreateSemaphore(0);
+	SDL_AtomicSet(&posts_left, NUM_OVERHEAD_OPS);
+	SDL_AtomicSet(&waits_done, 0);
+	start = SDL_GetTicksNS();
+	for ( i = 0; i < NUM_OVERHEAD_THREADS; ++i ) {
+		waiters[i] = SDL_CreateThread(WaitThread, NULL);
+	}
+	for ( i = 0; i < NUM_OVERHEAD_THREADS; ++i ) {
+		posters[i] = SDL_CreateThread(PostThread, NULL);
+	}
+	for ( i = 0; i < NUM_OVERHEAD_THREADS; ++i ) {
+		SDL_WaitThread(posters[i], NULL);
+	}
+	for ( i = 0; i < NUM_OVERHEAD_THREADS; ++i ) {
+		SDL_WaitThread(waiters[i], NULL);
+	}
+	/* The waiters give up 100 ms after the last post */
+	elapsed = SDL_GetTicksNS() - start - 100000000;
+
+	if ( SDL_AtomicGet(&waits_done) != NUM_OVERHEAD_OPS ||
+	     SDL_SemValue(sem) != 0 ) {
+		fprintf(stderr, "%d posts, but %d waits and %d left over\n",
+		        NUM_OVERHEAD_OPS, SDL_AtomicGet(&waits_done),
+		        SDL_SemValue(sem));
+	}
+	printf("Contended post and wait, %d threads each: %.1f ns each\n",
+	       NUM_OVERHEAD_THREADS, (double)elapsed / NUM_OVERHEAD_OPS);
+	SDL_DestroySemaphore(sem);
+}
+
 int main(int argc, char **argv)
 {
 	SDL_Thread *threads[NUM_THREADS];
@@ -97,6 +207,9 @@ int main(int argc, char **argv)
 	SDL_DestroySemaphore(sem);
 
 	TestWaitTimeout();
+	TestShortTimeouts();
+	TestOverheadUncontended();
+	TestOverheadContended();
 
 	SDL_Quit();
 	return(0);
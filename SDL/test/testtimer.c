@@ -24,10 +24,29 @@ static Uint32 SDLCALL callback(Uint32 interval, void *param)
   return interval;
 }
 
+static Uint32 SDLCALL precise(Uint32 interval, void *param)
+{
+	++ticks;
+	return(interval);
+}
+
+static void print_stats(const char *what)
+{
+	SDL_TimerStats stats;
+
+	SDL_GetTimerStats(&stats, 1);
+	printf("%s: %d callbacks, %d late, lateness average %d us, "
+	       "max %d us, %d wakeups\n", what, stats.callbacks, stats.late,
+	       stats.callbacks ? stats.lateness_total / stats.callbacks : 0,
+	       stats.lateness_max, stats.wakeups);
+}
+
 int main(int argc, char *argv[])
 {
-	int desired;
+	int i, desired;
 	SDL_TimerID t1, t2, t3;
+	Uint32 start_ticks;
+	Uint64 start_ns, now_ns;
 
 	if ( SDL_Init(SDL_INIT_TIMER) < 0 ) {
 		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
@@ -81,6 +100,39 @@ int main(int argc, char *argv[])
 
 	SDL_RemoveTimer(t2);
 	SDL_RemoveTimer(t3);
+	print_stats("Multiple timers");
+
+	/* Nothing should wake the timer thread without timers */
+	printf("Waiting 1 second without timers\n");
+	SDL_Delay(1000);
+	print_stats("No timers");
+
+	/* Test a timer faster than a millisecond */
+	printf("Testing a 500 us timer for 1 second\n");
+	ticks = 0;
+	t1 = SDL_AddTimerUS(500, precise, NULL);
+	if(!t1)
+	  fprintf(stderr,"Could not create precise timer: %s\n", SDL_GetError());
+	SDL_Delay(1000);
+	SDL_RemoveTimer(t1);
+	printf("Precise timer ran %d times, expected 2000\n", ticks);
+	print_stats("Precise timer");
+
+	/* Compare the high resolution clock with the ticks */
+	printf("Performance counter frequency: %.0f per second\n",
+	       (double)SDL_GetPerformanceFrequency());
+	start_ticks = SDL_GetTicks();
+	start_ns = SDL_GetTicksNS();
+	SDL_Delay(100);
+	printf("SDL_Delay(100) took %u ms, %.3f ms by the counter\n",
+	       SDL_GetTicks() - start_ticks,
+	       (double)(SDL_GetTicksNS() - start_ns) / 1000000.0);
+	start_ns = SDL_GetTicksNS();
+	for ( i = 0; i < 1000000; ++i ) {
+		now_ns = SDL_GetTicksNS();
+	}
+	printf("SDL_GetTicksNS() takes %.1f ns\n",
+	       (double)(now_ns - start_ns) / 1000000.0);
 
 	SDL_Quit();
 	return(0);
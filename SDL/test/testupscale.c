@@ -0,0 +1,135 @@
+/*
+ * Benchmarks SDL_SoftUpscale() and SDL_SoftStretchFiltered() at the
+ *  screen sizes DOS games use.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+static int testMilliseconds = 1000;
+
+static const struct {
+    int w, h;
+} resolutions[] = {
+    { 320, 200 }, { 320, 240 }, { 640, 400 }, { 640, 480 }
+};
+
+static void fill_random(SDL_Surface *surface)
+{
+    Uint8 *pixels = (Uint8 *) surface->pixels;
+    int x, y;
+
+    /* A handful of colours, so the edge rules of Scale2x kick in */
+    for (y = 0; y < surface->h; y++) {
+        for (x = 0; x < surface->pitch; x++) {
+            pixels[x] = (Uint8) ((rand() % 4) * 0x55);
+        }
+        pixels += surface->pitch;
+    }
+}
+
+static void report(const char *name, SDL_Surface *src, int factor,
+                   int frames, Uint32 elapsed)
+{
+    double fps, mpix;
+
+    if (elapsed == 0)
+        elapsed = 1;
+    fps = (frames * 1000.0) / elapsed;
+    mpix = (fps * src->w * factor * src->h * factor) / 1000000.0;
+    printf("  %-10s %dx  %4dx%-4d %2d bpp: %8.1f frames/sec, %8.1f Mpixels/sec\n",
+           name, factor, src->w, src->h, src->format->BitsPerPixel,
+           fps, mpix);
+}
+
+static void bench_upscale(SDL_Surface *src, SDL_Surface *dst, int factor,
+                          SDL_UpscaleFilter filter, const char *name)
+{
+    Uint32 start, now;
+    int frames = 0;
+
+    start = now = SDL_GetTicks();
+    while ((now - start) < (Uint32) testMilliseconds) {
+        if (SDL_SoftUpscale(src, NULL, dst, NULL, factor, filter) < 0) {
+            printf("  %s %dx failed: %s\n", name, factor, SDL_GetError());
+            return;
+        }
+        frames++;
+        now = SDL_GetTicks();
+    }
+    report(name, src, factor, frames, now - start);
+}
+
+static void bench_stretch(SDL_Surface *src, SDL_Surface *dst, int factor,
+                          SDL_StretchFilter filter, const char *name)
+{
+    Uint32 start, now;
+    int frames = 0;
+
+    start = now = SDL_GetTicks();
+    while ((now - start) < (Uint32) testMilliseconds) {
+        if (SDL_SoftStretchFiltered(src, NULL, dst, NULL, filter) < 0) {
+            printf("  %s failed: %s\n", name, SDL_GetError());
+            return;
+        }
+        frames++;
+        now = SDL_GetTicks();
+    }
+    report(name, src, factor, frames, now - start);
+}
+
+int main(int argc, char **argv)
+{
+    static const int depths[] = { 8, 16, 32 };
+    SDL_Surface *src, *dst;
+    int i, d, factor;
+
+    if (argc > 1) {
+        testMilliseconds = atoi(argv[1]);
+        if (testMilliseconds <= 0)
+            testMilliseconds = 1000;
+    }
+
+    if (SDL_Init(0) < 0) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    for (i = 0; i < (int) (sizeof(resolutions) / sizeof(resolutions[0])); i++) {
+        for (d = 0; d < (int) (sizeof(depths) / sizeof(depths[0])); d++) {
+            src = SDL_CreateRGBSurface(SDL_SWSURFACE, resolutions[i].w,
+                                       resolutions[i].h, depths[d], 0, 0, 0, 0);
+            if (src == NULL) {
+                fprintf(stderr, "Couldn't create surface: %s\n", SDL_GetError());
+                SDL_Quit();
+                return 1;
+            }
+            fill_random(src);
+            for (factor = 2; factor <= 4; factor++) {
+                dst = SDL_CreateRGBSurface(SDL_SWSURFACE, src->w * factor,
+                                           src->h * factor, depths[d], 0, 0, 0, 0);
+                if (dst == NULL) {
+                    fprintf(stderr, "Couldn't create surface: %s\n", SDL_GetError());
+                    SDL_FreeSurface(src);
+                    SDL_Quit();
+                    return 1;
+                }
+                bench_upscale(src, dst, factor, SDL_UPSCALE_NEAREST, "nearest");
+                bench_upscale(src, dst, factor, SDL_UPSCALE_SCALEX, "scalex");
+                if (depths[d] != 8) {
+                    bench_stretch(src, dst, factor, SDL_STRETCH_NEAREST, "stretch");
+                    bench_stretch(src, dst, factor, SDL_STRETCH_BILINEAR, "bilinear");
+                }
+                SDL_FreeSurface(dst);
+            }
+            SDL_FreeSurface(src);
+        }
+    }
+
+    SDL_Quit();
+    return 0;
+}
+
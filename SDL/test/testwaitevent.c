@@ -0,0 +1,123 @@
+
+/* Test program to measure how long SDL_WaitEvent() takes to return after
+   another thread pushes an event, and how much processor time waiting
+   with nothing happening uses.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "SDL.h"
+
+static int events = 200;
+static volatile Uint64 sent;
+static SDL_sem *received;
+
+static int SDLCALL pusher(void *data)
+{
+	SDL_Event event;
+	int i;
+
+	SDL_memset(&event, 0, sizeof(event));
+	event.type = SDL_USEREVENT;
+	for ( i = 0; i < events; ++i ) {
+		/* Let the main thread get back to sleep first */
+		SDL_Delay(1 + (rand() % 5));
+		sent = SDL_GetTicksNS();
+		SDL_PushEvent(&event);
+		SDL_SemWait(received);
+	}
+	return(0);
+}
+
+static int compare(const void *a, const void *b)
+{
+	Sint64 x = *(const Sint64 *)a;
+	Sint64 y = *(const Sint64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+	Uint32 init_flags = SDL_INIT_VIDEO;
+	SDL_Thread *thread;
+	SDL_Event event;
+	Sint64 *latency;
+	Uint32 start;
+	clock_t cpu;
+	int i;
+
+	for ( i = 1; i < argc; ++i ) {
+		if ( strcmp(argv[i], "-events") == 0 && argv[i+1] ) {
+			events = atoi(argv[++i]);
+		} else if ( strcmp(argv[i], "-eventthread") == 0 ) {
+			init_flags |= SDL_INIT_EVENTTHREAD;
+		} else {
+			fprintf(stderr,
+			        "Usage: %s [-events n] [-eventthread]\n", argv[0]);
+			return(1);
+		}
+	}
+	if ( events <= 0 ) {
+		fprintf(stderr, "Events must be positive\n");
+		return(1);
+	}
+
+	if ( SDL_Init(init_flags) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+	if ( SDL_SetVideoMode(320, 240, 0, 0) == NULL ) {
+		fprintf(stderr, "Couldn't set video mode: %s\n", SDL_GetError());
+		SDL_Quit();
+		return(1);
+	}
+	while ( SDL_PollEvent(&event) ) {
+		/* Throw away the events from setting the mode */ ;
+	}
+
+	/* Wait with nothing happening */
+	start = SDL_GetTicks();
+	cpu = clock();
+	i = SDL_WaitEventTimeout(&event, 1000);
+	cpu = clock() - cpu;
+	printf("Waited %d ms for no events (%s), using %.1f ms of processor time\n",
+	       SDL_GetTicks() - start, i ? "got one" : "timed out",
+	       cpu * 1000.0 / CLOCKS_PER_SEC);
+
+	/* Wait for events pushed by another thread */
+	latency = (Sint64 *)malloc(events * sizeof(*latency));
+	received = SDL_CreateSemaphore(0);
+	if ( ! latency || ! received ) {
+		fprintf(stderr, "Out of memory\n");
+		SDL_Quit();
+		return(1);
+	}
+	thread = SDL_CreateThread(pusher, NULL);
+	for ( i = 0; i < events; ) {
+		if ( ! SDL_WaitEvent(&event) ) {
+			fprintf(stderr, "Couldn't wait: %s\n", SDL_GetError());
+			break;
+		}
+		if ( event.type == SDL_USEREVENT ) {
+			latency[i++] = (Sint64)(SDL_GetTicksNS() - sent);
+			SDL_SemPost(received);
+		}
+	}
+	SDL_WaitThread(thread, NULL);
+
+	qsort(latency, i, sizeof(*latency), compare);
+	printf("%d pushed events, microseconds until SDL_WaitEvent() returned:\n", i);
+	printf("  min %.1f, median %.1f, 90%% %.1f, 99%% %.1f, max %.1f\n",
+	       latency[0] / 1000.0, latency[i / 2] / 1000.0,
+	       latency[(i * 9) / 10] / 1000.0, latency[(i * 99) / 100] / 1000.0,
+	       latency[i - 1] / 1000.0);
+
+	SDL_DestroySemaphore(received);
+	free(latency);
+	SDL_Quit();
+	return(0);
+}